@@ -1,4 +1,6 @@
 #include "protocol_api.h"
+#include "corpus.h"
+#include "perf_counters.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,6 +8,7 @@
 #include <stdint.h>
 
 #define M_TRIALS 10
+#define CORPUS_DIR "bench/corpus"
 
 __uint128_t calculate_elapsed_time(struct timespec start, struct timespec end) {
     // Convert to nanoseconds
@@ -19,71 +22,71 @@ void print_time(__uint128_t time_ns) {
     printf("Elapsed time: %.3f milliseconds\n", time_ms);
 }
 
-void run(int n, int m) {
+/// Scans N announcements M times; with @p pc, also reports its hardware counters per announcement.
+void run(int n, int m, perf_counters* pc) {
     struct timespec start, end;
     __uint128_t total_ns = 0;
 
-    for (int trial = 0; trial < m; ++trial) {
-        // Receiver keypair
-        uint8_t k_pub[CRYPTO_PUBLICKEYBYTES];
-        uint8_t k_priv[CRYPTO_SECRETKEYBYTES];
-        crypto_kem_keypair(k_pub, k_priv);
-
-        uint8_t v_pub[CRYPTO_PUBLICKEYBYTES];
-        uint8_t v_priv[CRYPTO_SECRETKEYBYTES];
-        crypto_kem_keypair(v_pub, v_priv);
-
-        uint8_t** ephemeral_pub_key_reg = malloc(n * sizeof(uint8_t*));
-        uint8_t* view_tags = malloc(n * sizeof(uint8_t));
-        for (int i = 0; i < n; ++i) {
-            ephemeral_pub_key_reg[i] = malloc(CRYPTO_CIPHERTEXTBYTES);
-        }
-
-        for (int i = 0; i < n; ++i) {
-            uint8_t temp_pub[CRYPTO_PUBLICKEYBYTES];
-            uint8_t temp_priv[CRYPTO_SECRETKEYBYTES];
-            crypto_kem_keypair(temp_pub, temp_priv);
-
-            uint8_t ss[CRYPTO_BYTES];
-            crypto_kem_enc(ephemeral_pub_key_reg[i], ss, temp_pub);
+    corpus_params params = { .kyber_k = KYBER_K, .n = n, .match_rate = 0 };
+    char path[256];
+    corpus_default_path(path, sizeof(path), CORPUS_DIR, &params);
 
-            view_tags[i] = calculate_view_tag(ss);
-        }
+    corpus c;
+    if (corpus_load_or_generate(&c, path, &params) != 0) {
+        fprintf(stderr, "could not load or generate %s\n", path);
+        return;
+    }
 
+    if (pc != NULL) perf_counters_start(pc);
+    for (int trial = 0; trial < m; ++trial) {
         clock_gettime(CLOCK_REALTIME, &start);
 
         for (int i = 0; i < n; ++i) {
             uint8_t ss[CRYPTO_BYTES];
             uint8_t stealth_pub_key[STEALTH_ADDRESS_BYTES];
 
-            crypto_kem_dec(ss, ephemeral_pub_key_reg[i], v_priv);
+            sap_kem_dec(ss, corpus_ct(&c, i), c.v_priv);
             uint8_t tag = calculate_view_tag(ss);
 
-            if (tag == view_tags[i]) {
-                calculate_stealth_pub_key(stealth_pub_key, ss, k_pub);
+            if (tag == corpus_tag(&c, i)[0]) {
+                calculate_stealth_pub_key(stealth_pub_key, ss, c.k_pub);
             }
         }
 
         clock_gettime(CLOCK_REALTIME, &end);
         __uint128_t elapsed_ns = calculate_elapsed_time(start, end);
         total_ns += elapsed_ns;
-
-        for (int i = 0; i < n; ++i) free(ephemeral_pub_key_reg[i]);
-        free(ephemeral_pub_key_reg);
-        free(view_tags);
     }
+    if (pc != NULL) perf_counters_stop(pc);
+
+    corpus_free(&c);
 
     double avg_ms = (double)total_ns / m / 1e6;
     printf("N = %d, Avg time = %.3f ms\n", n, avg_ms);
+    if (pc != NULL) perf_counters_print(pc, (double)n * m, "announcement");
 }
 
-int main() {
+/**
+ * @brief Runs the scan benchmark; `-p` adds hardware counters per announcement
+ * (cycles, instructions, L1d and LLC misses, branch misses) from perf_event_open().
+ */
+int main(int argc, char** argv) {
     int ns[] = {5000, 10000, 20000, 40000, 80000};
     int len = sizeof(ns) / sizeof(ns[0]);
 
+    perf_counters counters, *pc = NULL;
+    if (argc > 1 && strcmp(argv[1], "-p") == 0) {
+        if (perf_counters_open(&counters) > 0) {
+            pc = &counters;
+        } else {
+            fprintf(stderr, "hardware counters are not available (see /proc/sys/kernel/perf_event_paranoid)\n");
+        }
+    }
+
     for (int i = 0; i < len; ++i) {
-        run(ns[i], M_TRIALS);
+        run(ns[i], M_TRIALS, pc);
     }
+    if (pc != NULL) perf_counters_close(pc);
     
     /*  N = 5000, Avg time = 72.737 ms
         N = 10000, Avg time = 134.340 ms
@@ -0,0 +1,94 @@
+#include "protocol_api.h"
+#include "corpus.h"
+#include "numa_scan.h"
+#include "tune.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <stdint.h>
+
+#define M_TRIALS 5
+#define CORPUS_DIR "bench/corpus"
+
+static const char* page_kind(int pages)
+{
+    return pages == SAP_NUMA_PAGES_HUGETLB ? "hugetlb" : pages == SAP_NUMA_PAGES_THP ? "thp" : "4k";
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+/// Scans the corpus @p m times with the given scanner flags and threads and prints the throughput.
+static void run(const corpus* c, const uint8_t* const* cts, const uint8_t* view_tags, int flags, const char* name,
+    unsigned int threads, int m)
+{
+    sap_numa_scanner s;
+    uint64_t start = now_ns();
+    if (sap_numa_scanner_init(&s, cts, view_tags, c->n, c->v_priv, flags) != 0) {
+        fprintf(stderr, "could not prepare the %s scanner\n", name);
+        return;
+    }
+    uint64_t setup_ns = now_ns() - start;
+
+    uint8_t* hits = malloc(c->n);
+    uint64_t total_ns = 0;
+    size_t found = 0;
+    for (int trial = 0; trial < m; ++trial) {
+        start = now_ns();
+        found = sap_numa_scanner_scan(&s, hits, NULL, threads);
+        total_ns += now_ns() - start;
+    }
+
+    double avg_ms = (double)total_ns / m / 1e6;
+    printf(" %-12s shards = %u (%s), setup = %.1f ms, scan = %.3f ms, %.0f announcements/s, %zu view-tag hits\n",
+        name, s.n_shards, page_kind(s.shards[0].mem.pages), setup_ns / 1e6, avg_ms, c->n / (avg_ms / 1e3), found);
+    free(hits);
+    sap_numa_scanner_free(&s);
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 80000;
+
+    corpus_params params = { .kyber_k = KYBER_K, .n = n, .match_rate = 1.0 / n };
+    char path[256];
+    corpus_default_path(path, sizeof(path), CORPUS_DIR, &params);
+
+    corpus c;
+    if (corpus_load_or_generate(&c, path, &params) != 0) {
+        fprintf(stderr, "could not load or generate %s\n", path);
+        return 1;
+    }
+
+    const uint8_t** cts = malloc(c.n * sizeof(*cts));
+    uint8_t* view_tags = malloc(c.n);
+    for (size_t i = 0; i < c.n; i++) {
+        cts[i] = corpus_ct(&c, i);
+        view_tags[i] = corpus_tag(&c, i)[0];
+    }
+
+    sap_numa_topology topology;
+    sap_numa_topology_read(&topology);
+    printf("NUMA scan, N = %d, %u node(s):", n, topology.n_nodes);
+    for (unsigned int i = 0; i < topology.n_nodes; i++) {
+        printf(" node%d/%u cpus", topology.nodes[i].id, topology.nodes[i].n_cpus);
+    }
+    /* the tuned thread count if sap_tune has run on this machine, otherwise every CPU */
+    sap_tune_profile profiles[3];
+    sap_tune_startup(profiles, 0);
+    unsigned int threads = profiles[KYBER_K - 2].threads;
+    printf(", %s threads\n", threads > 0 ? "tuned" : "all");
+
+    run(&c, cts, view_tags, 0, "unaware", threads, M_TRIALS);
+    run(&c, cts, view_tags, SAP_NUMA_HUGE, "huge", threads, M_TRIALS);
+    run(&c, cts, view_tags, SAP_NUMA_SHARDS, "shards", threads, M_TRIALS);
+    run(&c, cts, view_tags, SAP_NUMA_SHARDS | SAP_NUMA_HUGE, "shards+huge", threads, M_TRIALS);
+
+    free(cts);
+    free(view_tags);
+    corpus_free(&c);
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "cpucycles.h"
+#include "protocol_api.h"
+#include "randombytes.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define N_TRIALS 31
+#define N_CALLS 200
+#define HASH_LONG_BYTES 1024
+#define VIEW_TAG_BATCH 8
+
+static const char* const backend_names[SAP_BACKEND_COUNT] = { "ref", "avx2", "avx512" };
+
+/**
+ * Prints one result row: median and MAD of cycles per call over all trials for
+ * every backend, and the median cost per byte of the fastest backend when the
+ * primitive hashes @p bytes bytes. Backends the CPU cannot run print n/a.
+ */
+static void report(const char* name, double samples[SAP_BACKEND_COUNT][N_TRIALS], size_t bytes)
+{
+    double best = 0;
+
+    printf("%-36s", name);
+    for (int b = 0; b < SAP_BACKEND_COUNT; b++) {
+        if (!sap_backend_supported((sap_backend_id)b)) {
+            printf(" %10s %7s", "n/a", "");
+            continue;
+        }
+        double med = median(samples[b], N_TRIALS);
+        double mad = median_abs_dev(samples[b], N_TRIALS, med);
+        if (best == 0 || med < best) best = med;
+        printf(" %10.0f %7.0f", med, mad);
+    }
+    if (bytes) printf(" %9.2f", best / bytes);
+    printf("\n");
+}
+
+/**
+ * Times CALL on every supported backend (bound to `be`) in N_TRIALS trials of
+ * N_CALLS back-to-back calls each, after one untimed warm-up trial, and reports
+ * cycles per call.
+ */
+#define BENCH(NAME, BYTES, CALL)                                            \
+    do {                                                                    \
+        double samples[SAP_BACKEND_COUNT][N_TRIALS];                        \
+        for (int b = 0; b < SAP_BACKEND_COUNT; b++) {                       \
+            if (!sap_backend_supported((sap_backend_id)b)) continue;        \
+            const sap_backend* be = sap_backend_get((sap_backend_id)b);     \
+            for (int c = 0; c < N_CALLS; c++) { CALL; }                     \
+            for (int t = 0; t < N_TRIALS; t++) {                            \
+                uint64_t t0 = cpucycles();                                  \
+                for (int c = 0; c < N_CALLS; c++) { CALL; }                 \
+                samples[b][t] = (double)(cpucycles() - t0) / N_CALLS;       \
+            }                                                               \
+        }                                                                   \
+        report(NAME, samples, BYTES);                                       \
+    } while (0)
+
+int main(int argc, char** argv)
+{
+    int cpu = argc > 1 ? atoi(argv[1]) : 0;
+    pin_cpu(cpu);
+
+    uint8_t k_pub[CRYPTO_PUBLICKEYBYTES];
+    uint8_t k_priv[CRYPTO_SECRETKEYBYTES];
+    sap_kem_keypair(k_pub, k_priv);
+
+    uint8_t ss[VIEW_TAG_BATCH * SS_BYTES];
+    randombytes(ss, sizeof(ss));
+
+    uint8_t ct[CRYPTO_CIPHERTEXTBYTES];
+    uint8_t ss_enc[SS_BYTES];
+    sap_kem_enc(ct, ss_enc, k_pub);
+
+    static int16_t a[KYBER_K * KYBER_K * KYBER_N] __attribute__((aligned(64)));
+    static int16_t s[KYBER_K * KYBER_N] __attribute__((aligned(64)));
+    static int16_t r[KYBER_N] __attribute__((aligned(64)));
+    static int16_t pkpv[KYBER_K * KYBER_N] __attribute__((aligned(64)));
+    const uint8_t* seed = k_pub + KYBER_POLYVECBYTES;
+    uint8_t unpacked_seed[KYBER_SYMBYTES];
+    uint8_t packed[KYBER_POLYVECBYTES];
+
+    uint8_t in[4 * HASH_LONG_BYTES];
+    uint8_t out[VIEW_TAG_BATCH * HASH_LONG_BYTES];
+    randombytes(in, sizeof(in));
+    const uint8_t* in4[4] = { in, in + HASH_LONG_BYTES, in + 2 * HASH_LONG_BYTES, in + 3 * HASH_LONG_BYTES };
+    uint8_t* out4[4] = { out, out + HASH_LONG_BYTES, out + 2 * HASH_LONG_BYTES, out + 3 * HASH_LONG_BYTES };
+
+    /* Inputs of the NTT-domain kernels; the coefficient order differs between
+     * backends, which does not matter for timing */
+    const sap_backend* active = sap_backend_active();
+    active->gen_matrix(a, seed, 0);
+    for (int i = 0; i < KYBER_K; i++) {
+        active->poly_getnoise_eta1(s + i * KYBER_N, ss, i);
+    }
+
+    printf("%s (KYBER_K = %d), CPU %d, %d trials x %d calls, active backend %s\n",
+        CRYPTO_ALGNAME, KYBER_K, cpu, N_TRIALS, N_CALLS, active->name);
+    printf("%-36s", "primitive (cycles/call, MAD)");
+    for (int b = 0; b < SAP_BACKEND_COUNT; b++) printf(" %10s %7s", backend_names[b], "MAD");
+    printf(" %9s\n", "cycles/B");
+
+    BENCH("gen_matrix", 0, be->gen_matrix(a, seed, 0));
+    BENCH("unpack_pk", 0, be->unpack_pk(pkpv, unpacked_seed, k_pub));
+    BENCH("poly_getnoise_eta1", 0, be->poly_getnoise_eta1(r, ss, 0));
+    BENCH("polyvec_ntt", 0, be->polyvec_ntt(s));
+    BENCH("polyvec_invntt_tomont", 0, be->polyvec_invntt_tomont(s));
+    BENCH("polyvec_basemul_acc_montgomery", 0, be->polyvec_basemul_acc_montgomery(r, a, s));
+    BENCH("polyvec_tobytes", 0, be->polyvec_tobytes(packed, pkpv));
+    BENCH("shake128 (32 B in, 32 B out)", SS_BYTES,
+        be->hash_shake128(out, 32, in, SS_BYTES));
+    BENCH("shake128 (1024 B in, 32 B out)", HASH_LONG_BYTES,
+        be->hash_shake128(out, 32, in, HASH_LONG_BYTES));
+    BENCH("shake128 (32 B in, 1024 B out)", HASH_LONG_BYTES,
+        be->hash_shake128(out, HASH_LONG_BYTES, in, SS_BYTES));
+    BENCH("shake128x4 (4x32 B in, 4x32 B out)", 4 * SS_BYTES,
+        be->hash_shake128x4(out4, 32, in4, SS_BYTES));
+    BENCH("shake128x4 (4x1024 B in, 4x32 B out)", 4 * HASH_LONG_BYTES,
+        be->hash_shake128x4(out4, 32, in4, HASH_LONG_BYTES));
+    BENCH("view-tag hash (8x32 B in, 8x32 B out)", VIEW_TAG_BATCH * SS_BYTES,
+        be->hash_ss_batch(out, ss, VIEW_TAG_BATCH));
+    BENCH("kem_enc", 0, be->kem_enc(ct, ss_enc, k_pub));
+    BENCH("kem_dec", 0, be->kem_dec(ss_enc, ct, k_priv));
+    BENCH("stealth_pub_key", 0, be->stealth_pub_key(packed, ss, k_pub));
+
+    return 0;
+}
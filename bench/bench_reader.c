@@ -0,0 +1,120 @@
+#include "protocol_api.h"
+#include "corpus.h"
+#include "reader.h"
+#include "scan.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define M_TRIALS 3
+#define CORPUS_DIR "bench/corpus"
+
+static uint64_t now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+/// Drops the register from the page cache, so that every trial reads it from the device.
+static void drop_cache(const char* path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+/// The current path: load the whole register, then scan it.
+static double run_load(const char* path, const sap_scan_key* key, size_t* found)
+{
+    uint64_t start = now_ns();
+    corpus c;
+    if (corpus_load(&c, path) != 0) {
+        return -1;
+    }
+    const uint8_t** cts = malloc(c.n * sizeof(*cts));
+    uint8_t* view_tags = malloc(c.n);
+    uint8_t* hits = malloc(c.n);
+    for (size_t i = 0; i < c.n; i++) {
+        cts[i] = corpus_ct(&c, i);
+        view_tags[i] = corpus_tag(&c, i)[0];
+    }
+    *found = sap_scan(hits, NULL, cts, view_tags, c.n, key);
+    double ms = (now_ns() - start) / 1e6;
+    free(cts);
+    free(view_tags);
+    free(hits);
+    corpus_free(&c);
+    return ms;
+}
+
+/// Streams the register with the reader and scans every batch as it arrives.
+static double run_reader(const char* path, const sap_scan_key* key, int flags, unsigned int depth, size_t* found,
+    sap_reader_stats* stats)
+{
+    uint64_t start = now_ns();
+    sap_reader_config config = { .path = path, .queue_depth = depth, .flags = flags };
+    sap_reader* r = sap_reader_open(&config);
+    if (r == NULL) {
+        return -1;
+    }
+    uint8_t hits[1 << 11];
+    sap_reader_batch b;
+    *found = 0;
+    while (sap_reader_next(r, &b) == 1) {
+        *found += sap_scan(hits, NULL, b.cts, b.view_tags, b.n, key);
+        sap_reader_release(r, &b);
+    }
+    sap_reader_get_stats(r, stats);
+    sap_reader_close(r);
+    return (now_ns() - start) / 1e6;
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 80000;
+    corpus_params params = { .kyber_k = KYBER_K, .n = n, .match_rate = 1.0 / n };
+    char path[256];
+    corpus_default_path(path, sizeof(path), CORPUS_DIR, &params);
+
+    corpus c;
+    if (corpus_load_or_generate(&c, path, &params) != 0) {
+        fprintf(stderr, "could not load or generate %s\n", path);
+        return 1;
+    }
+    sap_scan_key key;
+    sap_scan_key_init(&key, c.v_priv);
+    corpus_free(&c);
+
+    printf("Cold register scan, N = %d (%s)\n", n, path);
+    double total = 0;
+    size_t found = 0;
+    for (int t = 0; t < M_TRIALS; t++) {
+        drop_cache(path);
+        total += run_load(path, &key, &found);
+    }
+    printf(" %-22s %9.3f ms, %zu hits\n", "corpus_load + scan", total / M_TRIALS, found);
+
+    static const struct { const char* name; int flags; unsigned int depth; } modes[] = {
+        { "pread, depth 1", SAP_READER_NO_URING, 1 },
+        { "pread, depth 8", SAP_READER_NO_URING, 8 },
+        { "io_uring, depth 8", 0, 8 },
+        { "io_uring, depth 32", 0, 32 },
+    };
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        sap_reader_stats stats = { 0 };
+        total = 0;
+        for (int t = 0; t < M_TRIALS; t++) {
+            drop_cache(path);
+            total += run_reader(path, &key, modes[m].flags, modes[m].depth, &found, &stats);
+        }
+        printf(" %-22s %9.3f ms, %zu hits (%s%s%s, %llu reads)\n", modes[m].name, total / M_TRIALS, found,
+            stats.uring ? "io_uring" : "pread", stats.direct ? ", O_DIRECT" : "",
+            stats.registered ? ", registered buffers" : "", (unsigned long long)stats.reads);
+    }
+    return 0;
+}
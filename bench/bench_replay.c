@@ -0,0 +1,407 @@
+#include "protocol_api.h"
+#include "corpus.h"
+#include "ingest.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdint.h>
+
+#define CORPUS_DIR "bench/corpus"
+#define DEFAULT_WORKLOAD "bench/workloads/mixed.wl"
+#define INGEST_CAPACITY 4096
+
+/**
+ * Workload description, read from a text file of `key = value` lines.
+ * Lines starting with '#' are comments.
+ */
+typedef struct {
+    double send_rate;           /**< Mean payments per second outside bursts. */
+    double burst_multiplier;    /**< Arrival rate multiplier during a burst. */
+    double burst_period_ms;     /**< Length of one burst cycle. */
+    double burst_duty;          /**< Fraction of each cycle spent in a burst. */
+    int recipients;             /**< Number of distinct recipients payments go to. */
+    double popularity_skew;     /**< Zipf exponent of recipient popularity (0 = uniform). */
+    int initial_register;       /**< Announcements in the register before replay starts. */
+    int register_growth;        /**< Whether sent announcements are appended to the register. */
+    int duration_ms;            /**< Length of each replay phase. */
+    int sender_threads;         /**< Threads driving the sender path. */
+    int scanner_threads;        /**< Threads continuously scanning the register. */
+} workload;
+
+/**
+ * Register shared by senders (appending) and scanners (reading). Senders push
+ * into the lock-free ingestion ring; the ingest thread is the only writer of the
+ * register. Slots below `count` are fully written; announcements that find the
+ * ring full or arrive beyond `capacity` are dropped.
+ */
+typedef struct {
+    uint8_t* ephemeral_pub_keys;
+    uint8_t* view_tags;
+    size_t capacity;
+    _Atomic size_t count;
+    sap_ingest_ring ring;
+} shared_register;
+
+typedef struct {
+    uint8_t (*k_pub)[CRYPTO_PUBLICKEYBYTES];
+    uint8_t (*v_pub)[CRYPTO_PUBLICKEYBYTES];
+    double* popularity_cdf;
+} recipient_set;
+
+typedef struct {
+    const workload* w;
+    shared_register* reg;
+    const recipient_set* rs;
+    const corpus* wallet;
+    struct timespec start;
+    _Atomic int* stop;
+    unsigned int seed;
+    double* latencies_us;
+    size_t n_latencies, cap_latencies;
+    size_t scanned, matches;
+} replay_thread;
+
+static double elapsed_ms(struct timespec start, struct timespec now)
+{
+    return (now.tv_sec - start.tv_sec) * 1e3 + (now.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+static double uniform01(unsigned int* seed)
+{
+    return (rand_r(seed) + 1.0) / ((double)RAND_MAX + 2.0);
+}
+
+static int parse_workload(workload* w, const char* path)
+{
+    *w = (workload){ .send_rate = 500, .burst_multiplier = 4, .burst_period_ms = 1000,
+        .burst_duty = 0.2, .recipients = 256, .popularity_skew = 1.0, .initial_register = 10000,
+        .register_growth = 1, .duration_ms = 3000, .sender_threads = 2, .scanner_threads = 1 };
+
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+
+    char line[256], key[64];
+    double value;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || sscanf(line, " %63[a-z_] = %lf", key, &value) != 2) continue;
+
+        if (!strcmp(key, "send_rate")) w->send_rate = value;
+        else if (!strcmp(key, "burst_multiplier")) w->burst_multiplier = value;
+        else if (!strcmp(key, "burst_period_ms")) w->burst_period_ms = value;
+        else if (!strcmp(key, "burst_duty")) w->burst_duty = value;
+        else if (!strcmp(key, "recipients")) w->recipients = (int)value;
+        else if (!strcmp(key, "popularity_skew")) w->popularity_skew = value;
+        else if (!strcmp(key, "initial_register")) w->initial_register = (int)value;
+        else if (!strcmp(key, "register_growth")) w->register_growth = (int)value;
+        else if (!strcmp(key, "duration_ms")) w->duration_ms = (int)value;
+        else if (!strcmp(key, "sender_threads")) w->sender_threads = (int)value;
+        else if (!strcmp(key, "scanner_threads")) w->scanner_threads = (int)value;
+        else fprintf(stderr, "warning: unknown workload key '%s'\n", key);
+    }
+    fclose(f);
+
+    if (w->recipients < 1) w->recipients = 1;
+    if (w->sender_threads < 1) w->sender_threads = 1;
+    return 0;
+}
+
+/**
+ * Current arrival rate: send_rate, multiplied by burst_multiplier during the
+ * first burst_duty fraction of every burst period.
+ */
+static double arrival_rate(const workload* w, double t_ms)
+{
+    double phase = fmod(t_ms, w->burst_period_ms) / w->burst_period_ms;
+    return phase < w->burst_duty ? w->send_rate * w->burst_multiplier : w->send_rate;
+}
+
+static int pick_recipient(const recipient_set* rs, int n, unsigned int* seed)
+{
+    double u = uniform01(seed);
+    int lo = 0, hi = n - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (rs->popularity_cdf[mid] < u) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static void register_append(shared_register* reg, const uint8_t* ct, uint8_t tag)
+{
+    sap_ingest_push(&reg->ring, ct, tag);
+}
+
+/**
+ * Workflow:
+ *  1. Draws Poisson arrivals at this thread's share of the current arrival rate.
+ *  2. Waits for the scheduled arrival, picks a recipient by popularity and runs
+ *     the sender path (encapsulation, stealth public key, view tag).
+ *  3. Queues the announcement for the register and records the latency from the
+ *     scheduled arrival to completion, so queueing behind slow sends is included.
+ */
+static void* sender_thread(void* arg)
+{
+    replay_thread* t = arg;
+    const workload* w = t->w;
+    double next_ms = 0;
+
+    while (!atomic_load(t->stop)) {
+        double rate = arrival_rate(w, next_ms) / w->sender_threads;
+        next_ms += -log(uniform01(&t->seed)) * 1e3 / rate;
+        if (next_ms >= w->duration_ms) break;
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double wait_ms = next_ms - elapsed_ms(t->start, now);
+        if (wait_ms > 0) {
+            struct timespec ts = { (time_t)(wait_ms / 1e3), (long)(fmod(wait_ms, 1e3) * 1e6) };
+            nanosleep(&ts, NULL);
+        }
+
+        int r = pick_recipient(t->rs, w->recipients, &t->seed);
+        uint8_t ct[CRYPTO_CIPHERTEXTBYTES];
+        uint8_t ss[CRYPTO_BYTES];
+        uint8_t stealth_pub_key[STEALTH_ADDRESS_BYTES];
+
+        sap_kem_enc(ct, ss, t->rs->v_pub[r]);
+        calculate_stealth_pub_key(stealth_pub_key, ss, t->rs->k_pub[r]);
+        uint8_t view_tag = calculate_view_tag(ss);
+
+        if (w->register_growth) {
+            register_append(t->reg, ct, view_tag);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (t->n_latencies == t->cap_latencies) {
+            t->cap_latencies = t->cap_latencies ? 2 * t->cap_latencies : 1024;
+            t->latencies_us = realloc(t->latencies_us, t->cap_latencies * sizeof(double));
+        }
+        t->latencies_us[t->n_latencies++] = (elapsed_ms(t->start, now) - next_ms) * 1e3;
+    }
+    return NULL;
+}
+
+/**
+ * Workflow:
+ *  1. Waits until at least one announcement is published.
+ *  2. Repeatedly walks the register from the start to the currently published end.
+ *  3. Decapsulates every announcement with the wallet's view key, compares view
+ *     tags and derives the stealth public key on a hit.
+ */
+static void* scanner_thread(void* arg)
+{
+    replay_thread* t = arg;
+    size_t i = 0;
+
+    while (!atomic_load(t->stop)) {
+        size_t end = atomic_load_explicit(&t->reg->count, memory_order_acquire);
+        if (end == 0) {
+            struct timespec ts = { 0, 100000 };
+            nanosleep(&ts, NULL);
+            continue;
+        }
+        if (i >= end) i = 0;
+
+        uint8_t ss[CRYPTO_BYTES];
+        uint8_t stealth_pub_key[STEALTH_ADDRESS_BYTES];
+        sap_kem_dec(ss, t->reg->ephemeral_pub_keys + i * CRYPTO_CIPHERTEXTBYTES, t->wallet->v_priv);
+        if (calculate_view_tag(ss) == t->reg->view_tags[i]) {
+            calculate_stealth_pub_key(stealth_pub_key, ss, t->wallet->k_pub);
+            t->matches++;
+        }
+        t->scanned++;
+        i++;
+    }
+    return NULL;
+}
+
+/**
+ * Workflow:
+ *  1. Takes the announcements the senders published in the ingestion ring.
+ *  2. Scans them for the wallet as they arrive (live payment detection).
+ *  3. Appends them to the register, which only this thread writes, and publishes
+ *     the new end; once the senders are done, drains the ring and exits.
+ */
+static void* ingest_thread(void* arg)
+{
+    replay_thread* t = arg;
+    shared_register* reg = t->reg;
+    sap_scan_key key;
+    sap_scan_key_init(&key, t->wallet->v_priv);
+
+    for (;;) {
+        int stopping = atomic_load(t->stop);
+        const uint8_t* cts[SAP_INGEST_BATCH];
+        uint8_t tags[SAP_INGEST_BATCH], hits[SAP_INGEST_BATCH];
+        size_t n = sap_ingest_peek(&reg->ring, cts, tags, SAP_INGEST_BATCH);
+        if (n == 0) {
+            if (stopping) break;
+            struct timespec ts = { 0, 50000 };
+            nanosleep(&ts, NULL);
+            continue;
+        }
+
+        t->matches += sap_scan(hits, NULL, cts, tags, n, &key);
+        t->scanned += n;
+
+        size_t end = atomic_load_explicit(&reg->count, memory_order_relaxed);
+        for (size_t j = 0; j < n && end < reg->capacity; j++, end++) {
+            memcpy(reg->ephemeral_pub_keys + end * CRYPTO_CIPHERTEXTBYTES, cts[j], CRYPTO_CIPHERTEXTBYTES);
+            reg->view_tags[end] = tags[j];
+        }
+        sap_ingest_release(&reg->ring, n);
+        atomic_store_explicit(&reg->count, end, memory_order_release);
+    }
+    return NULL;
+}
+
+static int cmp_double(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double* sorted, size_t n, double p)
+{
+    if (n == 0) return 0;
+    size_t i = (size_t)(p / 100.0 * (n - 1) + 0.5);
+    return sorted[i];
+}
+
+/**
+ * Runs one replay phase with @p scanners scanner threads next to the senders
+ * and prints send throughput, sender latency percentiles and scan throughput.
+ */
+static void run_phase(const workload* w, const corpus* wallet, const recipient_set* rs, int scanners)
+{
+    shared_register reg;
+    size_t expected_sends = (size_t)(w->send_rate * w->burst_multiplier * w->duration_ms / 1e3);
+    reg.capacity = w->initial_register + 2 * expected_sends + 1024;
+    reg.ephemeral_pub_keys = malloc(reg.capacity * CRYPTO_CIPHERTEXTBYTES);
+    reg.view_tags = malloc(reg.capacity);
+    sap_ingest_init(&reg.ring, INGEST_CAPACITY);
+
+    memcpy(reg.ephemeral_pub_keys, wallet->ephemeral_pub_keys, wallet->n * CRYPTO_CIPHERTEXTBYTES);
+    for (size_t i = 0; i < wallet->n; i++) reg.view_tags[i] = corpus_tag(wallet, i)[0];
+    atomic_init(&reg.count, wallet->n);
+
+    _Atomic int stop = 0;
+    int ingest = w->register_growth ? 1 : 0;
+    int n_threads = w->sender_threads + scanners + ingest;
+    replay_thread* threads = calloc(n_threads, sizeof(replay_thread));
+    pthread_t* tids = malloc(n_threads * sizeof(pthread_t));
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < n_threads; i++) {
+        threads[i] = (replay_thread){ .w = w, .reg = &reg, .rs = rs, .wallet = wallet,
+            .start = start, .stop = &stop, .seed = 0x5a9u + i };
+        pthread_create(&tids[i], NULL, i < w->sender_threads ? sender_thread
+            : i < w->sender_threads + scanners ? scanner_thread : ingest_thread, &threads[i]);
+    }
+
+    for (int i = 0; i < w->sender_threads; i++) pthread_join(tids[i], NULL);
+    atomic_store(&stop, 1);
+    for (int i = w->sender_threads; i < n_threads; i++) pthread_join(tids[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double wall_ms = elapsed_ms(start, end);
+
+    size_t sends = 0, scanned = 0, matches = 0;
+    for (int i = 0; i < n_threads - ingest; i++) {
+        sends += threads[i].n_latencies;
+        scanned += threads[i].scanned;
+        matches += threads[i].matches;
+    }
+    double* lat = malloc((sends + 1) * sizeof(double));
+    size_t k = 0;
+    for (int i = 0; i < w->sender_threads; i++) {
+        memcpy(lat + k, threads[i].latencies_us, threads[i].n_latencies * sizeof(double));
+        k += threads[i].n_latencies;
+        free(threads[i].latencies_us);
+    }
+    qsort(lat, sends, sizeof(double), cmp_double);
+
+    printf("scanners = %d: sends = %zu (%.0f/s), scanned = %zu (%.0f/s, %zu tag hits), register = %zu\n",
+        scanners, sends, sends / (wall_ms / 1e3), scanned, scanned / (wall_ms / 1e3), matches,
+        atomic_load(&reg.count));
+    printf("  sender latency us: p50 = %.0f, p90 = %.0f, p99 = %.0f, p99.9 = %.0f, max = %.0f\n",
+        percentile(lat, sends, 50), percentile(lat, sends, 90), percentile(lat, sends, 99),
+        percentile(lat, sends, 99.9), sends ? lat[sends - 1] : 0);
+    if (ingest) {
+        printf("  ingest: %zu announcements scanned on arrival (%zu tag hits), %zu rejected by the full ring\n",
+            threads[n_threads - 1].scanned, threads[n_threads - 1].matches,
+            atomic_load(&reg.ring.rejected));
+    }
+
+    free(lat);
+    free(threads);
+    free(tids);
+    free(reg.ephemeral_pub_keys);
+    free(reg.view_tags);
+    sap_ingest_free(&reg.ring);
+}
+
+/**
+ * @brief Replays a workload that mixes bursts of payments with continuous scanning.
+ *
+ * The workload file (default bench/workloads/mixed.wl) gives arrival rates, burst
+ * shape, recipient popularity and register growth. The driver runs the workload
+ * once without scanners as a baseline and once with the configured scanner
+ * threads, so that interference between the sender and recipient paths shows up
+ * as a shift in sender latency percentiles.
+ */
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : DEFAULT_WORKLOAD;
+    workload w;
+    if (parse_workload(&w, path) != 0) {
+        fprintf(stderr, "could not read workload %s\n", path);
+        return 1;
+    }
+
+    corpus_params params = { .kyber_k = KYBER_K, .n = w.initial_register, .match_rate = 0.001 };
+    char corpus_path[256];
+    corpus_default_path(corpus_path, sizeof(corpus_path), CORPUS_DIR, &params);
+
+    corpus wallet;
+    if (corpus_load_or_generate(&wallet, corpus_path, &params) != 0) {
+        fprintf(stderr, "could not load or generate %s\n", corpus_path);
+        return 1;
+    }
+
+    recipient_set rs;
+    rs.k_pub = malloc(w.recipients * sizeof(*rs.k_pub));
+    rs.v_pub = malloc(w.recipients * sizeof(*rs.v_pub));
+    rs.popularity_cdf = malloc(w.recipients * sizeof(double));
+
+    double total = 0;
+    for (int r = 0; r < w.recipients; r++) {
+        uint8_t sk[CRYPTO_SECRETKEYBYTES];
+        sap_kem_keypair(rs.k_pub[r], sk);
+        sap_kem_keypair(rs.v_pub[r], sk);
+        total += 1.0 / pow(r + 1, w.popularity_skew);
+        rs.popularity_cdf[r] = total;
+    }
+    for (int r = 0; r < w.recipients; r++) rs.popularity_cdf[r] /= total;
+
+    printf("%s: %s, %.0f sends/s (x%.1f bursts), %d recipients (skew %.2f), %d ms, %d senders\n",
+        path, CRYPTO_ALGNAME, w.send_rate, w.burst_multiplier, w.recipients, w.popularity_skew,
+        w.duration_ms, w.sender_threads);
+
+    run_phase(&w, &wallet, &rs, 0);
+    if (w.scanner_threads > 0) {
+        run_phase(&w, &wallet, &rs, w.scanner_threads);
+    }
+
+    free(rs.k_pub);
+    free(rs.v_pub);
+    free(rs.popularity_cdf);
+    corpus_free(&wallet);
+    return 0;
+}
@@ -1,4 +1,6 @@
 #include "protocol_api.h"
+#include "corpus.h"
+#include "scan.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,6 +8,7 @@
 #include <stdint.h>
 
 #define M_TRIALS 10
+#define CORPUS_DIR "bench/corpus"
 
 __uint128_t calculate_elapsed_time(struct timespec start, struct timespec end) {
     // Convert to nanoseconds
@@ -40,45 +43,33 @@ void shuffle_registers(uint8_t** epkr, uint8_t** view_tags, int n) {
 
 void run(int n, int m) {
     struct timespec start, end;
-    __uint128_t total_ns = 0;
+    __uint128_t total_ns = 0, batch_ns = 0;
 
-    for (int trial = 0; trial < m; ++trial) {
-        // Receiver keypair
-        uint8_t k_pub[CRYPTO_PUBLICKEYBYTES];
-        uint8_t k_priv[CRYPTO_SECRETKEYBYTES];
-        crypto_kem_keypair(k_pub, k_priv);
-
-        uint8_t v_pub[CRYPTO_PUBLICKEYBYTES];
-        uint8_t v_priv[CRYPTO_SECRETKEYBYTES];
-        crypto_kem_keypair(v_pub, v_priv);
-
-        uint8_t** ephemeral_pub_key_reg = malloc(n * sizeof(uint8_t*));
-        // uint8_t* view_tags = malloc(n * sizeof(uint8_t));
-        // uint8_t* view_tags = malloc(n * 32 * sizeof(uint8_t));
-        uint8_t** view_tags = malloc(n * sizeof(uint8_t*));
-        for (int i = 0; i < n; ++i) {
-            ephemeral_pub_key_reg[i] = malloc(CRYPTO_CIPHERTEXTBYTES);
-        }
+    // Exactly one announcement is addressed to the recipient
+    corpus_params params = { .kyber_k = KYBER_K, .n = n, .match_rate = 1.0 / n };
+    char path[256];
+    corpus_default_path(path, sizeof(path), CORPUS_DIR, &params);
 
-        for (int i = 0; i < n-1; ++i) {
-            uint8_t temp_pub[CRYPTO_PUBLICKEYBYTES];
-            uint8_t temp_priv[CRYPTO_SECRETKEYBYTES];
-            crypto_kem_keypair(temp_pub, temp_priv);
+    corpus c;
+    if (corpus_load_or_generate(&c, path, &params) != 0) {
+        fprintf(stderr, "could not load or generate %s\n", path);
+        return;
+    }
 
-            uint8_t ss[CRYPTO_BYTES];
-            crypto_kem_enc(ephemeral_pub_key_reg[i], ss, temp_pub);
+    uint8_t** ephemeral_pub_key_reg = malloc(n * sizeof(uint8_t*));
+    uint8_t** view_tags = malloc(n * sizeof(uint8_t*));
+    uint8_t* first_bytes = malloc(n);
+    uint8_t* hits = malloc(n);
+    uint8_t* secrets = malloc((size_t)n * CRYPTO_BYTES);
+    sap_scan_key key;
+    sap_scan_key_init(&key, c.v_priv);
 
-            // view_tags[i] = calculate_view_tag(ss);
-            // shake128(view_tags+32*i, 32, ss, KYBER_SSBYTES);
-            view_tags[i] = calculate_ss_hash(ss);
+    for (int trial = 0; trial < m; ++trial) {
+        for (int i = 0; i < n; ++i) {
+            ephemeral_pub_key_reg[i] = corpus_ct(&c, i);
+            view_tags[i] = corpus_tag(&c, i);
         }
 
-        uint8_t ss_sender[CRYPTO_BYTES];
-        crypto_kem_enc(ephemeral_pub_key_reg[n-1], ss_sender, v_pub);
-        // view_tags[n-1] = calculate_view_tag(ss_sender);
-        // shake128(view_tags+32*(n-1), 32, ss_sender, KYBER_SSBYTES);
-        view_tags[n-1] = calculate_ss_hash(ss_sender);
-
         shuffle_registers(ephemeral_pub_key_reg, view_tags, n);
 
         clock_gettime(CLOCK_REALTIME, &start);
@@ -87,19 +78,16 @@ void run(int n, int m) {
             uint8_t ss[CRYPTO_BYTES];
             uint8_t stealth_pub_key[STEALTH_ADDRESS_BYTES];
 
-            crypto_kem_dec(ss, ephemeral_pub_key_reg[i], v_priv);
-            // uint8_t tag = calculate_view_tag(ss);
+            sap_kem_dec(ss, ephemeral_pub_key_reg[i], c.v_priv);
             uint8_t* tag = calculate_ss_hash(ss);
 
-            // if (tag == view_tags[i]) {
-            //     calculate_stealth_pub_key(stealth_pub_key, ss, k_pub);
-            // }
             int equal=1;
             for(int j=0; j<32; j++){
                 if(tag[j] != view_tags[i][j])equal=0;
             }
+            free(tag);
             if(equal){
-                calculate_stealth_pub_key(stealth_pub_key, ss, k_pub);
+                calculate_stealth_pub_key(stealth_pub_key, ss, c.k_pub);
                 break;
             }
 
@@ -109,16 +97,36 @@ void run(int n, int m) {
         __uint128_t elapsed_ns = calculate_elapsed_time(start, end);
         total_ns += elapsed_ns;
 
+        // The same early exit with the batch scanner, over the same order
         for (int i = 0; i < n; ++i) {
-            free(ephemeral_pub_key_reg[i]);
-            free(view_tags[i]);
+            first_bytes[i] = view_tags[i][0];
         }
-        free(ephemeral_pub_key_reg);
-        free(view_tags);
+        clock_gettime(CLOCK_REALTIME, &start);
+
+        sap_scan_limits limits = { .max_hits = 1 };
+        sap_scan_cursor cursor;
+        sap_scan_cursor_init(&cursor, 0);
+        sap_scan_until(hits, secrets, (const uint8_t* const*)ephemeral_pub_key_reg, first_bytes, n, &key, &limits,
+            &cursor);
+        if (cursor.status == SAP_SCAN_HIT_LIMIT) {
+            uint8_t stealth_pub_key[STEALTH_ADDRESS_BYTES];
+            calculate_stealth_pub_key(stealth_pub_key, secrets + (cursor.next - 1) * CRYPTO_BYTES, c.k_pub);
+        }
+
+        clock_gettime(CLOCK_REALTIME, &end);
+        batch_ns += calculate_elapsed_time(start, end);
     }
 
+    free(ephemeral_pub_key_reg);
+    free(view_tags);
+    free(first_bytes);
+    free(hits);
+    free(secrets);
+    corpus_free(&c);
+
     double avg_ms = (double)total_ns / m / 1e6;
-    printf(" N = %d, Avg time = %.3f ms\n", n, avg_ms);
+    double batch_ms = (double)batch_ns / m / 1e6;
+    printf(" N = %d, Avg time = %.3f ms, batch scan to first match = %.3f ms\n", n, avg_ms, batch_ms);
 }
 
 int main() {
@@ -1,4 +1,7 @@
 #include "protocol_api.h"
+#include "corpus.h"
+#include "scan.h"
+#include "scan_mixed.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,6 +9,7 @@
 #include <stdint.h>
 
 #define M_TRIALS 10
+#define CORPUS_DIR "bench/corpus"
 
 __uint128_t calculate_elapsed_time(struct timespec start, struct timespec end) {
     // Convert to nanoseconds
@@ -42,38 +46,41 @@ void run(int n, int m, int shuffle) {
     struct timespec start, end;
     __uint128_t total_ns_1 = 0,
                 total_ns_2 = 0,
-                total_ns_3 = 0;
+                total_ns_3 = 0,
+                total_ns_4 = 0;
+
+    // Exactly one announcement is addressed to the recipient
+    corpus_params params = { .kyber_k = KYBER_K, .n = n, .match_rate = 1.0 / n };
+    char path[256];
+    corpus_default_path(path, sizeof(path), CORPUS_DIR, &params);
+
+    corpus c;
+    if (corpus_load_or_generate(&c, path, &params) != 0) {
+        fprintf(stderr, "could not load or generate %s\n", path);
+        return;
+    }
 
-    for (int trial = 0; trial < m; ++trial) {
-        // Receiver keypair
-        uint8_t k_pub[CRYPTO_PUBLICKEYBYTES];
-        uint8_t k_priv[CRYPTO_SECRETKEYBYTES];
-        crypto_kem_keypair(k_pub, k_priv);
+    uint8_t** ephemeral_pub_key_reg = malloc(n * sizeof(uint8_t*));
+    uint8_t** view_tags = malloc(n * sizeof(uint8_t*));
+    uint8_t* tag_bytes = malloc(n);
+    uint8_t* hits = malloc(n);
+    uint8_t* hit_ss = malloc((size_t)n * SS_BYTES);
 
-        uint8_t v_pub[CRYPTO_PUBLICKEYBYTES];
-        uint8_t v_priv[CRYPTO_SECRETKEYBYTES];
-        crypto_kem_keypair(v_pub, v_priv);
+    sap_scan_key key;
+    sap_scan_key_init(&key, c.v_priv);
 
-        uint8_t** ephemeral_pub_key_reg = malloc(n * sizeof(uint8_t*));
-        uint8_t** view_tags = malloc(n * sizeof(uint8_t*));
+    for (int trial = 0; trial < m; ++trial) {
         for (int i = 0; i < n; ++i) {
-            ephemeral_pub_key_reg[i] = malloc(CRYPTO_CIPHERTEXTBYTES);
+            ephemeral_pub_key_reg[i] = corpus_ct(&c, i);
+            view_tags[i] = corpus_tag(&c, i);
         }
 
-        for (int i = 0; i < n-1; ++i) {
-            uint8_t temp_pub[CRYPTO_PUBLICKEYBYTES];
-            uint8_t temp_priv[CRYPTO_SECRETKEYBYTES];
-            crypto_kem_keypair(temp_pub, temp_priv);
-
-            uint8_t ss[CRYPTO_BYTES];
-            crypto_kem_enc(ephemeral_pub_key_reg[i], ss, temp_pub);
-
-            view_tags[i] = calculate_ss_hash(ss);
-        }
-
-        uint8_t ss_sender[CRYPTO_BYTES];
-        crypto_kem_enc(ephemeral_pub_key_reg[n-1], ss_sender, v_pub);
-        view_tags[n-1] = calculate_ss_hash(ss_sender);
+        // Without shuffling, the single match is the last announcement
+        size_t match = c.matches[0];
+        ephemeral_pub_key_reg[match] = corpus_ct(&c, n - 1);
+        view_tags[match] = corpus_tag(&c, n - 1);
+        ephemeral_pub_key_reg[n - 1] = corpus_ct(&c, match);
+        view_tags[n - 1] = corpus_tag(&c, match);
 
         if(shuffle) shuffle_registers(ephemeral_pub_key_reg, view_tags, n);
 
@@ -85,8 +92,8 @@ void run(int n, int m, int shuffle) {
             uint8_t ss[CRYPTO_BYTES];
             uint8_t stealth_pub_key[STEALTH_ADDRESS_BYTES];
 
-            crypto_kem_dec(ss, ephemeral_pub_key_reg[i], v_priv);
-            calculate_stealth_pub_key(stealth_pub_key, ss, k_pub);
+            sap_kem_dec(ss, ephemeral_pub_key_reg[i], c.v_priv);
+            calculate_stealth_pub_key(stealth_pub_key, ss, c.k_pub);
         }
         clock_gettime(CLOCK_REALTIME, &end);
         elapsed_ns = calculate_elapsed_time(start, end);
@@ -98,11 +105,11 @@ void run(int n, int m, int shuffle) {
             uint8_t ss[CRYPTO_BYTES];
             uint8_t stealth_pub_key[STEALTH_ADDRESS_BYTES];
 
-            crypto_kem_dec(ss, ephemeral_pub_key_reg[i], v_priv);
+            sap_kem_dec(ss, ephemeral_pub_key_reg[i], c.v_priv);
             uint8_t tag = calculate_view_tag(ss);
 
             if(view_tags[i][0] == tag)
-                calculate_stealth_pub_key(stealth_pub_key, ss, k_pub);
+                calculate_stealth_pub_key(stealth_pub_key, ss, c.k_pub);
         }
         clock_gettime(CLOCK_REALTIME, &end);
         elapsed_ns = calculate_elapsed_time(start, end);
@@ -114,30 +121,121 @@ void run(int n, int m, int shuffle) {
             uint8_t ss[CRYPTO_BYTES];
             uint8_t stealth_pub_key[STEALTH_ADDRESS_BYTES];
 
-            crypto_kem_dec(ss, ephemeral_pub_key_reg[i], v_priv);
+            sap_kem_dec(ss, ephemeral_pub_key_reg[i], c.v_priv);
             uint8_t* tag = calculate_ss_hash(ss);
 
             int equal=1;
             for(int j=0; j<32; j++){ if(tag[j] != view_tags[i][j]) equal=0; }
-            if(equal){ calculate_stealth_pub_key(stealth_pub_key, ss, k_pub); break; }
+            free(tag);
+            if(equal){ calculate_stealth_pub_key(stealth_pub_key, ss, c.k_pub); break; }
         }
         clock_gettime(CLOCK_REALTIME, &end);
         elapsed_ns = calculate_elapsed_time(start, end);
         total_ns_3 += elapsed_ns;
 
+        //using 1B of hash view tag, SAP_SCAN_LANES announcements at a time
+        for (int i = 0; i < n; ++i) tag_bytes[i] = view_tags[i][0];
+        clock_gettime(CLOCK_REALTIME, &start);
+        sap_scan(hits, hit_ss, (const uint8_t* const*)ephemeral_pub_key_reg, tag_bytes, n, &key);
         for (int i = 0; i < n; ++i) {
-            free(ephemeral_pub_key_reg[i]);
-            free(view_tags[i]);
+            uint8_t stealth_pub_key[STEALTH_ADDRESS_BYTES];
+            if (hits[i])
+                calculate_stealth_pub_key(stealth_pub_key, hit_ss + (size_t)i * SS_BYTES, c.k_pub);
         }
-        free(ephemeral_pub_key_reg);
-        free(view_tags);
+        clock_gettime(CLOCK_REALTIME, &end);
+        elapsed_ns = calculate_elapsed_time(start, end);
+        total_ns_4 += elapsed_ns;
     }
 
+    free(ephemeral_pub_key_reg);
+    free(view_tags);
+    free(tag_bytes);
+    free(hits);
+    free(hit_ss);
+    corpus_free(&c);
+
     double avg_ms_1 = (double)total_ns_1 / m / 1e6;
     double avg_ms_2 = (double)total_ns_2 / m / 1e6;
     double avg_ms_3 = (double)total_ns_3 / m / 1e6;
-    printf("N = %5d, Avg time (No WT|1B WT|Full WT) = %8.3fms | %8.3fms | %8.3fms\n",
-                                                     n, avg_ms_1,avg_ms_2,avg_ms_3);
+    double avg_ms_4 = (double)total_ns_4 / m / 1e6;
+    printf("N = %5d, Avg time (No WT|1B WT|Full WT|1B WT x16) = %8.3fms | %8.3fms | %8.3fms | %8.3fms\n",
+                                                     n, avg_ms_1,avg_ms_2,avg_ms_3,avg_ms_4);
+}
+
+/*
+ * Scans a register mixing all three levels with sap_scan_mixed() and, for
+ * reference, the same announcements already split into one pure array per level
+ * with the per-level scanners.
+ */
+void run_mixed(int n, int m) {
+    const sap_scan_level* scan_levels[CORPUS_LEVELS] = {
+        &pqsap_kyber512_scan_level, &pqsap_kyber768_scan_level, &pqsap_kyber1024_scan_level
+    };
+    corpus_params params = { .kyber_k = CORPUS_MIXED, .n = n, .match_rate = 1.0 / n };
+    char path[256];
+    corpus_default_path(path, sizeof(path), CORPUS_DIR, &params);
+
+    corpus c;
+    if (corpus_load_or_generate(&c, path, &params) != 0) {
+        fprintf(stderr, "could not load or generate %s\n", path);
+        return;
+    }
+
+    const uint8_t** cts = malloc(n * sizeof(uint8_t*));
+    const uint8_t** sorted = malloc(n * sizeof(uint8_t*));
+    uint8_t* tags = malloc(n);
+    uint8_t* sorted_tags = malloc(n);
+    uint8_t* hits = malloc(n);
+    uint8_t* hit_ss = malloc((size_t)n * SS_BYTES);
+    size_t count[CORPUS_LEVELS] = { 0 }, begin[CORPUS_LEVELS];
+
+    for (int i = 0; i < n; ++i) {
+        cts[i] = corpus_ct(&c, i);
+        tags[i] = corpus_tag(&c, i)[0];
+        count[c.levels[i] - 2]++;
+    }
+    begin[0] = 0;
+    for (int l = 1; l < CORPUS_LEVELS; ++l) begin[l] = begin[l - 1] + count[l - 1];
+    for (int l = 0, j = 0; l < CORPUS_LEVELS; ++l) {
+        for (int i = 0; i < n; ++i) {
+            if (c.levels[i] != l + 2) continue;
+            sorted[j] = cts[i];
+            sorted_tags[j++] = tags[i];
+        }
+    }
+
+    sap_scan_keyset ks;
+    const uint8_t* v_priv[CORPUS_LEVELS] = { c.keys[0].v_priv, c.keys[1].v_priv, c.keys[2].v_priv };
+    sap_scan_keyset_init(&ks, v_priv);
+
+    struct timespec start, end;
+    __uint128_t total_ns_mixed = 0, total_ns_sorted = 0;
+    for (int trial = 0; trial < m; ++trial) {
+        clock_gettime(CLOCK_REALTIME, &start);
+        sap_scan_mixed(hits, hit_ss, cts, c.levels, tags, n, &ks);
+        clock_gettime(CLOCK_REALTIME, &end);
+        total_ns_mixed += calculate_elapsed_time(start, end);
+
+        clock_gettime(CLOCK_REALTIME, &start);
+        for (int l = 0; l < CORPUS_LEVELS; ++l) {
+            scan_levels[l]->scan(hits + begin[l], hit_ss + begin[l] * SS_BYTES, sorted + begin[l],
+                sorted_tags + begin[l], count[l], ks.keys[l]);
+        }
+        clock_gettime(CLOCK_REALTIME, &end);
+        total_ns_sorted += calculate_elapsed_time(start, end);
+    }
+
+    sap_scan_keyset_free(&ks);
+    free(cts);
+    free(sorted);
+    free(tags);
+    free(sorted_tags);
+    free(hits);
+    free(hit_ss);
+    corpus_free(&c);
+
+    printf("N = %5d, Avg time mixed K=2/3/4 (sap_scan_mixed|presorted per level) = %8.3fms | %8.3fms\n",
+        n, (double)total_ns_mixed / m / 1e6, (double)total_ns_sorted / m / 1e6);
 }
 
 int main() {
@@ -148,6 +246,9 @@ int main() {
     for (int i = 0; i < len; ++i) {
         run(ns[i], M_TRIALS, shuffle);
     }
+    for (int i = 0; i < len; ++i) {
+        run_mixed(ns[i], M_TRIALS);
+    }
     
     /*  N =  5000, Avg time (No WT|1B WT|Full WT) =   67.174ms |   43.454ms |   44.289ms
         N = 10000, Avg time (No WT|1B WT|Full WT) =  135.695ms |   88.034ms |   88.525ms
@@ -0,0 +1,68 @@
+#ifndef CPUCYCLES_H
+#define CPUCYCLES_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <x86intrin.h>
+
+/// @file cpucycles.h
+/// @brief Cycle counter, CPU pinning and robust statistics shared by the benchmarks.
+
+/// @brief Reads the time stamp counter, serialized against earlier instructions.
+static inline uint64_t cpucycles(void)
+{
+    unsigned int aux;
+    _mm_lfence();
+    return __rdtscp(&aux);
+}
+
+/// @brief Pins the calling thread to a single CPU so that frequency and cache state stay stable.
+///
+/// @param[in] cpu CPU index to pin to.
+/// @return 0 on success, -1 if the affinity could not be set.
+static inline int pin_cpu(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        fprintf(stderr, "warning: could not pin to CPU %d\n", cpu);
+        return -1;
+    }
+    return 0;
+}
+
+static int cmp_double(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/// @brief Returns the median of @p n samples. The array is sorted in place.
+static inline double median(double* v, size_t n)
+{
+    qsort(v, n, sizeof(double), cmp_double);
+    return (n & 1) ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+}
+
+/// @brief Returns the median absolute deviation of @p n samples around @p med.
+///
+/// The input array is left untouched.
+static inline double median_abs_dev(const double* v, size_t n, double med)
+{
+    double* dev = malloc(n * sizeof(double));
+    for (size_t i = 0; i < n; i++) {
+        dev[i] = v[i] > med ? v[i] - med : med - v[i];
+    }
+    double mad = median(dev, n);
+    free(dev);
+    return mad;
+}
+
+#endif
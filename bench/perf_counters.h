@@ -0,0 +1,119 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/// @file perf_counters.h
+/// @brief Hardware counters of the calling thread through perf_event_open(2), for the benchmarks.
+///
+/// Each event is opened on its own, user space only, so an event the CPU or the
+/// hypervisor does not offer is simply missing rather than failing the rest.
+/// Counts are scaled up when the kernel had to multiplex the counters.
+
+/// @brief The events, in the order of perf_counters::values.
+enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_EVENTS
+};
+
+static const char* const perf_event_names[PERF_EVENTS] = {
+    "cycles", "instructions", "L1d misses", "LLC misses", "branch misses"
+};
+
+/// @brief Open counters and their last readings.
+typedef struct {
+    int fds[PERF_EVENTS];       /**< -1 if the event is not available. */
+    double values[PERF_EVENTS];
+} perf_counters;
+
+/// @brief Opens the counters, disabled.
+///
+/// @return The number of events available (0 if perf_event_open() is not permitted).
+static inline int perf_counters_open(perf_counters* pc)
+{
+    static const struct { uint32_t type; uint64_t config; } events[PERF_EVENTS] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    };
+    int n = 0;
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[e].type;
+        attr.config = events[e].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        pc->fds[e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        pc->values[e] = 0;
+        n += pc->fds[e] >= 0;
+    }
+    return n;
+}
+
+/// @brief Resets and starts the counters.
+static inline void perf_counters_start(perf_counters* pc)
+{
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        if (pc->fds[e] < 0) continue;
+        ioctl(pc->fds[e], PERF_EVENT_IOC_RESET, 0);
+        ioctl(pc->fds[e], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+/// @brief Stops the counters and reads them into pc->values.
+static inline void perf_counters_stop(perf_counters* pc)
+{
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        if (pc->fds[e] < 0) continue;
+        ioctl(pc->fds[e], PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t v[3];
+        if (read(pc->fds[e], v, sizeof(v)) != sizeof(v) || v[2] == 0) {
+            pc->values[e] = 0;
+            continue;
+        }
+        pc->values[e] = (double)v[0] * ((double)v[1] / (double)v[2]);
+    }
+}
+
+/// @brief Prints the last readings divided by @p per (such as the number of announcements).
+static inline void perf_counters_print(const perf_counters* pc, double per, const char* unit)
+{
+    printf("   per %s:", unit);
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        if (pc->fds[e] < 0) {
+            printf(" %s n/a", perf_event_names[e]);
+        } else {
+            printf(" %s %.1f", perf_event_names[e], pc->values[e] / per);
+        }
+        printf(e + 1 < PERF_EVENTS ? "," : "\n");
+    }
+}
+
+/// @brief Closes the counters.
+static inline void perf_counters_close(perf_counters* pc)
+{
+    for (int e = 0; e < PERF_EVENTS; e++) {
+        if (pc->fds[e] >= 0) close(pc->fds[e]);
+        pc->fds[e] = -1;
+    }
+}
+
+#endif
@@ -0,0 +1,19 @@
+# Mixed send/scan workload for benchmark_replay.
+# Payments arrive as a Poisson process at send_rate per second, multiplied by
+# burst_multiplier during the first burst_duty of every burst_period_ms.
+send_rate = 500
+burst_multiplier = 4
+burst_period_ms = 1000
+burst_duty = 0.2
+
+# Recipient popularity follows a Zipf law with this exponent (0 = uniform).
+recipients = 256
+popularity_skew = 1.0
+
+# Register size at start; with register_growth = 1 every payment appends its announcement.
+initial_register = 10000
+register_growth = 1
+
+duration_ms = 3000
+sender_threads = 2
+scanner_threads = 1
@@ -0,0 +1,371 @@
+#include <stdint.h>
+#include "params.h"
+#include "consts.h"
+
+/*
+ * Constant tables of the AVX-512 kernels. The NTT works on pairs of 512-bit
+ * vectors holding 64 consecutive coefficients; for the layers with len < 32 the
+ * pair is reshuffled so that the first vector holds the lower and the second the
+ * upper butterfly inputs. Generated from the reference zetas table.
+ */
+
+/* Lane indices for _mm512_permutex2var_epi16 from the len = 2 pair layout back to
+ * natural order, applied at the end of the forward NTT, see ntt.c */
+const int16_t ntt512_perm_fwd[64] __attribute__((aligned(64))) = {
+      0,     1,    32,    33,     2,     3,    34,    35,     4,     5,    36,    37,     6,     7,    38,    39,
+      8,     9,    40,    41,    10,    11,    42,    43,    12,    13,    44,    45,    14,    15,    46,    47,
+     16,    17,    48,    49,    18,    19,    50,    51,    20,    21,    52,    53,    22,    23,    54,    55,
+     24,    25,    56,    57,    26,    27,    58,    59,    28,    29,    60,    61,    30,    31,    62,    63
+};
+
+/* The inverse, applied at the start of the inverse NTT */
+const int16_t ntt512_perm_inv[64] __attribute__((aligned(64))) = {
+      0,     1,     4,     5,     8,     9,    12,    13,    16,    17,    20,    21,    24,    25,    28,    29,
+     32,    33,    36,    37,    40,    41,    44,    45,    48,    49,    52,    53,    56,    57,    60,    61,
+      2,     3,     6,     7,    10,    11,    14,    15,    18,    19,    22,    23,    26,    27,    30,    31,
+     34,    35,    38,    39,    42,    43,    46,    47,    50,    51,    54,    55,    58,    59,    62,    63
+};
+
+/* Per-lane zetas of the forward layers len = 16, 8, 4, 2 for each 64-coefficient block */
+const int16_t ntt512_zetas_fwd[4][4][32] __attribute__((aligned(64))) = {
+  {
+    {
+       -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,
+        622,   622,   622,   622,   622,   622,   622,   622,   622,   622,   622,   622,   622,   622,   622,   622
+    },
+    {
+       1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,
+        182,   182,   182,   182,   182,   182,   182,   182,   182,   182,   182,   182,   182,   182,   182,   182
+    },
+    {
+        962,   962,   962,   962,   962,   962,   962,   962,   962,   962,   962,   962,   962,   962,   962,   962,
+      -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202
+    },
+    {
+      -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474,
+       1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468
+    }
+  },
+  {
+    {
+        573,   573,   573,   573,   573,   573,   573,   573, -1325, -1325, -1325, -1325, -1325, -1325, -1325, -1325,
+        264,   264,   264,   264,   264,   264,   264,   264,   383,   383,   383,   383,   383,   383,   383,   383
+    },
+    {
+       -829,  -829,  -829,  -829,  -829,  -829,  -829,  -829,  1458,  1458,  1458,  1458,  1458,  1458,  1458,  1458,
+      -1602, -1602, -1602, -1602, -1602, -1602, -1602, -1602,  -130,  -130,  -130,  -130,  -130,  -130,  -130,  -130
+    },
+    {
+       -681,  -681,  -681,  -681,  -681,  -681,  -681,  -681,  1017,  1017,  1017,  1017,  1017,  1017,  1017,  1017,
+        732,   732,   732,   732,   732,   732,   732,   732,   608,   608,   608,   608,   608,   608,   608,   608
+    },
+    {
+      -1542, -1542, -1542, -1542, -1542, -1542, -1542, -1542,   411,   411,   411,   411,   411,   411,   411,   411,
+       -205,  -205,  -205,  -205,  -205,  -205,  -205,  -205, -1571, -1571, -1571, -1571, -1571, -1571, -1571, -1571
+    }
+  },
+  {
+    {
+       1223,  1223,  1223,  1223,   652,   652,   652,   652,  -552,  -552,  -552,  -552,  1015,  1015,  1015,  1015,
+      -1293, -1293, -1293, -1293,  1491,  1491,  1491,  1491,  -282,  -282,  -282,  -282, -1544, -1544, -1544, -1544
+    },
+    {
+        516,   516,   516,   516,    -8,    -8,    -8,    -8,  -320,  -320,  -320,  -320,  -666,  -666,  -666,  -666,
+      -1618, -1618, -1618, -1618, -1162, -1162, -1162, -1162,   126,   126,   126,   126,  1469,  1469,  1469,  1469
+    },
+    {
+       -853,  -853,  -853,  -853,   -90,   -90,   -90,   -90,  -271,  -271,  -271,  -271,   830,   830,   830,   830,
+        107,   107,   107,   107, -1421, -1421, -1421, -1421,  -247,  -247,  -247,  -247,  -951,  -951,  -951,  -951
+    },
+    {
+       -398,  -398,  -398,  -398,   961,   961,   961,   961, -1508, -1508, -1508, -1508,  -725,  -725,  -725,  -725,
+        448,   448,   448,   448, -1065, -1065, -1065, -1065,   677,   677,   677,   677, -1275, -1275, -1275, -1275
+    }
+  },
+  {
+    {
+      -1103, -1103,   430,   430,   555,   555,   843,   843, -1251, -1251,   871,   871,  1550,  1550,   105,   105,
+        422,   422,   587,   587,   177,   177,  -235,  -235,  -291,  -291,  -460,  -460,  1574,  1574,  1653,  1653
+    },
+    {
+       -246,  -246,   778,   778,  1159,  1159,  -147,  -147,  -777,  -777,  1483,  1483,  -602,  -602,  1119,  1119,
+      -1590, -1590,   644,   644,  -872,  -872,   349,   349,   418,   418,   329,   329,  -156,  -156,   -75,   -75
+    },
+    {
+        817,   817,  1097,  1097,   603,   603,   610,   610,  1322,  1322, -1285, -1285, -1465, -1465,   384,   384,
+      -1215, -1215,  -136,  -136,  1218,  1218, -1335, -1335,  -874,  -874,   220,   220, -1187, -1187, -1659, -1659
+    },
+    {
+      -1185, -1185, -1530, -1530, -1278, -1278,   794,   794, -1510, -1510,  -854,  -854,  -870,  -870,   478,   478,
+       -108,  -108,  -308,  -308,   996,   996,   991,   991,   958,   958, -1460, -1460,  1522,  1522,  1628,  1628
+    }
+  }
+};
+
+/* The same zetas multiplied by QINV mod 2^16 */
+const int16_t ntt512_zetas_fwd_qinv[4][4][32] __attribute__((aligned(64))) = {
+  {
+    {
+      -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907,
+      27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758
+    },
+    {
+      -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799,
+      -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690
+    },
+    {
+      10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690,
+       1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358
+    },
+    {
+      -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202,
+      31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164
+    }
+  },
+  {
+    {
+      -5827, -5827, -5827, -5827, -5827, -5827, -5827, -5827, 17363, 17363, 17363, 17363, 17363, 17363, 17363, 17363,
+      -26360, -26360, -26360, -26360, -26360, -26360, -26360, -26360, -29057, -29057, -29057, -29057, -29057, -29057, -29057, -29057
+    },
+    {
+       5571,  5571,  5571,  5571,  5571,  5571,  5571,  5571, -1102, -1102, -1102, -1102, -1102, -1102, -1102, -1102,
+      21438, 21438, 21438, 21438, 21438, 21438, 21438, 21438, -26242, -26242, -26242, -26242, -26242, -26242, -26242, -26242
+    },
+    {
+      -28073, -28073, -28073, -28073, -28073, -28073, -28073, -28073, 24313, 24313, 24313, 24313, 24313, 24313, 24313, 24313,
+      -10532, -10532, -10532, -10532, -10532, -10532, -10532, -10532,  8800,  8800,  8800,  8800,  8800,  8800,  8800,  8800
+    },
+    {
+      18426, 18426, 18426, 18426, 18426, 18426, 18426, 18426,  8859,  8859,  8859,  8859,  8859,  8859,  8859,  8859,
+      26675, 26675, 26675, 26675, 26675, 26675, 26675, 26675, -16163, -16163, -16163, -16163, -16163, -16163, -16163, -16163
+    }
+  },
+  {
+    {
+      -5689, -5689, -5689, -5689, -6516, -6516, -6516, -6516,  1496,  1496,  1496,  1496, 30967, 30967, 30967, 30967,
+      -23565, -23565, -23565, -23565, 20179, 20179, 20179, 20179, 20710, 20710, 20710, 20710, 25080, 25080, 25080, 25080
+    },
+    {
+      -12796, -12796, -12796, -12796, 26616, 26616, 26616, 26616, 16064, 16064, 16064, 16064, -12442, -12442, -12442, -12442,
+       9134,  9134,  9134,  9134,  -650,  -650,  -650,  -650, -25986, -25986, -25986, -25986, 27837, 27837, 27837, 27837
+    },
+    {
+      19883, 19883, 19883, 19883, -28250, -28250, -28250, -28250, -15887, -15887, -15887, -15887, -8898, -8898, -8898, -8898,
+      -28309, -28309, -28309, -28309,  9075,  9075,  9075,  9075, -30199, -30199, -30199, -30199, 18249, 18249, 18249, 18249
+    },
+    {
+      13426, 13426, 13426, 13426, 14017, 14017, 14017, 14017, -29156, -29156, -29156, -29156, -12757, -12757, -12757, -12757,
+      16832, 16832, 16832, 16832,  4311,  4311,  4311,  4311, -24155, -24155, -24155, -24155, -17915, -17915, -17915, -17915
+    }
+  },
+  {
+    {
+       -335,  -335, 11182, 11182, -11477, -11477, 13387, 13387, -32227, -32227, -14233, -14233, 20494, 20494, -21655, -21655,
+      -27738, -27738, 13131, 13131,   945,   945, -4587, -4587, -14883, -14883, 23092, 23092,  6182,  6182,  5493,  5493
+    },
+    {
+      32010, 32010, -32502, -32502, 10631, 10631, 30317, 30317, 29175, 29175, -18741, -18741, -28762, -28762, 12639, 12639,
+      -18486, -18486, 20100, 20100, 17560, 17560, 18525, 18525, -14430, -14430, 19529, 19529, -5276, -5276, -12619, -12619
+    },
+    {
+      -31183, -31183, 20297, 20297, 25435, 25435,  2146,  2146, -7382, -7382, 15355, 15355, 24391, 24391, -32384, -32384,
+      -20927, -20927, -6280, -6280, 10946, 10946, -14903, -14903, 24214, 24214, -11044, -11044, 16989, 16989, 14469, 14469
+    },
+    {
+      10335, 10335, -21498, -21498, -7934, -7934, -20198, -20198, -22502, -22502, 23210, 23210, 10906, 10906, -17442, -17442,
+      31636, 31636, -23860, -23860, 28644, 28644, -20257, -20257, 23998, 23998,  7756,  7756, -17422, -17422, 23132, 23132
+    }
+  }
+};
+
+/* Per-lane zetas of the inverse layers len = 2, 4, 8, 16 for each 64-coefficient block */
+const int16_t ntt512_zetas_inv[4][4][32] __attribute__((aligned(64))) = {
+  {
+    {
+       1628,  1628,  1522,  1522, -1460, -1460,   958,   958,   991,   991,   996,   996,  -308,  -308,  -108,  -108,
+        478,   478,  -870,  -870,  -854,  -854, -1510, -1510,   794,   794, -1278, -1278, -1530, -1530, -1185, -1185
+    },
+    {
+      -1659, -1659, -1187, -1187,   220,   220,  -874,  -874, -1335, -1335,  1218,  1218,  -136,  -136, -1215, -1215,
+        384,   384, -1465, -1465, -1285, -1285,  1322,  1322,   610,   610,   603,   603,  1097,  1097,   817,   817
+    },
+    {
+        -75,   -75,  -156,  -156,   329,   329,   418,   418,   349,   349,  -872,  -872,   644,   644, -1590, -1590,
+       1119,  1119,  -602,  -602,  1483,  1483,  -777,  -777,  -147,  -147,  1159,  1159,   778,   778,  -246,  -246
+    },
+    {
+       1653,  1653,  1574,  1574,  -460,  -460,  -291,  -291,  -235,  -235,   177,   177,   587,   587,   422,   422,
+        105,   105,  1550,  1550,   871,   871, -1251, -1251,   843,   843,   555,   555,   430,   430, -1103, -1103
+    }
+  },
+  {
+    {
+      -1275, -1275, -1275, -1275,   677,   677,   677,   677, -1065, -1065, -1065, -1065,   448,   448,   448,   448,
+       -725,  -725,  -725,  -725, -1508, -1508, -1508, -1508,   961,   961,   961,   961,  -398,  -398,  -398,  -398
+    },
+    {
+       -951,  -951,  -951,  -951,  -247,  -247,  -247,  -247, -1421, -1421, -1421, -1421,   107,   107,   107,   107,
+        830,   830,   830,   830,  -271,  -271,  -271,  -271,   -90,   -90,   -90,   -90,  -853,  -853,  -853,  -853
+    },
+    {
+       1469,  1469,  1469,  1469,   126,   126,   126,   126, -1162, -1162, -1162, -1162, -1618, -1618, -1618, -1618,
+       -666,  -666,  -666,  -666,  -320,  -320,  -320,  -320,    -8,    -8,    -8,    -8,   516,   516,   516,   516
+    },
+    {
+      -1544, -1544, -1544, -1544,  -282,  -282,  -282,  -282,  1491,  1491,  1491,  1491, -1293, -1293, -1293, -1293,
+       1015,  1015,  1015,  1015,  -552,  -552,  -552,  -552,   652,   652,   652,   652,  1223,  1223,  1223,  1223
+    }
+  },
+  {
+    {
+      -1571, -1571, -1571, -1571, -1571, -1571, -1571, -1571,  -205,  -205,  -205,  -205,  -205,  -205,  -205,  -205,
+        411,   411,   411,   411,   411,   411,   411,   411, -1542, -1542, -1542, -1542, -1542, -1542, -1542, -1542
+    },
+    {
+        608,   608,   608,   608,   608,   608,   608,   608,   732,   732,   732,   732,   732,   732,   732,   732,
+       1017,  1017,  1017,  1017,  1017,  1017,  1017,  1017,  -681,  -681,  -681,  -681,  -681,  -681,  -681,  -681
+    },
+    {
+       -130,  -130,  -130,  -130,  -130,  -130,  -130,  -130, -1602, -1602, -1602, -1602, -1602, -1602, -1602, -1602,
+       1458,  1458,  1458,  1458,  1458,  1458,  1458,  1458,  -829,  -829,  -829,  -829,  -829,  -829,  -829,  -829
+    },
+    {
+        383,   383,   383,   383,   383,   383,   383,   383,   264,   264,   264,   264,   264,   264,   264,   264,
+      -1325, -1325, -1325, -1325, -1325, -1325, -1325, -1325,   573,   573,   573,   573,   573,   573,   573,   573
+    }
+  },
+  {
+    {
+       1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,  1468,
+      -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474, -1474
+    },
+    {
+      -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202, -1202,
+        962,   962,   962,   962,   962,   962,   962,   962,   962,   962,   962,   962,   962,   962,   962,   962
+    },
+    {
+        182,   182,   182,   182,   182,   182,   182,   182,   182,   182,   182,   182,   182,   182,   182,   182,
+       1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577,  1577
+    },
+    {
+        622,   622,   622,   622,   622,   622,   622,   622,   622,   622,   622,   622,   622,   622,   622,   622,
+       -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171,  -171
+    }
+  }
+};
+
+/* The same zetas multiplied by QINV mod 2^16 */
+const int16_t ntt512_zetas_inv_qinv[4][4][32] __attribute__((aligned(64))) = {
+  {
+    {
+      23132, 23132, -17422, -17422,  7756,  7756, 23998, 23998, -20257, -20257, 28644, 28644, -23860, -23860, 31636, 31636,
+      -17442, -17442, 10906, 10906, 23210, 23210, -22502, -22502, -20198, -20198, -7934, -7934, -21498, -21498, 10335, 10335
+    },
+    {
+      14469, 14469, 16989, 16989, -11044, -11044, 24214, 24214, -14903, -14903, 10946, 10946, -6280, -6280, -20927, -20927,
+      -32384, -32384, 24391, 24391, 15355, 15355, -7382, -7382,  2146,  2146, 25435, 25435, 20297, 20297, -31183, -31183
+    },
+    {
+      -12619, -12619, -5276, -5276, 19529, 19529, -14430, -14430, 18525, 18525, 17560, 17560, 20100, 20100, -18486, -18486,
+      12639, 12639, -28762, -28762, -18741, -18741, 29175, 29175, 30317, 30317, 10631, 10631, -32502, -32502, 32010, 32010
+    },
+    {
+       5493,  5493,  6182,  6182, 23092, 23092, -14883, -14883, -4587, -4587,   945,   945, 13131, 13131, -27738, -27738,
+      -21655, -21655, 20494, 20494, -14233, -14233, -32227, -32227, 13387, 13387, -11477, -11477, 11182, 11182,  -335,  -335
+    }
+  },
+  {
+    {
+      -17915, -17915, -17915, -17915, -24155, -24155, -24155, -24155,  4311,  4311,  4311,  4311, 16832, 16832, 16832, 16832,
+      -12757, -12757, -12757, -12757, -29156, -29156, -29156, -29156, 14017, 14017, 14017, 14017, 13426, 13426, 13426, 13426
+    },
+    {
+      18249, 18249, 18249, 18249, -30199, -30199, -30199, -30199,  9075,  9075,  9075,  9075, -28309, -28309, -28309, -28309,
+      -8898, -8898, -8898, -8898, -15887, -15887, -15887, -15887, -28250, -28250, -28250, -28250, 19883, 19883, 19883, 19883
+    },
+    {
+      27837, 27837, 27837, 27837, -25986, -25986, -25986, -25986,  -650,  -650,  -650,  -650,  9134,  9134,  9134,  9134,
+      -12442, -12442, -12442, -12442, 16064, 16064, 16064, 16064, 26616, 26616, 26616, 26616, -12796, -12796, -12796, -12796
+    },
+    {
+      25080, 25080, 25080, 25080, 20710, 20710, 20710, 20710, 20179, 20179, 20179, 20179, -23565, -23565, -23565, -23565,
+      30967, 30967, 30967, 30967,  1496,  1496,  1496,  1496, -6516, -6516, -6516, -6516, -5689, -5689, -5689, -5689
+    }
+  },
+  {
+    {
+      -16163, -16163, -16163, -16163, -16163, -16163, -16163, -16163, 26675, 26675, 26675, 26675, 26675, 26675, 26675, 26675,
+       8859,  8859,  8859,  8859,  8859,  8859,  8859,  8859, 18426, 18426, 18426, 18426, 18426, 18426, 18426, 18426
+    },
+    {
+       8800,  8800,  8800,  8800,  8800,  8800,  8800,  8800, -10532, -10532, -10532, -10532, -10532, -10532, -10532, -10532,
+      24313, 24313, 24313, 24313, 24313, 24313, 24313, 24313, -28073, -28073, -28073, -28073, -28073, -28073, -28073, -28073
+    },
+    {
+      -26242, -26242, -26242, -26242, -26242, -26242, -26242, -26242, 21438, 21438, 21438, 21438, 21438, 21438, 21438, 21438,
+      -1102, -1102, -1102, -1102, -1102, -1102, -1102, -1102,  5571,  5571,  5571,  5571,  5571,  5571,  5571,  5571
+    },
+    {
+      -29057, -29057, -29057, -29057, -29057, -29057, -29057, -29057, -26360, -26360, -26360, -26360, -26360, -26360, -26360, -26360,
+      17363, 17363, 17363, 17363, 17363, 17363, 17363, 17363, -5827, -5827, -5827, -5827, -5827, -5827, -5827, -5827
+    }
+  },
+  {
+    {
+      31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164, 31164,
+      -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202, -11202
+    },
+    {
+       1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,  1358,
+      10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690, 10690
+    },
+    {
+      -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690, -15690,
+      -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799, -3799
+    },
+    {
+      27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758, 27758,
+      -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907, -20907
+    }
+  }
+};
+
+/* Zeta of the degree-2 factor each coefficient belongs to (+-zetas[64 + i/4]), see basemul() */
+const int16_t basemul512_zetas[256] __attribute__((aligned(64))) = {
+  -1103, -1103,  1103,  1103,   430,   430,  -430,  -430,   555,   555,  -555,  -555,   843,   843,  -843,  -843,
+  -1251, -1251,  1251,  1251,   871,   871,  -871,  -871,  1550,  1550, -1550, -1550,   105,   105,  -105,  -105,
+    422,   422,  -422,  -422,   587,   587,  -587,  -587,   177,   177,  -177,  -177,  -235,  -235,   235,   235,
+   -291,  -291,   291,   291,  -460,  -460,   460,   460,  1574,  1574, -1574, -1574,  1653,  1653, -1653, -1653,
+   -246,  -246,   246,   246,   778,   778,  -778,  -778,  1159,  1159, -1159, -1159,  -147,  -147,   147,   147,
+   -777,  -777,   777,   777,  1483,  1483, -1483, -1483,  -602,  -602,   602,   602,  1119,  1119, -1119, -1119,
+  -1590, -1590,  1590,  1590,   644,   644,  -644,  -644,  -872,  -872,   872,   872,   349,   349,  -349,  -349,
+    418,   418,  -418,  -418,   329,   329,  -329,  -329,  -156,  -156,   156,   156,   -75,   -75,    75,    75,
+    817,   817,  -817,  -817,  1097,  1097, -1097, -1097,   603,   603,  -603,  -603,   610,   610,  -610,  -610,
+   1322,  1322, -1322, -1322, -1285, -1285,  1285,  1285, -1465, -1465,  1465,  1465,   384,   384,  -384,  -384,
+  -1215, -1215,  1215,  1215,  -136,  -136,   136,   136,  1218,  1218, -1218, -1218, -1335, -1335,  1335,  1335,
+   -874,  -874,   874,   874,   220,   220,  -220,  -220, -1187, -1187,  1187,  1187, -1659, -1659,  1659,  1659,
+  -1185, -1185,  1185,  1185, -1530, -1530,  1530,  1530, -1278, -1278,  1278,  1278,   794,   794,  -794,  -794,
+  -1510, -1510,  1510,  1510,  -854,  -854,   854,   854,  -870,  -870,   870,   870,   478,   478,  -478,  -478,
+   -108,  -108,   108,   108,  -308,  -308,   308,   308,   996,   996,  -996,  -996,   991,   991,  -991,  -991,
+    958,   958,  -958,  -958, -1460, -1460,  1460,  1460,  1522,  1522, -1522, -1522,  1628,  1628, -1628, -1628
+};
+
+/* The same zetas multiplied by QINV mod 2^16 */
+const int16_t basemul512_zetas_qinv[256] __attribute__((aligned(64))) = {
+   -335,  -335,   335,   335, 11182, 11182, -11182, -11182, -11477, -11477, 11477, 11477, 13387, 13387, -13387, -13387,
+  -32227, -32227, 32227, 32227, -14233, -14233, 14233, 14233, 20494, 20494, -20494, -20494, -21655, -21655, 21655, 21655,
+  -27738, -27738, 27738, 27738, 13131, 13131, -13131, -13131,   945,   945,  -945,  -945, -4587, -4587,  4587,  4587,
+  -14883, -14883, 14883, 14883, 23092, 23092, -23092, -23092,  6182,  6182, -6182, -6182,  5493,  5493, -5493, -5493,
+  32010, 32010, -32010, -32010, -32502, -32502, 32502, 32502, 10631, 10631, -10631, -10631, 30317, 30317, -30317, -30317,
+  29175, 29175, -29175, -29175, -18741, -18741, 18741, 18741, -28762, -28762, 28762, 28762, 12639, 12639, -12639, -12639,
+  -18486, -18486, 18486, 18486, 20100, 20100, -20100, -20100, 17560, 17560, -17560, -17560, 18525, 18525, -18525, -18525,
+  -14430, -14430, 14430, 14430, 19529, 19529, -19529, -19529, -5276, -5276,  5276,  5276, -12619, -12619, 12619, 12619,
+  -31183, -31183, 31183, 31183, 20297, 20297, -20297, -20297, 25435, 25435, -25435, -25435,  2146,  2146, -2146, -2146,
+  -7382, -7382,  7382,  7382, 15355, 15355, -15355, -15355, 24391, 24391, -24391, -24391, -32384, -32384, 32384, 32384,
+  -20927, -20927, 20927, 20927, -6280, -6280,  6280,  6280, 10946, 10946, -10946, -10946, -14903, -14903, 14903, 14903,
+  24214, 24214, -24214, -24214, -11044, -11044, 11044, 11044, 16989, 16989, -16989, -16989, 14469, 14469, -14469, -14469,
+  10335, 10335, -10335, -10335, -21498, -21498, 21498, 21498, -7934, -7934,  7934,  7934, -20198, -20198, 20198, 20198,
+  -22502, -22502, 22502, 22502, 23210, 23210, -23210, -23210, 10906, 10906, -10906, -10906, -17442, -17442, 17442, 17442,
+  31636, 31636, -31636, -31636, -23860, -23860, 23860, 23860, 28644, 28644, -28644, -28644, -20257, -20257, 20257, 20257,
+  23998, 23998, -23998, -23998,  7756,  7756, -7756, -7756, -17422, -17422, 17422, 17422, 23132, 23132, -23132, -23132
+};
@@ -0,0 +1,26 @@
+#ifndef CONSTS512_H
+#define CONSTS512_H
+
+#include <stdint.h>
+#include "params.h"
+
+#define ntt512_perm_fwd KYBER_NAMESPACE(ntt512_perm_fwd)
+extern const int16_t ntt512_perm_fwd[64];
+#define ntt512_perm_inv KYBER_NAMESPACE(ntt512_perm_inv)
+extern const int16_t ntt512_perm_inv[64];
+
+#define ntt512_zetas_fwd KYBER_NAMESPACE(ntt512_zetas_fwd)
+extern const int16_t ntt512_zetas_fwd[4][4][32];
+#define ntt512_zetas_fwd_qinv KYBER_NAMESPACE(ntt512_zetas_fwd_qinv)
+extern const int16_t ntt512_zetas_fwd_qinv[4][4][32];
+#define ntt512_zetas_inv KYBER_NAMESPACE(ntt512_zetas_inv)
+extern const int16_t ntt512_zetas_inv[4][4][32];
+#define ntt512_zetas_inv_qinv KYBER_NAMESPACE(ntt512_zetas_inv_qinv)
+extern const int16_t ntt512_zetas_inv_qinv[4][4][32];
+
+#define basemul512_zetas KYBER_NAMESPACE(basemul512_zetas)
+extern const int16_t basemul512_zetas[256];
+#define basemul512_zetas_qinv KYBER_NAMESPACE(basemul512_zetas_qinv)
+extern const int16_t basemul512_zetas_qinv[256];
+
+#endif
@@ -0,0 +1,258 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+#include "fips202x8.h"
+
+#define NROUNDS 24
+
+#define ROL(a, offset) _mm512_rol_epi64(a, offset)
+/* a ^ b ^ c ^ d ^ e with two three-input logic operations */
+#define XOR5(a, b, c, d, e) \
+  _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(a, b, c, 0x96), d, e, 0x96)
+/* a ^ (~b & c) */
+#define CHI(a, b, c) _mm512_ternarylogic_epi64(a, b, c, 0xD2)
+
+/* Keccak round constants */
+static const uint64_t KeccakF_RoundConstants[NROUNDS] = {
+  (uint64_t)0x0000000000000001ULL,
+  (uint64_t)0x0000000000008082ULL,
+  (uint64_t)0x800000000000808aULL,
+  (uint64_t)0x8000000080008000ULL,
+  (uint64_t)0x000000000000808bULL,
+  (uint64_t)0x0000000080000001ULL,
+  (uint64_t)0x8000000080008081ULL,
+  (uint64_t)0x8000000000008009ULL,
+  (uint64_t)0x000000000000008aULL,
+  (uint64_t)0x0000000000000088ULL,
+  (uint64_t)0x0000000080008009ULL,
+  (uint64_t)0x000000008000000aULL,
+  (uint64_t)0x000000008000808bULL,
+  (uint64_t)0x800000000000008bULL,
+  (uint64_t)0x8000000000008089ULL,
+  (uint64_t)0x8000000000008003ULL,
+  (uint64_t)0x8000000000008002ULL,
+  (uint64_t)0x8000000000000080ULL,
+  (uint64_t)0x000000000000800aULL,
+  (uint64_t)0x800000008000000aULL,
+  (uint64_t)0x8000000080008081ULL,
+  (uint64_t)0x8000000000008080ULL,
+  (uint64_t)0x0000000080000001ULL,
+  (uint64_t)0x8000000080008008ULL
+};
+
+/*************************************************
+* Name:        KeccakF1600_StatePermute8x
+*
+* Description: The Keccak F1600 permutation on eight states at once; one round
+*              per iteration, with theta, rho, pi and chi unrolled over the lanes
+*
+* Arguments:   - __m512i *s: pointer to the interleaved states
+**************************************************/
+static void KeccakF1600_StatePermute8x(__m512i s[25])
+{
+  unsigned int round;
+  __m512i B[25];
+  __m512i C0, C1, C2, C3, C4, D0, D1, D2, D3, D4;
+
+  for(round = 0; round < NROUNDS; round++) {
+    /* theta */
+    C0 = XOR5(s[0], s[5], s[10], s[15], s[20]);
+    C1 = XOR5(s[1], s[6], s[11], s[16], s[21]);
+    C2 = XOR5(s[2], s[7], s[12], s[17], s[22]);
+    C3 = XOR5(s[3], s[8], s[13], s[18], s[23]);
+    C4 = XOR5(s[4], s[9], s[14], s[19], s[24]);
+    D0 = _mm512_xor_si512(C4, ROL(C1, 1));
+    D1 = _mm512_xor_si512(C0, ROL(C2, 1));
+    D2 = _mm512_xor_si512(C1, ROL(C3, 1));
+    D3 = _mm512_xor_si512(C2, ROL(C4, 1));
+    D4 = _mm512_xor_si512(C3, ROL(C0, 1));
+    /* rho and pi */
+    B[0] = _mm512_xor_si512(s[0], D0);
+    B[10] = ROL(_mm512_xor_si512(s[1], D1), 1);
+    B[20] = ROL(_mm512_xor_si512(s[2], D2), 62);
+    B[5] = ROL(_mm512_xor_si512(s[3], D3), 28);
+    B[15] = ROL(_mm512_xor_si512(s[4], D4), 27);
+    B[16] = ROL(_mm512_xor_si512(s[5], D0), 36);
+    B[1] = ROL(_mm512_xor_si512(s[6], D1), 44);
+    B[11] = ROL(_mm512_xor_si512(s[7], D2), 6);
+    B[21] = ROL(_mm512_xor_si512(s[8], D3), 55);
+    B[6] = ROL(_mm512_xor_si512(s[9], D4), 20);
+    B[7] = ROL(_mm512_xor_si512(s[10], D0), 3);
+    B[17] = ROL(_mm512_xor_si512(s[11], D1), 10);
+    B[2] = ROL(_mm512_xor_si512(s[12], D2), 43);
+    B[12] = ROL(_mm512_xor_si512(s[13], D3), 25);
+    B[22] = ROL(_mm512_xor_si512(s[14], D4), 39);
+    B[23] = ROL(_mm512_xor_si512(s[15], D0), 41);
+    B[8] = ROL(_mm512_xor_si512(s[16], D1), 45);
+    B[18] = ROL(_mm512_xor_si512(s[17], D2), 15);
+    B[3] = ROL(_mm512_xor_si512(s[18], D3), 21);
+    B[13] = ROL(_mm512_xor_si512(s[19], D4), 8);
+    B[14] = ROL(_mm512_xor_si512(s[20], D0), 18);
+    B[24] = ROL(_mm512_xor_si512(s[21], D1), 2);
+    B[9] = ROL(_mm512_xor_si512(s[22], D2), 61);
+    B[19] = ROL(_mm512_xor_si512(s[23], D3), 56);
+    B[4] = ROL(_mm512_xor_si512(s[24], D4), 14);
+    /* chi */
+    s[0] = CHI(B[0], B[1], B[2]);
+    s[1] = CHI(B[1], B[2], B[3]);
+    s[2] = CHI(B[2], B[3], B[4]);
+    s[3] = CHI(B[3], B[4], B[0]);
+    s[4] = CHI(B[4], B[0], B[1]);
+    s[5] = CHI(B[5], B[6], B[7]);
+    s[6] = CHI(B[6], B[7], B[8]);
+    s[7] = CHI(B[7], B[8], B[9]);
+    s[8] = CHI(B[8], B[9], B[5]);
+    s[9] = CHI(B[9], B[5], B[6]);
+    s[10] = CHI(B[10], B[11], B[12]);
+    s[11] = CHI(B[11], B[12], B[13]);
+    s[12] = CHI(B[12], B[13], B[14]);
+    s[13] = CHI(B[13], B[14], B[10]);
+    s[14] = CHI(B[14], B[10], B[11]);
+    s[15] = CHI(B[15], B[16], B[17]);
+    s[16] = CHI(B[16], B[17], B[18]);
+    s[17] = CHI(B[17], B[18], B[19]);
+    s[18] = CHI(B[18], B[19], B[15]);
+    s[19] = CHI(B[19], B[15], B[16]);
+    s[20] = CHI(B[20], B[21], B[22]);
+    s[21] = CHI(B[21], B[22], B[23]);
+    s[22] = CHI(B[22], B[23], B[24]);
+    s[23] = CHI(B[23], B[24], B[20]);
+    s[24] = CHI(B[24], B[20], B[21]);
+    /* iota */
+    s[0] = _mm512_xor_si512(s[0], _mm512_set1_epi64((long long)KeccakF_RoundConstants[round]));
+  }
+}
+
+/* Xors one rate-sized block of each input into the matching state */
+static void keccakx8_xor_block(__m512i s[25], unsigned int r, const uint8_t *in[8], size_t offset)
+{
+  unsigned int i, j;
+  uint64_t w[8];
+
+  for(i = 0; i < r/8; i++) {
+    for(j = 0; j < 8; j++)
+      memcpy(&w[j], in[j] + offset + 8*i, 8);
+    s[i] = _mm512_xor_si512(s[i], _mm512_loadu_si512((const void *)w));
+  }
+}
+
+/*************************************************
+* Name:        keccakx8_absorb_once
+*
+* Description: Absorbs eight inputs of inlen bytes each into zeroed states and
+*              applies the domain separation byte p and the final padding bit
+*
+* Arguments:   - __m512i *s: pointer to the interleaved states
+*              - unsigned int r: rate in bytes
+*              - const uint8_t *in[8]: pointers to the inputs
+*              - size_t inlen: length of each input in bytes
+*              - uint8_t p: domain separation byte
+**************************************************/
+static void keccakx8_absorb_once(__m512i s[25], unsigned int r, const uint8_t *in[8], size_t inlen, uint8_t p)
+{
+  unsigned int i, j;
+  size_t offset = 0;
+  uint8_t t[8][SHAKE128_RATE];
+  const uint8_t *tp[8];
+
+  for(i = 0; i < 25; i++)
+    s[i] = _mm512_setzero_si512();
+
+  while(inlen >= r) {
+    keccakx8_xor_block(s, r, in, offset);
+    KeccakF1600_StatePermute8x(s);
+    offset += r;
+    inlen -= r;
+  }
+
+  for(j = 0; j < 8; j++) {
+    memset(t[j], 0, r);
+    memcpy(t[j], in[j] + offset, inlen);
+    t[j][inlen] = p;
+    t[j][r-1] |= 0x80;
+    tp[j] = t[j];
+  }
+  keccakx8_xor_block(s, r, tp, 0);
+}
+
+/*************************************************
+* Name:        keccakx8_squeezeblocks
+*
+* Description: Squeezes nblocks full blocks from each of the eight states
+*
+* Arguments:   - uint8_t *out[8]: pointers to the outputs
+*              - size_t nblocks: number of blocks per output
+*              - unsigned int r: rate in bytes
+*              - __m512i *s: pointer to the interleaved states
+**************************************************/
+static void keccakx8_squeezeblocks(uint8_t *out[8], size_t nblocks, unsigned int r, __m512i s[25])
+{
+  unsigned int i, j;
+  size_t offset = 0;
+  uint64_t w[8];
+
+  while(nblocks > 0) {
+    KeccakF1600_StatePermute8x(s);
+    for(i = 0; i < r/8; i++) {
+      _mm512_storeu_si512((void *)w, s[i]);
+      for(j = 0; j < 8; j++)
+        memcpy(out[j] + offset + 8*i, &w[j], 8);
+    }
+    offset += r;
+    nblocks--;
+  }
+}
+
+/* One-shot SHAKE over eight inputs of the same length */
+static void keccakx8(uint8_t *out[8], size_t outlen, unsigned int r,
+                     const uint8_t *in[8], size_t inlen)
+{
+  unsigned int j;
+  size_t nblocks = outlen/r;
+  uint8_t t[8][SHAKE128_RATE];
+  uint8_t *tp[8];
+  keccakx8_state state;
+
+  keccakx8_absorb_once(state.s, r, in, inlen, 0x1F);
+  keccakx8_squeezeblocks(out, nblocks, r, state.s);
+
+  outlen -= nblocks*r;
+  if(outlen) {
+    for(j = 0; j < 8; j++)
+      tp[j] = t[j];
+    keccakx8_squeezeblocks(tp, 1, r, state.s);
+    for(j = 0; j < 8; j++)
+      memcpy(out[j] + nblocks*r, t[j], outlen);
+  }
+}
+
+void shake128x8_absorb_once(keccakx8_state *state, const uint8_t *in[8], size_t inlen)
+{
+  keccakx8_absorb_once(state->s, SHAKE128_RATE, in, inlen, 0x1F);
+}
+
+void shake128x8_squeezeblocks(uint8_t *out[8], size_t nblocks, keccakx8_state *state)
+{
+  keccakx8_squeezeblocks(out, nblocks, SHAKE128_RATE, state->s);
+}
+
+void shake256x8_absorb_once(keccakx8_state *state, const uint8_t *in[8], size_t inlen)
+{
+  keccakx8_absorb_once(state->s, SHAKE256_RATE, in, inlen, 0x1F);
+}
+
+void shake256x8_squeezeblocks(uint8_t *out[8], size_t nblocks, keccakx8_state *state)
+{
+  keccakx8_squeezeblocks(out, nblocks, SHAKE256_RATE, state->s);
+}
+
+void shake128x8(uint8_t *out[8], size_t outlen, const uint8_t *in[8], size_t inlen)
+{
+  keccakx8(out, outlen, SHAKE128_RATE, in, inlen);
+}
+
+void shake256x8(uint8_t *out[8], size_t outlen, const uint8_t *in[8], size_t inlen)
+{
+  keccakx8(out, outlen, SHAKE256_RATE, in, inlen);
+}
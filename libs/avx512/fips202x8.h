@@ -0,0 +1,39 @@
+#ifndef FIPS202X8_H
+#define FIPS202X8_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <immintrin.h>
+#include "fips202.h"
+
+/*
+ * Eight independent SHAKE instances in the 64-bit lanes of 512-bit vectors:
+ * s[i] holds Keccak lane i of all eight states. Counterpart of fips202x4.h for
+ * the AVX-512 backend; all eight inputs must have the same length.
+ */
+
+#define FIPS202X8_NAMESPACE(s) pqcrystals_kyber_fips202x8_avx512_##s
+
+typedef struct {
+  __m512i s[25];
+} keccakx8_state;
+
+#define shake128x8_absorb_once FIPS202X8_NAMESPACE(shake128x8_absorb_once)
+void shake128x8_absorb_once(keccakx8_state *state, const uint8_t *in[8], size_t inlen);
+
+#define shake128x8_squeezeblocks FIPS202X8_NAMESPACE(shake128x8_squeezeblocks)
+void shake128x8_squeezeblocks(uint8_t *out[8], size_t nblocks, keccakx8_state *state);
+
+#define shake256x8_absorb_once FIPS202X8_NAMESPACE(shake256x8_absorb_once)
+void shake256x8_absorb_once(keccakx8_state *state, const uint8_t *in[8], size_t inlen);
+
+#define shake256x8_squeezeblocks FIPS202X8_NAMESPACE(shake256x8_squeezeblocks)
+void shake256x8_squeezeblocks(uint8_t *out[8], size_t nblocks, keccakx8_state *state);
+
+#define shake128x8 FIPS202X8_NAMESPACE(shake128x8)
+void shake128x8(uint8_t *out[8], size_t outlen, const uint8_t *in[8], size_t inlen);
+
+#define shake256x8 FIPS202X8_NAMESPACE(shake256x8)
+void shake256x8(uint8_t *out[8], size_t outlen, const uint8_t *in[8], size_t inlen);
+
+#endif
@@ -0,0 +1,285 @@
+#include <stdint.h>
+#include <immintrin.h>
+#include "params.h"
+#include "consts.h"
+#include "ntt.h"
+
+/*
+ * The 256 coefficients of a polynomial live in eight 512-bit vectors of 32
+ * coefficients each. The layers with len >= 32 pair whole vectors; for len < 32
+ * the two vectors of each 64-coefficient block are reshuffled before every layer
+ * so that the first one holds the lower and the second the upper butterfly
+ * inputs. Those reshuffles move 256-, 128-, 64- and 32-bit units and are their
+ * own inverses; only the return to natural order needs a 16-bit permutation
+ * (see consts.c). The arithmetic matches the reference code in libs/ref/ntt.c
+ * lane by lane, so both produce identical representatives, not just congruent
+ * ones.
+ */
+
+#define V_Q    _mm512_set1_epi16(KYBER_Q)
+#define V_QINV _mm512_set1_epi16(-3327)
+
+/* Montgomery multiplication a*b*2^-16 with bqinv = b*QINV mod 2^16 */
+static inline __m512i fqmul(__m512i a, __m512i b, __m512i bqinv)
+{
+  __m512i lo = _mm512_mullo_epi16(a, bqinv);
+  __m512i hi = _mm512_mulhi_epi16(a, b);
+  lo = _mm512_mulhi_epi16(lo, V_Q);
+  return _mm512_sub_epi16(hi, lo);
+}
+
+/* Same as barrett_reduce(): ((20159*a + 2^25) >> 26) computed as two shifts */
+static inline __m512i barrett(__m512i a)
+{
+  __m512i t = _mm512_mulhi_epi16(a, _mm512_set1_epi16(20159));
+  t = _mm512_mulhrs_epi16(t, _mm512_set1_epi16(1 << 5));
+  t = _mm512_mullo_epi16(t, V_Q);
+  return _mm512_sub_epi16(a, t);
+}
+
+static inline void butterfly(__m512i *p, __m512i *q, __m512i z, __m512i zqinv)
+{
+  __m512i t = fqmul(*q, z, zqinv);
+  *q = _mm512_sub_epi16(*p, t);
+  *p = _mm512_add_epi16(*p, t);
+}
+
+static inline void invbutterfly(__m512i *p, __m512i *q, __m512i z, __m512i zqinv)
+{
+  __m512i t = *p;
+  *p = barrett(_mm512_add_epi16(t, *q));
+  *q = fqmul(_mm512_sub_epi16(*q, t), z, zqinv);
+}
+
+static inline __m512i bcast(int16_t c)
+{
+  return _mm512_set1_epi16(c);
+}
+
+static inline __m512i bcast_qinv(int16_t c)
+{
+  return _mm512_set1_epi16((int16_t)(c * -3327));
+}
+
+static inline void permute(__m512i *p, __m512i *q, const int16_t idx[64])
+{
+  __m512i lo = _mm512_load_si512((const void *)idx);
+  __m512i hi = _mm512_load_si512((const void *)(idx + 32));
+  __m512i a = _mm512_permutex2var_epi16(*p, lo, *q);
+  *q = _mm512_permutex2var_epi16(*p, hi, *q);
+  *p = a;
+}
+
+/* Swaps the upper 256 bits of p with the lower 256 bits of q */
+static inline void shuffle16(__m512i *p, __m512i *q)
+{
+  __m512i a = _mm512_shuffle_i64x2(*p, *q, 0x44);
+  *q = _mm512_shuffle_i64x2(*p, *q, 0xEE);
+  *p = a;
+}
+
+/* Interleaves the 128-bit units of p and q: p = (p0, q0, p2, q2), q = (p1, q1, p3, q3) */
+static inline void shuffle8(__m512i *p, __m512i *q)
+{
+  const __m512i lo = _mm512_setr_epi64(0, 1, 8, 9, 4, 5, 12, 13);
+  const __m512i hi = _mm512_setr_epi64(2, 3, 10, 11, 6, 7, 14, 15);
+  __m512i a = _mm512_permutex2var_epi64(*p, lo, *q);
+  *q = _mm512_permutex2var_epi64(*p, hi, *q);
+  *p = a;
+}
+
+/* Interleaves the 64-bit units of p and q */
+static inline void shuffle4(__m512i *p, __m512i *q)
+{
+  __m512i a = _mm512_unpacklo_epi64(*p, *q);
+  *q = _mm512_unpackhi_epi64(*p, *q);
+  *p = a;
+}
+
+/* Interleaves the 32-bit units of p and q */
+static inline void shuffle2(__m512i *p, __m512i *q)
+{
+  __m512i a = _mm512_mask_blend_epi32(0xAAAA, *p, _mm512_slli_epi64(*q, 32));
+  *q = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(*p, 32), *q);
+  *p = a;
+}
+
+/*************************************************
+* Name:        ntt_avx512
+*
+* Description: Forward NTT, same input and output order as ntt() in
+*              libs/ref/ntt.c (standard in, bitreversed out)
+*
+* Arguments:   - int16_t r[256]: pointer to input/output vector of elements of Zq
+**************************************************/
+void ntt_avx512(int16_t r[256])
+{
+  unsigned int i, p;
+  __m512i v[8], z, zq;
+
+  for(i = 0; i < 8; i++)
+    v[i] = _mm512_loadu_si512((const void *)(r + 32*i));
+
+  z = bcast(zetas[1]);
+  zq = bcast_qinv(zetas[1]);
+  for(i = 0; i < 4; i++)
+    butterfly(&v[i], &v[i+4], z, zq);
+
+  for(p = 0; p < 2; p++) {
+    z = bcast(zetas[2+p]);
+    zq = bcast_qinv(zetas[2+p]);
+    butterfly(&v[4*p], &v[4*p+2], z, zq);
+    butterfly(&v[4*p+1], &v[4*p+3], z, zq);
+  }
+
+  for(p = 0; p < 4; p++) {
+    __m512i *a = &v[2*p], *b = &v[2*p+1];
+
+    butterfly(a, b, bcast(zetas[4+p]), bcast_qinv(zetas[4+p]));
+
+    shuffle16(a, b);
+    butterfly(a, b, _mm512_load_si512((const void *)ntt512_zetas_fwd[0][p]),
+              _mm512_load_si512((const void *)ntt512_zetas_fwd_qinv[0][p]));
+    shuffle8(a, b);
+    butterfly(a, b, _mm512_load_si512((const void *)ntt512_zetas_fwd[1][p]),
+              _mm512_load_si512((const void *)ntt512_zetas_fwd_qinv[1][p]));
+    shuffle4(a, b);
+    butterfly(a, b, _mm512_load_si512((const void *)ntt512_zetas_fwd[2][p]),
+              _mm512_load_si512((const void *)ntt512_zetas_fwd_qinv[2][p]));
+    shuffle2(a, b);
+    butterfly(a, b, _mm512_load_si512((const void *)ntt512_zetas_fwd[3][p]),
+              _mm512_load_si512((const void *)ntt512_zetas_fwd_qinv[3][p]));
+
+    permute(a, b, ntt512_perm_fwd);
+  }
+
+  for(i = 0; i < 8; i++)
+    _mm512_storeu_si512((void *)(r + 32*i), v[i]);
+}
+
+/*************************************************
+* Name:        invntt_avx512
+*
+* Description: Inverse NTT and multiplication by the Montgomery factor 2^16,
+*              same as invntt() in libs/ref/ntt.c
+*
+* Arguments:   - int16_t r[256]: pointer to input/output vector of elements of Zq
+**************************************************/
+void invntt_avx512(int16_t r[256])
+{
+  unsigned int i, p;
+  __m512i v[8], z, zq;
+  const int16_t f = 1441; // mont^2/128
+
+  for(i = 0; i < 8; i++)
+    v[i] = _mm512_loadu_si512((const void *)(r + 32*i));
+
+  for(p = 0; p < 4; p++) {
+    __m512i *a = &v[2*p], *b = &v[2*p+1];
+
+    permute(a, b, ntt512_perm_inv);
+
+    invbutterfly(a, b, _mm512_load_si512((const void *)ntt512_zetas_inv[0][p]),
+                 _mm512_load_si512((const void *)ntt512_zetas_inv_qinv[0][p]));
+    shuffle2(a, b);
+    invbutterfly(a, b, _mm512_load_si512((const void *)ntt512_zetas_inv[1][p]),
+                 _mm512_load_si512((const void *)ntt512_zetas_inv_qinv[1][p]));
+    shuffle4(a, b);
+    invbutterfly(a, b, _mm512_load_si512((const void *)ntt512_zetas_inv[2][p]),
+                 _mm512_load_si512((const void *)ntt512_zetas_inv_qinv[2][p]));
+    shuffle8(a, b);
+    invbutterfly(a, b, _mm512_load_si512((const void *)ntt512_zetas_inv[3][p]),
+                 _mm512_load_si512((const void *)ntt512_zetas_inv_qinv[3][p]));
+    shuffle16(a, b);
+
+    invbutterfly(a, b, bcast(zetas[7-p]), bcast_qinv(zetas[7-p]));
+  }
+
+  for(p = 0; p < 2; p++) {
+    z = bcast(zetas[3-p]);
+    zq = bcast_qinv(zetas[3-p]);
+    invbutterfly(&v[4*p], &v[4*p+2], z, zq);
+    invbutterfly(&v[4*p+1], &v[4*p+3], z, zq);
+  }
+
+  z = bcast(zetas[1]);
+  zq = bcast_qinv(zetas[1]);
+  for(i = 0; i < 4; i++)
+    invbutterfly(&v[i], &v[i+4], z, zq);
+
+  z = bcast(f);
+  zq = bcast_qinv(f);
+  for(i = 0; i < 8; i++)
+    _mm512_storeu_si512((void *)(r + 32*i), fqmul(v[i], z, zq));
+}
+
+/*************************************************
+* Name:        basemul_avx512
+*
+* Description: Pointwise product of two polynomials in the NTT domain, i.e. 64
+*              products in Zq[X]/(X^2-zeta) as computed by basemul() in
+*              libs/ref/ntt.c. Each 32-bit lane holds one (c0, c1) pair.
+*
+* Arguments:   - int16_t r[256]: pointer to the output polynomial
+*              - const int16_t a[256]: pointer to the first factor
+*              - const int16_t b[256]: pointer to the second factor
+**************************************************/
+void basemul_avx512(int16_t r[256], const int16_t a[256], const int16_t b[256])
+{
+  unsigned int i;
+  __m512i va, vb, vbs, p, c, e, z, zq;
+
+  for(i = 0; i < 8; i++) {
+    va = _mm512_loadu_si512((const void *)(a + 32*i));
+    vb = _mm512_loadu_si512((const void *)(b + 32*i));
+    z = _mm512_load_si512((const void *)(basemul512_zetas + 32*i));
+    zq = _mm512_load_si512((const void *)(basemul512_zetas_qinv + 32*i));
+
+    /* (a0*b0, a1*b1) and (a0*b1, a1*b0) */
+    vbs = _mm512_rol_epi32(vb, 16);
+    p = fqmul(va, vb, _mm512_mullo_epi16(vb, V_QINV));
+    c = fqmul(va, vbs, _mm512_mullo_epi16(vbs, V_QINV));
+
+    /* r0 = a1*b1*zeta + a0*b0, r1 = a0*b1 + a1*b0 */
+    e = _mm512_add_epi16(fqmul(_mm512_rol_epi32(p, 16), z, zq), p);
+    c = _mm512_add_epi16(c, _mm512_rol_epi32(c, 16));
+
+    _mm512_storeu_si512((void *)(r + 32*i), _mm512_mask_blend_epi16(0xAAAAAAAA, e, c));
+  }
+}
+
+/*************************************************
+* Name:        tomont_avx512
+*
+* Description: Inplace conversion of all coefficients to the Montgomery domain
+*
+* Arguments:   - int16_t r[256]: pointer to input/output vector of elements of Zq
+**************************************************/
+void tomont_avx512(int16_t r[256])
+{
+  unsigned int i;
+  const int16_t f = (1ULL << 32) % KYBER_Q;
+  const __m512i z = bcast(f), zq = bcast_qinv(f);
+
+  for(i = 0; i < 8; i++) {
+    __m512i v = _mm512_loadu_si512((const void *)(r + 32*i));
+    _mm512_storeu_si512((void *)(r + 32*i), fqmul(v, z, zq));
+  }
+}
+
+/*************************************************
+* Name:        reduce_avx512
+*
+* Description: Applies Barrett reduction to all coefficients
+*
+* Arguments:   - int16_t r[256]: pointer to input/output vector of elements of Zq
+**************************************************/
+void reduce_avx512(int16_t r[256])
+{
+  unsigned int i;
+
+  for(i = 0; i < 8; i++) {
+    __m512i v = _mm512_loadu_si512((const void *)(r + 32*i));
+    _mm512_storeu_si512((void *)(r + 32*i), barrett(v));
+  }
+}
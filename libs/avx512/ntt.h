@@ -0,0 +1,26 @@
+#ifndef NTT512_H
+#define NTT512_H
+
+#include <stdint.h>
+#include "params.h"
+
+/* Reference zetas table (libs/ref/ntt.c); the AVX-512 tables derive from it. */
+#define zetas KYBER_NAMESPACE(zetas)
+extern const int16_t zetas[128];
+
+#define ntt_avx512 KYBER_NAMESPACE(ntt_avx512)
+void ntt_avx512(int16_t r[256]);
+
+#define invntt_avx512 KYBER_NAMESPACE(invntt_avx512)
+void invntt_avx512(int16_t r[256]);
+
+#define basemul_avx512 KYBER_NAMESPACE(basemul_avx512)
+void basemul_avx512(int16_t r[256], const int16_t a[256], const int16_t b[256]);
+
+#define tomont_avx512 KYBER_NAMESPACE(tomont_avx512)
+void tomont_avx512(int16_t r[256]);
+
+#define reduce_avx512 KYBER_NAMESPACE(reduce_avx512)
+void reduce_avx512(int16_t r[256]);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef PACK512_H
+#define PACK512_H
+
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+#include "params.h"
+
+/*
+ * Helpers for the (de)serialization code. A 512-bit vector of 32 coefficients
+ * is packed as four independent 128-bit lanes of 8 coefficients, each lane
+ * covering `stride` bytes of the byte string. The 16-byte lane accesses read
+ * or write past the end of a 4*stride block, which is harmless in the middle of
+ * a byte string; the last block of a string goes through a bounce buffer.
+ */
+
+static inline __m512i load_lanes(const uint8_t *p, unsigned int stride, int last)
+{
+  uint8_t tmp[64] = {0};
+  __m512i v;
+
+  if(last) {
+    memcpy(tmp, p, 4*stride);
+    p = tmp;
+  }
+  v = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i *)p));
+  v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i *)(p + stride)), 1);
+  v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i *)(p + 2*stride)), 2);
+  v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i *)(p + 3*stride)), 3);
+  return v;
+}
+
+/* Lanes are stored in ascending order so each one overwrites the tail of the previous */
+static inline void store_lanes(uint8_t *p, unsigned int stride, int last, __m512i v)
+{
+  uint8_t tmp[64];
+  uint8_t *q = last ? tmp : p;
+
+  _mm_storeu_si128((__m128i *)q, _mm512_castsi512_si128(v));
+  _mm_storeu_si128((__m128i *)(q + stride), _mm512_extracti32x4_epi32(v, 1));
+  _mm_storeu_si128((__m128i *)(q + 2*stride), _mm512_extracti32x4_epi32(v, 2));
+  _mm_storeu_si128((__m128i *)(q + 3*stride), _mm512_extracti32x4_epi32(v, 3));
+  if(last)
+    memcpy(p, tmp, 4*stride);
+}
+
+/* Maps int16 coefficients in (-q, q) to [0, q), as `t += ((int16_t)t >> 15) & KYBER_Q` */
+static inline __m512i csubq_neg(__m512i a)
+{
+  return _mm512_add_epi16(a, _mm512_and_si512(_mm512_srai_epi16(a, 15), _mm512_set1_epi16(KYBER_Q)));
+}
+
+/* ((t & (2^d-1))*KYBER_Q + 2^(d-1)) >> d for d-bit values t, as one rounding multiplication */
+static inline __m512i decompress_d(__m512i t, unsigned int d)
+{
+  t = _mm512_and_si512(t, _mm512_set1_epi16((1 << d) - 1));
+  return _mm512_mulhrs_epi16(_mm512_slli_epi16(t, 15 - d), _mm512_set1_epi16(KYBER_Q));
+}
+
+#endif
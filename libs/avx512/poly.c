@@ -0,0 +1,354 @@
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+#include "params.h"
+#include "poly.h"
+#include "polyx8.h"
+#include "ntt.h"
+#include "cbd.h"
+#include "fips202x8.h"
+#include "pack512.h"
+
+/*
+ * poly.c for the AVX-512 backend. Only the single-polynomial noise functions
+ * come from libs/ref/poly.c, which leaves out everything below when
+ * KYBER_BACKEND_AVX512 is defined. The (de)compression routines evaluate the
+ * same integer expressions as the reference code, so the byte strings match
+ * exactly.
+ */
+
+/* Reference compression of 16 coefficients in 32-bit lanes (d0 in libs/ref/poly.c) */
+static inline __m256i compress_x16(__m256i a)
+{
+  __m512i u = _mm512_cvtepi16_epi32(a);
+  u = _mm512_add_epi32(u, _mm512_and_si512(_mm512_srai_epi32(u, 15), _mm512_set1_epi32(KYBER_Q)));
+#if (KYBER_POLYCOMPRESSEDBYTES == 128)
+  u = _mm512_add_epi32(_mm512_slli_epi32(u, 4), _mm512_set1_epi32(1665));
+  u = _mm512_srli_epi32(_mm512_mullo_epi32(u, _mm512_set1_epi32(80635)), 28);
+  u = _mm512_and_si512(u, _mm512_set1_epi32(0xf));
+#elif (KYBER_POLYCOMPRESSEDBYTES == 160)
+  u = _mm512_add_epi32(_mm512_slli_epi32(u, 5), _mm512_set1_epi32(1664));
+  u = _mm512_srli_epi32(_mm512_mullo_epi32(u, _mm512_set1_epi32(40318)), 27);
+  u = _mm512_and_si512(u, _mm512_set1_epi32(0x1f));
+#else
+#error "KYBER_POLYCOMPRESSEDBYTES needs to be in {128, 160}"
+#endif
+  return _mm512_cvtepi32_epi16(u);
+}
+
+/*************************************************
+* Name:        poly_compress
+*
+* Description: Compression and subsequent serialization of a polynomial
+*
+* Arguments:   - uint8_t *r: pointer to output byte array
+*                            (of length KYBER_POLYCOMPRESSEDBYTES)
+*              - const poly *a: pointer to input polynomial
+**************************************************/
+void poly_compress(uint8_t r[KYBER_POLYCOMPRESSEDBYTES], const poly *a)
+{
+  unsigned int i;
+  __m512i v;
+
+  for(i = 0; i < KYBER_N/32; i++) {
+    v = _mm512_loadu_si512((const void *)(a->coeffs + 32*i));
+    v = _mm512_inserti64x4(_mm512_castsi256_si512(compress_x16(_mm512_castsi512_si256(v))),
+                           compress_x16(_mm512_extracti64x4_epi64(v, 1)), 1);
+#if (KYBER_POLYCOMPRESSEDBYTES == 128)
+    /* t0 | t1 << 4 in the low byte of each 32-bit lane */
+    v = _mm512_or_si512(v, _mm512_srli_epi32(v, 12));
+    _mm_storeu_si128((__m128i *)(r + 16*i), _mm512_cvtepi32_epi8(v));
+#else
+    /* 10 bits per 32-bit lane, 20 per 64-bit lane, 40 in the low half of each 128-bit lane */
+    v = _mm512_madd_epi16(v, _mm512_set1_epi32(1 | (32 << 16)));
+    v = _mm512_or_si512(_mm512_and_si512(v, _mm512_set1_epi64(0x3FF)),
+                        _mm512_andnot_si512(_mm512_set1_epi64(0x3FF), _mm512_srli_epi64(v, 22)));
+    v = _mm512_or_si512(v, _mm512_slli_epi64(_mm512_bsrli_epi128(v, 8), 20));
+    store_lanes(r + 20*i, 5, i == KYBER_N/32 - 1, v);
+#endif
+  }
+}
+
+/*************************************************
+* Name:        poly_decompress
+*
+* Description: De-serialization and subsequent decompression of a polynomial;
+*              approximate inverse of poly_compress
+*
+* Arguments:   - poly *r: pointer to output polynomial
+*              - const uint8_t *a: pointer to input byte array
+*                                  (of length KYBER_POLYCOMPRESSEDBYTES bytes)
+**************************************************/
+void poly_decompress(poly *r, const uint8_t a[KYBER_POLYCOMPRESSEDBYTES])
+{
+  unsigned int i;
+  __m512i t;
+
+  for(i = 0; i < KYBER_N/32; i++) {
+#if (KYBER_POLYCOMPRESSEDBYTES == 128)
+    __m128i b = _mm_loadu_si128((const __m128i *)(a + 16*i));
+    __m128i lo = _mm_and_si128(b, _mm_set1_epi8(15));
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(b, 4), _mm_set1_epi8(15));
+    t = _mm512_cvtepu8_epi16(_mm256_set_m128i(_mm_unpackhi_epi8(lo, hi), _mm_unpacklo_epi8(lo, hi)));
+    t = decompress_d(t, 4);
+#else
+    /* coefficient k of a lane starts at bit 5k of its 5 bytes */
+    const __m512i idx = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 0, 1, 1, 2, 1, 2, 2, 3, 3, 4, 3, 4, 4, 5));
+    const __m512i shift = _mm512_broadcast_i32x4(_mm_setr_epi16(0, 5, 2, 7, 4, 1, 6, 3));
+    t = _mm512_shuffle_epi8(load_lanes(a + 20*i, 5, i == KYBER_N/32 - 1), idx);
+    t = decompress_d(_mm512_srlv_epi16(t, shift), 5);
+#endif
+    _mm512_storeu_si512((void *)(r->coeffs + 32*i), t);
+  }
+}
+
+/*************************************************
+* Name:        poly_tobytes
+*
+* Description: Serialization of a polynomial
+*
+* Arguments:   - uint8_t *r: pointer to output byte array
+*                            (needs space for KYBER_POLYBYTES bytes)
+*              - const poly *a: pointer to input polynomial
+**************************************************/
+void poly_tobytes(uint8_t r[KYBER_POLYBYTES], const poly *a)
+{
+  unsigned int i;
+  const __m512i idx = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
+  __m512i t;
+
+  for(i = 0; i < KYBER_N/32; i++) {
+    t = csubq_neg(_mm512_loadu_si512((const void *)(a->coeffs + 32*i)));
+    /* t0 | t1 << 12 in the low three bytes of each 32-bit lane */
+    t = _mm512_madd_epi16(t, _mm512_set1_epi32(1 | (4096 << 16)));
+    store_lanes(r + 48*i, 12, i == KYBER_N/32 - 1, _mm512_shuffle_epi8(t, idx));
+  }
+}
+
+/*************************************************
+* Name:        poly_frombytes
+*
+* Description: De-serialization of a polynomial;
+*              inverse of poly_tobytes
+*
+* Arguments:   - poly *r: pointer to output polynomial
+*              - const uint8_t *a: pointer to input byte array
+*                                  (of KYBER_POLYBYTES bytes)
+**************************************************/
+void poly_frombytes(poly *r, const uint8_t a[KYBER_POLYBYTES])
+{
+  unsigned int i;
+  const __m512i idx = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11));
+  const __m512i shift = _mm512_set1_epi32(4 << 16);
+  __m512i t;
+
+  for(i = 0; i < KYBER_N/32; i++) {
+    t = _mm512_shuffle_epi8(load_lanes(a + 48*i, 12, i == KYBER_N/32 - 1), idx);
+    t = _mm512_and_si512(_mm512_srlv_epi16(t, shift), _mm512_set1_epi16(0xFFF));
+    _mm512_storeu_si512((void *)(r->coeffs + 32*i), t);
+  }
+}
+
+/*************************************************
+* Name:        poly_frommsg
+*
+* Description: Convert 32-byte message to polynomial
+*
+* Arguments:   - poly *r: pointer to output polynomial
+*              - const uint8_t *msg: pointer to input message
+**************************************************/
+void poly_frommsg(poly *r, const uint8_t msg[KYBER_INDCPA_MSGBYTES])
+{
+  unsigned int i;
+  uint32_t m;
+
+#if (KYBER_INDCPA_MSGBYTES != KYBER_N/8)
+#error "KYBER_INDCPA_MSGBYTES must be equal to KYBER_N/8 bytes!"
+#endif
+
+  for(i = 0; i < KYBER_N/32; i++) {
+    memcpy(&m, msg + 4*i, 4);
+    _mm512_storeu_si512((void *)(r->coeffs + 32*i),
+                        _mm512_maskz_mov_epi16(m, _mm512_set1_epi16((KYBER_Q+1)/2)));
+  }
+}
+
+/*************************************************
+* Name:        poly_tomsg
+*
+* Description: Convert polynomial to 32-byte message
+*
+* Arguments:   - uint8_t *msg: pointer to output message
+*              - const poly *a: pointer to input polynomial
+**************************************************/
+void poly_tomsg(uint8_t msg[KYBER_INDCPA_MSGBYTES], const poly *a)
+{
+  unsigned int i;
+  uint16_t m;
+  __m512i t;
+
+  for(i = 0; i < KYBER_N/16; i++) {
+    /* t as in the reference code, including its uint32_t wrap-around */
+    t = _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i *)(a->coeffs + 16*i)));
+    t = _mm512_add_epi32(_mm512_slli_epi32(t, 1), _mm512_set1_epi32(1665));
+    t = _mm512_srli_epi32(_mm512_mullo_epi32(t, _mm512_set1_epi32(80635)), 28);
+    m = _mm512_test_epi32_mask(t, _mm512_set1_epi32(1));
+    memcpy(msg + 2*i, &m, 2);
+  }
+}
+
+/*************************************************
+* Name:        poly_getnoise_x8
+*
+* Description: Samples n noise polynomials with 8-way SHAKE256; the first n_eta1
+*              with parameter KYBER_ETA1, the rest with KYBER_ETA2. Polynomial i
+*              uses nonce + i, so the result equals n calls of
+*              poly_getnoise_eta1()/poly_getnoise_eta2().
+*
+* Arguments:   - poly *r[]: pointers to the n output polynomials
+*              - unsigned int n: number of polynomials
+*              - unsigned int n_eta1: how many of them use KYBER_ETA1
+*              - const uint8_t *seed: pointer to input seed
+*                                     (of length KYBER_SYMBYTES bytes)
+*              - uint8_t nonce: nonce of the first polynomial
+**************************************************/
+void poly_getnoise_x8(poly *r[], unsigned int n, unsigned int n_eta1,
+                      const uint8_t seed[KYBER_SYMBYTES], uint8_t nonce)
+{
+  unsigned int i, j, lanes;
+  uint8_t ext[8][KYBER_SYMBYTES+1];
+  uint8_t buf[8][2*SHAKE256_RATE];
+  const uint8_t *in[8];
+  uint8_t *out[8];
+  keccakx8_state state;
+
+#if KYBER_ETA1*KYBER_N/4 > 2*SHAKE256_RATE || KYBER_ETA2*KYBER_N/4 > 2*SHAKE256_RATE
+#error "poly_getnoise_x8 assumes that two SHAKE256 blocks cover the noise input"
+#endif
+
+  for(i = 0; i < n; i += 8) {
+    lanes = n - i < 8 ? n - i : 8;
+    for(j = 0; j < 8; j++) {
+      memcpy(ext[j], seed, KYBER_SYMBYTES);
+      ext[j][KYBER_SYMBYTES] = nonce + i + (j < lanes ? j : 0);
+      in[j] = ext[j];
+      out[j] = buf[j];
+    }
+
+    shake256x8_absorb_once(&state, in, KYBER_SYMBYTES+1);
+    shake256x8_squeezeblocks(out, 2, &state);
+
+    for(j = 0; j < lanes; j++) {
+      if(i + j < n_eta1)
+        poly_cbd_eta1(r[i+j], buf[j]);
+      else
+        poly_cbd_eta2(r[i+j], buf[j]);
+    }
+  }
+}
+
+/*************************************************
+* Name:        poly_ntt
+*
+* Description: Computes negacyclic number-theoretic transform (NTT) of
+*              a polynomial in place;
+*              inputs assumed to be in normal order, output in bitreversed order
+*
+* Arguments:   - uint16_t *r: pointer to in/output polynomial
+**************************************************/
+void poly_ntt(poly *r)
+{
+  ntt_avx512(r->coeffs);
+  reduce_avx512(r->coeffs);
+}
+
+/*************************************************
+* Name:        poly_invntt_tomont
+*
+* Description: Computes inverse of negacyclic number-theoretic transform (NTT)
+*              of a polynomial in place;
+*              inputs assumed to be in bitreversed order, output in normal order
+*
+* Arguments:   - uint16_t *a: pointer to in/output polynomial
+**************************************************/
+void poly_invntt_tomont(poly *r)
+{
+  invntt_avx512(r->coeffs);
+}
+
+/*************************************************
+* Name:        poly_basemul_montgomery
+*
+* Description: Multiplication of two polynomials in NTT domain
+*
+* Arguments:   - poly *r: pointer to output polynomial
+*              - const poly *a: pointer to first input polynomial
+*              - const poly *b: pointer to second input polynomial
+**************************************************/
+void poly_basemul_montgomery(poly *r, const poly *a, const poly *b)
+{
+  basemul_avx512(r->coeffs, a->coeffs, b->coeffs);
+}
+
+/*************************************************
+* Name:        poly_tomont
+*
+* Description: Inplace conversion of all coefficients of a polynomial
+*              from normal domain to Montgomery domain
+*
+* Arguments:   - poly *r: pointer to input/output polynomial
+**************************************************/
+void poly_tomont(poly *r)
+{
+  tomont_avx512(r->coeffs);
+}
+
+/*************************************************
+* Name:        poly_reduce
+*
+* Description: Applies Barrett reduction to all coefficients of a polynomial
+*
+* Arguments:   - poly *r: pointer to input/output polynomial
+**************************************************/
+void poly_reduce(poly *r)
+{
+  reduce_avx512(r->coeffs);
+}
+
+/*************************************************
+* Name:        poly_add
+*
+* Description: Add two polynomials; no modular reduction is performed
+*
+* Arguments: - poly *r: pointer to output polynomial
+*            - const poly *a: pointer to first input polynomial
+*            - const poly *b: pointer to second input polynomial
+**************************************************/
+void poly_add(poly *r, const poly *a, const poly *b)
+{
+  unsigned int i;
+  for(i = 0; i < KYBER_N/32; i++) {
+    __m512i x = _mm512_loadu_si512((const void *)(a->coeffs + 32*i));
+    __m512i y = _mm512_loadu_si512((const void *)(b->coeffs + 32*i));
+    _mm512_storeu_si512((void *)(r->coeffs + 32*i), _mm512_add_epi16(x, y));
+  }
+}
+
+/*************************************************
+* Name:        poly_sub
+*
+* Description: Subtract two polynomials; no modular reduction is performed
+*
+* Arguments: - poly *r:       pointer to output polynomial
+*            - const poly *a: pointer to first input polynomial
+*            - const poly *b: pointer to second input polynomial
+**************************************************/
+void poly_sub(poly *r, const poly *a, const poly *b)
+{
+  unsigned int i;
+  for(i = 0; i < KYBER_N/32; i++) {
+    __m512i x = _mm512_loadu_si512((const void *)(a->coeffs + 32*i));
+    __m512i y = _mm512_loadu_si512((const void *)(b->coeffs + 32*i));
+    _mm512_storeu_si512((void *)(r->coeffs + 32*i), _mm512_sub_epi16(x, y));
+  }
+}
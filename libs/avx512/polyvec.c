@@ -0,0 +1,135 @@
+#include <stdint.h>
+#include <immintrin.h>
+#include "params.h"
+#include "poly.h"
+#include "polyvec.h"
+#include "pack512.h"
+
+/*
+ * Compression of vectors of polynomials for the AVX-512 backend; the remaining
+ * functions of polyvec.c come from libs/ref/polyvec.c. The reference code
+ * computes the compressed value with a 64-bit product, reproduced here with
+ * _mm512_mul_epu32() on the even and odd 32-bit lanes.
+ */
+
+#if (KYBER_POLYVECCOMPRESSEDBYTES == (KYBER_K * 352))
+#define POLYVEC_D 11
+#define POLYVEC_OFFSET 1664
+#define POLYVEC_FACTOR 645084
+#define POLYVEC_SHIFT 31
+#elif (KYBER_POLYVECCOMPRESSEDBYTES == (KYBER_K * 320))
+#define POLYVEC_D 10
+#define POLYVEC_OFFSET 1665
+#define POLYVEC_FACTOR 1290167
+#define POLYVEC_SHIFT 32
+#else
+#error "KYBER_POLYVECCOMPRESSEDBYTES needs to be in {320*KYBER_K, 352*KYBER_K}"
+#endif
+
+#define POLYVEC_STRIDE POLYVEC_D /* bytes per 8 coefficients */
+
+/* ((t << D) + OFFSET) * FACTOR >> SHIFT for 16 canonical coefficients */
+static inline __m256i compress_x16(__m256i a)
+{
+  const __m512i f = _mm512_set1_epi64(POLYVEC_FACTOR);
+  __m512i x, even, odd;
+
+  x = _mm512_cvtepu16_epi32(a);
+  x = _mm512_add_epi32(_mm512_slli_epi32(x, POLYVEC_D), _mm512_set1_epi32(POLYVEC_OFFSET));
+  even = _mm512_srli_epi64(_mm512_mul_epu32(x, f), POLYVEC_SHIFT);
+  odd = _mm512_slli_epi64(_mm512_mul_epu32(_mm512_srli_epi64(x, 32), f), 32 - POLYVEC_SHIFT);
+  x = _mm512_mask_blend_epi32(0xAAAA, even, odd);
+  x = _mm512_and_si512(x, _mm512_set1_epi32((1 << POLYVEC_D) - 1));
+  return _mm512_cvtepi32_epi16(x);
+}
+
+/* Packs the 8 D-bit values of each 128-bit lane into its low D bytes */
+static inline __m512i pack_lanes(__m512i t)
+{
+#if POLYVEC_D == 10
+  const __m512i idx = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 2, 3, 4, 8, 9, 10, 11, 12, -1, -1, -1, -1, -1, -1));
+  const __m512i m = _mm512_set1_epi64(0xFFFFF);
+
+  t = _mm512_madd_epi16(t, _mm512_set1_epi32(1 | (1024 << 16)));
+  t = _mm512_or_si512(_mm512_and_si512(t, m), _mm512_andnot_si512(m, _mm512_srli_epi64(t, 12)));
+  return _mm512_shuffle_epi8(t, idx);
+#else
+  const __m512i m = _mm512_set1_epi64(0x3FFFFF);
+
+  t = _mm512_madd_epi16(t, _mm512_set1_epi32(1 | (2048 << 16)));
+  t = _mm512_or_si512(_mm512_and_si512(t, m), _mm512_andnot_si512(m, _mm512_srli_epi64(t, 10)));
+  /* 44 bits per 64-bit lane: q0 | q1 << 44 spans bytes 0..10 of the 128-bit lane */
+  return _mm512_mask_blend_epi64(0xAA,
+                                 _mm512_or_si512(t, _mm512_slli_epi64(_mm512_bsrli_epi128(t, 8), 44)),
+                                 _mm512_srli_epi64(t, 20));
+#endif
+}
+
+/* Inverse of pack_lanes(); coefficient k of a lane starts at bit D*k */
+static inline __m512i unpack_lanes(__m512i b)
+{
+#if POLYVEC_D == 10
+  const __m512i idx = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 1, 2, 2, 3, 3, 4, 5, 6, 6, 7, 7, 8, 8, 9));
+  const __m512i shift = _mm512_broadcast_i32x4(_mm_setr_epi16(0, 2, 4, 6, 0, 2, 4, 6));
+
+  return _mm512_srlv_epi16(_mm512_shuffle_epi8(b, idx), shift);
+#else
+  /* coefficients 2 and 5 of a lane reach into a third byte */
+  const __m512i idx = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 1, 2, 2, 3, 4, 5, 5, 6, 6, 7, 8, 9, 9, 10));
+  const __m512i shift = _mm512_broadcast_i32x4(_mm_setr_epi16(0, 3, 6, 1, 4, 7, 2, 5));
+  const __m512i idx3 = _mm512_broadcast_i32x4(_mm_setr_epi8(-1, -1, -1, -1, 4, -1, -1, -1, -1, -1, 8, -1, -1, -1, -1, -1));
+  const __m512i shift3 = _mm512_broadcast_i32x4(_mm_setr_epi16(0, 0, 10, 0, 0, 9, 0, 0));
+
+  return _mm512_or_si512(_mm512_srlv_epi16(_mm512_shuffle_epi8(b, idx), shift),
+                         _mm512_sllv_epi16(_mm512_shuffle_epi8(b, idx3), shift3));
+#endif
+}
+
+/*************************************************
+* Name:        polyvec_compress
+*
+* Description: Compress and serialize vector of polynomials
+*
+* Arguments:   - uint8_t *r: pointer to output byte array
+*                            (needs space for KYBER_POLYVECCOMPRESSEDBYTES)
+*              - const polyvec *a: pointer to input vector of polynomials
+**************************************************/
+void polyvec_compress(uint8_t r[KYBER_POLYVECCOMPRESSEDBYTES], const polyvec *a)
+{
+  unsigned int i, j;
+  __m512i v;
+
+  for(i = 0; i < KYBER_K; i++) {
+    for(j = 0; j < KYBER_N/32; j++) {
+      v = csubq_neg(_mm512_loadu_si512((const void *)(a->vec[i].coeffs + 32*j)));
+      v = _mm512_inserti64x4(_mm512_castsi256_si512(compress_x16(_mm512_castsi512_si256(v))),
+                             compress_x16(_mm512_extracti64x4_epi64(v, 1)), 1);
+      store_lanes(r, POLYVEC_STRIDE, i == KYBER_K - 1 && j == KYBER_N/32 - 1, pack_lanes(v));
+      r += 4*POLYVEC_STRIDE;
+    }
+  }
+}
+
+/*************************************************
+* Name:        polyvec_decompress
+*
+* Description: De-serialize and decompress vector of polynomials;
+*              approximate inverse of polyvec_compress
+*
+* Arguments:   - polyvec *r:       pointer to output vector of polynomials
+*              - const uint8_t *a: pointer to input byte array
+*                                  (of length KYBER_POLYVECCOMPRESSEDBYTES)
+**************************************************/
+void polyvec_decompress(polyvec *r, const uint8_t a[KYBER_POLYVECCOMPRESSEDBYTES])
+{
+  unsigned int i, j;
+  __m512i t;
+
+  for(i = 0; i < KYBER_K; i++) {
+    for(j = 0; j < KYBER_N/32; j++) {
+      t = unpack_lanes(load_lanes(a, POLYVEC_STRIDE, i == KYBER_K - 1 && j == KYBER_N/32 - 1));
+      _mm512_storeu_si512((void *)(r->vec[i].coeffs + 32*j), decompress_d(t, POLYVEC_D));
+      a += 4*POLYVEC_STRIDE;
+    }
+  }
+}
@@ -0,0 +1,12 @@
+#ifndef POLYX8_H
+#define POLYX8_H
+
+#include <stdint.h>
+#include "params.h"
+#include "poly.h"
+
+#define poly_getnoise_x8 KYBER_NAMESPACE(poly_getnoise_x8)
+void poly_getnoise_x8(poly *r[], unsigned int n, unsigned int n_eta1,
+                      const uint8_t seed[KYBER_SYMBYTES], uint8_t nonce);
+
+#endif
@@ -0,0 +1,74 @@
+#include <stdint.h>
+#include <immintrin.h>
+#include "params.h"
+#include "rejsample512.h"
+
+/* Per 128-bit lane: the two bytes holding each of the eight 12-bit values in the
+ * lane's 12 input bytes (odd values additionally need a shift by 4) */
+static const int8_t rej_shuffle[16] = {
+  0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11
+};
+
+/*************************************************
+* Name:        rej_uniform_avx512
+*
+* Description: Same as rej_uniform() in libs/indcpa.c: parses 12-bit values from
+*              buf and keeps those below q, in order. Decodes 32 candidates per
+*              iteration and packs the accepted ones with a masked compress on
+*              32-bit lanes (AVX512F; the 16-bit compress would need VBMI2).
+*
+* Arguments:   - int16_t *r: pointer to output buffer
+*              - unsigned int len: requested number of 16-bit integers
+*              - const uint8_t *buf: pointer to input buffer
+*              - unsigned int buflen: length of input buffer in bytes
+*
+* Returns number of sampled 16-bit integers (at most len)
+**************************************************/
+unsigned int rej_uniform_avx512(int16_t *r, unsigned int len, const uint8_t *buf, unsigned int buflen)
+{
+  unsigned int ctr = 0, pos = 0, n;
+  uint16_t val0, val1;
+  __mmask32 good;
+  __m512i f, lo, hi;
+  const __m512i idx = _mm512_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6, 6, 7, 8, 9, 9, 10, 11, 12);
+  const __m512i shuf = _mm512_broadcast_i32x4(_mm_loadu_si128((const void *)rej_shuffle));
+  const __m512i shift = _mm512_set1_epi32(4 << 16);
+  const __m512i mask = _mm512_set1_epi16(0xFFF);
+  const __m512i bound = _mm512_set1_epi16(KYBER_Q);
+
+  /* 48 bytes are consumed per iteration, 64 loaded */
+  while(ctr + 32 <= len && pos + 64 <= buflen) {
+    f = _mm512_loadu_si512((const void *)(buf + pos));
+    f = _mm512_permutexvar_epi32(idx, f);
+    f = _mm512_shuffle_epi8(f, shuf);
+    f = _mm512_srlv_epi16(f, shift);
+    f = _mm512_and_si512(f, mask);
+    good = _mm512_cmplt_epu16_mask(f, bound);
+    pos += 48;
+
+    lo = _mm512_cvtepu16_epi32(_mm512_castsi512_si256(f));
+    hi = _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(f, 1));
+    lo = _mm512_maskz_compress_epi32((__mmask16)good, lo);
+    hi = _mm512_maskz_compress_epi32((__mmask16)(good >> 16), hi);
+
+    n = __builtin_popcount(good & 0xFFFF);
+    _mm512_mask_cvtepi32_storeu_epi16(r + ctr, (__mmask16)((1u << n) - 1), lo);
+    ctr += n;
+    n = __builtin_popcount(good >> 16);
+    _mm512_mask_cvtepi32_storeu_epi16(r + ctr, (__mmask16)((1u << n) - 1), hi);
+    ctr += n;
+  }
+
+  while(ctr < len && pos + 3 <= buflen) {
+    val0 = ((buf[pos+0] >> 0) | ((uint16_t)buf[pos+1] << 8)) & 0xFFF;
+    val1 = ((buf[pos+1] >> 4) | ((uint16_t)buf[pos+2] << 4)) & 0xFFF;
+    pos += 3;
+
+    if(val0 < KYBER_Q)
+      r[ctr++] = val0;
+    if(ctr < len && val1 < KYBER_Q)
+      r[ctr++] = val1;
+  }
+
+  return ctr;
+}
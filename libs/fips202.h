@@ -15,6 +15,10 @@
  * - `libpqcrystals_fips202_ref.so` (reference implementation)
  * - `libpqcrystals_fips202x4_avx2.so` (AVX2-optimized implementation)
  *
+ * Sources compiled with KYBER_BACKEND_REF use the portable implementation in libs/ref/fips202.c.
+ * The AVX-512 backend shares the single-state functions with the AVX2 backend and adds the
+ * 8-way libs/avx512/fips202x8.c.
+ *
  * @note All functions operate on byte arrays, and sizes are specified in bytes.
  *
  * @see https://nvlpubs.nist.gov/nistpubs/FIPS/NIST.FIPS.202.pdf for the FIPS 202 standard.
@@ -31,7 +35,11 @@
 #define SHA3_256_RATE 136
 #define SHA3_512_RATE 72
 
+#ifdef KYBER_BACKEND_REF
+#define FIPS202_NAMESPACE(s) pqcrystals_kyber_fips202_ref_##s
+#else
 #define FIPS202_NAMESPACE(s) pqcrystals_kyber_fips202_avx2_##s
+#endif
 
 typedef struct {
     uint64_t s[25];
@@ -8,6 +8,11 @@
 #include "ntt.h"
 #include "symmetric.h"
 #include "randombytes.h"
+#ifdef KYBER_BACKEND_AVX512
+#include "fips202x8.h"
+#include "polyx8.h"
+#include "rejsample512.h"
+#endif
 
 /**
  * @brief Serialize the public key as a concatenation of the serialized vector of polynomials pk and the public seed used to generate the matrix A.
@@ -88,6 +93,7 @@ static void unpack_ciphertext(polyvec *b, poly *v, const uint8_t c[KYBER_INDCPA_
   poly_decompress(v, c+KYBER_POLYVECCOMPRESSEDBYTES);
 }
 
+#ifndef KYBER_BACKEND_AVX512
 /**
  * @brief Run rejection sampling on uniform random bytes to generate uniform random integers mod q.
  *
@@ -119,6 +125,7 @@ static unsigned int rej_uniform(int16_t *r,
 
   return ctr;
 }
+#endif
 
 #define gen_a(A,B)  gen_matrix(A,B,0)
 #define gen_at(A,B) gen_matrix(A,B,1)
@@ -154,6 +161,7 @@ static unsigned int rej_uniform(int16_t *r,
 #endif
 
 #define GEN_MATRIX_NBLOCKS ((12*KYBER_N/8*(1 << 12)/KYBER_Q + XOF_BLOCKBYTES)/XOF_BLOCKBYTES)
+#ifndef KYBER_BACKEND_AVX512
 // Not static for benchmarking
 void gen_matrix(polyvec *a, const uint8_t seed[KYBER_SYMBYTES], int transposed)
 {
@@ -181,6 +189,58 @@ void gen_matrix(polyvec *a, const uint8_t seed[KYBER_SYMBYTES], int transposed)
     }
   }
 }
+#else
+/*
+ * AVX-512 variant: expands up to eight matrix entries per pass of the 8-way
+ * SHAKE128 and parses them with rej_uniform_avx512(). Lanes past the last entry
+ * of the final pass repeat its first entry and are discarded.
+ */
+void gen_matrix(polyvec *a, const uint8_t seed[KYBER_SYMBYTES], int transposed)
+{
+  unsigned int n, k, idx, i, j, lanes, pending;
+  unsigned int ctr[8];
+  uint8_t ext[8][KYBER_SYMBYTES+2];
+  uint8_t buf[8][GEN_MATRIX_NBLOCKS*XOF_BLOCKBYTES];
+  const uint8_t *in[8];
+  uint8_t *out[8];
+  int16_t *coeffs[8];
+  keccakx8_state state;
+
+  for(n=0;n<KYBER_K*KYBER_K;n+=8) {
+    lanes = KYBER_K*KYBER_K - n < 8 ? KYBER_K*KYBER_K - n : 8;
+    for(k=0;k<8;k++) {
+      idx = n + (k < lanes ? k : 0);
+      i = idx / KYBER_K;
+      j = idx % KYBER_K;
+      memcpy(ext[k], seed, KYBER_SYMBYTES);
+      ext[k][KYBER_SYMBYTES+0] = transposed ? i : j;
+      ext[k][KYBER_SYMBYTES+1] = transposed ? j : i;
+      in[k] = ext[k];
+      out[k] = buf[k];
+      coeffs[k] = a[i].vec[j].coeffs;
+    }
+
+    shake128x8_absorb_once(&state, in, KYBER_SYMBYTES+2);
+    shake128x8_squeezeblocks(out, GEN_MATRIX_NBLOCKS, &state);
+
+    pending = 0;
+    for(k=0;k<lanes;k++) {
+      ctr[k] = rej_uniform_avx512(coeffs[k], KYBER_N, buf[k], sizeof(buf[k]));
+      pending |= ctr[k] < KYBER_N;
+    }
+
+    while(pending) {
+      shake128x8_squeezeblocks(out, 1, &state);
+      pending = 0;
+      for(k=0;k<lanes;k++) {
+        if(ctr[k] < KYBER_N)
+          ctr[k] += rej_uniform_avx512(coeffs[k] + ctr[k], KYBER_N - ctr[k], buf[k], XOF_BLOCKBYTES);
+        pending |= ctr[k] < KYBER_N;
+      }
+    }
+  }
+}
+#endif
 
 /*************************************************
 * Name:        indcpa_keypair_derand
@@ -212,10 +272,19 @@ void indcpa_keypair_derand(uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES],
 
   gen_a(a, publicseed);
 
+#ifdef KYBER_BACKEND_AVX512
+  poly *noise[2*KYBER_K];
+  for(i=0;i<KYBER_K;i++) {
+    noise[i] = &skpv.vec[i];
+    noise[KYBER_K+i] = &e.vec[i];
+  }
+  poly_getnoise_x8(noise, 2*KYBER_K, 2*KYBER_K, noiseseed, nonce);
+#else
   for(i=0;i<KYBER_K;i++)
     poly_getnoise_eta1(&skpv.vec[i], noiseseed, nonce++);
   for(i=0;i<KYBER_K;i++)
     poly_getnoise_eta1(&e.vec[i], noiseseed, nonce++);
+#endif
 
   polyvec_ntt(&skpv);
   polyvec_ntt(&e);
@@ -265,11 +334,21 @@ void indcpa_enc(uint8_t c[KYBER_INDCPA_BYTES],
   poly_frommsg(&k, m);
   gen_at(at, seed);
 
+#ifdef KYBER_BACKEND_AVX512
+  poly *noise[2*KYBER_K+1];
+  for(i=0;i<KYBER_K;i++) {
+    noise[i] = &sp.vec[i];
+    noise[KYBER_K+i] = &ep.vec[i];
+  }
+  noise[2*KYBER_K] = &epp;
+  poly_getnoise_x8(noise, 2*KYBER_K+1, KYBER_K, coins, nonce);
+#else
   for(i=0;i<KYBER_K;i++)
     poly_getnoise_eta1(sp.vec+i, coins, nonce++);
   for(i=0;i<KYBER_K;i++)
     poly_getnoise_eta2(ep.vec+i, coins, nonce++);
   poly_getnoise_eta2(&epp, coins, nonce++);
+#endif
 
   polyvec_ntt(&sp);
 
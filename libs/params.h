@@ -14,23 +14,38 @@
  *
  * Depending on the value of KYBER_K (2, 3, or 4) and whether KYBER_90S is defined,
  * this macro creates a namespace prefix used for naming functions and variables.
+ * Sources compiled with KYBER_BACKEND_REF use the portable reference namespace
+ * (libs/ref/), sources compiled with KYBER_BACKEND_AVX512 the AVX-512 namespace
+ * (libs/avx512/), instead of the AVX2 shared libraries.
  * This ensures that the correct version of the Kyber algorithm (with different security levels)
  * is used during compilation.
  */
 #if   (KYBER_K == 2)
-#ifdef KYBER_90S
+#if defined(KYBER_BACKEND_REF)
+#define KYBER_NAMESPACE(s) pqcrystals_kyber512_ref_##s
+#elif defined(KYBER_BACKEND_AVX512)
+#define KYBER_NAMESPACE(s) pqcrystals_kyber512_avx512_##s
+#elif defined(KYBER_90S)
 #define KYBER_NAMESPACE(s) pqcrystals_kyber512_90s_avx2_##s
 #else
 #define KYBER_NAMESPACE(s) pqcrystals_kyber512_avx2_##s
 #endif
 #elif (KYBER_K == 3)
-#ifdef KYBER_90S
+#if defined(KYBER_BACKEND_REF)
+#define KYBER_NAMESPACE(s) pqcrystals_kyber768_ref_##s
+#elif defined(KYBER_BACKEND_AVX512)
+#define KYBER_NAMESPACE(s) pqcrystals_kyber768_avx512_##s
+#elif defined(KYBER_90S)
 #define KYBER_NAMESPACE(s) pqcrystals_kyber768_90s_avx2_##s
 #else
 #define KYBER_NAMESPACE(s) pqcrystals_kyber768_avx2_##s
 #endif
 #elif (KYBER_K == 4)
-#ifdef KYBER_90S
+#if defined(KYBER_BACKEND_REF)
+#define KYBER_NAMESPACE(s) pqcrystals_kyber1024_ref_##s
+#elif defined(KYBER_BACKEND_AVX512)
+#define KYBER_NAMESPACE(s) pqcrystals_kyber1024_avx512_##s
+#elif defined(KYBER_90S)
 #define KYBER_NAMESPACE(s) pqcrystals_kyber1024_90s_avx2_##s
 #else
 #define KYBER_NAMESPACE(s) pqcrystals_kyber1024_avx2_##s
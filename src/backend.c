@@ -0,0 +1,66 @@
+#include "protocol_api.h"
+#include <stdlib.h>
+
+int sap_backend_parse(const char* name, sap_backend_id* id)
+{
+    if (strcmp(name, "ref") == 0) {
+        *id = SAP_BACKEND_REF;
+        return 0;
+    }
+    if (strcmp(name, "avx2") == 0) {
+        *id = SAP_BACKEND_AVX2;
+        return 0;
+    }
+    if (strcmp(name, "avx512") == 0) {
+        *id = SAP_BACKEND_AVX512;
+        return 0;
+    }
+    return -1;
+}
+
+int sap_backend_supported(sap_backend_id id)
+{
+    switch (id) {
+    case SAP_BACKEND_REF: return 1;
+    case SAP_BACKEND_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    case SAP_BACKEND_AVX512:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    default: return 0;
+    }
+}
+
+/**
+ * Workflow:
+ *  1. Honors SAP_BACKEND if it names a backend the CPU supports.
+ *  2. Otherwise picks the fastest supported backend; later enum values are faster.
+ *  3. Caches the result; the first call happens from the load-time constructors of
+ *     the per-level tables (see backend_select.c), before any thread is started.
+ */
+sap_backend_id sap_backend_detect(void)
+{
+    static int detected = -1;
+    if (detected >= 0) {
+        return (sap_backend_id)detected;
+    }
+
+    const char* forced = getenv("SAP_BACKEND");
+    sap_backend_id id;
+    if (forced != NULL && sap_backend_parse(forced, &id) == 0 && sap_backend_supported(id)) {
+        detected = id;
+        return id;
+    }
+    if (forced != NULL) {
+        fprintf(stderr, "SAP_BACKEND=%s is unknown or unsupported on this CPU, ignoring\n", forced);
+    }
+    detected = SAP_BACKEND_REF;
+    for (int i = SAP_BACKEND_COUNT - 1; i > SAP_BACKEND_REF; i--) {
+        if (sap_backend_supported((sap_backend_id)i)) {
+            detected = i;
+            break;
+        }
+    }
+    return (sap_backend_id)detected;
+}
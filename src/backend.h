@@ -0,0 +1,210 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fips202.h"
+#include "probes.h"
+
+/// @file backend.h
+/// @brief Runtime-selected Kyber implementations behind one function table.
+///
+/// Every security level is built three times: against the AVX2 shared libraries,
+/// from the portable sources in libs/ref/, and from libs/ref/ with the NTT, base
+/// multiplication and Keccak replaced by the AVX-512 kernels in libs/avx512/. At
+/// startup the fastest backend the CPU supports is selected (AVX-512, then AVX2,
+/// then the reference code), so a single binary runs on the whole fleet. The
+/// environment variable SAP_BACKEND (`ref`, `avx2` or `avx512`) overrides the
+/// choice, which is how the slower paths are exercised on newer machines.
+///
+/// All backends produce byte-identical keys, ciphertexts, shared secrets and
+/// stealth public keys, so they can be mixed freely between sender and recipient.
+
+/// @brief Identifies one backend.
+typedef enum {
+    SAP_BACKEND_REF = 0,    /**< Portable C implementation (libs/ref/). */
+    SAP_BACKEND_AVX2,       /**< AVX2 shared libraries (libpqcrystals_*_avx2.so). */
+    SAP_BACKEND_AVX512,     /**< AVX-512 kernels (libs/avx512/), needs AVX512F and AVX512BW. */
+    SAP_BACKEND_COUNT
+} sap_backend_id;
+
+/// @brief Function table of one backend at one security level.
+///
+/// The KEM entries have the semantics of the crypto_kem_* API in kem.h, the hash
+/// entries those of the functions of the same name in fips202.h.
+typedef struct {
+    const char* name;
+    sap_backend_id id;
+
+    int (*kem_keypair_derand)(uint8_t* pk, uint8_t* sk, const uint8_t* coins);
+    int (*kem_keypair)(uint8_t* pk, uint8_t* sk);
+    int (*kem_enc_derand)(uint8_t* ct, uint8_t* ss, const uint8_t* pk, const uint8_t* coins);
+    int (*kem_enc)(uint8_t* ct, uint8_t* ss, const uint8_t* pk);
+    int (*kem_dec)(uint8_t* ss, const uint8_t* ct, const uint8_t* sk);
+
+    void (*hash_shake128)(uint8_t* out, size_t outlen, const uint8_t* in, size_t inlen);
+    void (*hash_shake256)(uint8_t* out, size_t outlen, const uint8_t* in, size_t inlen);
+    void (*hash_shake256_absorb_once)(keccak_state* state, const uint8_t* in, size_t inlen);
+    void (*hash_shake256_squeeze)(uint8_t* out, size_t outlen, keccak_state* state);
+    void (*hash_sha3_512)(uint8_t* out, const uint8_t* in, size_t inlen);
+
+    /// Computes A * s + k_pub for s sampled from @p ss (see calculate_stealth_pub_key()).
+    void (*stealth_pub_key)(uint8_t* stealth_pub_key, const uint8_t* ss, const uint8_t* k_pub);
+
+    /// Hashes @p n shared secrets into 32 bytes each with SHAKE128, as used for view
+    /// tags; the AVX2 and AVX-512 backends hash 4 and 8 secrets per Keccak pass.
+    void (*hash_ss_batch)(uint8_t* out, const uint8_t* ss, size_t n);
+
+    /// Samples the stealth secrets of @p n shared secrets: for each one the KYBER_K
+    /// polynomials poly_getnoise_eta1(ss, 0 .. KYBER_K - 1), as sampled, one after
+    /// the other. The AVX2 and AVX-512 backends sample 4 and 8 polynomials, of any
+    /// secrets, per Keccak pass.
+    void (*stealth_noise_batch)(int16_t* s, const uint8_t* ss, size_t n);
+
+    /// @name Kernels
+    /// Level-specific building blocks, exposed for the primitive benchmarks. The
+    /// polynomial arguments are KYBER_K (matrix: KYBER_K * KYBER_K) arrays of
+    /// KYBER_N coefficients, aligned to 64 bytes. The NTT-domain coefficient order
+    /// is backend specific.
+    /// @{
+    void (*gen_matrix)(int16_t* a, const uint8_t* seed, int transposed);
+    void (*poly_getnoise_eta1)(int16_t* r, const uint8_t* seed, uint8_t nonce);
+    void (*polyvec_ntt)(int16_t* r);
+    void (*polyvec_invntt_tomont)(int16_t* r);
+    void (*polyvec_basemul_acc_montgomery)(int16_t* r, const int16_t* a, const int16_t* b);
+    void (*unpack_pk)(int16_t* pk, uint8_t* seed, const uint8_t* packed_pk);
+    void (*polyvec_tobytes)(uint8_t* r, const int16_t* a);
+    /// Four SHAKE128 hashes of equal length; one 4-way Keccak pass on AVX2, one
+    /// 8-way pass with four lanes used on AVX-512, four calls on the reference backend.
+    void (*hash_shake128x4)(uint8_t* out[4], size_t outlen, const uint8_t* in[4], size_t inlen);
+    /// @}
+} sap_backend;
+
+/// @brief Returns the backend the CPU (and SAP_BACKEND) selects, independent of the level.
+sap_backend_id sap_backend_detect(void);
+
+/// @brief Parses a backend name (`ref`, `avx2`, `avx512`).
+///
+/// @return 0 on success, -1 if @p name is unknown.
+int sap_backend_parse(const char* name, sap_backend_id* id);
+
+/// @brief Reports whether the CPU can run a backend.
+int sap_backend_supported(sap_backend_id id);
+
+/// @name Tables of every level
+/// sap_backend_get() and sap_backend_active() under their per-level names, for
+/// code that handles several security levels (see sap.hpp).
+/// @{
+const sap_backend* pqsap_kyber512_backend_get(sap_backend_id id);
+const sap_backend* pqsap_kyber768_backend_get(sap_backend_id id);
+const sap_backend* pqsap_kyber1024_backend_get(sap_backend_id id);
+const sap_backend* pqsap_kyber512_backend_active(void);
+const sap_backend* pqsap_kyber768_backend_active(void);
+const sap_backend* pqsap_kyber1024_backend_active(void);
+int pqsap_kyber512_backend_use(sap_backend_id id);
+int pqsap_kyber768_backend_use(sap_backend_id id);
+int pqsap_kyber1024_backend_use(sap_backend_id id);
+/// @}
+
+/* The rest depends on the compiled security level (KYBER_K, see protocol_api.h) */
+#ifdef SAP_NAMESPACE
+
+#define sap_backend_get SAP_NAMESPACE(backend_get)
+/// @brief Returns the table of a backend at the compiled security level.
+const sap_backend* sap_backend_get(sap_backend_id id);
+
+#define sap_backend_active SAP_NAMESPACE(backend_active)
+/// @brief Returns the table selected at startup for the compiled security level.
+const sap_backend* sap_backend_active(void);
+
+#define sap_backend_use SAP_NAMESPACE(backend_use)
+/// @brief Makes another backend the active one at the compiled security level.
+///
+/// Meant for startup (see tune.h): threads that are calling through the old
+/// table at the same time may see either one.
+///
+/// @return 0 on success, -1 if the CPU cannot run @p id.
+int sap_backend_use(sap_backend_id id);
+
+#define sap_backend_ref SAP_NAMESPACE(backend_ref)
+extern const sap_backend sap_backend_ref;
+#define sap_backend_avx2 SAP_NAMESPACE(backend_avx2)
+extern const sap_backend sap_backend_avx2;
+#define sap_backend_avx512 SAP_NAMESPACE(backend_avx512)
+extern const sap_backend sap_backend_avx512;
+
+/// @brief crypto_kem_keypair_derand() on the active backend.
+static inline int sap_kem_keypair_derand(uint8_t* pk, uint8_t* sk, const uint8_t* coins)
+{
+    return sap_backend_active()->kem_keypair_derand(pk, sk, coins);
+}
+
+/// @brief crypto_kem_keypair() on the active backend.
+static inline int sap_kem_keypair(uint8_t* pk, uint8_t* sk)
+{
+    return sap_backend_active()->kem_keypair(pk, sk);
+}
+
+/// @brief crypto_kem_enc_derand() on the active backend.
+static inline int sap_kem_enc_derand(uint8_t* ct, uint8_t* ss, const uint8_t* pk, const uint8_t* coins)
+{
+    return sap_backend_active()->kem_enc_derand(ct, ss, pk, coins);
+}
+
+/// @brief crypto_kem_enc() on the active backend.
+static inline int sap_kem_enc(uint8_t* ct, uint8_t* ss, const uint8_t* pk)
+{
+    return sap_backend_active()->kem_enc(ct, ss, pk);
+}
+
+/// @brief crypto_kem_dec() on the active backend.
+static inline int sap_kem_dec(uint8_t* ss, const uint8_t* ct, const uint8_t* sk)
+{
+    SAP_PROBE2(kem_dec__entry, ct, sk);
+    int ret = sap_backend_active()->kem_dec(ss, ct, sk);
+    SAP_PROBE1(kem_dec__return, ret);
+    return ret;
+}
+
+/// @brief shake128() on the active backend.
+static inline void sap_shake128(uint8_t* out, size_t outlen, const uint8_t* in, size_t inlen)
+{
+    sap_backend_active()->hash_shake128(out, outlen, in, inlen);
+}
+
+/// @brief shake256() on the active backend.
+static inline void sap_shake256(uint8_t* out, size_t outlen, const uint8_t* in, size_t inlen)
+{
+    sap_backend_active()->hash_shake256(out, outlen, in, inlen);
+}
+
+/// @brief shake256_absorb_once() on the active backend.
+static inline void sap_shake256_absorb_once(keccak_state* state, const uint8_t* in, size_t inlen)
+{
+    sap_backend_active()->hash_shake256_absorb_once(state, in, inlen);
+}
+
+/// @brief sha3_512() on the active backend.
+static inline void sap_sha3_512(uint8_t* out, const uint8_t* in, size_t inlen)
+{
+    sap_backend_active()->hash_sha3_512(out, in, inlen);
+}
+
+/// @brief hash_ss_batch() on the active backend.
+static inline void sap_hash_ss_batch(uint8_t* out, const uint8_t* ss, size_t n)
+{
+    sap_backend_active()->hash_ss_batch(out, ss, n);
+}
+
+/// @brief stealth_noise_batch() on the active backend.
+static inline void sap_stealth_noise_batch(int16_t* s, const uint8_t* ss, size_t n)
+{
+    sap_backend_active()->stealth_noise_batch(s, ss, n);
+}
+
+/// @brief shake256_squeeze() on the active backend.
+static inline void sap_shake256_squeeze(uint8_t* out, size_t outlen, keccak_state* state)
+{
+    sap_backend_active()->hash_shake256_squeeze(out, outlen, state);
+}
+
+#endif
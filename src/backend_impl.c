@@ -0,0 +1,278 @@
+#include "protocol_api.h"
+#include "cbd.h"
+#include "wipe.h"
+
+/*
+ * Compiled once per security level and backend. Without a KYBER_BACKEND_* macro
+ * the Kyber and Keccak symbols resolve to the AVX2 shared libraries, with
+ * KYBER_BACKEND_REF to the portable sources in libs/ref/ and with
+ * KYBER_BACKEND_AVX512 to those sources plus the kernels in libs/avx512/ (see
+ * KYBER_NAMESPACE and FIPS202_NAMESPACE).
+ */
+#if defined(KYBER_BACKEND_REF)
+#define BACKEND_TABLE sap_backend_ref
+#define BACKEND_ID SAP_BACKEND_REF
+#define BACKEND_NAME "ref"
+#elif defined(KYBER_BACKEND_AVX512)
+#include "fips202x8.h"
+#include "polyx8.h"
+#define BACKEND_TABLE sap_backend_avx512
+#define BACKEND_ID SAP_BACKEND_AVX512
+#define BACKEND_NAME "avx512"
+#define BACKEND_NTT_STANDARD_ORDER
+#else
+#define BACKEND_TABLE sap_backend_avx2
+#define BACKEND_ID SAP_BACKEND_AVX2
+#define BACKEND_NAME "avx2"
+#define BACKEND_FUSED_STEALTH
+#include "stealth_avx2.h"
+#endif
+
+#ifdef KYBER_BACKEND_REF
+#define BACKEND_NTT_STANDARD_ORDER
+#endif
+
+#ifdef BACKEND_NTT_STANDARD_ORDER
+/**
+ * The stealth secret s is sampled with poly_getnoise_eta1() and used directly as an
+ * NTT-domain operand, so its meaning depends on the coefficient order of the NTT
+ * domain. The protocol was defined on the AVX2 backend, whose NTT domain keeps each
+ * 128-coefficient half as a transposed 16x8 block. This permutes s into the
+ * standard order used by the reference and AVX-512 NTTs so all backends yield the
+ * same key.
+ */
+static void poly_avx2_order_to_standard(poly* r)
+{
+    int16_t t[KYBER_N];
+    memcpy(t, r->coeffs, sizeof(t));
+    for (int h = 0; h < KYBER_N; h += 128) {
+        for (int row = 0; row < 8; row++) {
+            for (int col = 0; col < 16; col++) {
+                r->coeffs[h + 8 * col + row] = t[h + 16 * row + col];
+            }
+        }
+    }
+}
+#endif
+
+/**
+ * Workflow:
+ *  1. Unpacks k_pub and expands the matrix A from its public seed.
+ *  2. Samples s from ss with poly_getnoise_eta1() (nonces 0..KYBER_K-1), all K
+ *     polynomials in one 8-way pass on AVX-512.
+ *  3. Computes A * s in the NTT domain, converts to Montgomery form and adds k_pub.
+ *  4. Reduces and serializes the result.
+ * On AVX2, steps 3 and 4 are one pass of stealth_pub_key_fused_avx2().
+ */
+static void stealth_pub_key(uint8_t* stealth_pub_key, const uint8_t* ss, const uint8_t* k_pub)
+{
+    polyvec pkpv, skpv;
+    polyvec a[KYBER_K];
+    uint8_t public_seed[KYBER_SYMBYTES];
+
+    unpack_pk(&pkpv, public_seed, k_pub);
+    gen_matrix(a, public_seed, 0);
+
+#ifdef KYBER_BACKEND_AVX512
+    poly* noise[KYBER_K];
+    for (int i = 0; i < KYBER_K; i++) {
+        noise[i] = &skpv.vec[i];
+    }
+    poly_getnoise_x8(noise, KYBER_K, KYBER_K, ss, 0);
+#else
+    for (int i = 0; i < KYBER_K; i++) {
+        poly_getnoise_eta1(&skpv.vec[i], ss, (uint8_t)i);
+    }
+#endif
+#ifdef BACKEND_NTT_STANDARD_ORDER
+    for (int i = 0; i < KYBER_K; i++) {
+        poly_avx2_order_to_standard(&skpv.vec[i]);
+    }
+#endif
+
+#ifdef BACKEND_FUSED_STEALTH
+    stealth_pub_key_fused_avx2(stealth_pub_key, a, &skpv, &pkpv);
+#else
+    polyvec p_poly;
+    for (int i = 0; i < KYBER_K; i++) {
+        polyvec_basemul_acc_montgomery(&p_poly.vec[i], &a[i], &skpv);
+        poly_tomont(&p_poly.vec[i]);
+    }
+
+    polyvec_add(&p_poly, &p_poly, &pkpv);
+    polyvec_reduce(&p_poly);
+
+    polyvec_tobytes(stealth_pub_key, &p_poly);
+#endif
+}
+
+/**
+ * Workflow:
+ *  1. Hashes the secrets in groups of 8 (AVX-512) or 4 (AVX2) Keccak lanes.
+ *  2. Fills the unused lanes of the last group with the first secret of the group
+ *     and discards their output; the reference backend hashes one by one.
+ */
+static void hash_ss_batch(uint8_t* out, const uint8_t* ss, size_t n)
+{
+#ifdef KYBER_BACKEND_REF
+    for (size_t i = 0; i < n; i++) {
+        shake128(out + 32 * i, 32, ss + KYBER_SSBYTES * i, KYBER_SSBYTES);
+    }
+#else
+#ifdef KYBER_BACKEND_AVX512
+    enum { LANES = 8 };
+#else
+    enum { LANES = 4 };
+#endif
+    uint8_t scratch[LANES][32];
+    const uint8_t* in[LANES];
+    uint8_t* dst[LANES];
+    for (size_t i = 0; i < n; i += LANES) {
+        for (size_t j = 0; j < LANES; j++) {
+            int used = i + j < n;
+            in[j] = ss + KYBER_SSBYTES * (used ? i + j : i);
+            dst[j] = used ? out + 32 * (i + j) : scratch[j];
+        }
+#ifdef KYBER_BACKEND_AVX512
+        shake128x8(dst, 32, in, KYBER_SSBYTES);
+#else
+        shake128x4(dst[0], dst[1], dst[2], dst[3], 32, in[0], in[1], in[2], in[3], KYBER_SSBYTES);
+#endif
+    }
+#endif
+}
+
+/// Room for the SHAKE256 output one eta1 polynomial is sampled from (two blocks),
+/// rounded up to whole 32-byte rows for the aligned loads of the AVX2 poly_cbd_eta1().
+#define NOISE_BUF_BYTES 288
+
+#if KYBER_ETA1 * KYBER_N / 4 + 32 > 2 * SHAKE256_RATE
+#error "stealth_noise_batch() assumes that two SHAKE256 blocks cover the noise input"
+#endif
+
+/**
+ * Workflow:
+ *  1. Numbers the polynomials to sample: t = i * KYBER_K + j is secret i, nonce j.
+ *  2. Expands SHAKE256(ss_i || j) for 8 (AVX-512) or 4 (AVX2) polynomials per
+ *     Keccak pass, across secrets, and samples each one with poly_cbd_eta1(); the
+ *     unused lanes of the last group repeat its first polynomial and are
+ *     discarded. The reference backend calls poly_getnoise_eta1() one by one.
+ */
+static void stealth_noise_batch(int16_t* s, const uint8_t* ss, size_t n)
+{
+    size_t total = n * KYBER_K;
+#ifdef KYBER_BACKEND_REF
+    for (size_t t = 0; t < total; t++) {
+        poly_getnoise_eta1((poly*)(s + t * KYBER_N), ss + KYBER_SSBYTES * (t / KYBER_K), (uint8_t)(t % KYBER_K));
+    }
+#else
+#ifdef KYBER_BACKEND_AVX512
+    enum { LANES = 8 };
+#else
+    enum { LANES = 4 };
+#endif
+    _Alignas(64) uint8_t buf[LANES][NOISE_BUF_BYTES];
+    uint8_t ext[LANES][KYBER_SYMBYTES + 1];
+    const uint8_t* in[LANES];
+    uint8_t* out[LANES];
+    for (size_t t = 0; t < total; t += LANES) {
+        for (size_t j = 0; j < LANES; j++) {
+            size_t u = t + j < total ? t + j : t;
+            memcpy(ext[j], ss + KYBER_SSBYTES * (u / KYBER_K), KYBER_SYMBYTES);
+            ext[j][KYBER_SYMBYTES] = (uint8_t)(u % KYBER_K);
+            in[j] = ext[j];
+            out[j] = buf[j];
+        }
+#ifdef KYBER_BACKEND_AVX512
+        shake256x8(out, 2 * SHAKE256_RATE, in, KYBER_SYMBYTES + 1);
+#else
+        shake256x4(out[0], out[1], out[2], out[3], 2 * SHAKE256_RATE, in[0], in[1], in[2], in[3], KYBER_SYMBYTES + 1);
+#endif
+        for (size_t j = 0; j < LANES && t + j < total; j++) {
+#ifdef KYBER_BACKEND_AVX512
+            poly_cbd_eta1((poly*)(s + (t + j) * KYBER_N), buf[j]);
+#else
+            poly_cbd_eta1((poly*)(s + (t + j) * KYBER_N), (const __m256i*)buf[j]);
+#endif
+        }
+    }
+    sap_wipe(buf, sizeof(buf));
+    sap_wipe(ext, sizeof(ext));
+#endif
+}
+
+static void kernel_gen_matrix(int16_t* a, const uint8_t* seed, int transposed)
+{
+    gen_matrix((polyvec*)a, seed, transposed);
+}
+
+static void kernel_poly_getnoise_eta1(int16_t* r, const uint8_t* seed, uint8_t nonce)
+{
+    poly_getnoise_eta1((poly*)r, seed, nonce);
+}
+
+static void kernel_polyvec_ntt(int16_t* r)
+{
+    polyvec_ntt((polyvec*)r);
+}
+
+static void kernel_polyvec_invntt_tomont(int16_t* r)
+{
+    polyvec_invntt_tomont((polyvec*)r);
+}
+
+static void kernel_polyvec_basemul_acc_montgomery(int16_t* r, const int16_t* a, const int16_t* b)
+{
+    polyvec_basemul_acc_montgomery((poly*)r, (const polyvec*)a, (const polyvec*)b);
+}
+
+static void kernel_unpack_pk(int16_t* pk, uint8_t* seed, const uint8_t* packed_pk)
+{
+    unpack_pk((polyvec*)pk, seed, packed_pk);
+}
+
+static void kernel_polyvec_tobytes(uint8_t* r, const int16_t* a)
+{
+    polyvec_tobytes(r, (const polyvec*)a);
+}
+
+static void kernel_hash_shake128x4(uint8_t* out[4], size_t outlen, const uint8_t* in[4], size_t inlen)
+{
+#if defined(KYBER_BACKEND_REF)
+    for (int j = 0; j < 4; j++) {
+        shake128(out[j], outlen, in[j], inlen);
+    }
+#elif defined(KYBER_BACKEND_AVX512)
+    uint8_t* dst[8] = { out[0], out[1], out[2], out[3], out[0], out[1], out[2], out[3] };
+    const uint8_t* src[8] = { in[0], in[1], in[2], in[3], in[0], in[1], in[2], in[3] };
+    shake128x8(dst, outlen, src, inlen);
+#else
+    shake128x4(out[0], out[1], out[2], out[3], outlen, in[0], in[1], in[2], in[3], inlen);
+#endif
+}
+
+const sap_backend BACKEND_TABLE = {
+    .name = BACKEND_NAME,
+    .id = BACKEND_ID,
+    .kem_keypair_derand = crypto_kem_keypair_derand,
+    .kem_keypair = crypto_kem_keypair,
+    .kem_enc_derand = crypto_kem_enc_derand,
+    .kem_enc = crypto_kem_enc,
+    .kem_dec = crypto_kem_dec,
+    .hash_shake128 = shake128,
+    .hash_shake256 = shake256,
+    .hash_shake256_absorb_once = shake256_absorb_once,
+    .hash_shake256_squeeze = shake256_squeeze,
+    .hash_sha3_512 = sha3_512,
+    .stealth_pub_key = stealth_pub_key,
+    .hash_ss_batch = hash_ss_batch,
+    .stealth_noise_batch = stealth_noise_batch,
+    .gen_matrix = kernel_gen_matrix,
+    .poly_getnoise_eta1 = kernel_poly_getnoise_eta1,
+    .polyvec_ntt = kernel_polyvec_ntt,
+    .polyvec_invntt_tomont = kernel_polyvec_invntt_tomont,
+    .polyvec_basemul_acc_montgomery = kernel_polyvec_basemul_acc_montgomery,
+    .unpack_pk = kernel_unpack_pk,
+    .polyvec_tobytes = kernel_polyvec_tobytes,
+    .hash_shake128x4 = kernel_hash_shake128x4,
+};
@@ -0,0 +1,38 @@
+#include "protocol_api.h"
+
+/* Per-level selection; compiled once per KYBER_K like corpus_gen.c. */
+
+static const sap_backend* active_backend = &sap_backend_ref;
+
+const sap_backend* sap_backend_get(sap_backend_id id)
+{
+    switch (id) {
+    case SAP_BACKEND_REF: return &sap_backend_ref;
+    case SAP_BACKEND_AVX2: return &sap_backend_avx2;
+    case SAP_BACKEND_AVX512: return &sap_backend_avx512;
+    default: return NULL;
+    }
+}
+
+const sap_backend* sap_backend_active(void)
+{
+    return active_backend;
+}
+
+int sap_backend_use(sap_backend_id id)
+{
+    if (!sap_backend_supported(id) || sap_backend_get(id) == NULL) {
+        return -1;
+    }
+    active_backend = sap_backend_get(id);
+    return 0;
+}
+
+/**
+ * Resolves the backend once at load time, before main() and before any thread can
+ * call through the table.
+ */
+__attribute__((constructor)) static void select_backend(void)
+{
+    active_backend = sap_backend_get(sap_backend_detect());
+}
@@ -0,0 +1,764 @@
+#include "coord.h"
+#include "corpus.h"
+#include "keyblob.h"
+#include "scan_mixed.h"
+#include "scand_proto.h"
+#include "wipe.h"
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/// Register entries a worker scans at a time.
+#define COORD_CHUNK 1024
+/// Body of a MATCH frame.
+#define COORD_MATCH_BYTES (4 + 4 + 8 + 32)
+#define COORD_DEFAULT_WORKERS 4
+#define COORD_DEFAULT_ATTEMPTS 3
+
+static const sap_scan_level* const scan_levels[SAP_SCAN_MIXED_LEVELS] = {
+    &pqsap_kyber512_scan_level, &pqsap_kyber768_scan_level, &pqsap_kyber1024_scan_level
+};
+
+static uint64_t now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+/* ---- frames ---- */
+
+static int write_all(int fd, const uint8_t* p, size_t len)
+{
+    int sock = 1;
+    while (len > 0) {
+        ssize_t n = sock ? send(fd, p, len, MSG_NOSIGNAL) : write(fd, p, len);
+        if (n < 0 && errno == ENOTSOCK && sock) {
+            sock = 0;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/// @return 1 if @p len bytes were read, 0 on end of file before the first byte, -1 otherwise.
+static int read_all(int fd, uint8_t* p, size_t len)
+{
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = read(fd, p + got, len - got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return n == 0 && got == 0 ? 0 : -1;
+        got += (size_t)n;
+    }
+    return 1;
+}
+
+static int send_frame(int fd, uint8_t type, const uint8_t* body, size_t len)
+{
+    uint8_t header[SAP_SCAND_HEADER_BYTES];
+    sap_scand_put32(header, (uint32_t)len);
+    header[4] = type;
+    return write_all(fd, header, sizeof(header)) == 0 && write_all(fd, body, len) == 0 ? 0 : -1;
+}
+
+/* ---- worker ---- */
+
+typedef struct {
+    uint32_t kyber_k;
+    const void* scan_key;
+    void* owned;                /**< scan_key if it was prepared here, NULL if it is in a key blob. */
+} worker_key;
+
+typedef struct {
+    uint64_t index;
+    uint32_t key;
+    uint8_t ss[32];
+} worker_hit;
+
+/// The keys of a worker process, kept from one job to the next.
+typedef struct {
+    char path[4097];            /**< Key file they were loaded from. */
+    worker_key* keys;
+    long n;                     /**< Number of keys, -1 while none are loaded. */
+    sap_keyblob blob;
+} worker_keyset;
+
+static void free_keys(worker_key* keys, size_t n, sap_keyblob* blob)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (keys[i].owned == NULL) continue;
+        sap_wipe(keys[i].owned, scan_levels[keys[i].kyber_k - 2]->key_bytes);
+        free(keys[i].owned);
+    }
+    free(keys);
+    sap_keyblob_close(blob);
+}
+
+/// Maps a key blob (keyblob.h) and points the keys into it; returns the number of keys or -1.
+static long map_keys(const char* path, worker_key** out, sap_keyblob* blob)
+{
+    if (sap_keyblob_open(blob, path, NULL, 0) != 0) {
+        return -1;
+    }
+    worker_key* keys = malloc((blob->n > 0 ? blob->n : 1) * sizeof(*keys));
+    if (keys == NULL) {
+        sap_keyblob_close(blob);
+        return -1;
+    }
+    for (size_t i = 0; i < blob->n; i++) {
+        keys[i] = (worker_key){ blob->entries[i].kyber_k, sap_keyblob_scan_key(blob, i), NULL };
+    }
+    *out = keys;
+    return (long)blob->n;
+}
+
+/// Reads a key file and prepares every view key, or maps a key blob; returns the number of keys or -1.
+static long load_keys(const char* path, worker_key** out, sap_keyblob* blob)
+{
+    memset(blob, 0, sizeof(*blob));
+    if (sap_keyblob_is_blob(path)) {
+        return map_keys(path, out, blob);
+    }
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return -1;
+    }
+    uint8_t* buf = NULL;
+    size_t len = 0, cap = 0, got;
+    do {
+        if (len == cap) {
+            cap = cap ? 2 * cap : 1 << 16;
+            uint8_t* b = realloc(buf, cap);
+            if (b == NULL) {
+                break;
+            }
+            buf = b;
+        }
+        got = fread(buf + len, 1, cap - len, f);
+        len += got;
+    } while (got > 0);
+    int ok = !ferror(f) && buf != NULL && len < cap;
+    fclose(f);
+
+    worker_key* keys = NULL;
+    size_t n = 0;
+    for (size_t off = 0; ok && off < len; n++) {
+        size_t ct_bytes, pk_bytes, sk_bytes;
+        ok = corpus_level_sizes(buf[off], &ct_bytes, &pk_bytes, &sk_bytes) == 0
+            && len - off >= 1 + pk_bytes + sk_bytes;
+        worker_key* k = ok ? realloc(keys, (n + 1) * sizeof(*keys)) : NULL;
+        if (k == NULL) {
+            ok = 0;
+            break;
+        }
+        keys = k;
+        const sap_scan_level* level = scan_levels[buf[off] - 2];
+        keys[n].kyber_k = buf[off];
+        keys[n].scan_key = keys[n].owned = malloc(level->key_bytes);
+        if (keys[n].owned == NULL) {
+            ok = 0;
+            break;
+        }
+        level->key_init(keys[n].owned, buf + off + 1 + pk_bytes);
+        off += 1 + pk_bytes + sk_bytes;
+    }
+    if (buf != NULL) {
+        sap_wipe(buf, len);
+        free(buf);
+    }
+    if (!ok) {
+        free_keys(keys, n, blob);
+        return -1;
+    }
+    *out = keys;
+    return (long)n;
+}
+
+static int cmp_hit(const void* a, const void* b)
+{
+    const worker_hit* x = a;
+    const worker_hit* y = b;
+    if (x->index != y->index) return x->index < y->index ? -1 : 1;
+    return x->key < y->key ? -1 : x->key > y->key;
+}
+
+/**
+ * Workflow:
+ *  1. Loads the shard's range of the register, and the keys unless @p ks already
+ *     holds those of @p key_path.
+ *  2. Walks the range in chunks, grouped by level, and scans every chunk with
+ *     each key of the level; the hits of a chunk are sorted and sent as MATCH
+ *     frames, so that they arrive in ascending index order.
+ *  3. Sends DONE, or FAIL if the register or the keys cannot be read.
+ *
+ * @return 0 if the reply was sent, -1 on a write error.
+ */
+static int run_job(int out_fd, uint32_t shard, uint64_t begin, uint64_t end, const char* reg_path,
+    const char* key_path, worker_keyset* ks)
+{
+    static const char no_register[] = "cannot read the register range";
+    static const char no_keys[] = "cannot read the key file";
+    uint8_t body[COORD_MATCH_BYTES + sizeof(no_register)];
+    sap_scand_put32(body, shard);
+
+    corpus reg;
+    if (corpus_load_range(&reg, reg_path, begin, end) != 0) {
+        memcpy(body + 4, no_register, sizeof(no_register) - 1);
+        return send_frame(out_fd, SAP_COORD_FAIL, body, 4 + sizeof(no_register) - 1);
+    }
+    if (ks->n >= 0 && strcmp(ks->path, key_path) != 0) {
+        free_keys(ks->keys, (size_t)ks->n, &ks->blob);
+        ks->n = -1;
+    }
+    if (ks->n < 0) {
+        ks->n = load_keys(key_path, &ks->keys, &ks->blob);
+        snprintf(ks->path, sizeof(ks->path), "%s", key_path);
+    }
+    const worker_key* keys = ks->keys;
+    long n_keys = ks->n;
+    if (n_keys < 0) {
+        corpus_free(&reg);
+        memcpy(body + 4, no_keys, sizeof(no_keys) - 1);
+        return send_frame(out_fd, SAP_COORD_FAIL, body, 4 + sizeof(no_keys) - 1);
+    }
+
+    const uint8_t* (*cts)[COORD_CHUNK] = malloc(sizeof(*cts) * SAP_SCAN_MIXED_LEVELS);
+    uint8_t (*tags)[COORD_CHUNK] = malloc(sizeof(*tags) * SAP_SCAN_MIXED_LEVELS);
+    uint32_t (*index)[COORD_CHUNK] = malloc(sizeof(*index) * SAP_SCAN_MIXED_LEVELS);
+    uint8_t* hits = malloc(COORD_CHUNK);
+    uint8_t* ss = malloc(COORD_CHUNK * 32);
+    worker_hit* found = NULL;
+    size_t cap_found = 0;
+    int ret = cts && tags && index && hits && ss ? 0 : -1;
+
+    for (size_t lo = 0; ret == 0 && lo < reg.n; lo += COORD_CHUNK) {
+        size_t hi = reg.n - lo < COORD_CHUNK ? reg.n : lo + COORD_CHUNK;
+        size_t count[SAP_SCAN_MIXED_LEVELS] = { 0 }, n_found = 0;
+        for (size_t i = lo; i < hi; i++) {
+            unsigned int l = reg.levels[i] - 2u;
+            cts[l][count[l]] = corpus_ct(&reg, i);
+            tags[l][count[l]] = corpus_tag(&reg, i)[0];
+            index[l][count[l]++] = (uint32_t)(i - lo);
+        }
+        for (long k = 0; ret == 0 && k < n_keys; k++) {
+            unsigned int l = keys[k].kyber_k - 2;
+            if (count[l] == 0 || scan_levels[l]->scan(hits, ss, cts[l], tags[l], count[l], keys[k].scan_key) == 0) {
+                continue;
+            }
+            for (size_t j = 0; ret == 0 && j < count[l]; j++) {
+                if (!hits[j]) continue;
+                if (n_found == cap_found) {
+                    size_t cap = cap_found ? 2 * cap_found : 16;
+                    worker_hit* f = malloc(cap * sizeof(*f));
+                    if (f == NULL) {
+                        ret = -1;
+                        break;
+                    }
+                    if (found != NULL) {
+                        memcpy(f, found, n_found * sizeof(*f));
+                        sap_wipe(found, cap_found * sizeof(*f));
+                        free(found);
+                    }
+                    found = f;
+                    cap_found = cap;
+                }
+                found[n_found].index = begin + lo + index[l][j];
+                found[n_found].key = (uint32_t)k;
+                memcpy(found[n_found++].ss, ss + j * 32, 32);
+                sap_wipe(ss + j * 32, 32);
+            }
+        }
+        qsort(found, n_found, sizeof(*found), cmp_hit);
+        for (size_t j = 0; ret == 0 && j < n_found; j++) {
+            sap_scand_put32(body + 4, found[j].key);
+            sap_scand_put64(body + 8, found[j].index);
+            memcpy(body + 16, found[j].ss, 32);
+            ret = send_frame(out_fd, SAP_COORD_MATCH, body, COORD_MATCH_BYTES);
+        }
+    }
+    sap_wipe(body, sizeof(body));
+    if (found != NULL) sap_wipe(found, cap_found * sizeof(*found));
+    free(found);
+    free(cts);
+    free(tags);
+    free(index);
+    free(hits);
+    free(ss);
+
+    sap_scand_put32(body, shard);
+    if (ret == 0) {
+        sap_scand_put64(body + 4, reg.n);
+        ret = send_frame(out_fd, SAP_COORD_DONE, body, 12);
+    } else {
+        static const char no_memory[] = "out of memory";
+        memcpy(body + 4, no_memory, sizeof(no_memory) - 1);
+        send_frame(out_fd, SAP_COORD_FAIL, body, 4 + sizeof(no_memory) - 1);
+    }
+    corpus_free(&reg);
+    return ret;
+}
+
+/// Reads one JOB frame and runs it; returns 1 after a job, 0 if the link was closed, -1 on an error.
+static int serve_job(int in_fd, int out_fd, worker_keyset* ks)
+{
+    uint8_t header[SAP_SCAND_HEADER_BYTES];
+    uint8_t body[4 + 8 + 8 + 2 * (2 + 4096)];
+    int r = read_all(in_fd, header, sizeof(header));
+    if (r <= 0) {
+        return r;
+    }
+    uint32_t len = sap_scand_get32(header);
+    if (header[4] != SAP_COORD_JOB || len < 4 + 8 + 8 + 2 || len > sizeof(body)
+        || read_all(in_fd, body, len) != 1) {
+        return -1;
+    }
+
+    /* paths are copied out to terminate them */
+    char reg_path[4097], key_path[4097];
+    size_t reg_len = body[20] | (size_t)body[21] << 8;
+    if (22 + reg_len + 2 > len) {
+        return -1;
+    }
+    size_t key_len = body[22 + reg_len] | (size_t)body[23 + reg_len] << 8;
+    if (reg_len > 4096 || key_len > 4096 || 24 + reg_len + key_len != len) {
+        return -1;
+    }
+    memcpy(reg_path, body + 22, reg_len);
+    reg_path[reg_len] = '\0';
+    memcpy(key_path, body + 24 + reg_len, key_len);
+    key_path[key_len] = '\0';
+
+    return run_job(out_fd, sap_scand_get32(body), sap_scand_get64(body + 4), sap_scand_get64(body + 12), reg_path,
+        key_path, ks) == 0 ? 1 : -1;
+}
+
+int sap_coord_worker_serve(int in_fd, int out_fd)
+{
+    worker_keyset ks = { .n = -1 };
+    int r;
+    while ((r = serve_job(in_fd, out_fd, &ks)) == 1) {}
+    if (ks.n >= 0) free_keys(ks.keys, (size_t)ks.n, &ks.blob);
+    return r;
+}
+
+/* ---- transports ---- */
+
+static int fork_spawn(void* ctx, unsigned int worker, int* fd, long* handle)
+{
+    (void)ctx;
+    (void)worker;
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) {
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(sv[0]);
+        close(sv[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        close(sv[0]);
+        _exit(sap_coord_worker_serve(sv[1], sv[1]) == 0 ? 0 : 1);
+    }
+    close(sv[1]);
+    *fd = sv[0];
+    *handle = pid;
+    return 0;
+}
+
+static int exec_spawn(void* ctx, unsigned int worker, int* fd, long* handle)
+{
+    (void)worker;
+    char* const* argv = ctx;
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) {
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(sv[0]);
+        close(sv[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        if (dup2(sv[1], 0) < 0 || dup2(sv[1], 1) < 0) _exit(127);
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+    close(sv[1]);
+    *fd = sv[0];
+    *handle = pid;
+    return 0;
+}
+
+static void pid_reap(void* ctx, long handle, int kill_it)
+{
+    (void)ctx;
+    if (kill_it) kill((pid_t)handle, SIGKILL);
+    while (waitpid((pid_t)handle, NULL, 0) < 0 && errno == EINTR) {
+    }
+}
+
+const sap_coord_transport sap_coord_fork_transport = { fork_spawn, pid_reap, NULL };
+
+sap_coord_transport sap_coord_exec_transport(char* const* argv)
+{
+    sap_coord_transport t = { exec_spawn, pid_reap, (void*)argv };
+    return t;
+}
+
+/* ---- coordinator ---- */
+
+enum { SHARD_PENDING, SHARD_RUNNING, SHARD_DONE };
+
+typedef struct {
+    uint64_t begin, end;
+    int state;
+    unsigned int attempts;
+    sap_coord_match* matches;
+    size_t n_matches, cap_matches;
+} coord_shard;
+
+typedef struct {
+    int fd;                     /**< -1 if no worker runs in this slot. */
+    long handle;
+    long shard;                 /**< Shard being scanned, or -1. */
+    uint64_t deadline;
+    uint8_t* in;
+    size_t in_len, in_cap;
+} coord_worker;
+
+typedef struct {
+    const sap_coord_config* config;
+    const sap_coord_transport* transport;
+    coord_shard* shards;
+    size_t n_shards, next_pending, n_done;
+    coord_worker* workers;
+    unsigned int n_workers;
+    long* handles;              /**< Workers whose link was closed, reaped at the end. */
+    size_t n_handles;
+    sap_coord_result* result;
+} coord;
+
+static void shard_reset(coord_shard* s)
+{
+    if (s->matches != NULL) sap_wipe(s->matches, s->n_matches * sizeof(*s->matches));
+    s->n_matches = 0;
+    s->state = SHARD_PENDING;
+}
+
+/// Ends a worker that failed; its shard goes back to the pending ones.
+static void worker_fail(coord* c, coord_worker* w)
+{
+    close(w->fd);
+    c->transport->reap(c->transport->ctx, w->handle, 1);
+    w->fd = -1;
+    w->in_len = 0;
+    if (w->shard >= 0) {
+        shard_reset(&c->shards[w->shard]);
+        if ((size_t)w->shard < c->next_pending) c->next_pending = (size_t)w->shard;
+        c->result->failures++;
+    }
+    w->shard = -1;
+}
+
+/// Closes the link of an idle worker, which then exits; it is reaped at the end.
+static void worker_retire(coord* c, coord_worker* w)
+{
+    close(w->fd);
+    c->handles[c->n_handles++] = w->handle;
+    w->fd = -1;
+}
+
+static long next_shard(coord* c)
+{
+    while (c->next_pending < c->n_shards && c->shards[c->next_pending].state != SHARD_PENDING) c->next_pending++;
+    return c->next_pending < c->n_shards ? (long)c->next_pending : -1;
+}
+
+/**
+ * Hands the next pending shard to an idle worker.
+ *
+ * @return 0 if a shard was sent or none is pending, -1 if the next one has used
+ * up its attempts.
+ */
+static int dispatch(coord* c, coord_worker* w)
+{
+    long i = next_shard(c);
+    if (i < 0) {
+        return 0;
+    }
+    coord_shard* s = &c->shards[i];
+    unsigned int attempts = c->config->attempts ? c->config->attempts : COORD_DEFAULT_ATTEMPTS;
+    if (s->attempts >= attempts) {
+        return -1;
+    }
+    size_t reg_len = strlen(c->config->register_path), key_len = strlen(c->config->key_path);
+    if (reg_len > 4096 || key_len > 4096) {
+        return -1;
+    }
+    uint8_t body[4 + 8 + 8 + 2 * (2 + 4096)];
+    sap_scand_put32(body, (uint32_t)i);
+    sap_scand_put64(body + 4, s->begin);
+    sap_scand_put64(body + 12, s->end);
+    body[20] = (uint8_t)reg_len;
+    body[21] = (uint8_t)(reg_len >> 8);
+    memcpy(body + 22, c->config->register_path, reg_len);
+    body[22 + reg_len] = (uint8_t)key_len;
+    body[23 + reg_len] = (uint8_t)(key_len >> 8);
+    memcpy(body + 24 + reg_len, c->config->key_path, key_len);
+
+    s->attempts++;
+    s->state = SHARD_RUNNING;
+    w->shard = i;
+    w->deadline = c->config->timeout_ms ? now_ns() + (uint64_t)c->config->timeout_ms * 1000000u : 0;
+    if (send_frame(w->fd, SAP_COORD_JOB, body, 24 + reg_len + key_len) != 0) {
+        worker_fail(c, w);
+    }
+    return 0;
+}
+
+/// @return 0 if the frame was taken, -1 if the worker has to be failed.
+static int handle_frame(coord* c, coord_worker* w, uint8_t type, const uint8_t* body, size_t len)
+{
+    if (len < 4 || w->shard < 0 || sap_scand_get32(body) != (uint32_t)w->shard) {
+        return -1;
+    }
+    coord_shard* s = &c->shards[w->shard];
+    switch (type) {
+    case SAP_COORD_MATCH: {
+        uint64_t index = len == COORD_MATCH_BYTES ? sap_scand_get64(body + 8) : 0;
+        if (len != COORD_MATCH_BYTES || index < s->begin || index >= s->end) {
+            return -1;
+        }
+        if (s->n_matches == s->cap_matches) {
+            size_t cap = s->cap_matches ? 2 * s->cap_matches : 16;
+            sap_coord_match* m = malloc(cap * sizeof(*m));
+            if (m == NULL) {
+                return -1;
+            }
+            if (s->matches != NULL) {
+                memcpy(m, s->matches, s->n_matches * sizeof(*m));
+                sap_wipe(s->matches, s->cap_matches * sizeof(*m));
+                free(s->matches);
+            }
+            s->matches = m;
+            s->cap_matches = cap;
+        }
+        sap_coord_match* m = &s->matches[s->n_matches++];
+        m->index = index;
+        m->key = sap_scand_get32(body + 4);
+        memcpy(m->ss, body + 16, 32);
+        return 0;
+    }
+    case SAP_COORD_DONE:
+        if (len != 12 || sap_scand_get64(body + 4) != s->end - s->begin) {
+            return -1;
+        }
+        s->state = SHARD_DONE;
+        c->result->scanned += s->end - s->begin;
+        c->n_done++;
+        w->shard = -1;
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+/// Reads what a worker sent and takes the complete frames.
+static void worker_read(coord* c, coord_worker* w)
+{
+    if (w->in_cap - w->in_len < 4096) {
+        size_t cap = w->in_cap ? 2 * w->in_cap : 1 << 16;
+        uint8_t* in = realloc(w->in, cap);
+        if (in == NULL) {
+            worker_fail(c, w);
+            return;
+        }
+        w->in = in;
+        w->in_cap = cap;
+    }
+    ssize_t n = read(w->fd, w->in + w->in_len, w->in_cap - w->in_len);
+    if (n < 0 && errno == EINTR) {
+        return;
+    }
+    if (n <= 0) {
+        worker_fail(c, w);
+        return;
+    }
+    w->in_len += (size_t)n;
+
+    size_t off = 0;
+    while (w->in_len - off >= SAP_SCAND_HEADER_BYTES) {
+        uint32_t len = sap_scand_get32(w->in + off);
+        if (len > SAP_SCAND_MAX_BODY) {
+            worker_fail(c, w);
+            return;
+        }
+        if (w->in_len - off < SAP_SCAND_HEADER_BYTES + len) break;
+        if (handle_frame(c, w, w->in[off + 4], w->in + off + SAP_SCAND_HEADER_BYTES, len) != 0) {
+            worker_fail(c, w);
+            return;
+        }
+        off += SAP_SCAND_HEADER_BYTES + len;
+    }
+    memmove(w->in, w->in + off, w->in_len - off);
+    w->in_len -= off;
+}
+
+/// Concatenates the match lists of the shards, which are in register order.
+static int merge(coord* c)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < c->n_shards; i++) total += c->shards[i].n_matches;
+    c->result->matches = malloc(total * sizeof(sap_coord_match) + 1);
+    if (c->result->matches == NULL) {
+        return -1;
+    }
+    for (size_t i = 0; i < c->n_shards; i++) {
+        memcpy(c->result->matches + c->result->n_matches, c->shards[i].matches,
+            c->shards[i].n_matches * sizeof(sap_coord_match));
+        c->result->n_matches += c->shards[i].n_matches;
+    }
+    return 0;
+}
+
+/**
+ * Workflow:
+ *  1. Reads the register size and splits it into shards of equal length.
+ *  2. Keeps one worker per slot while shards are pending, hands every idle worker
+ *     the next pending shard and closes the link of idle workers once none is.
+ *  3. Polls the busy workers, collects their matches per shard and fails workers
+ *     whose link breaks, that send anything unexpected or miss their deadline;
+ *     their shards are handed out again.
+ *  4. Reaps all workers and merges the match lists.
+ */
+int sap_coord_run(const sap_coord_config* config, sap_coord_result* result)
+{
+    memset(result, 0, sizeof(*result));
+    size_t n;
+    if (corpus_entries(config->register_path, &n) != 0) {
+        return -1;
+    }
+    unsigned int workers = config->workers ? config->workers : COORD_DEFAULT_WORKERS;
+    size_t n_shards = config->shards ? config->shards : (size_t)workers * 4;
+    if (n_shards > n) n_shards = n;
+    if (n_shards == 0) n_shards = 1;
+    if (workers > n_shards) workers = (unsigned int)n_shards;
+    result->entries = n;
+    result->shards = n_shards;
+
+    coord c = { .config = config, .transport = config->transport ? config->transport : &sap_coord_fork_transport,
+        .n_shards = n_shards, .n_workers = workers, .result = result };
+    c.shards = calloc(n_shards, sizeof(*c.shards));
+    c.workers = calloc(workers, sizeof(*c.workers));
+    struct pollfd* fds = calloc(workers, sizeof(*fds));
+    unsigned int* polled = calloc(workers, sizeof(*polled));
+    int ret = c.shards && c.workers && fds && polled ? 0 : -1;
+    for (size_t i = 0; ret == 0 && i < n_shards; i++) {
+        c.shards[i].begin = (uint64_t)((unsigned __int128)n * i / n_shards);
+        c.shards[i].end = (uint64_t)((unsigned __int128)n * (i + 1) / n_shards);
+    }
+    for (unsigned int i = 0; ret == 0 && i < workers; i++) {
+        c.workers[i].fd = -1;
+        c.workers[i].shard = -1;
+    }
+
+    while (ret == 0 && c.n_done < n_shards) {
+        for (unsigned int i = 0; ret == 0 && i < workers; i++) {
+            coord_worker* w = &c.workers[i];
+            if (w->shard >= 0) continue;
+            if (w->fd < 0 && next_shard(&c) >= 0) {
+                long* h = realloc(c.handles, (result->spawned + 1) * sizeof(*h));
+                if (h == NULL || c.transport->spawn(c.transport->ctx, i, &w->fd, &w->handle) != 0) {
+                    if (h != NULL) c.handles = h;
+                    w->fd = -1;
+                    ret = -1;
+                    break;
+                }
+                c.handles = h;
+                result->spawned++;
+            }
+            if (w->fd < 0) continue;
+            ret = dispatch(&c, w);
+            if (ret == 0 && w->fd >= 0 && w->shard < 0 && next_shard(&c) < 0) worker_retire(&c, w);
+        }
+
+        nfds_t n_fds = 0;
+        int timeout = -1;
+        uint64_t now = now_ns();
+        for (unsigned int i = 0; ret == 0 && i < workers; i++) {
+            coord_worker* w = &c.workers[i];
+            if (w->fd < 0 || w->shard < 0) continue;
+            if (w->deadline != 0) {
+                uint64_t left = w->deadline > now ? (w->deadline - now + 999999) / 1000000 : 0;
+                if (timeout < 0 || left < (uint64_t)timeout) timeout = (int)left;
+            }
+            fds[n_fds].fd = w->fd;
+            fds[n_fds].events = POLLIN;
+            polled[n_fds++] = i;
+        }
+        if (ret != 0 || n_fds == 0) continue;
+        if (poll(fds, n_fds, timeout) < 0 && errno != EINTR) {
+            ret = -1;
+            break;
+        }
+
+        now = now_ns();
+        for (nfds_t j = 0; j < n_fds; j++) {
+            coord_worker* w = &c.workers[polled[j]];
+            if (fds[j].revents & (POLLIN | POLLHUP | POLLERR)) {
+                worker_read(&c, w);
+            }
+            if (w->fd >= 0 && w->shard >= 0 && w->deadline != 0 && now >= w->deadline) {
+                worker_fail(&c, w);
+            }
+        }
+    }
+
+    /* links are closed first: a forked worker may hold copies of the others */
+    for (unsigned int i = 0; c.workers != NULL && i < workers; i++) {
+        coord_worker* w = &c.workers[i];
+        if (w->fd >= 0 && w->shard >= 0) {
+            w->shard = -1;
+            worker_fail(&c, w);
+        } else if (w->fd >= 0) {
+            worker_retire(&c, w);
+        }
+        free(w->in);
+    }
+    for (size_t i = 0; i < c.n_handles; i++) c.transport->reap(c.transport->ctx, c.handles[i], 0);
+
+    if (ret == 0) ret = merge(&c);
+    for (size_t i = 0; c.shards != NULL && i < n_shards; i++) {
+        if (c.shards[i].matches != NULL) sap_wipe(c.shards[i].matches, c.shards[i].cap_matches * sizeof(sap_coord_match));
+        free(c.shards[i].matches);
+    }
+    free(c.shards);
+    free(c.workers);
+    free(c.handles);
+    free(fds);
+    free(polled);
+    return ret;
+}
+
+void sap_coord_result_free(sap_coord_result* result)
+{
+    if (result->matches != NULL) sap_wipe(result->matches, result->n_matches * sizeof(sap_coord_match));
+    free(result->matches);
+    result->matches = NULL;
+    result->n_matches = 0;
+}
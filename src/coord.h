@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @file coord.h
+/// @brief Scanning one register with several worker processes.
+///
+/// The coordinator splits the register into shards, contiguous index ranges,
+/// and starts up to a given number of workers. It hands each worker one shard at
+/// a time, and every worker scans its shard with all keys of the key file. The
+/// worker loads only its range of the register (corpus_load_range()), so the
+/// register does not have to fit into any one process.
+///
+/// Each worker streams back the matches of its shard and then reports the shard
+/// done. The coordinator keeps the matches of a shard apart until then. A worker
+/// may exit, close its link, send something malformed or miss the shard deadline.
+/// The coordinator then drops the partial matches, ends the worker and hands the
+/// shard to a new one, up to a number of attempts per shard. At the end, the match
+/// lists of the shards are concatenated in register order.
+///
+/// Workers are reached through a transport, which starts a worker and returns a
+/// connected stream socket to it. The built-in transports fork the coordinator,
+/// or fork and run a worker binary with the socket as its standard input and
+/// output. A transport that connects to workers on other machines only has to
+/// provide the socket; the register and key file paths must then name the same
+/// files there.
+///
+/// A worker loads the key file once, at its first shard, and keeps the keys for
+/// the later ones. The key file may also be a key blob (keyblob.h, unencrypted),
+/// which the worker maps and verifies instead of preparing the keys.
+///
+/// Messages use the frames of scand_proto.h (u32 body length, u8 type, body;
+/// integers little-endian):
+///  - JOB:   u32 shard, u64 begin, u64 end, u16 length and register path,
+///           u16 length and key file path (coordinator to worker)
+///  - MATCH: u32 shard, u32 key, u64 index, 32-byte shared secret
+///  - DONE:  u32 shard, u64 announcements scanned
+///  - FAIL:  u32 shard and a message
+///
+/// A worker answers every JOB with MATCH frames in ascending index order and one
+/// DONE or FAIL, and exits when the coordinator closes the link.
+
+/// @brief Frame types of the coordinator protocol.
+enum {
+    SAP_COORD_JOB = 0x10,
+    SAP_COORD_MATCH = 0x90,
+    SAP_COORD_DONE = 0x91,
+    SAP_COORD_FAIL = 0x92
+};
+
+/// @brief Starts workers and connects to them.
+typedef struct {
+    /// @brief Starts a worker.
+    ///
+    /// @param[in] ctx The transport's context.
+    /// @param[in] worker Number of the worker slot (0 to workers - 1); a failed
+    /// worker is replaced by a new spawn with the same number.
+    /// @param[out] fd Connected stream socket to the worker.
+    /// @param[out] handle Identifies the worker to reap().
+    /// @return 0 on success, -1 on failure.
+    int (*spawn)(void* ctx, unsigned int worker, int* fd, long* handle);
+    /// @brief Waits for a worker to end, after its socket was closed; with
+    /// @p kill the worker is stopped first.
+    void (*reap)(void* ctx, long handle, int kill);
+    void* ctx;
+} sap_coord_transport;
+
+/// @brief Forks the coordinator; the child runs sap_coord_worker_serve().
+extern const sap_coord_transport sap_coord_fork_transport;
+
+/// @brief Returns a transport that forks and runs @p argv (NULL-terminated,
+/// searched in PATH) with the socket as standard input and output.
+///
+/// The program must call sap_coord_worker_serve(0, 1); `sap_coord -W` does.
+/// @p argv must stay valid while the transport is in use.
+sap_coord_transport sap_coord_exec_transport(char* const* argv);
+
+/// @brief Parameters of sap_coord_run().
+typedef struct {
+    const char* register_path;      /**< Register file (sap_corpus format). */
+    const char* key_path;           /**< Key file (REGISTER bodies of scand_proto.h back to back) or key blob. */
+    unsigned int workers;           /**< Worker processes at a time, 0 for 4. */
+    size_t shards;                  /**< Number of shards, 0 for four per worker. */
+    unsigned int attempts;          /**< Workers a shard is handed to before giving up, 0 for 3. */
+    unsigned int timeout_ms;        /**< Time a worker has for one shard, 0 for no limit. */
+    const sap_coord_transport* transport;   /**< NULL for sap_coord_fork_transport. */
+} sap_coord_config;
+
+/// @brief A match found by a worker.
+typedef struct {
+    uint64_t index;                 /**< Register index. */
+    uint32_t key;                   /**< Position of the key in the key file, from 0. */
+    uint8_t ss[32];                 /**< Shared secret. */
+} sap_coord_match;
+
+/// @brief What sap_coord_run() found and did.
+typedef struct {
+    sap_coord_match* matches;       /**< Ordered by index, then key. */
+    size_t n_matches;
+    uint64_t entries;               /**< Size of the register. */
+    uint64_t scanned;               /**< Announcements scanned by the shards that completed. */
+    size_t shards;                  /**< Number of shards. */
+    unsigned int spawned;           /**< Workers started. */
+    unsigned int failures;          /**< Workers that failed or timed out during a shard. */
+} sap_coord_result;
+
+/// @brief Scans a register with worker processes and merges their matches.
+///
+/// @param[in] config Parameters.
+/// @param[out] result Matches and counters; release with sap_coord_result_free()
+/// (also after a failure, which may leave partial counters).
+/// @return 0 if every shard was scanned, -1 if the register cannot be read, a
+/// shard failed on every attempt or out of memory.
+int sap_coord_run(const sap_coord_config* config, sap_coord_result* result);
+
+/// @brief Wipes and releases the matches of a result.
+void sap_coord_result_free(sap_coord_result* result);
+
+/// @brief Serves JOB frames from @p in_fd, answering on @p out_fd, until the link is closed.
+///
+/// The keys are loaded at the first job and again only if a job names another
+/// key file; they are wiped when it returns.
+///
+/// @return 0 when the link was closed between jobs, -1 on a malformed frame or
+/// write error.
+int sap_coord_worker_serve(int in_fd, int out_fd);
@@ -0,0 +1,568 @@
+#include "corpus.h"
+#include "fips202.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CORPUS_MAGIC "PQSAPREG"
+#define CORPUS_VERSION 2
+
+/// Domain separation labels of the values drawn here (see also corpus_gen.c).
+enum {
+    LABEL_MATCHES = 'm',
+    LABEL_LEVELS = 'l'
+};
+
+/**
+ * On-disk header. All integers are stored in host (little-endian) byte order.
+ * In version 2 the header is followed by the n levels, the recipient keys of
+ * every level in use in ascending order (k_pub, k_priv, v_pub, v_priv each), the
+ * ephemeral public keys back to back, the tags and finally the n_matches match
+ * indices. ct_bytes, pk_bytes and sk_bytes are 0 for a mixed corpus. Version 1
+ * files are pure and have neither levels nor more than one set of keys.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t kyber_k;
+    uint64_t n;
+    uint64_t n_matches;
+    uint32_t ct_bytes;
+    uint32_t tag_bytes;
+    uint32_t pk_bytes;
+    uint32_t sk_bytes;
+    uint8_t seed[CORPUS_SEED_BYTES];
+} corpus_file_header;
+
+int corpus_level_sizes(uint32_t kyber_k, size_t* ct_bytes, size_t* pk_bytes, size_t* sk_bytes)
+{
+    switch (kyber_k) {
+    case 2: *ct_bytes = 768;  *pk_bytes = 800;  *sk_bytes = 1632; return 0;
+    case 3: *ct_bytes = 1088; *pk_bytes = 1184; *sk_bytes = 2400; return 0;
+    case 4: *ct_bytes = 1568; *pk_bytes = 1568; *sk_bytes = 3168; return 0;
+    default: return -1;
+    }
+}
+
+size_t corpus_match_count(const corpus_params* params)
+{
+    double rate = params->match_rate;
+    if (rate <= 0) return 0;
+    if (rate >= 1) return params->n;
+
+    size_t count = (size_t)llround(rate * (double)params->n);
+    return count > params->n ? params->n : count;
+}
+
+static int alloc_keys(corpus_keys* keys, uint32_t kyber_k)
+{
+    size_t ct_bytes, pk_bytes, sk_bytes;
+    corpus_level_sizes(kyber_k, &ct_bytes, &pk_bytes, &sk_bytes);
+    keys->k_pub = malloc(pk_bytes);
+    keys->k_priv = malloc(sk_bytes);
+    keys->v_pub = malloc(pk_bytes);
+    keys->v_priv = malloc(sk_bytes);
+    return keys->k_pub && keys->k_priv && keys->v_pub && keys->v_priv ? 0 : -1;
+}
+
+/**
+ * Workflow:
+ *  1. Records the level of every announcement (@p levels, or kyber_k for a pure
+ *     corpus) and lays out their ephemeral public keys back to back.
+ *  2. Allocates the announcements, the match indices and the recipient keys of
+ *     kyber_k, or of all levels for a mixed corpus.
+ */
+static int alloc_corpus(corpus* c, uint32_t kyber_k, const uint8_t* levels, size_t n, size_t n_matches)
+{
+    memset(c, 0, sizeof(*c));
+    c->kyber_k = kyber_k;
+    c->n = n;
+    c->n_matches = n_matches;
+    if (kyber_k != CORPUS_MIXED
+        && corpus_level_sizes(kyber_k, &c->ct_bytes, &c->pk_bytes, &c->sk_bytes) != 0) {
+        return -1;
+    }
+
+    c->levels = malloc(n + 1);
+    c->ct_offsets = malloc((n + 1) * sizeof(uint64_t));
+    c->tags = malloc(n * CORPUS_TAG_BYTES + 1);
+    c->matches = malloc(n_matches * sizeof(uint64_t) + 1);
+    if (!c->levels || !c->ct_offsets || !c->tags || !c->matches) {
+        corpus_free(c);
+        return -1;
+    }
+
+    uint64_t offset = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t k = levels != NULL ? levels[i] : kyber_k;
+        size_t ct_bytes, pk_bytes, sk_bytes;
+        if (corpus_level_sizes(k, &ct_bytes, &pk_bytes, &sk_bytes) != 0
+            || (kyber_k != CORPUS_MIXED && k != kyber_k)) {
+            corpus_free(c);
+            return -1;
+        }
+        c->levels[i] = (uint8_t)k;
+        c->ct_offsets[i] = offset;
+        offset += ct_bytes;
+    }
+    c->ct_offsets[n] = offset;
+    c->ephemeral_pub_keys = malloc(offset + 1);
+
+    int ok = c->ephemeral_pub_keys != NULL;
+    for (uint32_t k = 2; ok && k < 2 + CORPUS_LEVELS; k++) {
+        if (kyber_k == CORPUS_MIXED || kyber_k == k) ok = alloc_keys(&c->keys[k - 2], k) == 0;
+    }
+    if (!ok) {
+        corpus_free(c);
+        return -1;
+    }
+    if (kyber_k != CORPUS_MIXED) {
+        c->k_pub = c->keys[kyber_k - 2].k_pub;
+        c->k_priv = c->keys[kyber_k - 2].k_priv;
+        c->v_pub = c->keys[kyber_k - 2].v_pub;
+        c->v_priv = c->keys[kyber_k - 2].v_priv;
+    }
+    return 0;
+}
+
+int corpus_alloc(corpus* c, uint32_t kyber_k, size_t n, size_t n_matches)
+{
+    if (kyber_k == CORPUS_MIXED) {
+        memset(c, 0, sizeof(*c));
+        return -1;
+    }
+    return alloc_corpus(c, kyber_k, NULL, n, n_matches);
+}
+
+int corpus_alloc_mixed(corpus* c, const uint8_t* levels, size_t n, size_t n_matches)
+{
+    return alloc_corpus(c, CORPUS_MIXED, levels, n, n_matches);
+}
+
+void corpus_free(corpus* c)
+{
+    for (int l = 0; l < CORPUS_LEVELS; l++) {
+        free(c->keys[l].k_pub);
+        free(c->keys[l].k_priv);
+        free(c->keys[l].v_pub);
+        free(c->keys[l].v_priv);
+    }
+    free(c->levels);
+    free(c->ct_offsets);
+    free(c->ephemeral_pub_keys);
+    free(c->tags);
+    free(c->matches);
+    memset(c, 0, sizeof(*c));
+}
+
+/**
+ * Picks exactly @p k distinct match positions out of @p n with Floyd's algorithm,
+ * drawing randomness from SHAKE256(seed || LABEL_MATCHES).
+ */
+static void select_matches(uint8_t* is_match, size_t n, size_t k, const uint8_t seed[CORPUS_SEED_BYTES])
+{
+    uint8_t in[CORPUS_SEED_BYTES + 1];
+    memcpy(in, seed, CORPUS_SEED_BYTES);
+    in[CORPUS_SEED_BYTES] = LABEL_MATCHES;
+
+    keccak_state state;
+    shake256_absorb_once(&state, in, sizeof(in));
+
+    for (size_t j = n - k; j < n; j++) {
+        uint8_t buf[8];
+        uint64_t r = 0;
+        shake256_squeeze(buf, sizeof(buf), &state);
+        for (int b = 0; b < 8; b++) r |= (uint64_t)buf[b] << (8 * b);
+
+        size_t t = r % (j + 1);
+        if (is_match[t]) is_match[j] = 1;
+        else is_match[t] = 1;
+    }
+}
+
+/**
+ * Draws the level of every announcement of a mixed corpus uniformly from {2, 3, 4},
+ * rejecting bytes of SHAKE256(seed || LABEL_LEVELS) above 254.
+ */
+static void select_levels(uint8_t* levels, size_t n, const uint8_t seed[CORPUS_SEED_BYTES])
+{
+    uint8_t in[CORPUS_SEED_BYTES + 1];
+    memcpy(in, seed, CORPUS_SEED_BYTES);
+    in[CORPUS_SEED_BYTES] = LABEL_LEVELS;
+
+    keccak_state state;
+    shake256_absorb_once(&state, in, sizeof(in));
+
+    uint8_t buf[SHAKE256_RATE];
+    size_t pos = sizeof(buf);
+    for (size_t i = 0; i < n; i++) {
+        uint8_t b;
+        do {
+            if (pos == sizeof(buf)) {
+                shake256_squeeze(buf, sizeof(buf), &state);
+                pos = 0;
+            }
+            b = buf[pos++];
+        } while (b == 255);
+        levels[i] = (uint8_t)(2 + b % 3);
+    }
+}
+
+/**
+ * Workflow:
+ *  1. Draws the levels of a mixed corpus and allocates the corpus.
+ *  2. Selects the match positions.
+ *  3. Runs the generator of every level in use (see corpus_gen.c).
+ *  4. Records the sorted match indices.
+ */
+int corpus_generate(corpus* c, const corpus_params* params)
+{
+    static int (*const fill[CORPUS_LEVELS])(corpus*, const uint8_t*, unsigned int) = {
+        pqsap_kyber512_corpus_fill, pqsap_kyber768_corpus_fill, pqsap_kyber1024_corpus_fill
+    };
+    size_t n = params->n, n_matches = corpus_match_count(params);
+    uint8_t* is_match = calloc(n + 1, 1);
+    uint8_t* levels = NULL;
+    int ret = -1;
+
+    if (is_match == NULL) {
+        return -1;
+    }
+    if (params->kyber_k == CORPUS_MIXED) {
+        levels = malloc(n + 1);
+        if (levels != NULL) {
+            select_levels(levels, n, params->seed);
+            ret = corpus_alloc_mixed(c, levels, n, n_matches);
+        }
+    } else {
+        ret = corpus_alloc(c, params->kyber_k, n, n_matches);
+    }
+    if (ret != 0) {
+        free(is_match);
+        free(levels);
+        return -1;
+    }
+    memcpy(c->seed, params->seed, CORPUS_SEED_BYTES);
+    select_matches(is_match, n, n_matches, c->seed);
+
+    unsigned int threads = params->threads;
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (unsigned int)online : 1;
+    }
+    for (int l = 0; ret == 0 && l < CORPUS_LEVELS; l++) {
+        if (c->keys[l].k_pub != NULL) ret = fill[l](c, is_match, threads);
+    }
+
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (is_match[i]) c->matches[m++] = i;
+    }
+
+    free(is_match);
+    free(levels);
+    if (ret != 0) {
+        corpus_free(c);
+    }
+    return ret;
+}
+
+/**
+ * Workflow:
+ *  1. Writes the header.
+ *  2. Writes the levels, the recipient keys of every level in use, the ephemeral
+ *     public keys, the tags and the match indices.
+ */
+int corpus_save(const corpus* c, const char* path)
+{
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+        return -1;
+    }
+
+    corpus_file_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CORPUS_MAGIC, sizeof(h.magic));
+    h.version = CORPUS_VERSION;
+    h.kyber_k = c->kyber_k;
+    h.n = c->n;
+    h.n_matches = c->n_matches;
+    h.ct_bytes = c->ct_bytes;
+    h.tag_bytes = CORPUS_TAG_BYTES;
+    h.pk_bytes = c->pk_bytes;
+    h.sk_bytes = c->sk_bytes;
+    memcpy(h.seed, c->seed, CORPUS_SEED_BYTES);
+
+    int ok = fwrite(&h, sizeof(h), 1, f) == 1
+        && fwrite(c->levels, 1, c->n, f) == c->n;
+    for (uint32_t k = 2; ok && k < 2 + CORPUS_LEVELS; k++) {
+        const corpus_keys* keys = &c->keys[k - 2];
+        size_t ct_bytes, pk_bytes, sk_bytes;
+        if (keys->k_pub == NULL) continue;
+        corpus_level_sizes(k, &ct_bytes, &pk_bytes, &sk_bytes);
+        ok = fwrite(keys->k_pub, pk_bytes, 1, f) == 1
+            && fwrite(keys->k_priv, sk_bytes, 1, f) == 1
+            && fwrite(keys->v_pub, pk_bytes, 1, f) == 1
+            && fwrite(keys->v_priv, sk_bytes, 1, f) == 1;
+    }
+    ok = ok && fwrite(c->ephemeral_pub_keys, 1, c->ct_offsets[c->n], f) == c->ct_offsets[c->n]
+        && fwrite(c->tags, CORPUS_TAG_BYTES, c->n, f) == c->n
+        && fwrite(c->matches, sizeof(uint64_t), c->n_matches, f) == c->n_matches;
+
+    if (fclose(f) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+/// Reads and validates the header (magic, version, level and sizes).
+static int read_header(FILE* f, corpus_file_header* h)
+{
+    size_t ct_bytes = 0, pk_bytes = 0, sk_bytes = 0;
+    if (fread(h, sizeof(*h), 1, f) != 1
+        || memcmp(h->magic, CORPUS_MAGIC, sizeof(h->magic)) != 0
+        || (h->version != 1 && h->version != CORPUS_VERSION)
+        || (h->version == 1 && h->kyber_k == CORPUS_MIXED)
+        || (h->kyber_k != CORPUS_MIXED && corpus_level_sizes(h->kyber_k, &ct_bytes, &pk_bytes, &sk_bytes) != 0)
+        || h->ct_bytes != ct_bytes || h->pk_bytes != pk_bytes || h->sk_bytes != sk_bytes
+        || h->tag_bytes != CORPUS_TAG_BYTES || h->n_matches > h->n) {
+        return -1;
+    }
+    return 0;
+}
+
+int corpus_load(corpus* c, const char* path)
+{
+    return corpus_load_range(c, path, 0, SIZE_MAX);
+}
+
+/**
+ * Workflow:
+ *  1. Reads the header and all levels (version 2), which locate the first
+ *     ephemeral public key of the range and the end of the section.
+ *  2. Allocates the corpus for the levels of the range, which rejects levels
+ *     that are invalid or, in a pure corpus, differ from the header.
+ *  3. Reads the keys, then seeks to the range in the ephemeral public keys and
+ *     the tags, and keeps the match indices inside it.
+ */
+int corpus_load_range(corpus* c, const char* path, size_t begin, size_t end)
+{
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return -1;
+    }
+
+    corpus_file_header h;
+    if (read_header(f, &h) != 0 || begin > h.n) {
+        fclose(f);
+        return -1;
+    }
+    if (end > h.n) end = h.n;
+    if (end < begin) end = begin;
+
+    uint8_t* levels = NULL;
+    uint64_t ct_before = (uint64_t)begin * h.ct_bytes, ct_total = h.n * h.ct_bytes;
+    int ok = 1;
+    if (h.version != 1) {
+        levels = malloc(h.n + 1);
+        ok = levels != NULL && fread(levels, 1, h.n, f) == h.n;
+        ct_before = ct_total = 0;
+        for (size_t i = 0; ok && i < h.n; i++) {
+            size_t ct_bytes, pk_bytes, sk_bytes;
+            ok = corpus_level_sizes(levels[i], &ct_bytes, &pk_bytes, &sk_bytes) == 0;
+            if (i < begin) ct_before += ct_bytes;
+            ct_total += ct_bytes;
+        }
+    }
+    ok = ok && alloc_corpus(c, h.kyber_k, levels != NULL ? levels + begin : NULL, end - begin, h.n_matches) == 0;
+    free(levels);
+    if (!ok) {
+        fclose(f);
+        return -1;
+    }
+    memcpy(c->seed, h.seed, CORPUS_SEED_BYTES);
+
+    for (uint32_t k = 2; ok && k < 2 + CORPUS_LEVELS; k++) {
+        const corpus_keys* keys = &c->keys[k - 2];
+        size_t ct_bytes, pk_bytes, sk_bytes;
+        if (keys->k_pub == NULL) continue;
+        corpus_level_sizes(k, &ct_bytes, &pk_bytes, &sk_bytes);
+        ok = fread(keys->k_pub, pk_bytes, 1, f) == 1
+            && fread(keys->k_priv, sk_bytes, 1, f) == 1
+            && fread(keys->v_pub, pk_bytes, 1, f) == 1
+            && fread(keys->v_priv, sk_bytes, 1, f) == 1;
+    }
+    off_t data = ok ? ftello(f) : -1;
+    ok = ok && data >= 0
+        && fseeko(f, data + (off_t)ct_before, SEEK_SET) == 0
+        && fread(c->ephemeral_pub_keys, 1, c->ct_offsets[c->n], f) == c->ct_offsets[c->n]
+        && fseeko(f, data + (off_t)ct_total + (off_t)begin * CORPUS_TAG_BYTES, SEEK_SET) == 0
+        && fread(c->tags, CORPUS_TAG_BYTES, c->n, f) == c->n
+        && fseeko(f, data + (off_t)ct_total + (off_t)h.n * CORPUS_TAG_BYTES, SEEK_SET) == 0
+        && fread(c->matches, sizeof(uint64_t), h.n_matches, f) == h.n_matches;
+    fclose(f);
+    if (!ok) {
+        corpus_free(c);
+        return -1;
+    }
+
+    size_t m = 0;
+    for (size_t j = 0; j < h.n_matches; j++) {
+        if (c->matches[j] >= begin && c->matches[j] < end) c->matches[m++] = c->matches[j] - begin;
+    }
+    c->n_matches = m;
+    return 0;
+}
+
+/**
+ * Workflow:
+ *  1. Reads announcements [c->n, end) with corpus_load_range().
+ *  2. Grows the arrays of @p c; a failed realloc() leaves them valid, only larger.
+ *  3. Copies the new levels, offsets (shifted by the old total), ephemeral public
+ *     keys, tags and match indices (shifted by the old count) behind the old ones.
+ */
+int corpus_extend(corpus* c, const char* path)
+{
+    corpus t;
+    if (corpus_load_range(&t, path, c->n, SIZE_MAX) != 0) {
+        return -1;
+    }
+    if (t.kyber_k != c->kyber_k) {
+        corpus_free(&t);
+        return -1;
+    }
+    size_t n = c->n + t.n, n_matches = c->n_matches + t.n_matches;
+    uint64_t ct_base = c->ct_offsets[c->n], ct_total = ct_base + t.ct_offsets[t.n];
+    uint8_t* levels = realloc(c->levels, n + 1);
+    if (levels != NULL) c->levels = levels;
+    uint64_t* ct_offsets = realloc(c->ct_offsets, (n + 1) * sizeof(uint64_t));
+    if (ct_offsets != NULL) c->ct_offsets = ct_offsets;
+    uint8_t* cts = realloc(c->ephemeral_pub_keys, ct_total + 1);
+    if (cts != NULL) c->ephemeral_pub_keys = cts;
+    uint8_t* tags = realloc(c->tags, n * CORPUS_TAG_BYTES + 1);
+    if (tags != NULL) c->tags = tags;
+    uint64_t* matches = realloc(c->matches, n_matches * sizeof(uint64_t) + 1);
+    if (matches != NULL) c->matches = matches;
+    if (levels == NULL || ct_offsets == NULL || cts == NULL || tags == NULL || matches == NULL) {
+        corpus_free(&t);
+        return -1;
+    }
+
+    memcpy(c->levels + c->n, t.levels, t.n);
+    for (size_t i = 0; i <= t.n; i++) c->ct_offsets[c->n + i] = ct_base + t.ct_offsets[i];
+    memcpy(c->ephemeral_pub_keys + ct_base, t.ephemeral_pub_keys, t.ct_offsets[t.n]);
+    memcpy(c->tags + c->n * CORPUS_TAG_BYTES, t.tags, t.n * CORPUS_TAG_BYTES);
+    for (size_t j = 0; j < t.n_matches; j++) c->matches[c->n_matches + j] = c->n + t.matches[j];
+    c->n = n;
+    c->n_matches = n_matches;
+    corpus_free(&t);
+    return 0;
+}
+
+/**
+ * Workflow:
+ *  1. Reads the header and the levels (or fills them in for version 1).
+ *  2. Adds up the sizes of the keys and of the ephemeral public keys to find
+ *     where the sections start.
+ */
+int corpus_read_layout(corpus_layout* l, const char* path)
+{
+    memset(l, 0, sizeof(*l));
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return -1;
+    }
+    corpus_file_header h;
+    int ok = read_header(f, &h) == 0;
+    l->levels = ok ? malloc(h.n + 1) : NULL;
+    ok = ok && l->levels != NULL;
+    if (ok && h.version == 1) {
+        memset(l->levels, (int)h.kyber_k, h.n);
+    } else if (ok) {
+        ok = fread(l->levels, 1, h.n, f) == h.n;
+    }
+    fclose(f);
+
+    uint64_t at = sizeof(h) + (ok && h.version != 1 ? h.n : 0), cts = 0;
+    for (uint32_t k = 2; ok && k < 2 + CORPUS_LEVELS; k++) {
+        size_t ct_bytes, pk_bytes, sk_bytes;
+        corpus_level_sizes(k, &ct_bytes, &pk_bytes, &sk_bytes);
+        if (h.kyber_k == CORPUS_MIXED || h.kyber_k == k) at += 2 * (pk_bytes + sk_bytes);
+    }
+    for (size_t i = 0; ok && i < h.n; i++) {
+        size_t ct_bytes, pk_bytes, sk_bytes;
+        ok = corpus_level_sizes(l->levels[i], &ct_bytes, &pk_bytes, &sk_bytes) == 0
+            && (h.kyber_k == CORPUS_MIXED || l->levels[i] == h.kyber_k);
+        cts += ct_bytes;
+    }
+    if (!ok) {
+        corpus_layout_free(l);
+        return -1;
+    }
+    l->kyber_k = h.kyber_k;
+    l->n = h.n;
+    l->cts_at = at;
+    l->tags_at = at + cts;
+    return 0;
+}
+
+void corpus_layout_free(corpus_layout* l)
+{
+    free(l->levels);
+    memset(l, 0, sizeof(*l));
+}
+
+int corpus_entries(const char* path, size_t* n)
+{
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return -1;
+    }
+    corpus_file_header h;
+    int ret = read_header(f, &h);
+    fclose(f);
+    if (ret == 0) *n = h.n;
+    return ret;
+}
+
+/// Creates the directory that holds @p path, if it names one and it does not exist.
+static void make_parent_dir(const char* path)
+{
+    char dir[4096];
+    const char* slash = strrchr(path, '/');
+    if (slash == NULL || slash == path || (size_t)(slash - path) >= sizeof(dir)) {
+        return;
+    }
+    memcpy(dir, path, slash - path);
+    dir[slash - path] = '\0';
+    mkdir(dir, 0755);
+}
+
+int corpus_load_or_generate(corpus* c, const char* path, const corpus_params* params)
+{
+    if (corpus_load(c, path) == 0) {
+        if (c->kyber_k == params->kyber_k && c->n == params->n
+            && c->n_matches == corpus_match_count(params)
+            && memcmp(c->seed, params->seed, CORPUS_SEED_BYTES) == 0) {
+            return 0;
+        }
+        corpus_free(c);
+    }
+
+    if (corpus_generate(c, params) != 0) {
+        return -1;
+    }
+    make_parent_dir(path);
+    if (corpus_save(c, path) != 0) {
+        fprintf(stderr, "warning: could not write corpus to %s\n", path);
+    }
+    return 0;
+}
+
+void corpus_default_path(char* path, size_t len, const char* dir, const corpus_params* params)
+{
+    snprintf(path, len, "%s/k%u_n%zu_m%zu_%02x%02x%02x%02x.sap", dir,
+        params->kyber_k, params->n, corpus_match_count(params),
+        params->seed[0], params->seed[1], params->seed[2], params->seed[3]);
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @file corpus.h
+/// @brief Reusable announcement registers (corpora) for benchmarks and tests.
+///
+/// A corpus is a register of announcements (ephemeral public keys plus the sender's
+/// 32-byte hash of the shared secret) together with the recipient key pairs that
+/// scan it and the indices of the announcements addressed to that recipient.
+/// Corpora are generated deterministically from a seed, in parallel, and written
+/// to disk once so that benchmark runs only pay for loading them.
+///
+/// Every announcement carries the security level (KYBER_K) it was made at, and
+/// ephemeral public keys of different levels differ in size. A corpus is either
+/// pure, with all announcements at one level, or mixed (CORPUS_MIXED), with the
+/// level of each announcement drawn from the seed and a recipient that holds key
+/// pairs at all three levels.
+
+/// @def CORPUS_TAG_BYTES
+/// @brief Number of bytes of shared-secret hash stored per announcement (see calculate_ss_hash()).
+#define CORPUS_TAG_BYTES 32
+
+/// @def CORPUS_SEED_BYTES
+/// @brief Number of bytes in the corpus generation seed.
+#define CORPUS_SEED_BYTES 32
+
+/// @def CORPUS_DECOYS
+/// @brief Number of deterministic decoy recipients that non-matching announcements are sent to.
+#define CORPUS_DECOYS 256
+
+/// @def CORPUS_MIXED
+/// @brief kyber_k of a corpus whose announcements use all three levels.
+#define CORPUS_MIXED 0
+
+/// @def CORPUS_LEVELS
+/// @brief Number of security levels; per-level arrays are indexed by KYBER_K - 2.
+#define CORPUS_LEVELS 3
+
+/// @brief Parameters of a corpus to generate.
+typedef struct {
+    uint32_t kyber_k;                   /**< Security level of all announcements (2, 3 or 4) or CORPUS_MIXED. */
+    size_t n;                           /**< Number of announcements. */
+    double match_rate;                  /**< Fraction of announcements addressed to the recipient. */
+    uint8_t seed[CORPUS_SEED_BYTES];    /**< Seed all keys and encapsulations are derived from. */
+    unsigned int threads;               /**< Worker threads, 0 selects one per online CPU. */
+} corpus_params;
+
+/// @brief The recipient's key pairs at one level.
+typedef struct {
+    uint8_t* k_pub;                     /**< Public spending key. */
+    uint8_t* k_priv;                    /**< Secret spending key. */
+    uint8_t* v_pub;                     /**< Public view key. */
+    uint8_t* v_priv;                    /**< Secret view key. */
+} corpus_keys;
+
+/// @brief An announcement register with its recipient keys and expected matches.
+typedef struct {
+    uint32_t kyber_k;                   /**< Security level of all announcements, or CORPUS_MIXED. */
+    size_t n;                           /**< Number of announcements. */
+    size_t ct_bytes;                    /**< Bytes per ephemeral public key (ciphertext); 0 if mixed. */
+    size_t pk_bytes;                    /**< Bytes per KEM public key; 0 if mixed. */
+    size_t sk_bytes;                    /**< Bytes per KEM secret key; 0 if mixed. */
+    uint8_t seed[CORPUS_SEED_BYTES];    /**< Generation seed. */
+    uint8_t* k_pub;                     /**< Recipient's public spending key (keys[kyber_k - 2]; NULL if mixed). */
+    uint8_t* k_priv;                    /**< Recipient's secret spending key (likewise). */
+    uint8_t* v_pub;                     /**< Recipient's public view key (likewise). */
+    uint8_t* v_priv;                    /**< Recipient's secret view key (likewise). */
+    corpus_keys keys[CORPUS_LEVELS];    /**< Recipient keys per level, NULL at levels the corpus does not use. */
+    uint8_t* levels;                    /**< n per-announcement levels (KYBER_K). */
+    uint64_t* ct_offsets;               /**< n + 1 offsets of the ephemeral public keys; the last is the total size. */
+    uint8_t* ephemeral_pub_keys;        /**< The n ephemeral public keys, back to back. */
+    uint8_t* tags;                      /**< n * CORPUS_TAG_BYTES shared-secret hashes. */
+    size_t n_matches;                   /**< Number of announcements addressed to the recipient. */
+    uint64_t* matches;                  /**< Sorted indices of those announcements. */
+} corpus;
+
+/// @brief Returns the ephemeral public key of announcement @p i.
+static inline uint8_t* corpus_ct(const corpus* c, size_t i)
+{
+    return c->ephemeral_pub_keys + c->ct_offsets[i];
+}
+
+/// @brief Returns the shared-secret hash of announcement @p i.
+static inline uint8_t* corpus_tag(const corpus* c, size_t i)
+{
+    return c->tags + i * CORPUS_TAG_BYTES;
+}
+
+/// @brief Looks up the KEM sizes of a security level.
+///
+/// @param[in] kyber_k Security level (2, 3 or 4).
+/// @param[out] ct_bytes Ciphertext bytes.
+/// @param[out] pk_bytes Public key bytes.
+/// @param[out] sk_bytes Secret key bytes.
+/// @return 0 on success, -1 if @p kyber_k is not a valid level.
+int corpus_level_sizes(uint32_t kyber_k, size_t* ct_bytes, size_t* pk_bytes, size_t* sk_bytes);
+
+/// @brief Returns how many announcements of a corpus with these parameters are matches.
+size_t corpus_match_count(const corpus_params* params);
+
+/// @brief Allocates the arrays of a pure corpus for the given level and size.
+///
+/// @return 0 on success, -1 on invalid level or allocation failure.
+int corpus_alloc(corpus* c, uint32_t kyber_k, size_t n, size_t n_matches);
+
+/// @brief Allocates the arrays of a mixed corpus and copies the per-announcement levels.
+///
+/// @return 0 on success, -1 on an invalid level or allocation failure.
+int corpus_alloc_mixed(corpus* c, const uint8_t* levels, size_t n, size_t n_matches);
+
+/// @brief Releases all memory owned by a corpus.
+void corpus_free(corpus* c);
+
+/// @brief Generates a corpus in parallel.
+///
+/// Draws the levels (for CORPUS_MIXED) and the match positions from the seed,
+/// then lets the generator of every level in use fill in its keys and
+/// announcements. The result depends only on the parameters (not on the thread
+/// count).
+///
+/// @return 0 on success, -1 on failure.
+int corpus_generate(corpus* c, const corpus_params* params);
+
+/// @brief Derives the recipient keys of one level and generates the announcements at that level.
+///
+/// @param[in,out] c Allocated corpus with seed and levels set; keys[KYBER_K - 2] must be allocated.
+/// @param[in] is_match n flags, 1 for announcements addressed to the recipient.
+/// @param[in] threads Number of worker threads (at least 1).
+/// @return 0 on success, -1 on failure.
+int pqsap_kyber512_corpus_fill(corpus* c, const uint8_t* is_match, unsigned int threads);
+int pqsap_kyber768_corpus_fill(corpus* c, const uint8_t* is_match, unsigned int threads);
+int pqsap_kyber1024_corpus_fill(corpus* c, const uint8_t* is_match, unsigned int threads);
+
+/// @brief Writes a corpus to @p path (format version 2, with per-announcement levels).
+///
+/// @return 0 on success, -1 on I/O error.
+int corpus_save(const corpus* c, const char* path);
+
+/// @brief Reads a corpus from @p path; version 1 files (one level, no level tags) are accepted.
+///
+/// @return 0 on success, -1 on I/O error or if the file is not a valid corpus.
+int corpus_load(corpus* c, const char* path);
+
+/// @brief Reads announcements [@p begin, @p end) of the corpus at @p path, with all its keys.
+///
+/// Only the levels of the whole register are read besides the range, so a
+/// process can work on a part of a register that does not fit its memory. The
+/// result is a corpus of end - begin announcements whose index 0 is @p begin;
+/// @p end is clamped to the size of the register, and the match indices are
+/// those inside the range, shifted likewise.
+///
+/// @return 0 on success, -1 on I/O error, if the file is not a valid corpus or
+/// @p begin is beyond its end.
+int corpus_load_range(corpus* c, const char* path, size_t begin, size_t end);
+
+/// @brief Appends the announcements of the corpus at @p path beyond the first c->n to @p c.
+///
+/// For registers that only grow: the announcements @p c holds are taken to be
+/// the start of the file, and only the levels of the whole register, the keys
+/// and the new announcements are read (see corpus_load_range()). The keys of
+/// @p c are kept.
+///
+/// @return 0 on success, also if nothing was added; -1 on I/O error, out of
+/// memory, if the file is not a valid corpus of the same level or holds fewer
+/// than c->n announcements. On failure @p c is unchanged.
+int corpus_extend(corpus* c, const char* path);
+
+/// @brief Reads the number of announcements of the corpus at @p path from its header.
+///
+/// @return 0 on success, -1 on I/O error or if the file is not a valid corpus.
+int corpus_entries(const char* path, size_t* n);
+
+/// @brief Where the sections of a register file are, for readers that do their own I/O.
+typedef struct {
+    uint32_t kyber_k;                   /**< Security level of all announcements, or CORPUS_MIXED. */
+    size_t n;                           /**< Number of announcements. */
+    uint8_t* levels;                    /**< n per-announcement levels. */
+    uint64_t cts_at;                    /**< File offset of the first ephemeral public key. */
+    uint64_t tags_at;                   /**< File offset of the first tag (CORPUS_TAG_BYTES each). */
+} corpus_layout;
+
+/// @brief Reads the header and levels of the corpus at @p path and locates its sections.
+///
+/// @param[out] l Layout; release with corpus_layout_free().
+/// @return 0 on success, -1 on I/O error or if the file is not a valid corpus.
+int corpus_read_layout(corpus_layout* l, const char* path);
+
+/// @brief Releases the levels of a layout.
+void corpus_layout_free(corpus_layout* l);
+
+/// @brief Loads the corpus at @p path if it matches @p params, otherwise generates and saves it
+/// (creating the directory of @p path if needed).
+///
+/// @return 0 on success, -1 on failure.
+int corpus_load_or_generate(corpus* c, const char* path, const corpus_params* params);
+
+/// @brief Builds the canonical file name of a corpus inside @p dir.
+void corpus_default_path(char* path, size_t len, const char* dir, const corpus_params* params);
@@ -0,0 +1,148 @@
+#include "protocol_api.h"
+#include "corpus.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+#define corpus_fill SAP_NAMESPACE(corpus_fill)
+
+/// Domain separation labels for the values derived from the corpus seed (see also corpus.c).
+enum {
+    LABEL_K_KEY = 'k',
+    LABEL_V_KEY = 'v',
+    LABEL_DECOY = 'd',
+    LABEL_ENC = 'e'
+};
+
+typedef struct {
+    corpus* c;
+    size_t begin, end;
+    const uint8_t* is_match;
+    uint8_t* decoy_pubs;
+} corpus_job;
+
+/**
+ * Derives @p outlen bytes as SHAKE256(seed || label || index).
+ */
+static void derive_coins(uint8_t* out, size_t outlen, const uint8_t seed[CORPUS_SEED_BYTES],
+    uint8_t label, uint64_t index)
+{
+    uint8_t in[CORPUS_SEED_BYTES + 1 + 8];
+    memcpy(in, seed, CORPUS_SEED_BYTES);
+    in[CORPUS_SEED_BYTES] = label;
+    for (int i = 0; i < 8; i++) in[CORPUS_SEED_BYTES + 1 + i] = (uint8_t)(index >> (8 * i));
+    sap_shake256(out, outlen, in, sizeof(in));
+}
+
+static void derive_keypair(uint8_t* pk, uint8_t* sk, const uint8_t seed[CORPUS_SEED_BYTES],
+    uint8_t label, uint64_t index)
+{
+    uint8_t coins[2 * KYBER_SYMBYTES];
+    derive_coins(coins, sizeof(coins), seed, label, index);
+    sap_kem_keypair_derand(pk, sk, coins);
+}
+
+/**
+ * Workflow:
+ *  1. For every announcement of this level in [begin, end), derives its encapsulation coins.
+ *  2. Encapsulates to the recipient's view key for matches, otherwise to a decoy.
+ *  3. Stores the ephemeral public key and the hash of the shared secret.
+ */
+static void* corpus_worker(void* arg)
+{
+    corpus_job* job = arg;
+    corpus* c = job->c;
+
+    for (size_t i = job->begin; i < job->end; i++) {
+        if (c->levels[i] != KYBER_K) continue;
+
+        uint8_t coins[KYBER_SYMBYTES];
+        uint8_t ss[SS_BYTES];
+        derive_coins(coins, sizeof(coins), c->seed, LABEL_ENC, i);
+
+        const uint8_t* pk = job->is_match[i] ? c->keys[KYBER_K - 2].v_pub
+            : job->decoy_pubs + (i % CORPUS_DECOYS) * CRYPTO_PUBLICKEYBYTES;
+        sap_kem_enc_derand(corpus_ct(c, i), ss, pk, coins);
+        sap_shake128(corpus_tag(c, i), CORPUS_TAG_BYTES, ss, SS_BYTES);
+    }
+    return NULL;
+}
+
+static void* decoy_worker(void* arg)
+{
+    corpus_job* job = arg;
+    uint8_t sk[CRYPTO_SECRETKEYBYTES];
+
+    for (size_t i = job->begin; i < job->end; i++) {
+        derive_keypair(job->decoy_pubs + i * CRYPTO_PUBLICKEYBYTES, sk,
+            job->c->seed, LABEL_DECOY, i);
+    }
+    return NULL;
+}
+
+/**
+ * Splits [0, n) into @p threads contiguous ranges and runs @p fn on each in parallel.
+ */
+static int run_parallel(void* (*fn)(void*), const corpus_job* proto, size_t n, unsigned int threads)
+{
+    pthread_t* tids = malloc(threads * sizeof(pthread_t));
+    corpus_job* jobs = malloc(threads * sizeof(corpus_job));
+    if (tids == NULL || jobs == NULL) {
+        free(tids);
+        free(jobs);
+        return -1;
+    }
+
+    unsigned int started = 0;
+    for (unsigned int t = 0; t < threads; t++) {
+        jobs[t] = *proto;
+        jobs[t].begin = n * t / threads;
+        jobs[t].end = n * (t + 1) / threads;
+        if (pthread_create(&tids[started], NULL, fn, &jobs[t]) == 0) {
+            started++;
+        } else {
+            fn(&jobs[t]);
+        }
+    }
+    for (unsigned int t = 0; t < started; t++) {
+        pthread_join(tids[t], NULL);
+    }
+
+    free(tids);
+    free(jobs);
+    return 0;
+}
+
+/**
+ * Workflow:
+ *  1. Derives the recipient's spending and view key pairs of this level from the seed.
+ *  2. Derives CORPUS_DECOYS decoy recipients in parallel.
+ *  3. Generates the announcements of this level in parallel (see corpus_worker()).
+ *
+ * The labels and indices do not depend on the other levels, so the announcements
+ * of a pure corpus are those of the same positions in a mixed one.
+ *
+ * @param[in,out] c Corpus allocated by corpus_generate() with the seed set.
+ * @param[in] is_match is_match[i] is 1 if announcement i is addressed to the recipient.
+ * @param[in] threads Number of threads.
+ * @return 0 on success, -1 on failure.
+ */
+int corpus_fill(corpus* c, const uint8_t* is_match, unsigned int threads)
+{
+    corpus_keys* keys = &c->keys[KYBER_K - 2];
+    derive_keypair(keys->k_pub, keys->k_priv, c->seed, LABEL_K_KEY, 0);
+    derive_keypair(keys->v_pub, keys->v_priv, c->seed, LABEL_V_KEY, 0);
+
+    uint8_t* decoy_pubs = malloc(CORPUS_DECOYS * CRYPTO_PUBLICKEYBYTES);
+    if (decoy_pubs == NULL) {
+        return -1;
+    }
+
+    corpus_job job = { c, 0, 0, is_match, decoy_pubs };
+    int ret = run_parallel(decoy_worker, &job, CORPUS_DECOYS, threads);
+    if (ret == 0) {
+        ret = run_parallel(corpus_worker, &job, c->n, threads);
+    }
+
+    free(decoy_pubs);
+    return ret;
+}
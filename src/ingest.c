@@ -0,0 +1,126 @@
+#include "ingest.h"
+#include "wipe.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Workflow:
+ *  1. Rounds the capacity up to a power of two and allocates cache-line aligned slots.
+ *  2. Writes every slot once, so that no page fault happens on the ingestion path,
+ *     and marks slot i free for position i.
+ */
+int sap_ingest_init(sap_ingest_ring* r, size_t capacity)
+{
+    size_t n = 2;
+    while (n < capacity) n <<= 1;
+
+    memset(r, 0, sizeof(*r));
+    r->slots = aligned_alloc(_Alignof(sap_ingest_slot), n * sizeof(sap_ingest_slot));
+    if (r->slots == NULL) {
+        return -1;
+    }
+    memset(r->slots, 0, n * sizeof(sap_ingest_slot));
+    for (size_t i = 0; i < n; i++) atomic_init(&r->slots[i].seq, i);
+
+    r->mask = n - 1;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->rejected, 0);
+    r->tail = 0;
+    return 0;
+}
+
+void sap_ingest_free(sap_ingest_ring* r)
+{
+    free(r->slots);
+    r->slots = NULL;
+}
+
+/**
+ * Workflow:
+ *  1. Claims the head position if its slot is free for it (sequence == position);
+ *     a sequence behind the position means the consumer has not released the slot
+ *     from the previous lap, i.e. the ring is full.
+ *  2. Fills the slot and publishes it with a release store of position + 1.
+ */
+int sap_ingest_push(sap_ingest_ring* r, const uint8_t ct[CIPHERTEXT_BYTES], uint8_t view_tag)
+{
+    size_t pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+    sap_ingest_slot* s;
+
+    for (;;) {
+        s = &r->slots[pos & r->mask];
+        size_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&r->head, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            atomic_fetch_add_explicit(&r->rejected, 1, memory_order_relaxed);
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+        }
+    }
+
+    memcpy(s->ct, ct, CIPHERTEXT_BYTES);
+    s->view_tag = view_tag;
+    atomic_store_explicit(&s->seq, pos + 1, memory_order_release);
+    return 0;
+}
+
+size_t sap_ingest_peek(sap_ingest_ring* r, const uint8_t** cts, uint8_t* view_tags, size_t max)
+{
+    size_t n = 0;
+    for (; n < max && n <= r->mask; n++) {
+        size_t pos = r->tail + n;
+        sap_ingest_slot* s = &r->slots[pos & r->mask];
+        if (atomic_load_explicit(&s->seq, memory_order_acquire) != pos + 1) break;
+        cts[n] = s->ct;
+        view_tags[n] = s->view_tag;
+    }
+    return n;
+}
+
+/**
+ * Marks each slot free for its position in the next lap (position + capacity).
+ */
+void sap_ingest_release(sap_ingest_ring* r, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        size_t pos = r->tail + i;
+        atomic_store_explicit(&r->slots[pos & r->mask].seq, pos + r->mask + 1, memory_order_release);
+    }
+    r->tail += n;
+}
+
+/**
+ * Workflow:
+ *  1. Takes the published run at the tail (see sap_ingest_peek()).
+ *  2. Scans it in place with sap_scan() and reports every hit.
+ *  3. Releases the slots to the producers.
+ */
+size_t sap_ingest_scan(sap_ingest_ring* r, const sap_scan_key* key, sap_ingest_hit_fn on_hit, void* arg,
+    size_t* hits)
+{
+    const uint8_t* cts[SAP_INGEST_BATCH];
+    uint8_t tags[SAP_INGEST_BATCH];
+    uint8_t found[SAP_INGEST_BATCH];
+    uint8_t ss[SAP_INGEST_BATCH * SS_BYTES];
+
+    size_t n = sap_ingest_peek(r, cts, tags, SAP_INGEST_BATCH);
+    size_t count = 0;
+    if (n > 0) {
+        count = sap_scan(found, on_hit != NULL ? ss : NULL, cts, tags, n, key);
+        for (size_t i = 0; on_hit != NULL && count > 0 && i < n; i++) {
+            if (!found[i]) continue;
+            on_hit(arg, cts[i], tags[i], ss + i * SS_BYTES);
+            sap_wipe(ss + i * SS_BYTES, SS_BYTES);
+        }
+        sap_ingest_release(r, n);
+    }
+    if (hits != NULL) *hits = count;
+    return n;
+}
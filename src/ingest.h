@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "scan.h"
+
+/// @file ingest.h
+/// @brief Lock-free ingestion of announcements from several feeds into one scanner.
+///
+/// A bounded multi-producer single-consumer ring in the style of Vyukov's bounded
+/// queue. Every slot carries a sequence number: a producer claims a position with a
+/// compare-and-swap on the head, copies the announcement into the slot and publishes
+/// it by advancing the slot's sequence; the consumer takes the run of published
+/// slots at the tail and hands their ciphertexts to sap_scan() in place, without
+/// copying them out. Producers never wait: a push into a full ring fails at once
+/// and is counted, so a slow scanner cannot stall the feeds, and a producer that is
+/// preempted between claim and publish only shortens the consumer's next batch.
+///
+/// All slots are allocated and touched by sap_ingest_init(); pushing and scanning
+/// do not allocate.
+
+/// @def SAP_INGEST_BATCH
+/// @brief Maximum number of announcements scanned by one sap_ingest_scan() call.
+#define SAP_INGEST_BATCH 256
+
+/// @brief One announcement; the ciphertext starts on a cache line.
+typedef struct {
+    _Alignas(64) uint8_t ct[CIPHERTEXT_BYTES];  /**< Ephemeral public key. */
+    uint8_t view_tag;                           /**< View tag published with it. */
+    _Atomic size_t seq;                         /**< pos when free for position pos, pos + 1 when published. */
+} sap_ingest_slot;
+
+/// @brief The ring; producer and consumer state live on separate cache lines.
+typedef struct {
+    sap_ingest_slot* slots;
+    size_t mask;                        /**< Capacity - 1; the capacity is a power of two. */
+    _Alignas(64) _Atomic size_t head;   /**< Next position claimed by a producer. */
+    _Atomic size_t rejected;            /**< Pushes that found the ring full. */
+    _Alignas(64) size_t tail;           /**< Next position read by the consumer. */
+} sap_ingest_ring;
+
+/// @brief Called by sap_ingest_scan() for every hit; @p ct is only valid during the call.
+typedef void (*sap_ingest_hit_fn)(void* arg, const uint8_t* ct, uint8_t view_tag, const uint8_t ss[SS_BYTES]);
+
+#define sap_ingest_init SAP_NAMESPACE(ingest_init)
+/// @brief Allocates and pre-faults the slots of a ring.
+///
+/// @param[out] r Ring; must be released with sap_ingest_free().
+/// @param[in] capacity Number of slots, rounded up to a power of two (at least 2).
+/// @return 0 on success, -1 if out of memory.
+int sap_ingest_init(sap_ingest_ring* r, size_t capacity);
+
+#define sap_ingest_free SAP_NAMESPACE(ingest_free)
+/// @brief Releases the slots of a ring; no producer or consumer may still use it.
+void sap_ingest_free(sap_ingest_ring* r);
+
+#define sap_ingest_push SAP_NAMESPACE(ingest_push)
+/// @brief Copies an announcement into the ring; safe to call from any number of threads.
+///
+/// @return 0 on success, -1 if the ring is full (the announcement is not queued).
+int sap_ingest_push(sap_ingest_ring* r, const uint8_t ct[CIPHERTEXT_BYTES], uint8_t view_tag);
+
+#define sap_ingest_peek SAP_NAMESPACE(ingest_peek)
+/// @brief Returns the published announcements at the tail without consuming them.
+///
+/// Consumer only. The pointers stay valid until sap_ingest_release().
+///
+/// @param[out] cts Receives pointers to up to @p max ciphertexts, oldest first.
+/// @param[out] view_tags Receives their view tags.
+/// @param[in] max Capacity of @p cts and @p view_tags.
+/// @return The number of announcements returned.
+size_t sap_ingest_peek(sap_ingest_ring* r, const uint8_t** cts, uint8_t* view_tags, size_t max);
+
+#define sap_ingest_release SAP_NAMESPACE(ingest_release)
+/// @brief Consumes the first @p n announcements returned by sap_ingest_peek(); consumer only.
+void sap_ingest_release(sap_ingest_ring* r, size_t n);
+
+#define sap_ingest_scan SAP_NAMESPACE(ingest_scan)
+/// @brief Scans and consumes up to SAP_INGEST_BATCH published announcements; consumer only.
+///
+/// @param[in] key Prepared view key.
+/// @param[in] on_hit Called with the ciphertext and shared secret of every hit, or NULL.
+/// @param[in] arg Passed to @p on_hit.
+/// @param[out] hits If not NULL, receives the number of hits.
+/// @return The number of announcements consumed (0 if the ring is empty).
+size_t sap_ingest_scan(sap_ingest_ring* r, const sap_scan_key* key, sap_ingest_hit_fn on_hit, void* arg,
+    size_t* hits);
@@ -0,0 +1,296 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "keyblob.h"
+#include "corpus.h"
+#include "fips202.h"
+#include "randombytes.h"
+#include "scan_mixed.h"
+#include "wipe.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define KEYBLOB_MAGIC "PQSAPKEX"
+#define KEYBLOB_VERSION 1
+
+static const char mac_label[] = "pqsap keyblob checksum v1";
+static const char enc_label[] = "pqsap keyblob keystream v1";
+
+/// The header as stored; the rest of its SAP_KEYBLOB_HEADER_BYTES is zero.
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t n_keys;
+    uint64_t file_bytes;
+    uint64_t key_bytes[SAP_SCAN_MIXED_LEVELS];  /**< sizeof(sap_scan_key) of each level. */
+    uint8_t nonce[16];
+    uint8_t check[32];
+} keyblob_header;
+
+static const sap_scan_level* const scan_levels[SAP_SCAN_MIXED_LEVELS] = {
+    &pqsap_kyber512_scan_level, &pqsap_kyber768_scan_level, &pqsap_kyber1024_scan_level
+};
+
+/// SHAKE256 over the label, the encryption key if any, the header with a zero checksum and the rest.
+static void checksum(uint8_t out[32], const uint8_t* blob, size_t len, const uint8_t* enc_key)
+{
+    keccak_state state;
+    keyblob_header h;
+    memcpy(&h, blob, sizeof(h));
+    memset(h.check, 0, sizeof(h.check));
+    shake256_init(&state);
+    shake256_absorb(&state, (const uint8_t*)mac_label, sizeof(mac_label) - 1);
+    if (enc_key != NULL) shake256_absorb(&state, enc_key, SAP_KEYBLOB_KEY_BYTES);
+    shake256_absorb(&state, (const uint8_t*)&h, sizeof(h));
+    shake256_absorb(&state, blob + sizeof(h), len - sizeof(h));
+    shake256_finalize(&state);
+    shake256_squeeze(out, 32, &state);
+    sap_wipe(&state, sizeof(state));
+}
+
+/// XORs everything after the header with the keystream of the key and the nonce.
+static void keystream_xor(uint8_t* blob, size_t len, const uint8_t* enc_key)
+{
+    keccak_state state;
+    const keyblob_header* h = (const keyblob_header*)blob;
+    uint8_t stream[SHAKE256_RATE];
+    shake256_init(&state);
+    shake256_absorb(&state, (const uint8_t*)enc_label, sizeof(enc_label) - 1);
+    shake256_absorb(&state, enc_key, SAP_KEYBLOB_KEY_BYTES);
+    shake256_absorb(&state, h->nonce, sizeof(h->nonce));
+    shake256_finalize(&state);
+    for (size_t off = SAP_KEYBLOB_HEADER_BYTES; off < len; off += sizeof(stream)) {
+        shake256_squeezeblocks(stream, 1, &state);
+        size_t take = len - off < sizeof(stream) ? len - off : sizeof(stream);
+        for (size_t i = 0; i < take; i++) blob[off + i] ^= stream[i];
+    }
+    sap_wipe(stream, sizeof(stream));
+    sap_wipe(&state, sizeof(state));
+}
+
+/**
+ * Workflow:
+ *  1. Lays out the table after the header, then per key its public key and its
+ *     prepared key on the next multiple of 64.
+ *  2. Prepares every key with the sap_scan_key_init() of its level.
+ *  3. Encrypts everything after the header under a fresh nonce if asked, then
+ *     fills in the checksum.
+ *  4. Writes a temporary file next to @p path, created afresh and readable by
+ *     the owner only (a leftover one is removed first), syncs it to disk and
+ *     renames it over @p path.
+ */
+int sap_keyblob_write(const char* path, const sap_keyblob_source* keys, size_t n, const uint8_t* enc_key)
+{
+    size_t len = SAP_KEYBLOB_HEADER_BYTES + n * sizeof(sap_keyblob_entry);
+    for (size_t i = 0; i < n; i++) {
+        size_t ct_bytes, pk_bytes, sk_bytes;
+        if (corpus_level_sizes(keys[i].kyber_k, &ct_bytes, &pk_bytes, &sk_bytes) != 0) {
+            return -1;
+        }
+        len = (len + pk_bytes + 63) & ~(size_t)63;
+        len += scan_levels[keys[i].kyber_k - 2]->key_bytes;
+    }
+    uint8_t* blob = calloc(1, len);
+    if (blob == NULL) {
+        return -1;
+    }
+
+    keyblob_header* h = (keyblob_header*)blob;
+    memcpy(h->magic, KEYBLOB_MAGIC, sizeof(h->magic));
+    h->version = KEYBLOB_VERSION;
+    h->n_keys = n;
+    h->file_bytes = len;
+    for (int l = 0; l < SAP_SCAN_MIXED_LEVELS; l++) h->key_bytes[l] = scan_levels[l]->key_bytes;
+    sap_keyblob_entry* entries = (sap_keyblob_entry*)(blob + SAP_KEYBLOB_HEADER_BYTES);
+    size_t off = SAP_KEYBLOB_HEADER_BYTES + n * sizeof(sap_keyblob_entry);
+    for (size_t i = 0; i < n; i++) {
+        size_t ct_bytes, pk_bytes = 0, sk_bytes;
+        corpus_level_sizes(keys[i].kyber_k, &ct_bytes, &pk_bytes, &sk_bytes);   /* checked above */
+        entries[i] = (sap_keyblob_entry){ keys[i].kyber_k, (uint32_t)pk_bytes, off, 0 };
+        memcpy(blob + off, keys[i].spend_pub, pk_bytes);
+        off = (off + pk_bytes + 63) & ~(size_t)63;
+        entries[i].key_offset = off;
+        scan_levels[keys[i].kyber_k - 2]->key_init(blob + off, keys[i].v_priv);
+        off += scan_levels[keys[i].kyber_k - 2]->key_bytes;
+    }
+    if (enc_key != NULL) {
+        h->flags |= SAP_KEYBLOB_ENCRYPTED;
+        randombytes(h->nonce, sizeof(h->nonce));
+        keystream_xor(blob, len, enc_key);
+    }
+    checksum(h->check, blob, len, enc_key);
+
+    char tmp[4096];
+    int ret = -1;
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) < (int)sizeof(tmp)) {
+        unlink(tmp);
+        int fd = open(tmp, O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, 0600);
+        FILE* f = fd >= 0 ? fdopen(fd, "wb") : NULL;
+        if (f == NULL && fd >= 0) {
+            close(fd);
+            unlink(tmp);
+        }
+        if (f != NULL) {
+            int ok = fwrite(blob, 1, len, f) == len && fflush(f) == 0 && fsync(fileno(f)) == 0;
+            ok = fclose(f) == 0 && ok;
+            ret = ok && rename(tmp, path) == 0 ? 0 : -1;
+            if (ret != 0) remove(tmp);
+        }
+    }
+    sap_wipe(blob, len);
+    free(blob);
+    return ret;
+}
+
+long sap_keyblob_convert(const char* blob_path, const char* key_path, const uint8_t* enc_key)
+{
+    FILE* f = fopen(key_path, "rb");
+    if (f == NULL) {
+        return -1;
+    }
+    uint8_t* buf = NULL;
+    size_t len = 0, cap = 0, got;
+    do {
+        if (len == cap) {
+            cap = cap ? 2 * cap : 1 << 16;
+            uint8_t* b = realloc(buf, cap);
+            if (b == NULL) {
+                break;
+            }
+            buf = b;
+        }
+        got = fread(buf + len, 1, cap - len, f);
+        len += got;
+    } while (got > 0);
+    int ok = !ferror(f) && buf != NULL && len < cap;
+    fclose(f);
+
+    sap_keyblob_source* keys = NULL;
+    size_t n = 0;
+    for (size_t off = 0; ok && off < len; n++) {
+        size_t ct_bytes, pk_bytes, sk_bytes;
+        ok = corpus_level_sizes(buf[off], &ct_bytes, &pk_bytes, &sk_bytes) == 0
+            && len - off >= 1 + pk_bytes + sk_bytes;
+        sap_keyblob_source* k = ok ? realloc(keys, (n + 1) * sizeof(*keys)) : NULL;
+        if (k == NULL) {
+            ok = 0;
+            break;
+        }
+        keys = k;
+        keys[n] = (sap_keyblob_source){ buf[off], buf + off + 1, buf + off + 1 + pk_bytes };
+        off += 1 + pk_bytes + sk_bytes;
+    }
+    ok = ok && sap_keyblob_write(blob_path, keys, n, enc_key) == 0;
+    free(keys);
+    if (buf != NULL) {
+        sap_wipe(buf, len);
+        free(buf);
+    }
+    return ok ? (long)n : -1;
+}
+
+int sap_keyblob_is_blob(const char* path)
+{
+    char magic[8];
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return 0;
+    }
+    int is_blob = fread(magic, 1, sizeof(magic), f) == sizeof(magic) && memcmp(magic, KEYBLOB_MAGIC, 8) == 0;
+    fclose(f);
+    return is_blob;
+}
+
+/// Checks that every entry names a valid level and lies inside the blob.
+static int entries_valid(const sap_keyblob* b)
+{
+    for (size_t i = 0; i < b->n; i++) {
+        const sap_keyblob_entry* e = &b->entries[i];
+        size_t ct_bytes, pk_bytes, sk_bytes;
+        if (corpus_level_sizes(e->kyber_k, &ct_bytes, &pk_bytes, &sk_bytes) != 0 || e->pub_bytes != pk_bytes
+            || e->pub_offset > b->map_bytes || b->map_bytes - e->pub_offset < pk_bytes || e->key_offset % 64 != 0
+            || e->key_offset > b->map_bytes
+            || b->map_bytes - e->key_offset < scan_levels[e->kyber_k - 2]->key_bytes) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Workflow:
+ *  1. Maps the file: read-only and shared if it is not encrypted, otherwise as a
+ *     writable private copy kept out of core dumps.
+ *  2. Checks the header against this build: magic, version, size, the size of
+ *     each level's sap_scan_key and whether a key was given for an encrypted blob.
+ *  3. Checks the checksum (not for SAP_KEYBLOB_NO_VERIFY on an unencrypted blob),
+ *     decrypts in place and write-protects the copy again.
+ *  4. Checks the table.
+ */
+int sap_keyblob_open(sap_keyblob* b, const char* path, const uint8_t* enc_key, unsigned int flags)
+{
+    memset(b, 0, sizeof(*b));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < SAP_KEYBLOB_HEADER_BYTES) {
+        close(fd);
+        return -1;
+    }
+    b->map_bytes = (size_t)st.st_size;
+    b->private_copy = enc_key != NULL;
+    void* map = b->private_copy ? mmap(NULL, b->map_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0)
+        : mmap(NULL, b->map_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    b->map = map;
+    madvise(b->map, b->map_bytes, MADV_WILLNEED);
+    if (b->private_copy) madvise(b->map, b->map_bytes, MADV_DONTDUMP);
+
+    keyblob_header h;
+    memcpy(&h, b->map, sizeof(h));
+    int ok = memcmp(h.magic, KEYBLOB_MAGIC, sizeof(h.magic)) == 0 && h.version == KEYBLOB_VERSION
+        && h.file_bytes == b->map_bytes && !(h.flags & SAP_KEYBLOB_ENCRYPTED) == (enc_key == NULL)
+        && h.n_keys <= (b->map_bytes - SAP_KEYBLOB_HEADER_BYTES) / sizeof(sap_keyblob_entry);
+    for (int l = 0; ok && l < SAP_SCAN_MIXED_LEVELS; l++) ok = h.key_bytes[l] == scan_levels[l]->key_bytes;
+    if (ok && (enc_key != NULL || !(flags & SAP_KEYBLOB_NO_VERIFY))) {
+        uint8_t check[32];
+        checksum(check, b->map, b->map_bytes, enc_key);
+        uint8_t diff = 0;
+        for (size_t i = 0; i < sizeof(check); i++) diff |= check[i] ^ h.check[i];
+        ok = diff == 0;
+    }
+    if (ok && enc_key != NULL) {
+        keystream_xor(b->map, b->map_bytes, enc_key);
+        ok = mprotect(b->map, b->map_bytes, PROT_READ) == 0;
+    }
+    b->n = (size_t)h.n_keys;
+    b->entries = (const sap_keyblob_entry*)(b->map + SAP_KEYBLOB_HEADER_BYTES);
+    if (!ok || !entries_valid(b)) {
+        sap_keyblob_close(b);
+        return -1;
+    }
+    return 0;
+}
+
+void sap_keyblob_close(sap_keyblob* b)
+{
+    if (b->map != NULL) {
+        if (b->private_copy && mprotect(b->map, b->map_bytes, PROT_READ | PROT_WRITE) == 0) {
+            sap_wipe(b->map, b->map_bytes);
+        }
+        munmap(b->map, b->map_bytes);
+    }
+    memset(b, 0, sizeof(*b));
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @file keyblob.h
+/// @brief Prepared view keys saved in a file, so that a scanner maps them instead of preparing them.
+///
+/// A key file (the sap_scand format: level byte, public spending key, secret view
+/// key) has to be expanded before scanning. Every secret view key is unpacked and
+/// moved into the NTT domain (sap_scan_key_init()), for every key and in every
+/// process that scans. A key blob holds the keys already expanded: the sap_scan_key
+/// of each key, 64-byte aligned, next to its public spending key. sap_keyblob_open()
+/// maps the file and hands out pointers into the mapping. Startup then costs what
+/// reading the file costs. Processes that map the same blob share its pages
+/// through the page cache.
+///
+/// Layout, in host byte order (the keys are stored as the scanners use them):
+///  - a header of SAP_KEYBLOB_HEADER_BYTES: magic, version, flags, key count,
+///    file size, sizeof(sap_scan_key) of each level, nonce and checksum;
+///  - the table of sap_keyblob_entry, one per key, in key file order;
+///  - the public keys and prepared keys the table points to.
+///
+/// The checksum is SHAKE256 over the header and everything after it. Keys
+/// prepared by a build with a different sap_scan_key layout are rejected by the
+/// size check. A blob can be encrypted with a 32-byte key. Everything after the
+/// header is then XORed with a SHAKE256 keystream of the key and the nonce, and
+/// the checksum also covers the key, which makes it a MAC. An encrypted blob is
+/// decrypted into a private copy of the mapping, so processes no longer share it.
+
+/// @def SAP_KEYBLOB_HEADER_BYTES
+/// @brief Size of the header; the key table starts on the next page.
+#define SAP_KEYBLOB_HEADER_BYTES 4096
+
+/// @def SAP_KEYBLOB_KEY_BYTES
+/// @brief Size of the encryption key.
+#define SAP_KEYBLOB_KEY_BYTES 32
+
+/// @def SAP_KEYBLOB_ENCRYPTED
+/// @brief Header flag: everything after the header is encrypted.
+#define SAP_KEYBLOB_ENCRYPTED 1u
+
+/// @def SAP_KEYBLOB_NO_VERIFY
+/// @brief sap_keyblob_open() flag: skip the checksum of an unencrypted blob.
+///
+/// Opening then only maps the file and checks the header and the table; the
+/// keys are paged in as they are first used.
+#define SAP_KEYBLOB_NO_VERIFY 1u
+
+/// @brief One key of a blob.
+typedef struct {
+    uint32_t kyber_k;           /**< Security level (2, 3 or 4). */
+    uint32_t pub_bytes;         /**< Size of the public spending key. */
+    uint64_t pub_offset;        /**< File offset of the public spending key. */
+    uint64_t key_offset;        /**< File offset of the sap_scan_key, a multiple of 64. */
+} sap_keyblob_entry;
+
+/// @brief A mapped blob.
+typedef struct {
+    uint8_t* map;
+    size_t map_bytes;
+    int private_copy;           /**< Decrypted in place; wiped when closed. */
+    size_t n;                   /**< Number of keys. */
+    const sap_keyblob_entry* entries;
+} sap_keyblob;
+
+/// @brief A key to store in a blob.
+typedef struct {
+    uint32_t kyber_k;
+    const uint8_t* spend_pub;   /**< Public spending key. */
+    const uint8_t* v_priv;      /**< Secret view key. */
+} sap_keyblob_source;
+
+/// @brief Prepares keys and writes them as a blob, replacing @p path atomically.
+///
+/// The new file is readable and writable by its owner only.
+///
+/// @param[in] enc_key SAP_KEYBLOB_KEY_BYTES to encrypt the blob with, or NULL.
+/// @return 0 on success, -1 on an invalid level, out of memory or a write error.
+int sap_keyblob_write(const char* path, const sap_keyblob_source* keys, size_t n, const uint8_t* enc_key);
+
+/// @brief Writes a blob with the keys of a key file (sap_scand format).
+///
+/// @return The number of keys, or -1 if the key file cannot be read or the blob written.
+long sap_keyblob_convert(const char* blob_path, const char* key_path, const uint8_t* enc_key);
+
+/// @brief Tells whether a file starts like a blob; cheap enough to pick a loader with.
+int sap_keyblob_is_blob(const char* path);
+
+/// @brief Maps a blob.
+///
+/// @param[out] b The blob; release with sap_keyblob_close().
+/// @param[in] enc_key The key of an encrypted blob, or NULL for an unencrypted one.
+/// @param[in] flags 0 or SAP_KEYBLOB_NO_VERIFY.
+/// @return 0 on success, -1 if the file cannot be mapped, is not a blob of this
+/// build, is damaged or the key is wrong (or missing for an encrypted blob).
+int sap_keyblob_open(sap_keyblob* b, const char* path, const uint8_t* enc_key, unsigned int flags);
+
+/// @brief Unmaps a blob; a decrypted copy is wiped first.
+void sap_keyblob_close(sap_keyblob* b);
+
+/// @brief Returns the prepared key (sap_scan_key of its level) of key @p i, for sap_scan_level::scan.
+static inline const void* sap_keyblob_scan_key(const sap_keyblob* b, size_t i)
+{
+    return b->map + b->entries[i].key_offset;
+}
+
+/// @brief Returns the public spending key of key @p i.
+static inline const uint8_t* sap_keyblob_spend_pub(const sap_keyblob* b, size_t i)
+{
+    return b->map + b->entries[i].pub_offset;
+}
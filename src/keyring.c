@@ -0,0 +1,219 @@
+#include "keyring.h"
+#include "wipe.h"
+#include <stdlib.h>
+#include <string.h>
+
+static sap_keyring_set* set_alloc(size_t n, uint64_t version)
+{
+    sap_keyring_set* s = malloc(sizeof(*s) + n * sizeof(s->wallets[0]));
+    if (s != NULL) {
+        s->version = version;
+        s->n = n;
+    }
+    return s;
+}
+
+static void wallet_free(sap_keyring_wallet* w)
+{
+    if (w != NULL) {
+        sap_scan_keyset_free(&w->ks);
+        free(w);
+    }
+}
+
+int sap_keyring_init(sap_keyring* kr)
+{
+    memset(kr, 0, sizeof(*kr));
+    sap_keyring_set* s = set_alloc(0, 0);
+    if (s == NULL || pthread_mutex_init(&kr->lock, NULL) != 0) {
+        free(s);
+        return -1;
+    }
+    atomic_init(&kr->set, s);
+    atomic_init(&kr->epoch, 1);
+    for (int i = 0; i < SAP_KEYRING_READERS; i++) {
+        atomic_init(&kr->readers[i].epoch, 0);
+        atomic_init(&kr->readers[i].joined, 0);
+    }
+    return 0;
+}
+
+void sap_keyring_free(sap_keyring* kr)
+{
+    for (sap_keyring_retired* r = kr->retired; r != NULL;) {
+        sap_keyring_retired* next = r->next;
+        free(r->set);
+        wallet_free(r->wallet);
+        free(r);
+        r = next;
+    }
+    sap_keyring_set* s = atomic_load(&kr->set);
+    for (size_t i = 0; s != NULL && i < s->n; i++) wallet_free(s->wallets[i]);
+    free(s);
+    pthread_mutex_destroy(&kr->lock);
+    memset(kr, 0, sizeof(*kr));
+}
+
+/// Returns the oldest epoch a worker is still in, or UINT64_MAX if none is inside a batch.
+static uint64_t oldest_reader(sap_keyring* kr)
+{
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < SAP_KEYRING_READERS; i++) {
+        uint64_t e = atomic_load(&kr->readers[i].epoch);
+        if (e != 0 && e < oldest) oldest = e;
+    }
+    return oldest;
+}
+
+static size_t collect_locked(sap_keyring* kr)
+{
+    uint64_t oldest = oldest_reader(kr);
+    sap_keyring_retired** at = &kr->retired;
+    while (*at != NULL) {
+        sap_keyring_retired* r = *at;
+        if (r->epoch < oldest) {
+            *at = r->next;
+            free(r->set);
+            wallet_free(r->wallet);
+            free(r);
+            kr->n_retired--;
+        } else {
+            at = &r->next;
+        }
+    }
+    return kr->n_retired;
+}
+
+/**
+ * Workflow (with the writer lock held):
+ *  1. Swaps @p next in; from here on, workers that enter find it.
+ *  2. Retires the old set and @p removed under the current epoch and moves the
+ *     epoch on. A worker that announced the old epoch or an older one may still
+ *     hold them; one that announces a later epoch read it after the swap.
+ *  3. Frees what earlier changes retired, as far as the workers allow.
+ */
+static int publish_locked(sap_keyring* kr, sap_keyring_set* next, sap_keyring_wallet* removed)
+{
+    sap_keyring_retired* r = malloc(sizeof(*r));
+    if (r == NULL) {
+        return -1;
+    }
+    r->set = atomic_exchange(&kr->set, next);
+    r->wallet = removed;
+    r->epoch = atomic_fetch_add(&kr->epoch, 1);
+    r->next = kr->retired;
+    kr->retired = r;
+    kr->n_retired++;
+    collect_locked(kr);
+    return 0;
+}
+
+int sap_keyring_add(sap_keyring* kr, uint64_t id, const uint8_t* const v_priv[SAP_SCAN_MIXED_LEVELS])
+{
+    sap_keyring_wallet* w = malloc(sizeof(*w));
+    if (w == NULL) {
+        return -1;
+    }
+    w->id = id;
+    if (sap_scan_keyset_init(&w->ks, v_priv) != 0) {
+        free(w);
+        return -1;
+    }
+
+    pthread_mutex_lock(&kr->lock);
+    const sap_keyring_set* cur = atomic_load(&kr->set);
+    int taken = 0;
+    for (size_t i = 0; i < cur->n; i++) taken |= cur->wallets[i]->id == id;
+    sap_keyring_set* next = taken ? NULL : set_alloc(cur->n + 1, cur->version + 1);
+    int ret = -1;
+    if (next != NULL) {
+        memcpy(next->wallets, cur->wallets, cur->n * sizeof(cur->wallets[0]));
+        next->wallets[cur->n] = w;
+        ret = publish_locked(kr, next, NULL);
+        if (ret != 0) free(next);
+    }
+    pthread_mutex_unlock(&kr->lock);
+    if (ret != 0) wallet_free(w);
+    return ret;
+}
+
+int sap_keyring_remove(sap_keyring* kr, uint64_t id)
+{
+    pthread_mutex_lock(&kr->lock);
+    const sap_keyring_set* cur = atomic_load(&kr->set);
+    size_t at = cur->n;
+    for (size_t i = 0; i < cur->n; i++) {
+        if (cur->wallets[i]->id == id) at = i;
+    }
+    sap_keyring_set* next = at == cur->n ? NULL : set_alloc(cur->n - 1, cur->version + 1);
+    int ret = -1;
+    if (next != NULL) {
+        memcpy(next->wallets, cur->wallets, at * sizeof(cur->wallets[0]));
+        memcpy(next->wallets + at, cur->wallets + at + 1, (cur->n - at - 1) * sizeof(cur->wallets[0]));
+        ret = publish_locked(kr, next, cur->wallets[at]);
+        if (ret != 0) free(next);
+    }
+    pthread_mutex_unlock(&kr->lock);
+    return ret;
+}
+
+size_t sap_keyring_collect(sap_keyring* kr)
+{
+    pthread_mutex_lock(&kr->lock);
+    size_t waiting = collect_locked(kr);
+    pthread_mutex_unlock(&kr->lock);
+    return waiting;
+}
+
+int sap_keyring_join(sap_keyring* kr)
+{
+    for (int i = 0; i < SAP_KEYRING_READERS; i++) {
+        int free_slot = 0;
+        if (atomic_compare_exchange_strong(&kr->readers[i].joined, &free_slot, 1)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void sap_keyring_leave(sap_keyring* kr, int slot)
+{
+    atomic_store(&kr->readers[slot].epoch, 0);
+    atomic_store(&kr->readers[slot].joined, 0);
+}
+
+const sap_keyring_set* sap_keyring_enter(sap_keyring* kr, int slot)
+{
+    /* sequentially consistent: the announcement is visible before the set is read */
+    atomic_store(&kr->readers[slot].epoch, atomic_load(&kr->epoch));
+    return atomic_load(&kr->set);
+}
+
+void sap_keyring_exit(sap_keyring* kr, int slot)
+{
+    atomic_store_explicit(&kr->readers[slot].epoch, 0, memory_order_release);
+}
+
+size_t sap_keyring_scan(sap_keyring* kr, int slot, uint8_t* hits, uint8_t* ss, const uint8_t* const* cts,
+    const uint8_t* levels, const uint8_t* view_tags, size_t n, sap_keyring_hit_fn on_hit, void* arg,
+    uint64_t* version)
+{
+    const sap_keyring_set* s = sap_keyring_enter(kr, slot);
+    if (version != NULL) *version = s->version;
+    size_t total = 0;
+    for (size_t w = 0; w < s->n && total != SIZE_MAX; w++) {
+        size_t found = sap_scan_mixed(hits, ss, cts, levels, view_tags, n, &s->wallets[w]->ks);
+        if (found == SIZE_MAX) {
+            total = SIZE_MAX;
+            break;
+        }
+        total += found;
+        for (size_t i = 0; found > 0 && i < n; i++) {
+            if (!hits[i]) continue;
+            if (on_hit != NULL) on_hit(arg, s->wallets[w]->id, i, ss + i * 32);
+            sap_wipe(ss + i * 32, 32);
+        }
+    }
+    sap_keyring_exit(kr, slot);
+    return total;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "scan_mixed.h"
+
+/// @file keyring.h
+/// @brief The view keys of many wallets, changed while worker threads scan with them.
+///
+/// A scanner serving many wallets cannot stop its workers every time a wallet is
+/// added or removed. The keyring publishes the active wallets as an immutable
+/// set behind one atomic pointer. A worker enters the keyring at the start of a
+/// batch, scans the batch with every wallet of the set it found, and exits at the
+/// end. It takes no lock and sees a set that does not change during the batch.
+/// The next batch picks up the newest set.
+///
+/// Writers are serialized by a mutex. A writer builds a new set, swaps it in and
+/// retires the old set, together with the prepared keys of a removed wallet,
+/// under the current epoch. The epoch then moves on. Every worker announces the
+/// epoch it entered in its own cache line. Retired memory is freed, and the keys
+/// wiped, once no worker is still inside an epoch at or before the one it was
+/// retired in. That is one grace period, which normally ends with the batches
+/// that were running during the change.
+
+/// @def SAP_KEYRING_READERS
+/// @brief Largest number of worker threads joined at the same time.
+#define SAP_KEYRING_READERS 64
+
+/// @brief One wallet: an id chosen by the caller and its prepared view keys.
+typedef struct {
+    uint64_t id;
+    sap_scan_keyset ks;
+} sap_keyring_wallet;
+
+/// @brief An immutable set of wallets, as seen by a worker during one batch.
+typedef struct {
+    uint64_t version;                   /**< Number of changes before this set was published. */
+    size_t n;
+    sap_keyring_wallet* wallets[];      /**< Shared with the sets before and after. */
+} sap_keyring_set;
+
+/// @brief Memory waiting for the end of a grace period.
+typedef struct sap_keyring_retired {
+    struct sap_keyring_retired* next;
+    uint64_t epoch;                     /**< Epoch in which it was unpublished. */
+    sap_keyring_set* set;
+    sap_keyring_wallet* wallet;         /**< Removed wallet, or NULL. */
+} sap_keyring_retired;
+
+/// @brief The epoch a worker is in; 0 between batches.
+typedef struct {
+    _Alignas(64) _Atomic uint64_t epoch;
+    _Atomic int joined;
+} sap_keyring_reader;
+
+/// @brief The published set, the epochs of the workers and the memory waiting to be freed.
+typedef struct {
+    _Alignas(64) _Atomic(sap_keyring_set*) set;
+    _Atomic uint64_t epoch;             /**< Current epoch, from 1. */
+    _Alignas(64) pthread_mutex_t lock;  /**< Serializes writers; protects retired. */
+    sap_keyring_retired* retired;
+    size_t n_retired;
+    sap_keyring_reader readers[SAP_KEYRING_READERS];
+} sap_keyring;
+
+/// @brief Called by sap_keyring_scan() for every hit.
+typedef void (*sap_keyring_hit_fn)(void* arg, uint64_t wallet_id, size_t index, const uint8_t ss[32]);
+
+/// @brief Starts with an empty set.
+///
+/// @return 0 on success, -1 if out of memory.
+int sap_keyring_init(sap_keyring* kr);
+
+/// @brief Wipes and releases all keys; no worker may still be joined.
+void sap_keyring_free(sap_keyring* kr);
+
+/// @brief Prepares the keys of a wallet and publishes a set that includes it.
+///
+/// @param[in] id Wallet id, unique in the keyring.
+/// @param[in] v_priv v_priv[k - 2] is the secret view key of level k, or NULL.
+/// @return 0 on success, -1 if the id is taken or out of memory.
+int sap_keyring_add(sap_keyring* kr, uint64_t id, const uint8_t* const v_priv[SAP_SCAN_MIXED_LEVELS]);
+
+/// @brief Publishes a set without the wallet; its keys are wiped after the grace period.
+///
+/// @return 0 on success, -1 if there is no such wallet or out of memory.
+int sap_keyring_remove(sap_keyring* kr, uint64_t id);
+
+/// @brief Frees the retired sets and wallets whose grace period is over.
+///
+/// Writers call it after every change, so it is only needed to free memory
+/// sooner when the keyring does not change.
+///
+/// @return The number of retired items still waiting.
+size_t sap_keyring_collect(sap_keyring* kr);
+
+/// @brief Joins a worker thread.
+///
+/// @return The worker's slot for the calls below, or -1 if SAP_KEYRING_READERS are joined.
+int sap_keyring_join(sap_keyring* kr);
+
+/// @brief Gives the slot of a worker back; it must not be inside a batch.
+void sap_keyring_leave(sap_keyring* kr, int slot);
+
+/// @brief Starts a batch and returns the current set, valid until sap_keyring_exit().
+const sap_keyring_set* sap_keyring_enter(sap_keyring* kr, int slot);
+
+/// @brief Ends a batch.
+void sap_keyring_exit(sap_keyring* kr, int slot);
+
+/// @brief Scans one batch of a mixed register with every wallet of the current set.
+///
+/// @param[out] hits n bytes of scratch space.
+/// @param[out] ss n * 32 bytes of scratch space.
+/// @param[in] on_hit Called for every hit of every wallet, or NULL.
+/// @param[in] arg Passed to @p on_hit.
+/// @param[out] version If not NULL, receives the version of the set that was used.
+/// @return The number of hits over all wallets, or SIZE_MAX if out of memory.
+size_t sap_keyring_scan(sap_keyring* kr, int slot, uint8_t* hits, uint8_t* ss, const uint8_t* const* cts,
+    const uint8_t* levels, const uint8_t* view_tags, size_t n, sap_keyring_hit_fn on_hit, void* arg,
+    uint64_t* version);
@@ -0,0 +1,150 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "numa.h"
+#include <dirent.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/// set_mempolicy()/mbind() mode of <numaif.h>: allocate on the node, fall back to others.
+#define SAP_MPOL_PREFERRED 1
+
+/// Parses a cpulist such as "0-3,8-11" into @p mask, keeping only CPUs in @p allowed.
+static unsigned int parse_cpulist(uint64_t* mask, const char* list, const cpu_set_t* allowed)
+{
+    unsigned int n = 0;
+    const char* p = list;
+    while (*p != '\0' && *p != '\n') {
+        char* end;
+        long lo = strtol(p, &end, 10), hi = lo;
+        if (end == p) break;
+        if (*end == '-') {
+            p = end + 1;
+            hi = strtol(p, &end, 10);
+        }
+        for (long c = lo; c <= hi && c < SAP_NUMA_MAX_CPUS; c++) {
+            if (c >= 0 && CPU_ISSET((int)c, allowed)) {
+                mask[c / 64] |= (uint64_t)1 << (c % 64);
+                n++;
+            }
+        }
+        p = *end == ',' ? end + 1 : end;
+    }
+    return n;
+}
+
+static int cmp_node(const void* a, const void* b)
+{
+    return ((const sap_numa_node*)a)->id - ((const sap_numa_node*)b)->id;
+}
+
+void sap_numa_topology_read(sap_numa_topology* t)
+{
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        CPU_ZERO(&allowed);
+        for (int c = 0; c < CPU_SETSIZE; c++) CPU_SET(c, &allowed);
+    }
+    memset(t, 0, sizeof(*t));
+
+    DIR* dir = opendir("/sys/devices/system/node");
+    struct dirent* e;
+    while (dir != NULL && (e = readdir(dir)) != NULL && t->n_nodes < SAP_NUMA_MAX_NODES) {
+        int id;
+        char path[300], list[4096];
+        if (sscanf(e->d_name, "node%d", &id) != 1) continue;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/node/%s/cpulist", e->d_name);
+        FILE* f = fopen(path, "r");
+        if (f == NULL) continue;
+        int ok = fgets(list, sizeof(list), f) != NULL;
+        fclose(f);
+
+        sap_numa_node* node = &t->nodes[t->n_nodes];
+        memset(node, 0, sizeof(*node));
+        node->id = id;
+        node->n_cpus = ok ? parse_cpulist(node->cpus, list, &allowed) : 0;
+        if (node->n_cpus > 0) t->n_nodes++;
+    }
+    if (dir != NULL) closedir(dir);
+
+    if (t->n_nodes == 0) {
+        sap_numa_node* node = &t->nodes[0];
+        for (int c = 0; c < SAP_NUMA_MAX_CPUS; c++) {
+            if (CPU_ISSET(c, &allowed)) {
+                node->cpus[c / 64] |= (uint64_t)1 << (c % 64);
+                node->n_cpus++;
+            }
+        }
+        t->n_nodes = 1;
+    }
+    qsort(t->nodes, t->n_nodes, sizeof(t->nodes[0]), cmp_node);
+}
+
+int sap_numa_run_on(const sap_numa_node* node)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c = 0; c < SAP_NUMA_MAX_CPUS; c++) {
+        if (node->cpus[c / 64] >> (c % 64) & 1) CPU_SET(c, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0 ? 0 : -1;
+}
+
+/**
+ * Workflow:
+ *  1. With @p huge, tries the hugetlbfs pool, then an anonymous mapping padded
+ *     to a 2 MiB boundary with madvise(MADV_HUGEPAGE); otherwise a plain mapping.
+ *  2. Sets the preferred node of the range with mbind(); failures are ignored,
+ *     as the first touch from the node places the pages as well.
+ */
+int sap_numa_alloc(sap_numa_mem* m, size_t bytes, int node, int huge)
+{
+    memset(m, 0, sizeof(*m));
+    m->bytes = bytes;
+    size_t rounded = (bytes + SAP_NUMA_HUGE_PAGE - 1) & ~(SAP_NUMA_HUGE_PAGE - 1);
+    if (rounded == 0) rounded = SAP_NUMA_HUGE_PAGE;
+
+    if (huge) {
+        void* p = mmap(NULL, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            m->map = m->base = p;
+            m->map_bytes = rounded;
+            m->pages = SAP_NUMA_PAGES_HUGETLB;
+        }
+    }
+    if (m->map == NULL) {
+        size_t len = huge ? rounded + SAP_NUMA_HUGE_PAGE : rounded;
+        void* p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            return -1;
+        }
+        m->map = p;
+        m->map_bytes = len;
+        m->base = p;
+        if (huge) {
+            uintptr_t aligned = ((uintptr_t)p + SAP_NUMA_HUGE_PAGE - 1) & ~(uintptr_t)(SAP_NUMA_HUGE_PAGE - 1);
+            m->base = (void*)aligned;
+            m->pages = madvise(m->base, rounded, MADV_HUGEPAGE) == 0 ? SAP_NUMA_PAGES_THP : SAP_NUMA_PAGES_SMALL;
+        }
+    }
+
+    if (node >= 0 && node < SAP_NUMA_MAX_CPUS) {
+        unsigned long mask[SAP_NUMA_MAX_CPUS / (8 * sizeof(unsigned long))] = { 0 };
+        mask[node / (8 * sizeof(unsigned long))] = 1ul << (node % (8 * sizeof(unsigned long)));
+        syscall(SYS_mbind, m->base, rounded, SAP_MPOL_PREFERRED, mask, (unsigned long)SAP_NUMA_MAX_CPUS + 1, 0);
+    }
+    return 0;
+}
+
+void sap_numa_free(sap_numa_mem* m)
+{
+    if (m->map != NULL) munmap(m->map, m->map_bytes);
+    memset(m, 0, sizeof(*m));
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @file numa.h
+/// @brief NUMA topology, node-local memory and huge pages without libnuma.
+///
+/// The nodes come from /sys/devices/system/node, restricted to the CPUs the
+/// process may run on; without that directory all CPUs form node 0. Memory is
+/// placed with the mbind() system call and by touching it first from a thread
+/// running on the node, so it lands on the right node also where mbind() is not
+/// permitted.
+///
+/// Large mappings are backed by 2 MiB pages when possible: first from the
+/// hugetlbfs pool (MAP_HUGETLB), otherwise as transparent huge pages requested
+/// with madvise(MADV_HUGEPAGE) on a 2 MiB aligned range.
+
+/// @def SAP_NUMA_MAX_NODES
+/// @brief Largest number of nodes handled.
+#define SAP_NUMA_MAX_NODES 64
+
+/// @def SAP_NUMA_MAX_CPUS
+/// @brief CPUs above this index are ignored.
+#define SAP_NUMA_MAX_CPUS 1024
+
+/// @def SAP_NUMA_HUGE_PAGE
+/// @brief Huge page size used for the mappings.
+#define SAP_NUMA_HUGE_PAGE ((size_t)2 << 20)
+
+/// @brief A node and the CPUs of it that the process may use.
+typedef struct {
+    int id;                                     /**< Kernel node number. */
+    unsigned int n_cpus;                        /**< Number of CPUs in the mask. */
+    uint64_t cpus[SAP_NUMA_MAX_CPUS / 64];      /**< Bit c set for CPU c. */
+} sap_numa_node;
+
+/// @brief The nodes that have usable CPUs.
+typedef struct {
+    unsigned int n_nodes;
+    sap_numa_node nodes[SAP_NUMA_MAX_NODES];
+} sap_numa_topology;
+
+/// @brief How a mapping is backed.
+enum {
+    SAP_NUMA_PAGES_SMALL = 0,   /**< Base pages. */
+    SAP_NUMA_PAGES_THP = 1,     /**< Transparent huge pages were requested. */
+    SAP_NUMA_PAGES_HUGETLB = 2  /**< Pages from the hugetlbfs pool. */
+};
+
+/// @brief A mapping made by sap_numa_alloc().
+typedef struct {
+    void* base;                 /**< Usable memory, 2 MiB aligned for huge pages. */
+    size_t bytes;               /**< Requested size. */
+    void* map;                  /**< The whole mapping, for munmap(). */
+    size_t map_bytes;
+    int pages;                  /**< SAP_NUMA_PAGES_*. */
+} sap_numa_mem;
+
+/// @brief Reads the topology; there is always at least one node.
+void sap_numa_topology_read(sap_numa_topology* t);
+
+/// @brief Restricts the calling thread to the CPUs of a node; returns 0 or -1.
+int sap_numa_run_on(const sap_numa_node* node);
+
+/// @brief Maps anonymous memory, without touching it.
+///
+/// @param[out] m Mapping; released with sap_numa_free().
+/// @param[in] bytes Size.
+/// @param[in] node Node to prefer for the pages, or -1 for the default policy.
+/// @param[in] huge Nonzero to back the mapping with huge pages if possible.
+/// @return 0 on success, -1 if out of memory.
+int sap_numa_alloc(sap_numa_mem* m, size_t bytes, int node, int huge);
+
+/// @brief Unmaps memory from sap_numa_alloc().
+void sap_numa_free(sap_numa_mem* m);
@@ -0,0 +1,193 @@
+#include "numa_scan.h"
+#include "wipe.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    sap_numa_scanner* s;
+    sap_numa_shard* shard;
+    const uint8_t* const* cts;
+    const uint8_t* view_tags;
+    const uint8_t* v_priv;
+    int ret;
+} shard_fill;
+
+typedef struct {
+    const sap_numa_scanner* s;
+    const sap_numa_shard* shard;
+    size_t begin, end;              /**< Range within the shard. */
+    uint8_t* hits;
+    uint8_t* ss;
+    size_t found;
+} shard_scan;
+
+static size_t align64(size_t x)
+{
+    return (x + 63) & ~(size_t)63;
+}
+
+/**
+ * Workflow:
+ *  1. Moves to the shard's node, so that the pages it touches first are local.
+ *  2. Maps one region for the key, the ciphertexts, the pointer table and the tags.
+ *  3. Copies the shard's announcements and prepares the key in place.
+ */
+static void* fill_shard(void* arg)
+{
+    shard_fill* f = arg;
+    sap_numa_shard* shard = f->shard;
+    if (shard->node >= 0) {
+        sap_numa_run_on(&f->s->topology.nodes[shard->node]);
+    }
+
+    size_t key_off = 0;
+    size_t ct_off = align64(sizeof(sap_scan_key));
+    size_t ptr_off = align64(ct_off + shard->n * CIPHERTEXT_BYTES);
+    size_t tag_off = align64(ptr_off + shard->n * sizeof(uint8_t*));
+    size_t bytes = tag_off + shard->n;
+    int node = shard->node >= 0 ? f->s->topology.nodes[shard->node].id : -1;
+    if (sap_numa_alloc(&shard->mem, bytes, node, (f->s->flags & SAP_NUMA_HUGE) != 0) != 0) {
+        f->ret = -1;
+        return NULL;
+    }
+
+    uint8_t* base = shard->mem.base;
+    shard->key = (sap_scan_key*)(base + key_off);
+    shard->cts = (const uint8_t**)(base + ptr_off);
+    shard->view_tags = base + tag_off;
+    sap_scan_key_init(shard->key, f->v_priv);
+    for (size_t i = 0; i < shard->n; i++) {
+        uint8_t* ct = base + ct_off + i * CIPHERTEXT_BYTES;
+        memcpy(ct, f->cts[shard->begin + i], CIPHERTEXT_BYTES);
+        shard->cts[i] = ct;
+    }
+    memcpy(shard->view_tags, f->view_tags + shard->begin, shard->n);
+    f->ret = 0;
+    return NULL;
+}
+
+static void* scan_part(void* arg)
+{
+    shard_scan* p = arg;
+    if (p->shard->node >= 0) {
+        sap_numa_run_on(&p->s->topology.nodes[p->shard->node]);
+    }
+    size_t at = p->shard->begin + p->begin;
+    p->found = sap_scan(p->hits + at, p->ss != NULL ? p->ss + at * SS_BYTES : NULL, p->shard->cts + p->begin,
+        p->shard->view_tags + p->begin, p->end - p->begin, p->shard->key);
+    return NULL;
+}
+
+/**
+ * Workflow:
+ *  1. Reads the topology and sizes one shard per node by its CPU count, or a
+ *     single unpinned shard without SAP_NUMA_SHARDS.
+ *  2. Fills all shards in parallel, each from a thread on its node.
+ */
+int sap_numa_scanner_init(sap_numa_scanner* s, const uint8_t* const* cts, const uint8_t* view_tags, size_t n,
+    const uint8_t v_priv[SECRET_KEY_BYTES], int flags)
+{
+    memset(s, 0, sizeof(*s));
+    s->n = n;
+    s->flags = flags;
+    sap_numa_topology_read(&s->topology);
+
+    if (flags & SAP_NUMA_SHARDS) {
+        unsigned int cpus = 0;
+        for (unsigned int i = 0; i < s->topology.n_nodes; i++) cpus += s->topology.nodes[i].n_cpus;
+        size_t begin = 0, before = 0;
+        for (unsigned int i = 0; i < s->topology.n_nodes; i++) {
+            before += s->topology.nodes[i].n_cpus;
+            size_t end = (size_t)((unsigned __int128)n * before / cpus);
+            s->shards[i] = (sap_numa_shard){ .node = (int)i, .begin = begin, .n = end - begin };
+            begin = end;
+        }
+        s->n_shards = s->topology.n_nodes;
+    } else {
+        s->shards[0] = (sap_numa_shard){ .node = -1, .begin = 0, .n = n };
+        s->n_shards = 1;
+    }
+
+    shard_fill fills[SAP_NUMA_MAX_NODES];
+    pthread_t threads[SAP_NUMA_MAX_NODES];
+    int ret = 0;
+    unsigned int started = 0;
+    for (; started < s->n_shards; started++) {
+        fills[started] = (shard_fill){ s, &s->shards[started], cts, view_tags, v_priv, -1 };
+        if (pthread_create(&threads[started], NULL, fill_shard, &fills[started]) != 0) {
+            ret = -1;
+            break;
+        }
+    }
+    for (unsigned int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+        if (fills[i].ret != 0) ret = -1;
+    }
+    if (ret != 0) {
+        sap_numa_scanner_free(s);
+    }
+    return ret;
+}
+
+size_t sap_numa_scanner_scan(sap_numa_scanner* s, uint8_t* hits, uint8_t* ss, unsigned int threads)
+{
+    unsigned int cpus = 0;
+    for (unsigned int i = 0; i < s->topology.n_nodes; i++) cpus += s->topology.nodes[i].n_cpus;
+    if (threads == 0) threads = cpus;
+    if (threads < s->n_shards) threads = s->n_shards;
+
+    shard_scan* parts = calloc(threads, sizeof(*parts));
+    pthread_t* ids = calloc(threads, sizeof(*ids));
+    if (parts == NULL || ids == NULL) {
+        free(parts);
+        free(ids);
+        return SIZE_MAX;
+    }
+
+    /* threads per shard in proportion to its size, at least one each */
+    unsigned int n_parts = 0, left = threads;
+    for (unsigned int i = 0; i < s->n_shards; i++) {
+        const sap_numa_shard* shard = &s->shards[i];
+        unsigned int t = i + 1 == s->n_shards ? left
+            : (unsigned int)(s->n > 0 ? (unsigned __int128)threads * shard->n / s->n : 0);
+        if (t < 1) t = 1;
+        if (t > left - (s->n_shards - 1 - i)) t = left - (s->n_shards - 1 - i);
+        left -= t;
+        for (unsigned int j = 0; j < t; j++) {
+            /* slices start on a lane group so that only the last one is partial */
+            size_t groups = (shard->n + SAP_SCAN_LANES - 1) / SAP_SCAN_LANES;
+            size_t b = groups * j / t * SAP_SCAN_LANES, e = groups * (j + 1) / t * SAP_SCAN_LANES;
+            parts[n_parts++] = (shard_scan){ s, shard, b, e < shard->n ? e : shard->n, hits, ss, 0 };
+        }
+    }
+
+    size_t found = 0;
+    unsigned int started = 0;
+    for (; started < n_parts; started++) {
+        if (pthread_create(&ids[started], NULL, scan_part, &parts[started]) != 0) {
+            found = SIZE_MAX;
+            break;
+        }
+    }
+    for (unsigned int i = 0; i < started; i++) {
+        pthread_join(ids[i], NULL);
+        if (found != SIZE_MAX) found += parts[i].found;
+    }
+    free(parts);
+    free(ids);
+    return found;
+}
+
+void sap_numa_scanner_free(sap_numa_scanner* s)
+{
+    for (unsigned int i = 0; i < s->n_shards; i++) {
+        sap_numa_shard* shard = &s->shards[i];
+        if (shard->key != NULL) {
+            sap_wipe(shard->key, sizeof(sap_scan_key));
+        }
+        sap_numa_free(&shard->mem);
+        shard->key = NULL;
+    }
+    s->n_shards = 0;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "numa.h"
+#include "scan.h"
+
+/// @file numa_scan.h
+/// @brief Register scanning split into one shard per NUMA node.
+///
+/// On a multi-socket machine a plain sap_scan() across threads lets every socket
+/// read ciphertexts from wherever the register happened to be allocated, and a
+/// register of several GiB in 4 KiB pages needs far more TLB entries than the
+/// cores have. With SAP_NUMA_SHARDS the register is split into one contiguous
+/// shard per node, in proportion to the node's CPUs. Every shard is copied into
+/// memory of its node by a thread running there, together with the view tags, the
+/// ciphertext pointer table and a copy of the prepared view key, and is scanned only
+/// by threads pinned to that node. SAP_NUMA_HUGE backs the shards with 2 MiB pages.
+///
+/// Without flags there is a single unpinned shard in base pages, which is what a
+/// NUMA-unaware caller gets; the benchmark compares the two.
+
+/// @brief Flags of sap_numa_scanner_init().
+enum {
+    SAP_NUMA_SHARDS = 1,    /**< One shard per node, scanned by threads pinned to it. */
+    SAP_NUMA_HUGE = 2       /**< Huge pages for the shards. */
+};
+
+/// @brief The part of the register held by one node.
+typedef struct {
+    int node;                       /**< Index into the topology, or -1 if not pinned. */
+    size_t begin, n;                /**< Register range. */
+    sap_numa_mem mem;               /**< Holds all of the following. */
+    sap_scan_key* key;              /**< The node's copy of the prepared view key. */
+    const uint8_t** cts;            /**< Pointers into the copied ciphertexts. */
+    uint8_t* view_tags;
+} sap_numa_shard;
+
+/// @brief A register prepared for scanning with one view key.
+typedef struct {
+    sap_numa_topology topology;
+    unsigned int n_shards;
+    sap_numa_shard shards[SAP_NUMA_MAX_NODES];
+    size_t n;
+    int flags;
+} sap_numa_scanner;
+
+#define sap_numa_scanner_init SAP_NAMESPACE(numa_scanner_init)
+/// @brief Copies a register into node-local shards.
+///
+/// @param[out] s Scanner; released with sap_numa_scanner_free().
+/// @param[in] cts The n ciphertexts.
+/// @param[in] view_tags The n view tags.
+/// @param[in] n Number of announcements.
+/// @param[in] v_priv Secret view key.
+/// @param[in] flags SAP_NUMA_SHARDS and/or SAP_NUMA_HUGE.
+/// @return 0 on success, -1 if out of memory or a thread could not be started.
+int sap_numa_scanner_init(sap_numa_scanner* s, const uint8_t* const* cts, const uint8_t* view_tags, size_t n,
+    const uint8_t v_priv[SECRET_KEY_BYTES], int flags);
+
+#define sap_numa_scanner_scan SAP_NAMESPACE(numa_scanner_scan)
+/// @brief Scans the register as sap_scan() does, with @p threads threads.
+///
+/// The threads are divided among the shards in proportion to their size, at least
+/// one each. @p hits and @p ss are indexed by register position.
+///
+/// @param[in] threads Number of threads, 0 for one per usable CPU.
+/// @return The number of hits, or SIZE_MAX if a thread could not be started.
+size_t sap_numa_scanner_scan(sap_numa_scanner* s, uint8_t* hits, uint8_t* ss, unsigned int threads);
+
+#define sap_numa_scanner_free SAP_NAMESPACE(numa_scanner_free)
+/// @brief Wipes the key copies and unmaps the shards.
+void sap_numa_scanner_free(sap_numa_scanner* s);
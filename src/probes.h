@@ -0,0 +1,42 @@
+#pragma once
+
+/// @file probes.h
+/// @brief USDT tracepoints on the protocol hot paths (provider `pqsap`).
+///
+/// The probes are SystemTap SDT notes: each one compiles to a single nop plus an
+/// ELF note that names it and says where its arguments are. Until a tracer
+/// attaches, they cost that nop; bpftrace, perf or SystemTap turn them on live,
+/// for example:
+///
+///     bpftrace -e 'usdt:./libpqsap.so:pqsap:scan__done { @hits = sum(arg1); }'
+///     perf buildid-cache --add libpqsap.so && perf list sdt_pqsap:*
+///
+/// Probes:
+///  - kem_dec__entry(ct, sk) and kem_dec__return(ret), around sap_kem_dec();
+///  - view_tag__entry(ss) and view_tag__return(tag), around calculate_view_tag();
+///  - stealth_pub_key__entry(ss, k_pub) and stealth_pub_key__return(stealth_pub_key),
+///    around calculate_stealth_pub_key();
+///  - scan__start(n, kyber_k) and scan__done(n, hits), around every batch given
+///    to sap_scan() or sap_scan_until().
+///
+/// They need <sys/sdt.h> (systemtap-sdt-dev or systemtap-sdt-devel) at build
+/// time. Without it, or with -DSAP_NO_PROBES, each macro expands to
+/// `((void)sizeof((a) + 0))` per argument: no code and no note, and the
+/// arguments are type-checked but not evaluated.
+
+#if !defined(SAP_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define SAP_PROBES_ENABLED 1
+#endif
+#endif
+
+#ifdef SAP_PROBES_ENABLED
+#define SAP_PROBE1(name, a) DTRACE_PROBE1(pqsap, name, a)
+#define SAP_PROBE2(name, a, b) DTRACE_PROBE2(pqsap, name, a, b)
+#else
+#define SAP_PROBES_ENABLED 0
+/* sizeof keeps the arguments "used" without evaluating them */
+#define SAP_PROBE1(name, a) ((void)sizeof((a) + 0))
+#define SAP_PROBE2(name, a, b) ((void)sizeof((a) + 0), (void)sizeof((b) + 0))
+#endif
@@ -4,7 +4,7 @@
 
 /**
  * Workflow:
- *  1. Calls crypto_kem_dec(ss, ephemeral_pub_key, v)  to derive shared secret `ss` from ephemeral public key and private key `v`.
+ *  1. Calls sap_kem_dec(ss, ephemeral_pub_key, v)  to derive shared secret `ss` from ephemeral public key and private key `v`.
  *  2. Prints recipient's public key and derived shared secret.
  *  3. Calls calculate_stealth_pub_key() to compute stealth public key using public key `k_pub` and shared secret `ss`. The resulting stealth public key is written into the output parameter `stealth_pub_key`.
  *
@@ -19,7 +19,7 @@ void recipient_computes_stealth_pub_key(uint8_t stealth_pub_key[STEALTH_ADDRESS_
     const uint8_t v[SECRET_KEY_BYTES])
 {
     uint8_t ss[SS_BYTES];
-    crypto_kem_dec(ss, ephemeral_pub_key, v);
+    sap_kem_dec(ss, ephemeral_pub_key, v);
 
     printf("Recipient k_pub:\n");
     for (int i = 0; i < PUBLIC_KEY_BYTES; i++) printf("%02x", k_pub[i]);
@@ -35,7 +35,7 @@ void recipient_computes_stealth_pub_key(uint8_t stealth_pub_key[STEALTH_ADDRESS_
 /**
  * Workflow:
  *  1. Validates input.
- *  2. Calls crypto_kem_enc(ephemeral_pub_key, ss, v_pub) to generate shared secret `ss` and ephemeral public key.
+ *  2. Calls sap_kem_enc(ephemeral_pub_key, ss, v_pub) to generate shared secret `ss` and ephemeral public key.
  *  3. Prints sender's public key and derived shared secret.
  *  4. Calls calculate_stealth_pub_key() to compute stealth public key using public key `k_pub` and shared secret `ss`. The resulting stealth public key is written into the output parameter `stealth_pub_key`.
  *  5. Calls calculate_view_tag() to compute view tag from shared secret `ss`.
@@ -57,7 +57,7 @@ void sender_computes_stealth_pub_key_and_viewtag(uint8_t stealth_pub_key[STEALTH
     }
 
     uint8_t ss[SS_BYTES];
-    crypto_kem_enc(ephemeral_pub_key, ss, v_pub);
+    sap_kem_enc(ephemeral_pub_key, ss, v_pub);
 
     printf("Sender k_pub:\n");
     for (int i = 0; i < PUBLIC_KEY_BYTES; i++) printf("%02x", k_pub[i]);
@@ -74,7 +74,7 @@ void sender_computes_stealth_pub_key_and_viewtag(uint8_t stealth_pub_key[STEALTH
 
 /**
  * Workflow:
- *  1. Calls shake128(hash, 32, ss, KYBER_SSBYTES) to hash the shared secret into 32 bytes.
+ *  1. Calls sap_shake128(hash, 32, ss, KYBER_SSBYTES) to hash the shared secret into 32 bytes.
  *  2. Takes the first byte of the hash as the view tag.
  *
  * @param[in] ss Shared secret.
@@ -86,25 +86,20 @@ uint8_t calculate_view_tag(const uint8_t ss[SS_BYTES])
         return 0;
     }
 
+    SAP_PROBE1(view_tag__entry, ss);
     uint8_t hash[32];
-    shake128(hash, 32, ss, KYBER_SSBYTES);
+    sap_shake128(hash, 32, ss, KYBER_SSBYTES);
 
     uint8_t view_tag = hash[0];
+    SAP_PROBE1(view_tag__return, view_tag);
     return view_tag;
 }
 
 /**
  * Workflow:
- *  1. Initializes polyvec structures.
- *      - This step initializes the polyvec structures pkpv and skpv. These structures hold polynomial vectors, and each polynomial is essentially a vector of coefficients used in lattice-based cryptography.The public_seed is initialized to zero here, which will later be used to derive the public key.
- *  2. Unpacks recipient's public key using unpack_pk(&pkpv, public_seed, k_pub) .The unpacked public key is stored in `pkpv`.
- *  3. Derives matrix A deterministically using gen_matrix(a, public_seed, 0) .
- *      - The gen_matrix() function fills in the matrix a with polynomials where the coefficients are derived from a cryptographic randomness function xof_squeezeblocks()
- *  4. Converts shared secret into a noise sampled secret key vector `skpv` using  poly_getnoise_eta1() .
- *  5. Computes A * S + K polynomial vector:
- *      - Calls polyvec_basemul_acc_montgomery() and poly_tomont() for each element.
- *  6. Adds original public key polynomial and reduces ( polyvec_add(&p_poly, &p_poly, &pkpv)  polyvec_reduce(&p_poly) ).
- *  7. Converts resulting polynomial vector into byte array using polyvec_tobytes(stealth_pub_key, &p_poly).
+ *  1. Dispatches to the stealth_pub_key entry of the active backend (see backend.h).
+ *      - The backend unpacks `k_pub`, expands the matrix A from its public seed with gen_matrix() and samples the secret vector `s` from `ss` with poly_getnoise_eta1().
+ *      - It computes A * s + k_pub with polyvec_basemul_acc_montgomery(), poly_tomont(), polyvec_add() and polyvec_reduce(), and serializes the result with polyvec_tobytes().
  *
  * @param[out] stealth_pub_key Output array for stealth public key.
  * @param[in] ss Shared secret.
@@ -114,39 +109,9 @@ void calculate_stealth_pub_key(uint8_t stealth_pub_key[STEALTH_ADDRESS_BYTES],
     const uint8_t ss[KYBER_SYMBYTES],
     const uint8_t k_pub[KYBER_INDCPA_PUBLICKEYBYTES])
 {
-    polyvec pkpv, skpv;
-    uint8_t public_seed[KYBER_SYMBYTES] = { 0 };
-
-    polyvec pkpv_zero = { 0 };
-    polyvec skpv_zero = { 0 };
-    pkpv = pkpv_zero;
-    skpv = skpv_zero;
-
-    unpack_pk(&pkpv, public_seed, k_pub);
-
-    polyvec a[KYBER_K];
-    for (int i = 0; i < KYBER_K; i++) {
-        polyvec zero = { 0 };
-        a[i] = zero;
-    }
-    gen_matrix(a, public_seed, 0);
-
-    uint8_t nonce = 0;
-    for (int i = 0; i < KYBER_K; i++) {
-        poly_getnoise_eta1(&skpv.vec[i], ss, nonce);
-        nonce++;
-    }
-
-    polyvec p_poly = { 0 };
-    for (int i = 0; i < KYBER_K; i++) {
-        polyvec_basemul_acc_montgomery(&p_poly.vec[i], &a[i], &skpv);
-        poly_tomont(&p_poly.vec[i]);
-    }
-
-    polyvec_add(&p_poly, &p_poly, &pkpv);
-    polyvec_reduce(&p_poly);
-
-    polyvec_tobytes(stealth_pub_key, &p_poly);
+    SAP_PROBE2(stealth_pub_key__entry, ss, k_pub);
+    sap_backend_active()->stealth_pub_key(stealth_pub_key, ss, k_pub);
+    SAP_PROBE1(stealth_pub_key__return, stealth_pub_key);
 }
 
 
@@ -157,7 +122,7 @@ uint8_t* calculate_ss_hash(const uint8_t ss[SS_BYTES])
     }
 
     uint8_t* hash = malloc(32*sizeof(uint8_t));
-    shake128(hash, 32, ss, KYBER_SSBYTES);
+    sap_shake128(hash, 32, ss, KYBER_SSBYTES);
 
     return hash;
-}
\ No newline at end of file
+}
@@ -34,10 +34,28 @@
 /// @brief Number of bytes in a stealth address.
 #define STEALTH_ADDRESS_BYTES (KYBER_K * KYBER_POLYBYTES)
 
+/// @def STEALTH_SECRET_KEY_BYTES
+/// @brief Number of bytes in a stealth private key (the packed secret vector).
+#define STEALTH_SECRET_KEY_BYTES KYBER_POLYVECBYTES
+
 /// @def SS_BYTES
 /// @brief Number of bytes in a shared secret.
 #define SS_BYTES KYBER_SSBYTES
 
+/// @def SAP_NAMESPACE
+/// @brief Prefixes protocol-layer symbols that depend on KYBER_K, so that code built
+/// for several security levels can be linked into one binary (mirrors KYBER_NAMESPACE).
+#if   (KYBER_K == 2)
+#define SAP_NAMESPACE(s) pqsap_kyber512_##s
+#elif (KYBER_K == 3)
+#define SAP_NAMESPACE(s) pqsap_kyber768_##s
+#elif (KYBER_K == 4)
+#define SAP_NAMESPACE(s) pqsap_kyber1024_##s
+#endif
+
+#include "backend.h"
+
+#define calculate_stealth_pub_key SAP_NAMESPACE(stealth_pub_key)
 /// @brief Calculates the public key of the stealth address.
 ///
 /// @param[out] stealth_pub_key Array where the computed stealth public key will be stored (STEALTH_ADDRESS_BYTES).
@@ -47,6 +65,53 @@ void calculate_stealth_pub_key(uint8_t stealth_pub_key[STEALTH_ADDRESS_BYTES],
     const uint8_t ss[KYBER_SYMBYTES],
     const uint8_t k_pub[KYBER_INDCPA_PUBLICKEYBYTES]);
 
+/// @brief The secret vector of a spending key, unpacked once for calculate_stealth_priv_key().
+///
+/// Holds secret material; wipe it when the wallet is closed.
+typedef struct {
+    int16_t s[KYBER_K][KYBER_N];    /**< NTT domain, standard coefficient order, in [0, q). */
+} sap_spend_key;
+
+#define sap_spend_key_init SAP_NAMESPACE(spend_key_init)
+/// @brief Unpacks the secret vector of a spending key.
+///
+/// @param[out] key Unpacked key.
+/// @param[in] k_priv Recipient's secret spending key; only its first
+/// STEALTH_SECRET_KEY_BYTES (the packed secret vector) are read.
+void sap_spend_key_init(sap_spend_key* key, const uint8_t k_priv[SECRET_KEY_BYTES]);
+
+#define calculate_stealth_priv_key SAP_NAMESPACE(stealth_priv_key)
+/// @brief Calculates the private key of a stealth address.
+///
+/// The stealth public key is A * (s_k + s) + e, where s_k and e are the secret
+/// vector and the noise of k_pub and s is sampled from @p ss. The private key is
+/// s_k + s, packed like the secret vector of a Kyber secret key. Together with
+/// the seed of k_pub it forms an ordinary Kyber key pair.
+///
+/// @param[out] stealth_priv_key Array where the private key will be stored (STEALTH_SECRET_KEY_BYTES).
+/// @param[in] ss Shared secret of the announcement.
+/// @param[in] key Recipient's unpacked spending key.
+void calculate_stealth_priv_key(uint8_t stealth_priv_key[STEALTH_SECRET_KEY_BYTES],
+    const uint8_t ss[SS_BYTES],
+    const sap_spend_key* key);
+
+#define calculate_stealth_priv_keys SAP_NAMESPACE(stealth_priv_keys)
+/// @brief Calculates the private keys of many stealth addresses, for example all outputs of a wallet.
+///
+/// Equals @p n calls of calculate_stealth_priv_key(). The secrets are sampled 4
+/// (AVX2) or 8 (AVX-512) polynomials per Keccak pass across outputs, and the
+/// outputs are split among threads.
+///
+/// @param[out] stealth_priv_keys n * STEALTH_SECRET_KEY_BYTES bytes.
+/// @param[in] ss The n shared secrets, SS_BYTES each.
+/// @param[in] n Number of outputs.
+/// @param[in] key Recipient's unpacked spending key.
+/// @param[in] threads Number of threads, 0 for one per online CPU.
+/// @return 0 on success, -1 if out of memory.
+int calculate_stealth_priv_keys(uint8_t* stealth_priv_keys, const uint8_t* ss, size_t n,
+    const sap_spend_key* key, unsigned int threads);
+
+#define recipient_computes_stealth_pub_key SAP_NAMESPACE(recipient_computes_stealth_pub_key)
 /// @brief Computes the stealth public key by the recipient.
 ///
 /// The recipient uses their secret view key and the sender's ephemeral public key to compute the stealth address.
@@ -60,6 +125,7 @@ void recipient_computes_stealth_pub_key(uint8_t stealth_pub_key[STEALTH_ADDRESS_
     const uint8_t ephemeral_pub_key[CIPHERTEXT_BYTES],
     const uint8_t v[SECRET_KEY_BYTES]);
 
+#define sender_computes_stealth_pub_key_and_viewtag SAP_NAMESPACE(sender_computes_stealth_pub_key_and_viewtag)
 /// @brief Computes the stealth public key and view tag by the sender.
 ///
 /// The sender generates an ephemeral key pair, derives a shared secret, 
@@ -76,6 +142,7 @@ void sender_computes_stealth_pub_key_and_viewtag(uint8_t stealth_pub_key[STEALTH
     const uint8_t v_pub[PUBLIC_KEY_BYTES],
     const uint8_t k_pub[PUBLIC_KEY_BYTES]);
 
+#define calculate_view_tag SAP_NAMESPACE(view_tag)
 /// @brief Calculates a view tag from a shared secret.
 ///
 /// The view tag is used to quickly identify transactions meant for the recipient.
@@ -85,5 +152,5 @@ void sender_computes_stealth_pub_key_and_viewtag(uint8_t stealth_pub_key[STEALTH
 uint8_t calculate_view_tag(const uint8_t ss[SS_BYTES]);
 
 
-
-uint8_t* calculate_ss_hash(const uint8_t ss[SS_BYTES]);
\ No newline at end of file
+#define calculate_ss_hash SAP_NAMESPACE(ss_hash)
+uint8_t* calculate_ss_hash(const uint8_t ss[SS_BYTES]);
\ No newline at end of file
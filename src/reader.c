@@ -0,0 +1,525 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "reader.h"
+#include "scan_stats.h"
+#include "corpus.h"
+#include "numa.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define READER_DEFAULT_DEPTH 8
+#define READER_DEFAULT_BATCH ((size_t)1 << 20)
+/// Smallest and largest ephemeral public key (Kyber512 and Kyber1024).
+#define READER_MIN_CT 768
+#define READER_MAX_CT 1568
+
+enum { SLOT_FREE, SLOT_READING, SLOT_READY, SLOT_HELD };
+
+/// One of the two reads of a batch: the ephemeral public keys or the tags.
+typedef struct {
+    uint64_t at;                /**< File offset of the first byte needed. */
+    size_t len;                 /**< Bytes needed. */
+    uint64_t read_at;           /**< at rounded down to SAP_READER_ALIGN. */
+    size_t read_len;            /**< Aligned length of the read. */
+    size_t done;                /**< Bytes read so far. */
+    uint8_t* buf;
+    size_t cap;
+} reader_part;
+
+typedef struct {
+    int state;
+    unsigned int pending;       /**< Parts still being read. */
+    uint64_t begin;
+    size_t n;
+    reader_part parts[2];
+    const uint8_t** cts;
+    uint8_t* view_tags;
+} reader_slot;
+
+struct sap_reader {
+    corpus_layout layout;
+    int fd;
+    int direct;
+    size_t batch_bytes;
+    unsigned int n_slots;
+    reader_slot* slots;
+    sap_numa_mem mem;
+    uint64_t next;              /**< First announcement not yet assigned to a slot. */
+    uint64_t next_ct;           /**< Its offset in the ephemeral public key section. */
+    int failed;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    sap_reader_stats stats;
+
+    /* io_uring, if ring_fd >= 0 */
+    int ring_fd;
+    void* sq_ring;
+    size_t sq_ring_bytes;
+    void* cq_ring;
+    size_t cq_ring_bytes;
+    struct io_uring_sqe* sqes;
+    size_t sqes_bytes;
+    unsigned int *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned int *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe* cqes;
+    unsigned int to_submit;
+    int waiting;                /**< A thread waits for completions in io_uring_enter() without the lock. */
+};
+
+static size_t align_up(size_t x)
+{
+    return (x + SAP_READER_ALIGN - 1) & ~(size_t)(SAP_READER_ALIGN - 1);
+}
+
+/// Ephemeral public key size of a level; the layout has only valid levels.
+static size_t ct_size(uint8_t level)
+{
+    size_t ct_bytes = 0, pk_bytes, sk_bytes;
+    corpus_level_sizes(level, &ct_bytes, &pk_bytes, &sk_bytes);
+    return ct_bytes;
+}
+
+/* ---- batches ---- */
+
+static void plan_part(reader_part* p, uint64_t at, size_t len)
+{
+    p->at = at;
+    p->len = len;
+    p->read_at = at & ~(uint64_t)(SAP_READER_ALIGN - 1);
+    p->read_len = align_up((size_t)(at - p->read_at) + len);
+    p->done = 0;
+}
+
+/// Assigns the next announcements to a free slot, as many as fit into batch_bytes.
+static void plan_slot(sap_reader* r, reader_slot* s)
+{
+    size_t n = 0, bytes = 0;
+    while (r->next + n < r->layout.n) {
+        size_t size = ct_size(r->layout.levels[r->next + n]);
+        if (bytes + size > r->batch_bytes) break;
+        bytes += size;
+        n++;
+    }
+    s->begin = r->next;
+    s->n = n;
+    plan_part(&s->parts[0], r->layout.cts_at + r->next_ct, bytes);
+    plan_part(&s->parts[1], r->layout.tags_at + r->next * CORPUS_TAG_BYTES, n * CORPUS_TAG_BYTES);
+    s->state = SLOT_READING;
+    s->pending = 2;
+    r->next += n;
+    r->next_ct += bytes;
+    r->stats.reads += 2;
+    r->stats.bytes += s->parts[0].read_len + s->parts[1].read_len;
+}
+
+/// Points the ciphertext table and the view tags of a read slot into its buffers.
+static void finish_slot(sap_reader* r, reader_slot* s)
+{
+    const uint8_t* ct = s->parts[0].buf + (s->parts[0].at - s->parts[0].read_at);
+    const uint8_t* tag = s->parts[1].buf + (s->parts[1].at - s->parts[1].read_at);
+    for (size_t i = 0; i < s->n; i++) {
+        s->cts[i] = ct;
+        ct += ct_size(r->layout.levels[s->begin + i]);
+        s->view_tags[i] = tag[i * CORPUS_TAG_BYTES];
+    }
+    s->state = SLOT_READY;
+}
+
+/// Reads one part with pread(); returns 0 if every needed byte arrived.
+static int pread_part(int fd, reader_part* p)
+{
+    size_t need = (size_t)(p->at - p->read_at) + p->len;
+    while (p->done < need) {
+        ssize_t n = pread(fd, p->buf + p->done, p->read_len - p->done, (off_t)(p->read_at + p->done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p->done += (size_t)n;
+    }
+    return 0;
+}
+
+/* ---- io_uring ---- */
+
+static int uring_enter(sap_reader* r, unsigned int to_submit, unsigned int min_complete)
+{
+    unsigned int flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    for (;;) {
+        long ret = syscall(__NR_io_uring_enter, r->ring_fd, to_submit, min_complete, flags, NULL, 0);
+        if (ret >= 0) return 0;
+        if (errno != EINTR) return -1;
+    }
+}
+
+/// Queues the read of a part (of the remaining bytes after a short read).
+static void uring_queue(sap_reader* r, unsigned int slot, unsigned int part)
+{
+    reader_part* p = &r->slots[slot].parts[part];
+    unsigned int tail = *r->sq_tail, index = tail & *r->sq_mask;
+    struct io_uring_sqe* sqe = &r->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = r->stats.registered ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe->fd = r->fd;
+    sqe->off = p->read_at + p->done;
+    sqe->addr = (uint64_t)(uintptr_t)(p->buf + p->done);
+    sqe->len = (uint32_t)(p->read_len - p->done);
+    sqe->buf_index = (uint16_t)(2 * slot + part);
+    sqe->user_data = 2 * (uint64_t)slot + part;
+    r->sq_array[index] = index;
+    __atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    r->to_submit++;
+}
+
+/// Submits the queued reads without waiting for any.
+static int uring_submit(sap_reader* r)
+{
+    if (r->to_submit == 0) {
+        return 0;
+    }
+    unsigned int n = r->to_submit;
+    r->to_submit = 0;
+    return uring_enter(r, n, 0);
+}
+
+/// Plans and queues every free slot, then submits the queued reads.
+static int uring_fill(sap_reader* r)
+{
+    for (unsigned int i = 0; i < r->n_slots && r->next < r->layout.n; i++) {
+        if (r->slots[i].state != SLOT_FREE) continue;
+        plan_slot(r, &r->slots[i]);
+        uring_queue(r, i, 0);
+        uring_queue(r, i, 1);
+    }
+    return uring_submit(r);
+}
+
+/**
+ * Takes the completions that are there, without waiting. A short read is
+ * continued; a failed one sets failed and frees its slot once both parts are
+ * back.
+ *
+ * @return 0, or -1 if a continued read cannot be submitted.
+ */
+static int uring_reap(sap_reader* r)
+{
+    unsigned int head = *r->cq_head, tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+        const struct io_uring_cqe* cqe = &r->cqes[head & *r->cq_mask];
+        unsigned int slot = (unsigned int)(cqe->user_data / 2), part = (unsigned int)(cqe->user_data % 2);
+        reader_slot* s = &r->slots[slot];
+        reader_part* p = &s->parts[part];
+        size_t need = (size_t)(p->at - p->read_at) + p->len;
+        if (cqe->res > 0 && (p->done += (size_t)cqe->res) < need) {
+            uring_queue(r, slot, part);
+            continue;
+        }
+        if (cqe->res <= 0) r->failed = 1;
+        if (--s->pending == 0) {
+            if (r->failed) {
+                s->state = SLOT_FREE;
+            } else {
+                finish_slot(r, s);
+            }
+        }
+    }
+    __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+    return uring_submit(r);
+}
+
+/**
+ * Workflow:
+ *  1. Creates a ring with room for both reads of every slot and maps its
+ *     submission queue, completion queue and entries.
+ *  2. Registers the buffers of all parts, so that reads use IORING_OP_READ_FIXED;
+ *     if that is refused (locked memory limit), plain IORING_OP_READ is used.
+ *
+ * @return 0 on success, -1 if io_uring is not available.
+ */
+static int uring_setup(sap_reader* r)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    r->ring_fd = (int)syscall(__NR_io_uring_setup, 2 * r->n_slots, &p);
+    if (r->ring_fd < 0) {
+        r->ring_fd = -1;
+        return -1;
+    }
+
+    r->sq_ring_bytes = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+    r->cq_ring_bytes = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (r->cq_ring_bytes > r->sq_ring_bytes) r->sq_ring_bytes = r->cq_ring_bytes;
+        r->cq_ring_bytes = r->sq_ring_bytes;
+    }
+    r->sq_ring = mmap(NULL, r->sq_ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->ring_fd,
+        IORING_OFF_SQ_RING);
+    r->cq_ring = r->sq_ring;
+    if (r->sq_ring != MAP_FAILED && !(p.features & IORING_FEAT_SINGLE_MMAP)) {
+        r->cq_ring = mmap(NULL, r->cq_ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->ring_fd,
+            IORING_OFF_CQ_RING);
+    }
+    r->sqes_bytes = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->ring_fd,
+        IORING_OFF_SQES);
+    if (r->sq_ring == MAP_FAILED || r->cq_ring == MAP_FAILED || r->sqes == MAP_FAILED) {
+        if (r->sqes != MAP_FAILED) munmap(r->sqes, r->sqes_bytes);
+        if (r->cq_ring != MAP_FAILED && r->cq_ring != r->sq_ring) munmap(r->cq_ring, r->cq_ring_bytes);
+        if (r->sq_ring != MAP_FAILED) munmap(r->sq_ring, r->sq_ring_bytes);
+        close(r->ring_fd);
+        r->ring_fd = -1;
+        return -1;
+    }
+
+    uint8_t* sq = r->sq_ring;
+    uint8_t* cq = r->cq_ring;
+    r->sq_head = (unsigned int*)(sq + p.sq_off.head);
+    r->sq_tail = (unsigned int*)(sq + p.sq_off.tail);
+    r->sq_mask = (unsigned int*)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned int*)(sq + p.sq_off.array);
+    r->cq_head = (unsigned int*)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned int*)(cq + p.cq_off.tail);
+    r->cq_mask = (unsigned int*)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+    struct iovec* iov = calloc(2 * r->n_slots, sizeof(*iov));
+    if (iov != NULL) {
+        for (unsigned int i = 0; i < 2 * r->n_slots; i++) {
+            iov[i].iov_base = r->slots[i / 2].parts[i % 2].buf;
+            iov[i].iov_len = r->slots[i / 2].parts[i % 2].cap;
+        }
+        r->stats.registered = syscall(__NR_io_uring_register, r->ring_fd, IORING_REGISTER_BUFFERS, iov,
+            2 * r->n_slots) == 0;
+        free(iov);
+    }
+    r->stats.uring = 1;
+    return 0;
+}
+
+static void uring_close(sap_reader* r)
+{
+    if (r->ring_fd < 0) {
+        return;
+    }
+    munmap(r->sqes, r->sqes_bytes);
+    if (r->cq_ring != r->sq_ring) munmap(r->cq_ring, r->cq_ring_bytes);
+    munmap(r->sq_ring, r->sq_ring_bytes);
+    close(r->ring_fd);
+    r->ring_fd = -1;
+}
+
+/* ---- reader ---- */
+
+/**
+ * Opens the file with O_DIRECT unless disabled, and checks that a direct read
+ * works there; otherwise it is opened for buffered reads.
+ */
+static int open_file(sap_reader* r, const char* path, int flags)
+{
+    r->fd = (flags & SAP_READER_NO_DIRECT) ? -1 : open(path, O_RDONLY | O_DIRECT | O_CLOEXEC);
+    if (r->fd >= 0) {
+        reader_part* probe = &r->slots[0].parts[0];
+        if (pread(r->fd, probe->buf, SAP_READER_ALIGN, 0) >= 0) {
+            r->direct = 1;
+            return 0;
+        }
+        close(r->fd);
+    }
+    r->fd = open(path, O_RDONLY | O_CLOEXEC);
+    return r->fd >= 0 ? 0 : -1;
+}
+
+/**
+ * Workflow:
+ *  1. Reads the layout of the register (header and levels).
+ *  2. Maps the buffers of all slots at once, aligned and backed by huge pages
+ *     where possible: for every slot batch_bytes of ephemeral public keys and
+ *     the tags of the most announcements that fit, each with room to align the
+ *     read on both ends, and the tables a batch hands out.
+ *  3. Opens the file, sets up io_uring unless disabled and starts the first
+ *     queue_depth reads.
+ */
+sap_reader* sap_reader_open(const sap_reader_config* config)
+{
+    sap_reader* r = calloc(1, sizeof(*r));
+    if (r == NULL) {
+        return NULL;
+    }
+    r->fd = -1;
+    r->ring_fd = -1;
+    if (corpus_read_layout(&r->layout, config->path) != 0) {
+        free(r);
+        return NULL;
+    }
+    r->n_slots = config->queue_depth ? config->queue_depth : READER_DEFAULT_DEPTH;
+    r->batch_bytes = config->batch_bytes ? config->batch_bytes : READER_DEFAULT_BATCH;
+    if (r->batch_bytes < READER_MAX_CT) r->batch_bytes = READER_MAX_CT;
+
+    size_t max_n = r->batch_bytes / READER_MIN_CT;
+    size_t ct_cap = align_up(r->batch_bytes) + SAP_READER_ALIGN;
+    size_t tag_cap = align_up(max_n * CORPUS_TAG_BYTES) + SAP_READER_ALIGN;
+    size_t table = align_up(max_n * (sizeof(uint8_t*) + 1));
+    size_t per_slot = ct_cap + tag_cap + table;
+    r->slots = calloc(r->n_slots, sizeof(*r->slots));
+    if (r->slots == NULL || sap_numa_alloc(&r->mem, r->n_slots * per_slot, -1, 1) != 0
+        || pthread_mutex_init(&r->lock, NULL) != 0) {
+        corpus_layout_free(&r->layout);
+        free(r->slots);
+        free(r);
+        return NULL;
+    }
+    pthread_cond_init(&r->changed, NULL);
+    for (unsigned int i = 0; i < r->n_slots; i++) {
+        uint8_t* base = (uint8_t*)r->mem.base + i * per_slot;
+        reader_slot* s = &r->slots[i];
+        s->parts[0].buf = base;
+        s->parts[0].cap = ct_cap;
+        s->parts[1].buf = base + ct_cap;
+        s->parts[1].cap = tag_cap;
+        s->cts = (const uint8_t**)(base + ct_cap + tag_cap);
+        s->view_tags = (uint8_t*)(s->cts + max_n);
+    }
+
+    if (open_file(r, config->path, config->flags) != 0) {
+        sap_reader_close(r);
+        return NULL;
+    }
+    r->stats.direct = r->direct;
+    if (!(config->flags & SAP_READER_NO_URING) && uring_setup(r) == 0 && uring_fill(r) != 0) {
+        r->failed = 1;
+    }
+    return r;
+}
+
+size_t sap_reader_entries(const sap_reader* r)
+{
+    return r->layout.n;
+}
+
+/**
+ * Workflow:
+ *  1. Hands out the ready slot that comes first in the register.
+ *  2. With io_uring, while reads are in flight, one thread waits for a
+ *     completion in io_uring_enter() without holding the lock, then takes the
+ *     completions under the lock. Meanwhile other threads release and refill
+ *     slots, or wait for it on the condition variable.
+ *  3. With pread(), plans a free slot and reads it without holding the lock, so
+ *     that other threads read their batches at the same time.
+ *  4. Otherwise waits until another thread releases or fills a slot; returns 0
+ *     once the whole register was planned and no slot is being read or ready.
+ */
+static int next_batch(sap_reader* r, sap_reader_batch* b)
+{
+    pthread_mutex_lock(&r->lock);
+    for (;;) {
+        if (r->failed) {
+            pthread_mutex_unlock(&r->lock);
+            return -1;
+        }
+        reader_slot* ready = NULL;
+        reader_slot* free_slot = NULL;
+        int reading = 0;
+        for (unsigned int i = 0; i < r->n_slots; i++) {
+            reader_slot* s = &r->slots[i];
+            if (s->state == SLOT_READY && (ready == NULL || s->begin < ready->begin)) ready = s;
+            if (s->state == SLOT_FREE && free_slot == NULL) free_slot = s;
+            reading |= s->state == SLOT_READING;
+        }
+
+        if (ready != NULL) {
+            ready->state = SLOT_HELD;
+            b->begin = ready->begin;
+            b->n = ready->n;
+            b->levels = r->layout.levels + ready->begin;
+            b->cts = ready->cts;
+            b->tags = ready->parts[1].buf + (ready->parts[1].at - ready->parts[1].read_at);
+            b->view_tags = ready->view_tags;
+            b->slot = (unsigned int)(ready - r->slots);
+            pthread_mutex_unlock(&r->lock);
+            return 1;
+        }
+        if (r->ring_fd >= 0 && reading && !r->waiting) {
+            r->waiting = 1;
+            pthread_mutex_unlock(&r->lock);
+            int ret = uring_enter(r, 0, 1);
+            pthread_mutex_lock(&r->lock);
+            r->waiting = 0;
+            if (ret != 0 || uring_reap(r) != 0) r->failed = 1;
+            pthread_cond_broadcast(&r->changed);
+            continue;
+        }
+        if (r->ring_fd < 0 && free_slot != NULL && r->next < r->layout.n) {
+            plan_slot(r, free_slot);
+            pthread_mutex_unlock(&r->lock);
+            int ok = pread_part(r->fd, &free_slot->parts[0]) == 0 && pread_part(r->fd, &free_slot->parts[1]) == 0;
+            pthread_mutex_lock(&r->lock);
+            if (ok) {
+                finish_slot(r, free_slot);
+            } else {
+                r->failed = 1;
+            }
+            pthread_cond_broadcast(&r->changed);
+            continue;
+        }
+        if (!reading && r->next >= r->layout.n) {
+            pthread_mutex_unlock(&r->lock);
+            return 0;
+        }
+        pthread_cond_wait(&r->changed, &r->lock);
+    }
+}
+
+int sap_reader_next(sap_reader* r, sap_reader_batch* b)
+{
+    uint64_t start = sap_stats_cycles();
+    memset(b, 0, sizeof(*b));
+    int ret = next_batch(r, b);
+    sap_stats_add(sap_stats_thread(), SAP_STAT_CYCLES_IO_WAIT, sap_stats_cycles() - start);
+    return ret;
+}
+
+void sap_reader_release(sap_reader* r, const sap_reader_batch* b)
+{
+    pthread_mutex_lock(&r->lock);
+    r->slots[b->slot].state = SLOT_FREE;
+    if (r->ring_fd >= 0 && !r->failed && uring_fill(r) != 0) {
+        r->failed = 1;
+    }
+    pthread_cond_broadcast(&r->changed);
+    pthread_mutex_unlock(&r->lock);
+}
+
+void sap_reader_get_stats(sap_reader* r, sap_reader_stats* stats)
+{
+    pthread_mutex_lock(&r->lock);
+    *stats = r->stats;
+    pthread_mutex_unlock(&r->lock);
+}
+
+void sap_reader_close(sap_reader* r)
+{
+    if (r->ring_fd >= 0) {
+        /* the kernel may still write into the buffers */
+        for (;;) {
+            int reading = 0;
+            for (unsigned int i = 0; i < r->n_slots; i++) reading |= r->slots[i].state == SLOT_READING;
+            if (!reading || uring_enter(r, 0, 1) != 0 || uring_reap(r) != 0) break;
+        }
+    }
+    uring_close(r);
+    if (r->fd >= 0) close(r->fd);
+    sap_numa_free(&r->mem);
+    pthread_mutex_destroy(&r->lock);
+    pthread_cond_destroy(&r->changed);
+    corpus_layout_free(&r->layout);
+    free(r->slots);
+    free(r);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @file reader.h
+/// @brief Streaming a register file from disk in large asynchronous reads.
+///
+/// corpus_load() reads the whole register before the first announcement can
+/// be scanned. A register that is not in the page cache is then read in the
+/// buffered I/O size of the C library, one request at a time. The reader
+/// instead cuts the register into batches of whole announcements and keeps
+/// queue_depth of them in flight. Each batch is two reads: its ephemeral public
+/// keys and its tags. Both reads go into buffers that are registered with an
+/// io_uring instance. The file is opened with O_DIRECT, so reads bypass the page
+/// cache and every read is aligned to SAP_READER_ALIGN.
+///
+/// Scan threads take filled batches with sap_reader_next() and give them back
+/// with sap_reader_release(). A released buffer is refilled with the next part
+/// of the register at once. Batches are handed out in completion order.
+///
+/// Where io_uring is not available, for example under a seccomp filter, batches
+/// are read with pread() by the thread that asks for one. Several scan threads
+/// still keep several reads in flight then. Where the file system rejects
+/// O_DIRECT, the file is read through the page cache.
+
+/// @def SAP_READER_ALIGN
+/// @brief Alignment of file offsets, lengths and buffers of direct reads.
+#define SAP_READER_ALIGN 4096
+
+/// @brief Flags of sap_reader_config.
+enum {
+    SAP_READER_NO_URING = 1,    /**< Read with pread() even if io_uring is available. */
+    SAP_READER_NO_DIRECT = 2    /**< Read through the page cache. */
+};
+
+/// @brief Parameters of sap_reader_open().
+typedef struct {
+    const char* path;           /**< Register file (sap_corpus format). */
+    unsigned int queue_depth;   /**< Batches read ahead, 0 for 8. */
+    size_t batch_bytes;         /**< Ephemeral public key bytes per batch at most, 0 for 1 MiB. */
+    int flags;                  /**< SAP_READER_*. */
+} sap_reader_config;
+
+/// @brief Announcements read by one request, valid until released.
+typedef struct {
+    uint64_t begin;             /**< Register index of the first announcement. */
+    size_t n;                   /**< Number of announcements. */
+    const uint8_t* levels;      /**< Their levels (KYBER_K). */
+    const uint8_t* const* cts;  /**< Their ephemeral public keys. */
+    const uint8_t* tags;        /**< Their tags, CORPUS_TAG_BYTES each. */
+    const uint8_t* view_tags;   /**< The first byte of every tag, as sap_scan() takes them. */
+    unsigned int slot;          /**< Buffer the batch is in. */
+} sap_reader_batch;
+
+/// @brief How a reader does its I/O.
+typedef struct {
+    int uring;                  /**< 1 with io_uring, 0 with pread(). */
+    int direct;                 /**< 1 if the file is read with O_DIRECT. */
+    int registered;             /**< 1 if the buffers are registered with the ring. */
+    uint64_t reads;             /**< Read requests issued. */
+    uint64_t bytes;             /**< Bytes requested, with alignment. */
+} sap_reader_stats;
+
+typedef struct sap_reader sap_reader;
+
+/// @brief Opens a register file and starts reading it.
+///
+/// @return The reader, or NULL if the file is not a valid register or out of memory.
+sap_reader* sap_reader_open(const sap_reader_config* config);
+
+/// @brief Returns the number of announcements of the register.
+size_t sap_reader_entries(const sap_reader* r);
+
+/// @brief Takes the next filled batch; may be called from several threads.
+///
+/// @return 1 if @p b was filled, 0 once every batch was handed out, -1 on a read
+/// error (every later call fails as well).
+int sap_reader_next(sap_reader* r, sap_reader_batch* b);
+
+/// @brief Returns the buffer of a batch for the next read.
+void sap_reader_release(sap_reader* r, const sap_reader_batch* b);
+
+/// @brief Reports how the reader does its I/O.
+void sap_reader_get_stats(sap_reader* r, sap_reader_stats* stats);
+
+/// @brief Waits for the reads in flight and releases the reader.
+void sap_reader_close(sap_reader* r);
@@ -0,0 +1,425 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+extern "C" {
+#include "backend.h"
+#include "wipe.h"
+}
+
+/// @file sap.hpp
+/// @brief Header-only C++17 interface to the SAP protocol at all security levels.
+///
+/// The C API is selected by KYBER_K at compile time: protocol_api.h and the Kyber
+/// headers describe a single level, and the level-specific symbols carry the
+/// KYBER_NAMESPACE / SAP_NAMESPACE prefixes. libpqsap contains every level, so this
+/// layer talks to the per-level entry points directly (the backend tables of
+/// backend.h and the batch scan of scan.h) and turns the level into a template
+/// argument. Kyber512, Kyber768 and Kyber1024 can then be used side by side in one
+/// process, and all sizes and loop bounds are compile-time constants of sap::Params.
+///
+/// Buffers are strongly typed per level, secret keys and recipient contexts are
+/// move-only and wiped on destruction, and the batch functions take sap::span
+/// arguments. Size mismatches between batch arguments throw std::invalid_argument.
+
+extern "C" {
+// sap_scan_key_init() and sap_scan() of scan.h for every level; the prepared key is opaque here
+void pqsap_kyber512_scan_key_init(void* key, const uint8_t* v_priv);
+void pqsap_kyber768_scan_key_init(void* key, const uint8_t* v_priv);
+void pqsap_kyber1024_scan_key_init(void* key, const uint8_t* v_priv);
+size_t pqsap_kyber512_scan(uint8_t* hits, uint8_t* ss, const uint8_t* const* cts, const uint8_t* view_tags,
+    size_t n, const void* key);
+size_t pqsap_kyber768_scan(uint8_t* hits, uint8_t* ss, const uint8_t* const* cts, const uint8_t* view_tags,
+    size_t n, const void* key);
+size_t pqsap_kyber1024_scan(uint8_t* hits, uint8_t* ss, const uint8_t* const* cts, const uint8_t* view_tags,
+    size_t n, const void* key);
+}
+
+namespace sap {
+
+/// @brief Non-owning view of a contiguous sequence (the subset of std::span used here).
+template <typename T>
+class span {
+public:
+    constexpr span() noexcept = default;
+    constexpr span(T* data, std::size_t size) noexcept : data_(data), size_(size) {}
+    template <std::size_t N>
+    constexpr span(T (&a)[N]) noexcept : data_(a), size_(N) {}
+    /// Any container with data() and size(), e.g. std::vector and std::array.
+    template <typename C, typename = std::enable_if_t<std::is_convertible_v<
+                              decltype(std::declval<C&>().data()), T*>>>
+    constexpr span(C& c) noexcept : data_(c.data()), size_(c.size()) {}
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+    constexpr span(const span<U>& s) noexcept : data_(s.data()), size_(s.size()) {}
+
+    constexpr T* data() const noexcept { return data_; }
+    constexpr std::size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+    constexpr T& operator[](std::size_t i) const noexcept { return data_[i]; }
+    constexpr T* begin() const noexcept { return data_; }
+    constexpr T* end() const noexcept { return data_ + size_; }
+    constexpr span subspan(std::size_t offset, std::size_t count) const noexcept
+    {
+        return span(data_ + offset, count);
+    }
+
+private:
+    T* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+/// @brief Sizes of one parameter set, as in libs/params.h for KYBER_K = K.
+template <int K>
+struct Params {
+    static_assert(K == 2 || K == 3 || K == 4, "Kyber is defined for K = 2, 3 and 4");
+
+    static constexpr int k = K;
+    static constexpr const char* name = K == 2 ? "Kyber512" : K == 3 ? "Kyber768" : "Kyber1024";
+    static constexpr std::size_t n = 256;
+    static constexpr std::size_t symbytes = 32;
+    static constexpr std::size_t polybytes = 384;
+    static constexpr std::size_t shared_secret_bytes = 32;
+    static constexpr std::size_t public_key_bytes = K * polybytes + symbytes;
+    static constexpr std::size_t secret_key_bytes = 2 * K * polybytes + 3 * symbytes;
+    static constexpr std::size_t ciphertext_bytes = K == 4 ? K * 352 + 160 : K * 320 + 128;
+    static constexpr std::size_t stealth_address_bytes = K * polybytes;
+    /// sizeof(sap_scan_key), checked in scan.c.
+    static constexpr std::size_t scan_key_bytes = 4 * K * n + secret_key_bytes;
+    static constexpr std::size_t scan_lanes = 16;
+};
+
+namespace detail {
+
+/// The C entry points of one level.
+template <int K>
+struct Level;
+
+template <>
+struct Level<2> {
+    static const sap_backend* get(sap_backend_id id) { return pqsap_kyber512_backend_get(id); }
+    static const sap_backend* active() { return pqsap_kyber512_backend_active(); }
+    static constexpr auto scan_key_init = pqsap_kyber512_scan_key_init;
+    static constexpr auto scan = pqsap_kyber512_scan;
+};
+
+template <>
+struct Level<3> {
+    static const sap_backend* get(sap_backend_id id) { return pqsap_kyber768_backend_get(id); }
+    static const sap_backend* active() { return pqsap_kyber768_backend_active(); }
+    static constexpr auto scan_key_init = pqsap_kyber768_scan_key_init;
+    static constexpr auto scan = pqsap_kyber768_scan;
+};
+
+template <>
+struct Level<4> {
+    static const sap_backend* get(sap_backend_id id) { return pqsap_kyber1024_backend_get(id); }
+    static const sap_backend* active() { return pqsap_kyber1024_backend_active(); }
+    static constexpr auto scan_key_init = pqsap_kyber1024_scan_key_init;
+    static constexpr auto scan = pqsap_kyber1024_scan;
+};
+
+/// Clears secret memory with sap_wipe(), which the compiler cannot drop as a dead store.
+inline void wipe(void* p, std::size_t len) noexcept
+{
+    sap_wipe(p, len);
+}
+
+inline void require(bool ok, const char* what)
+{
+    if (!ok) throw std::invalid_argument(what);
+}
+
+/// Owning, wiped, move-only byte buffer on the heap.
+template <std::size_t N, std::size_t Align = alignof(std::max_align_t)>
+class SecretBuffer {
+public:
+    SecretBuffer() : p_(static_cast<std::uint8_t*>(::operator new(N, std::align_val_t(Align)))) {}
+    SecretBuffer(SecretBuffer&& o) noexcept : p_(std::exchange(o.p_, nullptr)) {}
+    SecretBuffer& operator=(SecretBuffer&& o) noexcept
+    {
+        if (this != &o) {
+            release();
+            p_ = std::exchange(o.p_, nullptr);
+        }
+        return *this;
+    }
+    SecretBuffer(const SecretBuffer&) = delete;
+    SecretBuffer& operator=(const SecretBuffer&) = delete;
+    ~SecretBuffer() { release(); }
+
+    std::uint8_t* data() noexcept { return p_; }
+    const std::uint8_t* data() const noexcept { return p_; }
+    explicit operator bool() const noexcept { return p_ != nullptr; }
+
+private:
+    void release() noexcept
+    {
+        if (p_ != nullptr) {
+            wipe(p_, N);
+            ::operator delete(p_, std::align_val_t(Align));
+            p_ = nullptr;
+        }
+    }
+
+    std::uint8_t* p_;
+};
+
+}  // namespace detail
+
+/// @brief Fixed-size byte string; the tag keeps equally sized kinds of data apart.
+template <std::size_t N, typename Tag>
+struct Bytes : std::array<std::uint8_t, N> {};
+
+struct PublicKeyTag;
+struct CiphertextTag;
+struct StealthAddressTag;
+struct SharedSecretTag;
+
+template <int K>
+using PublicKey = Bytes<Params<K>::public_key_bytes, PublicKeyTag>;
+template <int K>
+using Ciphertext = Bytes<Params<K>::ciphertext_bytes, CiphertextTag>;
+template <int K>
+using StealthAddress = Bytes<Params<K>::stealth_address_bytes, StealthAddressTag>;
+using SharedSecret = Bytes<32, SharedSecretTag>;
+
+static_assert(sizeof(SharedSecret) == 32, "batch functions treat arrays of Bytes as byte strings");
+
+/// @brief A Kyber secret key (crypto_kem_keypair() format); move-only, wiped on destruction.
+template <int K>
+class SecretKey {
+public:
+    static constexpr std::size_t size() noexcept { return Params<K>::secret_key_bytes; }
+
+    SecretKey() = default;
+    /// Copies a serialized key; throws std::invalid_argument if the length is wrong.
+    explicit SecretKey(span<const std::uint8_t> bytes)
+    {
+        detail::require(bytes.size() == size(), "sap::SecretKey: wrong length");
+        std::copy(bytes.begin(), bytes.end(), buf_.data());
+    }
+
+    std::uint8_t* data() noexcept { return buf_.data(); }
+    const std::uint8_t* data() const noexcept { return buf_.data(); }
+
+private:
+    detail::SecretBuffer<Params<K>::secret_key_bytes> buf_;
+};
+
+/// @brief A key pair; move-only through its secret key.
+template <int K>
+struct KeyPair {
+    PublicKey<K> pub;
+    SecretKey<K> sec;
+};
+
+/// @brief A recipient's published address: spend and view public keys.
+template <int K>
+struct MetaAddress {
+    PublicKey<K> spend;
+    PublicKey<K> view;
+};
+
+/// @brief What a sender publishes for one payment.
+template <int K>
+struct Announcement {
+    Ciphertext<K> ephemeral_pub_key;
+    StealthAddress<K> stealth_pub_key;
+    std::uint8_t view_tag;
+};
+
+/// @brief Sender-side operations of one level on one backend.
+///
+/// Move-only; a moved-from context must not be used.
+template <int K>
+class Context {
+public:
+    /// Uses the backend selected at startup (see backend.h).
+    Context() noexcept : backend_(detail::Level<K>::active()) {}
+    /// Uses a specific backend; throws std::invalid_argument if the CPU cannot run it.
+    explicit Context(sap_backend_id id) : backend_(detail::Level<K>::get(id))
+    {
+        detail::require(backend_ != nullptr && sap_backend_supported(id) != 0, "sap::Context: backend unavailable");
+    }
+    Context(Context&& o) noexcept : backend_(std::exchange(o.backend_, nullptr)) {}
+    Context& operator=(Context&& o) noexcept
+    {
+        if (this != &o) backend_ = std::exchange(o.backend_, nullptr);
+        return *this;
+    }
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
+    const sap_backend& backend() const noexcept { return *backend_; }
+
+    /// crypto_kem_keypair().
+    KeyPair<K> keypair() const
+    {
+        KeyPair<K> kp;
+        backend_->kem_keypair(kp.pub.data(), kp.sec.data());
+        return kp;
+    }
+
+    /// crypto_kem_keypair_derand() with 64 bytes of coins.
+    KeyPair<K> keypair(const std::array<std::uint8_t, 64>& coins) const
+    {
+        KeyPair<K> kp;
+        backend_->kem_keypair_derand(kp.pub.data(), kp.sec.data(), coins.data());
+        return kp;
+    }
+
+    /// calculate_stealth_pub_key().
+    StealthAddress<K> stealth_address(const SharedSecret& ss, const PublicKey<K>& spend) const
+    {
+        StealthAddress<K> r;
+        backend_->stealth_pub_key(r.data(), ss.data(), spend.data());
+        return r;
+    }
+
+    /// calculate_view_tag().
+    std::uint8_t view_tag(const SharedSecret& ss) const
+    {
+        std::uint8_t hash[32];
+        backend_->hash_shake128(hash, sizeof(hash), ss.data(), ss.size());
+        return hash[0];
+    }
+
+    /// calculate_view_tag() of every secret, hashing several per Keccak pass.
+    void view_tags(span<const SharedSecret> ss, span<std::uint8_t> tags) const
+    {
+        detail::require(ss.size() == tags.size(), "sap::Context::view_tags: size mismatch");
+        constexpr std::size_t chunk = 64;
+        std::uint8_t hash[chunk][32];
+        for (std::size_t i = 0; i < ss.size(); i += chunk) {
+            std::size_t m = std::min(chunk, ss.size() - i);
+            backend_->hash_ss_batch(hash[0], ss[i].data(), m);
+            for (std::size_t j = 0; j < m; j++) tags[i + j] = hash[j][0];
+        }
+    }
+
+    /// sender_computes_stealth_pub_key_and_viewtag() without the diagnostics.
+    Announcement<K> send(const MetaAddress<K>& to) const
+    {
+        Announcement<K> a;
+        SharedSecret ss;
+        backend_->kem_enc(a.ephemeral_pub_key.data(), ss.data(), to.view.data());
+        a.stealth_pub_key = stealth_address(ss, to.spend);
+        a.view_tag = view_tag(ss);
+        detail::wipe(ss.data(), ss.size());
+        return a;
+    }
+
+    /// send() for every address; the view tags are hashed in batches.
+    void send(span<const MetaAddress<K>> to, span<Announcement<K>> out) const
+    {
+        detail::require(to.size() == out.size(), "sap::Context::send: size mismatch");
+        constexpr std::size_t chunk = 64;
+        SharedSecret ss[chunk];
+        std::uint8_t tags[chunk];
+        for (std::size_t i = 0; i < to.size(); i += chunk) {
+            std::size_t m = std::min(chunk, to.size() - i);
+            for (std::size_t j = 0; j < m; j++) {
+                backend_->kem_enc(out[i + j].ephemeral_pub_key.data(), ss[j].data(), to[i + j].view.data());
+                out[i + j].stealth_pub_key = stealth_address(ss[j], to[i + j].spend);
+            }
+            view_tags(span<const SharedSecret>(ss, m), span<std::uint8_t>(tags, m));
+            for (std::size_t j = 0; j < m; j++) out[i + j].view_tag = tags[j];
+        }
+        detail::wipe(ss, sizeof(ss));
+    }
+
+private:
+    const sap_backend* backend_;
+};
+
+/// @brief Recipient side of one level: owns the view key, prepared for batch scanning.
+///
+/// Move-only; the key material is wiped on destruction. Scanning runs on the backend
+/// selected at startup, as sap_scan() does.
+template <int K>
+class Recipient {
+public:
+    Recipient(PublicKey<K> spend, SecretKey<K> view, Context<K> ctx = Context<K>())
+        : ctx_(std::move(ctx)), spend_(spend), view_(std::move(view))
+    {
+        detail::Level<K>::scan_key_init(scan_key_.data(), view_.data());
+    }
+
+    const PublicKey<K>& spend_key() const noexcept { return spend_; }
+    const Context<K>& context() const noexcept { return ctx_; }
+
+    /// recipient_computes_stealth_pub_key() if the view tag matches, otherwise nullopt.
+    std::optional<StealthAddress<K>> receive(const Announcement<K>& a) const
+    {
+        SharedSecret ss;
+        ctx_.backend().kem_dec(ss.data(), a.ephemeral_pub_key.data(), view_.data());
+        std::optional<StealthAddress<K>> r;
+        if (ctx_.view_tag(ss) == a.view_tag) r = ctx_.stealth_address(ss, spend_);
+        detail::wipe(ss.data(), ss.size());
+        return r;
+    }
+
+    /// sap_scan() over ciphertexts and their view tags.
+    ///
+    /// @param[out] hits hits[i] is 1 if announcement i is addressed to this recipient.
+    /// @param[out] ss Empty, or receives the shared secret of every hit.
+    /// @return The number of hits.
+    std::size_t scan(span<const Ciphertext<K>> cts, span<const std::uint8_t> view_tags, span<std::uint8_t> hits,
+        span<SharedSecret> ss = {}) const
+    {
+        detail::require(cts.size() == view_tags.size() && cts.size() == hits.size()
+                            && (ss.empty() || ss.size() == cts.size()),
+            "sap::Recipient::scan: size mismatch");
+        return scan_chunks(cts.size(), [&](std::size_t i) { return cts[i].data(); }, view_tags.data(), hits, ss);
+    }
+
+    /// sap_scan() over announcements.
+    std::size_t scan(span<const Announcement<K>> ann, span<std::uint8_t> hits, span<SharedSecret> ss = {}) const
+    {
+        detail::require(ann.size() == hits.size() && (ss.empty() || ss.size() == ann.size()),
+            "sap::Recipient::scan: size mismatch");
+        std::size_t found = 0;
+        std::uint8_t tags[chunk];
+        for (std::size_t i = 0; i < ann.size(); i += chunk) {
+            std::size_t m = std::min(chunk, ann.size() - i);
+            for (std::size_t j = 0; j < m; j++) tags[j] = ann[i + j].view_tag;
+            found += scan_chunks(m, [&](std::size_t j) { return ann[i + j].ephemeral_pub_key.data(); }, tags,
+                hits.subspan(i, m), ss.empty() ? ss : ss.subspan(i, m));
+        }
+        return found;
+    }
+
+    /// Announcements passed to sap_scan() at a time, a multiple of the scan lanes.
+    static constexpr std::size_t chunk = 16 * Params<K>::scan_lanes;
+
+private:
+    template <typename F>
+    std::size_t scan_chunks(std::size_t n, F ct, const std::uint8_t* view_tags, span<std::uint8_t> hits,
+        span<SharedSecret> ss) const
+    {
+        const std::uint8_t* ptrs[chunk];
+        std::size_t found = 0;
+        for (std::size_t i = 0; i < n; i += chunk) {
+            std::size_t m = std::min(chunk, n - i);
+            for (std::size_t j = 0; j < m; j++) ptrs[j] = ct(i + j);
+            found += detail::Level<K>::scan(hits.data() + i, ss.empty() ? nullptr : ss[i].data(), ptrs,
+                view_tags + i, m, scan_key_.data());
+        }
+        return found;
+    }
+
+    Context<K> ctx_;
+    PublicKey<K> spend_;
+    SecretKey<K> view_;
+    detail::SecretBuffer<Params<K>::scan_key_bytes, 32> scan_key_;
+};
+
+}  // namespace sap
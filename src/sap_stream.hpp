@@ -0,0 +1,219 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+#include "sap.hpp"
+
+/// @file sap_stream.hpp
+/// @brief C++20 coroutine interface that streams the matches of a scan.
+///
+/// sap::Recipient::scan() fills output arrays for the whole register before it
+/// returns. sap::scan_stream() instead returns a lazy sap::Generator that scans
+/// one chunk of Recipient<K>::chunk announcements at a time and yields every hit
+/// of the chunk before touching the next one, so a consumer (UI update, database
+/// writer, spend pipeline) starts on the first match while the rest of the register
+/// is still unscanned, and the memory in use does not grow with the register.
+///
+/// Nothing runs until the generator is first iterated. Destroying it cancels the
+/// scan: the coroutine frame is released at its current suspension point and the
+/// shared secrets it holds are wiped. The recipient and the scanned announcements
+/// are referenced, not copied, and must outlive the generator.
+
+namespace sap {
+
+/// @brief Minimal std::generator: a lazily evaluated, move-only input range.
+///
+/// Yielded values are referenced in the coroutine frame until the next resumption,
+/// so operator* gives mutable access and a consumer may move from it. An exception
+/// thrown by the coroutine is rethrown from begin() or operator++.
+template <typename T>
+class Generator {
+public:
+    struct promise_type {
+        T* value = nullptr;
+        std::exception_ptr error;
+
+        Generator get_return_object() noexcept
+        {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(T& v) noexcept
+        {
+            value = std::addressof(v);
+            return {};
+        }
+        std::suspend_always yield_value(T&& v) noexcept
+        {
+            value = std::addressof(v);
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { error = std::current_exception(); }
+    };
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+
+        iterator() noexcept = default;
+        explicit iterator(std::coroutine_handle<promise_type> h) noexcept : h_(h) {}
+
+        T& operator*() const noexcept { return *h_.promise().value; }
+        T* operator->() const noexcept { return h_.promise().value; }
+        iterator& operator++()
+        {
+            resume(h_);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        bool operator==(std::default_sentinel_t) const noexcept { return !h_ || h_.done(); }
+
+    private:
+        std::coroutine_handle<promise_type> h_;
+    };
+
+    Generator(Generator&& o) noexcept : h_(std::exchange(o.h_, nullptr)) {}
+    Generator& operator=(Generator&& o) noexcept
+    {
+        if (this != &o) {
+            if (h_) h_.destroy();
+            h_ = std::exchange(o.h_, nullptr);
+        }
+        return *this;
+    }
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+    ~Generator()
+    {
+        if (h_) h_.destroy();
+    }
+
+    /// Runs the coroutine up to its first yield; call once.
+    iterator begin()
+    {
+        resume(h_);
+        return iterator(h_);
+    }
+    std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+    explicit Generator(std::coroutine_handle<promise_type> h) noexcept : h_(h) {}
+
+    static void resume(std::coroutine_handle<promise_type> h)
+    {
+        h.resume();
+        if (h.done() && h.promise().error) std::rethrow_exception(std::exchange(h.promise().error, nullptr));
+    }
+
+    std::coroutine_handle<promise_type> h_;
+};
+
+/// @brief Owning handle to the shared secret of a match; move-only, wiped on destruction.
+class SharedSecretHandle {
+public:
+    explicit SharedSecretHandle(const SharedSecret& ss) { std::copy(ss.begin(), ss.end(), buf_.data()); }
+
+    static constexpr std::size_t size() noexcept { return 32; }
+    const std::uint8_t* data() const noexcept { return buf_.data(); }
+    /// A copy of the secret; the caller is responsible for wiping it.
+    SharedSecret get() const
+    {
+        SharedSecret ss;
+        std::copy(buf_.data(), buf_.data() + size(), ss.data());
+        return ss;
+    }
+
+private:
+    detail::SecretBuffer<32> buf_;
+};
+
+/// @brief One announcement addressed to the recipient.
+template <int K>
+struct Match {
+    std::size_t index;                  /**< Position in the scanned range. */
+    StealthAddress<K> stealth_pub_key;  /**< calculate_stealth_pub_key() of the shared secret. */
+    SharedSecretHandle shared_secret;
+};
+
+namespace detail {
+
+/// Wipes the shared secrets of a chunk when the coroutine frame goes away.
+template <std::size_t N>
+struct ChunkSecrets {
+    SharedSecret ss[N];
+    ~ChunkSecrets() { wipe(ss, sizeof(ss)); }
+};
+
+/// The coroutine behind scan_stream(); @p source scans m announcements from index i.
+template <int K, typename S>
+Generator<Match<K>> scan_chunks(const Recipient<K>& r, S source, std::size_t n)
+{
+    constexpr std::size_t chunk = Recipient<K>::chunk;
+    ChunkSecrets<chunk> secrets;
+    std::uint8_t hits[chunk];
+
+    for (std::size_t i = 0; i < n; i += chunk) {
+        std::size_t m = std::min(chunk, n - i);
+        if (source.scan(r, i, m, span<std::uint8_t>(hits, m), span<SharedSecret>(secrets.ss, m)) == 0) {
+            continue;
+        }
+        for (std::size_t j = 0; j < m; j++) {
+            if (!hits[j]) continue;
+            /* a named value: GCC 12 destroys temporaries of a co_yield operand twice */
+            Match<K> match { i + j, r.context().stealth_address(secrets.ss[j], r.spend_key()),
+                SharedSecretHandle(secrets.ss[j]) };
+            co_yield match;
+        }
+    }
+}
+
+template <int K>
+struct AnnouncementSource {
+    span<const Announcement<K>> ann;
+    std::size_t scan(const Recipient<K>& r, std::size_t i, std::size_t m, span<std::uint8_t> hits,
+        span<SharedSecret> ss) const
+    {
+        return r.scan(ann.subspan(i, m), hits, ss);
+    }
+};
+
+template <int K>
+struct CiphertextSource {
+    span<const Ciphertext<K>> cts;
+    span<const std::uint8_t> view_tags;
+    std::size_t scan(const Recipient<K>& r, std::size_t i, std::size_t m, span<std::uint8_t> hits,
+        span<SharedSecret> ss) const
+    {
+        return r.scan(cts.subspan(i, m), view_tags.subspan(i, m), hits, ss);
+    }
+};
+
+}  // namespace detail
+
+/// @brief Lazily scans announcements and yields the hits in order.
+template <int K>
+Generator<Match<K>> scan_stream(const Recipient<K>& r, std::type_identity_t<span<const Announcement<K>>> ann)
+{
+    return detail::scan_chunks<K>(r, detail::AnnouncementSource<K> { ann }, ann.size());
+}
+
+/// @brief Lazily scans ciphertexts with their view tags and yields the hits in order.
+///
+/// Throws std::invalid_argument right away if the lengths differ.
+template <int K>
+Generator<Match<K>> scan_stream(const Recipient<K>& r, std::type_identity_t<span<const Ciphertext<K>>> cts,
+    span<const std::uint8_t> view_tags)
+{
+    detail::require(cts.size() == view_tags.size(), "sap::scan_stream: size mismatch");
+    return detail::scan_chunks<K>(r, detail::CiphertextSource<K> { cts, view_tags }, cts.size());
+}
+
+}  // namespace sap
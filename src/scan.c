@@ -0,0 +1,444 @@
+#include "scan.h"
+#include "scan_mixed.h"
+#include "scan_stats.h"
+#include <immintrin.h>
+#include "ntt.h"
+#include "reduce.h"
+
+/*
+ * Compiled once per KYBER_K against the reference headers (KYBER_BACKEND_REF), so
+ * that zetas and the portable indcpa_dec() fallback are available. The kernels
+ * below are the loops of libs/ref with every int16_t coefficient replaced by a
+ * 16-lane vector holding that coefficient of 16 ciphertexts; they compute the
+ * same representatives as the reference code, lane by lane.
+ */
+
+#define AVX2 __attribute__((target("avx2")))
+
+/* sap.hpp allocates the key as opaque storage of this size */
+_Static_assert(sizeof(sap_scan_key) == 4 * KYBER_K * KYBER_N + SECRET_KEY_BYTES, "update sap::Params::scan_key_bytes");
+
+/// Rows of the 16x16 byte transpose, in the lane order its unpack network inverts.
+static const uint8_t transpose_rows[16] = { 0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15 };
+
+static AVX2 inline __m256i v_set1(int16_t c)
+{
+    return _mm256_set1_epi16(c);
+}
+
+/// montgomery_reduce(a * b) for a vector a and a scalar b, with bqinv = b * QINV.
+static AVX2 inline __m256i v_fqmul(__m256i a, int16_t b, int16_t bqinv)
+{
+    __m256i lo = _mm256_mullo_epi16(a, v_set1(bqinv));
+    __m256i hi = _mm256_mulhi_epi16(a, v_set1(b));
+    return _mm256_sub_epi16(hi, _mm256_mulhi_epi16(lo, v_set1(KYBER_Q)));
+}
+
+/// barrett_reduce() of every lane.
+static AVX2 inline __m256i v_barrett(__m256i a)
+{
+    __m256i t = _mm256_mulhi_epi16(a, v_set1(20159));
+    t = _mm256_mulhrs_epi16(t, v_set1(1 << 5));
+    return _mm256_sub_epi16(a, _mm256_mullo_epi16(t, v_set1(KYBER_Q)));
+}
+
+/// ((t & (2^d - 1)) * KYBER_Q + 2^(d-1)) >> d as one rounding multiplication.
+static AVX2 inline __m256i v_decompress(__m256i t, int d)
+{
+    t = _mm256_and_si256(t, v_set1((int16_t)((1 << d) - 1)));
+    return _mm256_mulhrs_epi16(_mm256_slli_epi16(t, 15 - d), v_set1(KYBER_Q));
+}
+
+/**
+ * Transposes @p len bytes (a multiple of 16) at offset @p off of the 16 ciphertexts,
+ * so that row i of @p t holds byte off + i of every lane.
+ */
+static AVX2 void transpose_bytes(uint8_t t[][SAP_SCAN_LANES], const uint8_t* const cts[SAP_SCAN_LANES],
+    size_t off, size_t len)
+{
+    for (size_t c = 0; c < len; c += 16) {
+        __m128i x[16], y[16];
+        for (int i = 0; i < 16; i++) {
+            x[i] = _mm_loadu_si128((const __m128i*)(cts[transpose_rows[i]] + off + c));
+        }
+        for (int i = 0; i < 8; i++) {
+            y[2 * i] = _mm_unpacklo_epi8(x[i], x[i + 8]);
+            y[2 * i + 1] = _mm_unpackhi_epi8(x[i], x[i + 8]);
+        }
+        for (int i = 0; i < 8; i++) {
+            x[2 * i] = _mm_unpacklo_epi16(y[i], y[i + 8]);
+            x[2 * i + 1] = _mm_unpackhi_epi16(y[i], y[i + 8]);
+        }
+        for (int i = 0; i < 8; i++) {
+            y[2 * i] = _mm_unpacklo_epi32(x[i], x[i + 8]);
+            y[2 * i + 1] = _mm_unpackhi_epi32(x[i], x[i + 8]);
+        }
+        for (int i = 0; i < 8; i++) {
+            _mm_store_si128((__m128i*)t[c + 2 * i], _mm_unpacklo_epi64(y[i], y[i + 8]));
+            _mm_store_si128((__m128i*)t[c + 2 * i + 1], _mm_unpackhi_epi64(y[i], y[i + 8]));
+        }
+    }
+}
+
+static AVX2 inline __m256i row(const uint8_t t[][SAP_SCAN_LANES], size_t i)
+{
+    return _mm256_cvtepu8_epi16(_mm_load_si128((const __m128i*)t[i]));
+}
+
+/// Polynomial k of polyvec_decompress() on transposed bytes.
+static AVX2 void v_polyvec_decompress(__m256i r[KYBER_N], const uint8_t t[][SAP_SCAN_LANES])
+{
+#if (KYBER_POLYVECCOMPRESSEDBYTES == (KYBER_K * 352))
+    for (int j = 0; j < KYBER_N / 8; j++) {
+        __m256i a[11];
+        for (int i = 0; i < 11; i++) a[i] = row(t, 11 * j + i);
+        __m256i* o = r + 8 * j;
+        o[0] = _mm256_or_si256(a[0], _mm256_slli_epi16(a[1], 8));
+        o[1] = _mm256_or_si256(_mm256_srli_epi16(a[1], 3), _mm256_slli_epi16(a[2], 5));
+        o[2] = _mm256_or_si256(_mm256_or_si256(_mm256_srli_epi16(a[2], 6), _mm256_slli_epi16(a[3], 2)),
+            _mm256_slli_epi16(a[4], 10));
+        o[3] = _mm256_or_si256(_mm256_srli_epi16(a[4], 1), _mm256_slli_epi16(a[5], 7));
+        o[4] = _mm256_or_si256(_mm256_srli_epi16(a[5], 4), _mm256_slli_epi16(a[6], 4));
+        o[5] = _mm256_or_si256(_mm256_or_si256(_mm256_srli_epi16(a[6], 7), _mm256_slli_epi16(a[7], 1)),
+            _mm256_slli_epi16(a[8], 9));
+        o[6] = _mm256_or_si256(_mm256_srli_epi16(a[8], 2), _mm256_slli_epi16(a[9], 6));
+        o[7] = _mm256_or_si256(_mm256_srli_epi16(a[9], 5), _mm256_slli_epi16(a[10], 3));
+        for (int i = 0; i < 8; i++) o[i] = v_decompress(o[i], 11);
+    }
+#elif (KYBER_POLYVECCOMPRESSEDBYTES == (KYBER_K * 320))
+    for (int j = 0; j < KYBER_N / 4; j++) {
+        __m256i a[5];
+        for (int i = 0; i < 5; i++) a[i] = row(t, 5 * j + i);
+        __m256i* o = r + 4 * j;
+        o[0] = _mm256_or_si256(a[0], _mm256_slli_epi16(a[1], 8));
+        o[1] = _mm256_or_si256(_mm256_srli_epi16(a[1], 2), _mm256_slli_epi16(a[2], 6));
+        o[2] = _mm256_or_si256(_mm256_srli_epi16(a[2], 4), _mm256_slli_epi16(a[3], 4));
+        o[3] = _mm256_or_si256(_mm256_srli_epi16(a[3], 6), _mm256_slli_epi16(a[4], 2));
+        for (int i = 0; i < 4; i++) o[i] = v_decompress(o[i], 10);
+    }
+#else
+#error "KYBER_POLYVECCOMPRESSEDBYTES needs to be in {320*KYBER_K, 352*KYBER_K}"
+#endif
+}
+
+/// poly_decompress() on transposed bytes.
+static AVX2 void v_poly_decompress(__m256i r[KYBER_N], const uint8_t t[][SAP_SCAN_LANES])
+{
+#if (KYBER_POLYCOMPRESSEDBYTES == 128)
+    for (int j = 0; j < KYBER_N / 2; j++) {
+        __m256i a = row(t, j);
+        r[2 * j] = v_decompress(a, 4);
+        r[2 * j + 1] = v_decompress(_mm256_srli_epi16(a, 4), 4);
+    }
+#elif (KYBER_POLYCOMPRESSEDBYTES == 160)
+    for (int j = 0; j < KYBER_N / 8; j++) {
+        __m256i a[5];
+        for (int i = 0; i < 5; i++) a[i] = row(t, 5 * j + i);
+        __m256i* o = r + 8 * j;
+        o[0] = a[0];
+        o[1] = _mm256_or_si256(_mm256_srli_epi16(a[0], 5), _mm256_slli_epi16(a[1], 3));
+        o[2] = _mm256_srli_epi16(a[1], 2);
+        o[3] = _mm256_or_si256(_mm256_srli_epi16(a[1], 7), _mm256_slli_epi16(a[2], 1));
+        o[4] = _mm256_or_si256(_mm256_srli_epi16(a[2], 4), _mm256_slli_epi16(a[3], 4));
+        o[5] = _mm256_srli_epi16(a[3], 1);
+        o[6] = _mm256_or_si256(_mm256_srli_epi16(a[3], 6), _mm256_slli_epi16(a[4], 2));
+        o[7] = _mm256_srli_epi16(a[4], 3);
+        for (int i = 0; i < 8; i++) o[i] = v_decompress(o[i], 5);
+    }
+#else
+#error "KYBER_POLYCOMPRESSEDBYTES needs to be in {128, 160}"
+#endif
+}
+
+/// poly_ntt(): ntt() followed by poly_reduce().
+static AVX2 void v_ntt(__m256i r[KYBER_N])
+{
+    unsigned int k = 1;
+    for (unsigned int len = 128; len >= 2; len >>= 1) {
+        for (unsigned int start = 0; start < KYBER_N; start += 2 * len) {
+            int16_t zeta = zetas[k++];
+            int16_t zqinv = (int16_t)(zeta * QINV);
+            for (unsigned int j = start; j < start + len; j++) {
+                __m256i t = v_fqmul(r[j + len], zeta, zqinv);
+                r[j + len] = _mm256_sub_epi16(r[j], t);
+                r[j] = _mm256_add_epi16(r[j], t);
+            }
+        }
+    }
+    for (int j = 0; j < KYBER_N; j++) r[j] = v_barrett(r[j]);
+}
+
+/// poly_invntt_tomont(): invntt() including the final multiplication by mont^2/128.
+static AVX2 void v_invntt(__m256i r[KYBER_N])
+{
+    const int16_t f = 1441;
+    unsigned int k = 127;
+    for (unsigned int len = 2; len <= 128; len <<= 1) {
+        for (unsigned int start = 0; start < KYBER_N; start += 2 * len) {
+            int16_t zeta = zetas[k--];
+            int16_t zqinv = (int16_t)(zeta * QINV);
+            for (unsigned int j = start; j < start + len; j++) {
+                __m256i t = r[j];
+                r[j] = v_barrett(_mm256_add_epi16(t, r[j + len]));
+                r[j + len] = v_fqmul(_mm256_sub_epi16(r[j + len], t), zeta, zqinv);
+            }
+        }
+    }
+    for (int j = 0; j < KYBER_N; j++) r[j] = v_fqmul(r[j], f, (int16_t)(f * QINV));
+}
+
+/**
+ * poly_basemul_montgomery() of the view secret polynomial @p s with @p b, added
+ * to @p acc (or stored into it for the first polynomial, @p first).
+ */
+static AVX2 void v_basemul_acc(__m256i acc[KYBER_N], const int16_t s[KYBER_N], const int16_t sq[KYBER_N],
+    const __m256i b[KYBER_N], int first)
+{
+    for (int i = 0; i < KYBER_N / 2; i++) {
+        int16_t zeta = (i & 1) ? (int16_t)-zetas[64 + i / 2] : zetas[64 + i / 2];
+        int16_t zqinv = (int16_t)(zeta * QINV);
+        const int16_t* a = s + 2 * i;
+        const int16_t* aq = sq + 2 * i;
+
+        __m256i r0 = v_fqmul(v_fqmul(b[2 * i + 1], a[1], aq[1]), zeta, zqinv);
+        r0 = _mm256_add_epi16(r0, v_fqmul(b[2 * i], a[0], aq[0]));
+        __m256i r1 = _mm256_add_epi16(v_fqmul(b[2 * i + 1], a[0], aq[0]), v_fqmul(b[2 * i], a[1], aq[1]));
+
+        if (first) {
+            acc[2 * i] = r0;
+            acc[2 * i + 1] = r1;
+        } else {
+            acc[2 * i] = _mm256_add_epi16(acc[2 * i], r0);
+            acc[2 * i + 1] = _mm256_add_epi16(acc[2 * i + 1], r1);
+        }
+    }
+}
+
+/// poly_tomsg() of every lane, including the uint32_t arithmetic of the reference code.
+static AVX2 void v_tomsg(uint8_t m[SAP_SCAN_LANES][KYBER_INDCPA_MSGBYTES], const __m256i r[KYBER_N])
+{
+    for (int i = 0; i < KYBER_N / 8; i++) {
+        __m256i acc = _mm256_setzero_si256();
+        for (int j = 0; j < 8; j++) {
+            __m256i c = r[8 * i + j];
+            __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(c));
+            __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(c, 1));
+            lo = _mm256_add_epi32(_mm256_slli_epi32(lo, 1), _mm256_set1_epi32(1665));
+            hi = _mm256_add_epi32(_mm256_slli_epi32(hi, 1), _mm256_set1_epi32(1665));
+            lo = _mm256_srli_epi32(_mm256_mullo_epi32(lo, _mm256_set1_epi32(80635)), 28);
+            hi = _mm256_srli_epi32(_mm256_mullo_epi32(hi, _mm256_set1_epi32(80635)), 28);
+            __m256i bit = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+            bit = _mm256_and_si256(bit, v_set1(1));
+            acc = _mm256_or_si256(acc, _mm256_slli_epi16(bit, j));
+        }
+        uint16_t bytes[SAP_SCAN_LANES];
+        _mm256_storeu_si256((__m256i*)bytes, acc);
+        for (int l = 0; l < SAP_SCAN_LANES; l++) m[l][i] = (uint8_t)bytes[l];
+    }
+}
+
+/**
+ * Workflow:
+ *  1. For each polynomial of u: transposes its compressed bytes, decompresses,
+ *     transforms to the NTT domain and accumulates the product with the view secret.
+ *  2. Reduces, transforms back and subtracts the product from the decompressed v.
+ *  3. Reduces and extracts the message bits of all lanes.
+ */
+static AVX2 void decrypt16_avx2(uint8_t m[SAP_SCAN_LANES][KYBER_INDCPA_MSGBYTES],
+    const uint8_t* const cts[SAP_SCAN_LANES], const sap_scan_key* key)
+{
+    enum { POLY_BYTES = KYBER_POLYVECCOMPRESSEDBYTES / KYBER_K };
+    _Static_assert(POLY_BYTES % 16 == 0 && KYBER_POLYCOMPRESSEDBYTES % 16 == 0,
+        "compressed polynomials must be whole 16-byte columns");
+
+    __m256i b[KYBER_N], acc[KYBER_N];
+    _Alignas(16) uint8_t t[POLY_BYTES][SAP_SCAN_LANES];
+
+    for (int k = 0; k < KYBER_K; k++) {
+        transpose_bytes(t, cts, k * POLY_BYTES, POLY_BYTES);
+        v_polyvec_decompress(b, t);
+        v_ntt(b);
+        v_basemul_acc(acc, key->s[k], key->s_qinv[k], b, k == 0);
+    }
+    for (int j = 0; j < KYBER_N; j++) acc[j] = v_barrett(acc[j]);
+    v_invntt(acc);
+
+    transpose_bytes(t, cts, KYBER_POLYVECCOMPRESSEDBYTES, KYBER_POLYCOMPRESSEDBYTES);
+    v_poly_decompress(b, t);
+    for (int j = 0; j < KYBER_N; j++) b[j] = v_barrett(_mm256_sub_epi16(b[j], acc[j]));
+
+    v_tomsg(m, b);
+}
+
+void sap_scan_key_init(sap_scan_key* key, const uint8_t v_priv[SECRET_KEY_BYTES])
+{
+    polyvec s;
+    polyvec_frombytes(&s, v_priv);
+    for (int k = 0; k < KYBER_K; k++) {
+        for (int j = 0; j < KYBER_N; j++) {
+            key->s[k][j] = s.vec[k].coeffs[j];
+            key->s_qinv[k][j] = (int16_t)(s.vec[k].coeffs[j] * QINV);
+        }
+    }
+    memcpy(key->v_priv, v_priv, SECRET_KEY_BYTES);
+}
+
+void sap_scan_decrypt16(uint8_t m[SAP_SCAN_LANES][KYBER_INDCPA_MSGBYTES],
+    const uint8_t* const cts[SAP_SCAN_LANES], const sap_scan_key* key)
+{
+    if (sap_backend_active()->id != SAP_BACKEND_REF) {
+        decrypt16_avx2(m, cts, key);
+        return;
+    }
+    for (int l = 0; l < SAP_SCAN_LANES; l++) {
+        indcpa_dec(m[l], cts[l], key->v_priv);
+    }
+}
+
+/**
+ * Workflow:
+ *  1. Decrypts the group of @p lanes announcements at @p i; the lanes past the
+ *     end repeat its first announcement.
+ *  2. Derives each candidate shared secret as in crypto_kem_dec(), the first half
+ *     of G(m || H(pk)), and hashes all candidates of the group into view tags.
+ *  3. Confirms every tag match with a full decapsulation and records the hit,
+ *     stopping after the lane of the @p limit-th hit.
+ *  4. Adds the counts and the cycles of the three stages to the thread's stats.
+ *
+ * @param[out] done Number of lanes recorded in @p hits.
+ * @return The number of hits.
+ */
+static size_t scan_group(uint8_t* hits, uint8_t* ss, const uint8_t* const* cts, const uint8_t* view_tags,
+    size_t i, size_t lanes, const sap_scan_key* key, size_t limit, size_t* done)
+{
+    const uint8_t* hpk = key->v_priv + SECRET_KEY_BYTES - 2 * KYBER_SYMBYTES;
+    size_t found = 0;
+
+    const uint8_t* group[SAP_SCAN_LANES];
+    for (size_t l = 0; l < SAP_SCAN_LANES; l++) {
+        group[l] = cts[i + (l < lanes ? l : 0)];
+    }
+
+    sap_stats_slot* stats = sap_stats_thread();
+    uint64_t t0 = sap_stats_cycles();
+    uint8_t m[SAP_SCAN_LANES][KYBER_INDCPA_MSGBYTES];
+    sap_scan_decrypt16(m, group, key);
+    uint64_t t1 = sap_stats_cycles();
+
+    uint8_t candidates[SAP_SCAN_LANES][SS_BYTES];
+    uint8_t tags[SAP_SCAN_LANES][32];
+    for (size_t l = 0; l < lanes; l++) {
+        uint8_t buf[2 * KYBER_SYMBYTES], kr[2 * KYBER_SYMBYTES];
+        memcpy(buf, m[l], KYBER_SYMBYTES);
+        memcpy(buf + KYBER_SYMBYTES, hpk, KYBER_SYMBYTES);
+        sap_sha3_512(kr, buf, sizeof(buf));
+        memcpy(candidates[l], kr, SS_BYTES);
+    }
+    sap_hash_ss_batch(tags[0], candidates[0], lanes);
+    uint64_t t2 = sap_stats_cycles();
+
+    size_t tag_hits = 0, l = 0;
+    for (; l < lanes && found < limit; l++) {
+        hits[i + l] = 0;
+        if (tags[l][0] != view_tags[i + l]) {
+            continue;
+        }
+
+        uint8_t confirmed[SS_BYTES], hash[32];
+        tag_hits++;
+        sap_kem_dec(confirmed, group[l], key->v_priv);
+        sap_shake128(hash, sizeof(hash), confirmed, SS_BYTES);
+        if (hash[0] == view_tags[i + l]) {
+            hits[i + l] = 1;
+            found++;
+            if (ss != NULL) {
+                memcpy(ss + (i + l) * SS_BYTES, confirmed, SS_BYTES);
+            }
+        }
+    }
+    *done = l;
+
+    sap_stats_add(stats, SAP_STAT_SCANNED, l);
+    sap_stats_add(stats, SAP_STAT_TAG_HITS, tag_hits);
+    sap_stats_add(stats, SAP_STAT_DECAPS, tag_hits);
+    sap_stats_add(stats, SAP_STAT_FALSE_POSITIVES, tag_hits - found);
+    sap_stats_add(stats, SAP_STAT_MATCHES, found);
+    sap_stats_add(stats, SAP_STAT_CYCLES_DECRYPT, t1 - t0);
+    sap_stats_add(stats, SAP_STAT_CYCLES_TAG, t2 - t1);
+    sap_stats_add(stats, SAP_STAT_CYCLES_CONFIRM, sap_stats_cycles() - t2);
+    return found;
+}
+
+size_t sap_scan(uint8_t* hits, uint8_t* ss, const uint8_t* const* cts, const uint8_t* view_tags,
+    size_t n, const sap_scan_key* key)
+{
+    size_t found = 0, done;
+    SAP_PROBE2(scan__start, n, KYBER_K);
+    for (size_t i = 0; i < n; i += SAP_SCAN_LANES) {
+        size_t lanes = n - i < SAP_SCAN_LANES ? n - i : SAP_SCAN_LANES;
+        found += scan_group(hits, ss, cts, view_tags, i, lanes, key, SIZE_MAX, &done);
+    }
+    SAP_PROBE2(scan__done, n, found);
+    return found;
+}
+
+/**
+ * Workflow:
+ *  1. Before every group, stops if the token is set or the deadline has passed.
+ *  2. Scans the group, cut short at the hit that reaches max_hits.
+ *  3. Advances the cursor past the lanes that were recorded.
+ */
+size_t sap_scan_until(uint8_t* hits, uint8_t* ss, const uint8_t* const* cts, const uint8_t* view_tags,
+    size_t n, const sap_scan_key* key, const sap_scan_limits* limits, sap_scan_cursor* cursor)
+{
+    static const sap_scan_limits none = { 0 };
+    if (limits == NULL) limits = &none;
+    size_t end = limits->end != 0 && limits->end < n ? limits->end : n;
+    size_t found = 0;
+    size_t begin = cursor->next;
+    SAP_PROBE2(scan__start, end - begin, KYBER_K);
+
+    while (cursor->next < end) {
+        if (limits->max_hits != 0 && cursor->hits >= limits->max_hits) {
+            cursor->status = SAP_SCAN_HIT_LIMIT;
+            break;
+        }
+        if (limits->cancel != NULL
+            && atomic_load_explicit(&limits->cancel->cancelled, memory_order_relaxed)) {
+            cursor->status = SAP_SCAN_CANCELLED;
+            break;
+        }
+        if (limits->deadline_ns != 0 && sap_scan_deadline_in(0) >= limits->deadline_ns) {
+            cursor->status = SAP_SCAN_DEADLINE;
+            break;
+        }
+
+        size_t lanes = end - cursor->next < SAP_SCAN_LANES ? end - cursor->next : SAP_SCAN_LANES;
+        size_t limit = limits->max_hits != 0 ? limits->max_hits - cursor->hits : SIZE_MAX, done;
+        size_t f = scan_group(hits, ss, cts, view_tags, cursor->next, lanes, key, limit, &done);
+        found += f;
+        cursor->hits += f;
+        cursor->next += done;
+    }
+    if (cursor->next >= end) {
+        cursor->status = limits->max_hits != 0 && cursor->hits >= limits->max_hits ? SAP_SCAN_HIT_LIMIT
+                                                                                    : SAP_SCAN_COMPLETE;
+    }
+    SAP_PROBE2(scan__done, cursor->next - begin, found);
+    return found;
+}
+
+static void scan_level_key_init(void* key, const uint8_t* v_priv)
+{
+    sap_scan_key_init(key, v_priv);
+}
+
+static size_t scan_level_scan(uint8_t* hits, uint8_t* ss, const uint8_t* const* cts, const uint8_t* view_tags,
+    size_t n, const void* key)
+{
+    return sap_scan(hits, ss, cts, view_tags, n, key);
+}
+
+const sap_scan_level SAP_NAMESPACE(scan_level) = {
+    KYBER_K, CIPHERTEXT_BYTES, SECRET_KEY_BYTES, sizeof(sap_scan_key), scan_level_key_init, scan_level_scan
+};
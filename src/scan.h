@@ -0,0 +1,143 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "protocol_api.h"
+
+/// @file scan.h
+/// @brief Batch scanning of announcements with one view key.
+///
+/// The single-ciphertext path decapsulates every announcement with sap_kem_dec()
+/// and hashes the shared secret into a view tag. The batch path decrypts
+/// SAP_SCAN_LANES ciphertexts at once: the announcements are transposed so that
+/// the 16 lanes of an AVX2 register hold the same coefficient of 16 ciphertexts,
+/// and polyvec_decompress(), the NTT, the base multiplication with the view secret
+/// (a broadcast scalar per coefficient), the inverse NTT and poly_tomsg() run on all
+/// of them with the same instructions and without any shuffles inside a polynomial.
+///
+/// A view tag is then derived from the shared secret the decrypted message commits
+/// to, skipping the re-encryption of the Fujisaki-Okamoto transform. Only
+/// announcements whose tag matches are decapsulated in full to confirm the hit, so
+/// the reported hits equal those of the single-ciphertext path for every
+/// well-formed ciphertext. (A ciphertext that fails re-encryption decapsulates to a
+/// pseudo-random secret whose tag matches by chance one time in 256; such false
+/// positives are not reported by the batch path.)
+///
+/// While the reference backend is active at this level (no AVX2, SAP_BACKEND=ref
+/// or sap_backend_use()), the same functions decrypt one ciphertext at a time with
+/// the portable code.
+
+/// @def SAP_SCAN_LANES
+/// @brief Number of announcements decrypted together.
+#define SAP_SCAN_LANES 16
+
+/// @brief A view key prepared for scanning.
+typedef struct {
+    int16_t s[KYBER_K][KYBER_N];        /**< View secret in the NTT domain (standard order). */
+    int16_t s_qinv[KYBER_K][KYBER_N];   /**< s * QINV mod 2^16, for Montgomery multiplication. */
+    uint8_t v_priv[SECRET_KEY_BYTES];   /**< The secret view key, used to confirm hits. */
+} sap_scan_key;
+
+#define sap_scan_key_init SAP_NAMESPACE(scan_key_init)
+/// @brief Unpacks a secret view key for sap_scan_decrypt16() and sap_scan().
+void sap_scan_key_init(sap_scan_key* key, const uint8_t v_priv[SECRET_KEY_BYTES]);
+
+#define sap_scan_decrypt16 SAP_NAMESPACE(scan_decrypt16)
+/// @brief Decrypts SAP_SCAN_LANES ciphertexts, as indcpa_dec() does for each one.
+///
+/// Follows the active backend: the AVX2 kernel for AVX2 and AVX-512, indcpa_dec()
+/// per lane for the reference backend.
+///
+/// @param[out] m The decrypted messages.
+/// @param[in] cts The ciphertexts; unused lanes may repeat a pointer.
+/// @param[in] key Prepared view key.
+void sap_scan_decrypt16(uint8_t m[SAP_SCAN_LANES][KYBER_INDCPA_MSGBYTES],
+    const uint8_t* const cts[SAP_SCAN_LANES], const sap_scan_key* key);
+
+#define sap_scan SAP_NAMESPACE(scan)
+/// @brief Finds the announcements addressed to a view key.
+///
+/// @param[out] hits hits[i] is set to 1 if announcement i carries the view tag of
+/// the view key, otherwise to 0.
+/// @param[out] ss If not NULL, receives the SS_BYTES shared secret of every hit at
+/// ss + i * SS_BYTES.
+/// @param[in] cts The n ephemeral public keys (ciphertexts).
+/// @param[in] view_tags The n view tags published with them.
+/// @param[in] n Number of announcements.
+/// @param[in] key Prepared view key.
+/// @return The number of hits.
+size_t sap_scan(uint8_t* hits, uint8_t* ss, const uint8_t* const* cts, const uint8_t* view_tags,
+    size_t n, const sap_scan_key* key);
+
+/// @brief Cancellation token shared between a scan and the thread that stops it.
+typedef struct {
+    atomic_int cancelled;
+} sap_scan_cancel;
+
+/// @brief Asks every scan that polls @p token to stop; callable from any thread.
+static inline void sap_scan_cancel_request(sap_scan_cancel* token)
+{
+    atomic_store_explicit(&token->cancelled, 1, memory_order_relaxed);
+}
+
+/// @brief Why sap_scan_until() returned.
+typedef enum {
+    SAP_SCAN_COMPLETE = 0,      /**< The whole range was scanned. */
+    SAP_SCAN_HIT_LIMIT,         /**< max_hits hits were found. */
+    SAP_SCAN_CANCELLED,         /**< The cancellation token was set. */
+    SAP_SCAN_DEADLINE           /**< The deadline passed. */
+} sap_scan_status;
+
+/// @brief When sap_scan_until() stops early. A zeroed struct sets no limit.
+typedef struct {
+    const sap_scan_cancel* cancel;  /**< Polled once per group of SAP_SCAN_LANES, or NULL. */
+    uint64_t deadline_ns;           /**< CLOCK_MONOTONIC time in nanoseconds, or 0. */
+    size_t max_hits;                /**< Stop at this total number of hits (1: first match), or 0. */
+    size_t end;                     /**< Stop before this index, or 0 for n. */
+} sap_scan_limits;
+
+/// @brief Position of a scan that can be resumed.
+typedef struct {
+    size_t next;                    /**< First announcement not scanned yet. */
+    size_t hits;                    /**< Hits found since sap_scan_cursor_init(). */
+    sap_scan_status status;         /**< Why the last call returned. */
+} sap_scan_cursor;
+
+/// @brief Starts a cursor at announcement @p begin.
+static inline void sap_scan_cursor_init(sap_scan_cursor* cursor, size_t begin)
+{
+    cursor->next = begin;
+    cursor->hits = 0;
+    cursor->status = SAP_SCAN_COMPLETE;
+}
+
+/// @brief Returns the CLOCK_MONOTONIC time @p ms milliseconds from now, for sap_scan_limits.
+static inline uint64_t sap_scan_deadline_in(uint64_t ms)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec + ms * 1000000u;
+}
+
+#define sap_scan_until SAP_NAMESPACE(scan_until)
+/// @brief sap_scan() that can stop early and be resumed.
+///
+/// Scans from cursor->next until the end of the range or a limit, in the same
+/// groups as sap_scan(). The token and the deadline are checked before every group,
+/// so a call overruns its deadline by at most one group. Calling again with the
+/// same cursor continues where the last call stopped; the results equal those of a
+/// single sap_scan() over the range.
+///
+/// @param[out] hits hits[i] is set for cursor->next <= i < the returned cursor->next.
+/// @param[out] ss As for sap_scan(), for the same indices.
+/// @param[in] cts The n ephemeral public keys (ciphertexts).
+/// @param[in] view_tags The n view tags published with them.
+/// @param[in] n Number of announcements.
+/// @param[in] key Prepared view key.
+/// @param[in] limits Stop conditions, or NULL for none.
+/// @param[in,out] cursor Where to start; on return where to resume, with the status.
+/// @return The number of hits found by this call.
+size_t sap_scan_until(uint8_t* hits, uint8_t* ss, const uint8_t* const* cts, const uint8_t* view_tags,
+    size_t n, const sap_scan_key* key, const sap_scan_limits* limits, sap_scan_cursor* cursor);
@@ -0,0 +1,100 @@
+#include "scan_mixed.h"
+#include "wipe.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const sap_scan_level* const scan_levels[SAP_SCAN_MIXED_LEVELS] = {
+    &pqsap_kyber512_scan_level, &pqsap_kyber768_scan_level, &pqsap_kyber1024_scan_level
+};
+
+int sap_scan_keyset_init(sap_scan_keyset* ks, const uint8_t* const v_priv[SAP_SCAN_MIXED_LEVELS])
+{
+    memset(ks, 0, sizeof(*ks));
+    for (int l = 0; l < SAP_SCAN_MIXED_LEVELS; l++) {
+        if (v_priv[l] == NULL) continue;
+
+        ks->keys[l] = malloc(scan_levels[l]->key_bytes);
+        if (ks->keys[l] == NULL) {
+            sap_scan_keyset_free(ks);
+            return -1;
+        }
+        scan_levels[l]->key_init(ks->keys[l], v_priv[l]);
+    }
+    return 0;
+}
+
+void sap_scan_keyset_free(sap_scan_keyset* ks)
+{
+    for (int l = 0; l < SAP_SCAN_MIXED_LEVELS; l++) {
+        if (ks->keys[l] == NULL) continue;
+
+        sap_wipe(ks->keys[l], scan_levels[l]->key_bytes);
+        free(ks->keys[l]);
+        ks->keys[l] = NULL;
+    }
+}
+
+/**
+ * Workflow:
+ *  1. Counts the announcements of every level and sorts their indices into one
+ *     bucket per level, plus a last bucket for invalid levels; the bucket is
+ *     computed arithmetically, so the pass has no data-dependent branch.
+ *  2. For every level with a key, gathers the ciphertexts and tags of up to
+ *     SAP_SCAN_MIXED_CHUNK announcements of its bucket, scans them with the
+ *     level's batch scanner and scatters the hits and shared secrets back.
+ */
+size_t sap_scan_mixed(uint8_t* hits, uint8_t* ss, const uint8_t* const* cts, const uint8_t* levels,
+    const uint8_t* view_tags, size_t n, const sap_scan_keyset* ks)
+{
+    size_t* order = malloc(n * sizeof(size_t) + 1);
+    if (order == NULL) {
+        return SIZE_MAX;
+    }
+    memset(hits, 0, n);
+
+    /* bucket b is counted in start[b + 2] and filled through start[b + 1] */
+    size_t start[SAP_SCAN_MIXED_LEVELS + 3] = { 0 };
+    for (size_t i = 0; i < n; i++) {
+        unsigned int b = (unsigned int)levels[i] - 2;
+        b = b < SAP_SCAN_MIXED_LEVELS ? b : SAP_SCAN_MIXED_LEVELS;
+        start[b + 2]++;
+    }
+    for (int b = 2; b < SAP_SCAN_MIXED_LEVELS + 3; b++) start[b] += start[b - 1];
+    for (size_t i = 0; i < n; i++) {
+        unsigned int b = (unsigned int)levels[i] - 2;
+        b = b < SAP_SCAN_MIXED_LEVELS ? b : SAP_SCAN_MIXED_LEVELS;
+        order[start[b + 1]++] = i;
+    }
+
+    const uint8_t* group[SAP_SCAN_MIXED_CHUNK];
+    uint8_t tags[SAP_SCAN_MIXED_CHUNK];
+    uint8_t found[SAP_SCAN_MIXED_CHUNK];
+    uint8_t secrets[SAP_SCAN_MIXED_CHUNK * 32];
+    size_t total = 0;
+
+    for (int l = 0; l < SAP_SCAN_MIXED_LEVELS; l++) {
+        if (ks->keys[l] == NULL) continue;
+
+        /* after the fill, bucket l spans [start[l], start[l + 1]) */
+        size_t end = start[l + 1];
+        for (size_t c = start[l]; c < end; c += SAP_SCAN_MIXED_CHUNK) {
+            size_t m = end - c < SAP_SCAN_MIXED_CHUNK ? end - c : SAP_SCAN_MIXED_CHUNK;
+            for (size_t j = 0; j < m; j++) {
+                group[j] = cts[order[c + j]];
+                tags[j] = view_tags[order[c + j]];
+            }
+            if (scan_levels[l]->scan(found, ss != NULL ? secrets : NULL, group, tags, m, ks->keys[l]) == 0) {
+                continue;
+            }
+            for (size_t j = 0; j < m; j++) {
+                if (!found[j]) continue;
+                hits[order[c + j]] = 1;
+                total++;
+                if (ss != NULL) memcpy(ss + order[c + j] * 32, secrets + j * 32, 32);
+            }
+        }
+    }
+
+    free(order);
+    return total;
+}
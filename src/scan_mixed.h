@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @file scan_mixed.h
+/// @brief Scanning of a register that mixes announcements of all security levels.
+///
+/// sap_scan() decrypts 16 ciphertexts of one level with the same instructions, so
+/// a register holding Kyber512, Kyber768 and Kyber1024 announcements cannot be fed
+/// to it entry by entry. sap_scan_mixed() first groups the indices by level with a
+/// counting sort whose bucket is looked up in a table rather than branched on, then
+/// hands every level a run of up to SAP_SCAN_MIXED_CHUNK announcements of that level
+/// at a time and scatters the results back to the register order. Every batch is
+/// as full as in a pure register, so the only overhead is the sort and the gather.
+///
+/// This header does not depend on KYBER_K; the per-level scanners are reached
+/// through the sap_scan_level tables.
+
+/// @def SAP_SCAN_MIXED_CHUNK
+/// @brief Announcements of one level passed to its scanner at a time (a multiple of 16).
+#define SAP_SCAN_MIXED_CHUNK 1024
+
+/// @def SAP_SCAN_MIXED_LEVELS
+/// @brief Number of security levels (KYBER_K = 2, 3 and 4).
+#define SAP_SCAN_MIXED_LEVELS 3
+
+/// @brief The batch scanner of one security level, with its key as an opaque blob.
+typedef struct {
+    uint32_t kyber_k;           /**< Security level (2, 3 or 4). */
+    size_t ct_bytes;            /**< Ciphertext size. */
+    size_t sk_bytes;            /**< Secret view key size. */
+    size_t key_bytes;           /**< Size of the prepared key (sap_scan_key). */
+    void (*key_init)(void* key, const uint8_t* v_priv);     /**< sap_scan_key_init() */
+    size_t (*scan)(uint8_t* hits, uint8_t* ss, const uint8_t* const* cts, const uint8_t* view_tags,
+        size_t n, const void* key);                         /**< sap_scan() */
+} sap_scan_level;
+
+extern const sap_scan_level pqsap_kyber512_scan_level;
+extern const sap_scan_level pqsap_kyber768_scan_level;
+extern const sap_scan_level pqsap_kyber1024_scan_level;
+
+/// @brief The prepared view keys of one recipient, one per level it scans.
+typedef struct {
+    void* keys[SAP_SCAN_MIXED_LEVELS];  /**< keys[k - 2] for level k, NULL if not scanned. */
+} sap_scan_keyset;
+
+/// @brief Prepares the view keys of a recipient for sap_scan_mixed().
+///
+/// @param[out] ks Key set; must be released with sap_scan_keyset_free().
+/// @param[in] v_priv v_priv[k - 2] is the secret view key of level k, or NULL if
+/// announcements of that level are to be skipped.
+/// @return 0 on success, -1 if out of memory.
+int sap_scan_keyset_init(sap_scan_keyset* ks, const uint8_t* const v_priv[SAP_SCAN_MIXED_LEVELS]);
+
+/// @brief Wipes and releases the keys of a key set.
+void sap_scan_keyset_free(sap_scan_keyset* ks);
+
+/// @brief Finds the announcements of a mixed register addressed to a recipient.
+///
+/// @param[out] hits hits[i] is set to 1 if announcement i is a hit, otherwise to 0
+/// (also for levels without a key and for invalid levels).
+/// @param[out] ss If not NULL, receives the 32-byte shared secret of every hit at
+/// ss + i * 32.
+/// @param[in] cts The n ephemeral public keys, each of the size of its level.
+/// @param[in] levels levels[i] is the security level (2, 3 or 4) of announcement i.
+/// @param[in] view_tags The n view tags.
+/// @param[in] n Number of announcements.
+/// @param[in] ks Prepared keys.
+/// @return The number of hits, or SIZE_MAX if out of memory.
+size_t sap_scan_mixed(uint8_t* hits, uint8_t* ss, const uint8_t* const* cts, const uint8_t* levels,
+    const uint8_t* view_tags, size_t n, const sap_scan_keyset* ks);
@@ -0,0 +1,139 @@
+#include "scan_sched.h"
+#include <stdlib.h>
+#include <string.h>
+
+/// Pass units per unit of cost, so that small costs over large weights still advance.
+#define SCHED_STRIDE_SCALE 1024
+
+void sap_sched_init(sap_sched* s, unsigned int tail_share)
+{
+    memset(s, 0, sizeof(*s));
+    if (tail_share == 0) tail_share = SAP_SCHED_DEFAULT_TAIL_SHARE;
+    if (tail_share > 99) tail_share = 99;
+    s->share[SAP_SCHED_TAIL] = tail_share;
+    s->share[SAP_SCHED_BACKFILL] = 100 - tail_share;
+}
+
+void sap_sched_free(sap_sched* s)
+{
+    free(s->entities);
+    s->entities = NULL;
+    s->n_entities = s->cap_entities = 0;
+}
+
+int sap_sched_add(sap_sched* s, sap_sched_entity* e, void* owner)
+{
+    if (s->n_entities == s->cap_entities) {
+        size_t cap = s->cap_entities ? 2 * s->cap_entities : 16;
+        sap_sched_entity** entities = realloc(s->entities, cap * sizeof(*entities));
+        if (entities == NULL) {
+            return -1;
+        }
+        s->entities = entities;
+        s->cap_entities = cap;
+    }
+    memset(e, 0, sizeof(*e));
+    e->owner = owner;
+    e->weight = SAP_SCHED_DEFAULT_WEIGHT;
+    e->queue = SAP_SCHED_IDLE;
+    s->entities[s->n_entities++] = e;
+    return 0;
+}
+
+void sap_sched_remove(sap_sched* s, sap_sched_entity* e)
+{
+    sap_sched_update(s, e, SAP_SCHED_IDLE, 0);
+    for (size_t i = 0; i < s->n_entities; i++) {
+        if (s->entities[i] == e) {
+            s->entities[i] = s->entities[--s->n_entities];
+            return;
+        }
+    }
+}
+
+void sap_sched_set_weight(sap_sched_entity* e, uint32_t weight)
+{
+    e->weight = weight > 0 ? weight : 1;
+}
+
+/**
+ * Workflow:
+ *  1. Leaves the old queue, if any.
+ *  2. Entering a queue that was empty: the queue's pass catches up with the other
+ *     queue's, so it cannot claim the time it was idle.
+ *  3. Entering from idle: the entity's pass catches up with the smallest pass in
+ *     its queue, and its queue delay starts. Moving from the other queue: the
+ *     entity takes the smallest pass, as its own counted in different time.
+ */
+void sap_sched_update(sap_sched* s, sap_sched_entity* e, int queue, uint64_t now)
+{
+    if (e->queue == queue) {
+        return;
+    }
+    int was_idle = e->queue == SAP_SCHED_IDLE;
+    if (!was_idle) {
+        s->runnable[e->queue]--;
+    }
+    e->queue = queue;
+    if (queue == SAP_SCHED_IDLE) {
+        e->ready = 0;
+        return;
+    }
+
+    int other = 1 - queue;
+    if (s->runnable[queue] == 0 && s->pass[queue] < s->pass[other]) {
+        s->pass[queue] = s->pass[other];
+    }
+    uint64_t min = UINT64_MAX;
+    for (size_t i = 0; i < s->n_entities; i++) {
+        const sap_sched_entity* o = s->entities[i];
+        if (o != e && o->queue == queue && o->pass < min) min = o->pass;
+    }
+    if (min != UINT64_MAX && (!was_idle || e->pass < min)) {
+        e->pass = min;
+    }
+    if (was_idle) {
+        e->ready = now > 0 ? now : 1;
+    }
+    s->runnable[queue]++;
+}
+
+sap_sched_entity* sap_sched_next(sap_sched* s)
+{
+    int queue;
+    if (s->runnable[SAP_SCHED_TAIL] > 0 && s->runnable[SAP_SCHED_BACKFILL] > 0) {
+        queue = s->pass[SAP_SCHED_TAIL] <= s->pass[SAP_SCHED_BACKFILL] ? SAP_SCHED_TAIL : SAP_SCHED_BACKFILL;
+    } else if (s->runnable[SAP_SCHED_TAIL] > 0) {
+        queue = SAP_SCHED_TAIL;
+    } else if (s->runnable[SAP_SCHED_BACKFILL] > 0) {
+        queue = SAP_SCHED_BACKFILL;
+    } else {
+        return NULL;
+    }
+
+    sap_sched_entity* best = NULL;
+    for (size_t i = 0; i < s->n_entities; i++) {
+        sap_sched_entity* e = s->entities[i];
+        if (e->queue == queue && (best == NULL || e->pass < best->pass)) best = e;
+    }
+    return best;
+}
+
+void sap_sched_charge(sap_sched* s, sap_sched_entity* e, uint64_t start, uint64_t cost)
+{
+    if (e->queue == SAP_SCHED_IDLE) {
+        return;
+    }
+    sap_sched_queue_stats* st = &s->stats[e->queue];
+    if (e->ready != 0) {
+        uint64_t wait = start > e->ready ? start - e->ready : 0;
+        st->waits++;
+        st->wait_sum += wait;
+        if (wait > st->wait_max) st->wait_max = wait;
+        e->ready = 0;
+    }
+    st->batches++;
+    st->cost += cost;
+    e->pass += cost * SCHED_STRIDE_SCALE / e->weight;
+    s->pass[e->queue] += cost * SCHED_STRIDE_SCALE / s->share[e->queue];
+}
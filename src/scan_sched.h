@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @file scan_sched.h
+/// @brief Weighted fair scheduling of scan batches across view keys.
+///
+/// A service that scans for many wallets has two kinds of work: following the
+/// tip of the register, where a new block should be scanned for every wallet
+/// within milliseconds, and backfilling, where a restoring wallet scans millions
+/// of old entries. Run first come first served, one restore delays payment
+/// detection for everybody.
+///
+/// Every scan key is an entity in one of two queues, SAP_SCHED_TAIL or
+/// SAP_SCHED_BACKFILL, and the caller runs one batch of the entity returned by
+/// sap_sched_next() at a time, so work is preempted at batch granularity. Both
+/// levels use stride scheduling: every batch advances the pass of its entity by
+/// cost / weight and the pass of its queue by cost / share, and the smallest pass
+/// runs next. While both queues have work the tail queue gets tail_share percent
+/// of the scan time; an idle queue leaves all of it to the other, and entities or
+/// queues that wake up do not bring credit from the time they were idle. A new
+/// block therefore waits for at most one backfill batch.
+///
+/// Costs are whatever the caller measures, normally nanoseconds of scan time.
+/// The scheduler is not thread-safe.
+
+/// @brief Queues, and the state of an entity without work.
+enum {
+    SAP_SCHED_TAIL = 0,         /**< Latency-sensitive work near the register tip. */
+    SAP_SCHED_BACKFILL = 1,     /**< Bulk work far behind the tip. */
+    SAP_SCHED_QUEUES = 2,
+    SAP_SCHED_IDLE = -1         /**< Nothing to scan. */
+};
+
+/// @def SAP_SCHED_DEFAULT_WEIGHT
+/// @brief Weight of an entity unless set otherwise.
+#define SAP_SCHED_DEFAULT_WEIGHT 100
+
+/// @def SAP_SCHED_DEFAULT_TAIL_SHARE
+/// @brief Percentage of the scan time given to the tail queue while both have work.
+#define SAP_SCHED_DEFAULT_TAIL_SHARE 90
+
+/// @brief A schedulable unit of work, normally embedded in a scan key.
+typedef struct {
+    void* owner;            /**< Caller's object. */
+    uint32_t weight;        /**< Relative share within its queue (at least 1). */
+    int queue;              /**< SAP_SCHED_TAIL, SAP_SCHED_BACKFILL or SAP_SCHED_IDLE. */
+    uint64_t pass;          /**< Virtual time of the entity within its queue. */
+    uint64_t ready;         /**< Time it became runnable, until its first batch; 0 otherwise. */
+} sap_sched_entity;
+
+/// @brief Counters of one queue.
+typedef struct {
+    uint64_t batches;       /**< Batches charged (a batch shared by n entities counts n times). */
+    uint64_t cost;          /**< Total cost charged. */
+    uint64_t waits;         /**< Entities that became runnable and then ran. */
+    uint64_t wait_sum;      /**< Total queue delay of those entities. */
+    uint64_t wait_max;      /**< Largest queue delay. */
+} sap_sched_queue_stats;
+
+/// @brief Scheduler state.
+typedef struct {
+    unsigned int share[SAP_SCHED_QUEUES];       /**< Percent of the scan time per queue. */
+    uint64_t pass[SAP_SCHED_QUEUES];            /**< Virtual time of each queue. */
+    size_t runnable[SAP_SCHED_QUEUES];          /**< Entities in each queue. */
+    sap_sched_entity** entities;
+    size_t n_entities, cap_entities;
+    sap_sched_queue_stats stats[SAP_SCHED_QUEUES];
+} sap_sched;
+
+/// @brief Initializes a scheduler.
+/// @param tail_share Percentage for the tail queue, clamped to 1..99; 0 selects
+/// SAP_SCHED_DEFAULT_TAIL_SHARE.
+void sap_sched_init(sap_sched* s, unsigned int tail_share);
+
+/// @brief Releases the entity list (not the entities).
+void sap_sched_free(sap_sched* s);
+
+/// @brief Adds an idle entity with SAP_SCHED_DEFAULT_WEIGHT; returns 0, or -1 if out of memory.
+int sap_sched_add(sap_sched* s, sap_sched_entity* e, void* owner);
+
+/// @brief Removes an entity.
+void sap_sched_remove(sap_sched* s, sap_sched_entity* e);
+
+/// @brief Sets the weight of an entity (0 is taken as 1).
+void sap_sched_set_weight(sap_sched_entity* e, uint32_t weight);
+
+/// @brief Moves an entity to a queue, or makes it idle.
+///
+/// An entity that becomes runnable starts its queue delay at @p now and gets the
+/// smallest pass of the runnable entities of its queue if its own is behind.
+void sap_sched_update(sap_sched* s, sap_sched_entity* e, int queue, uint64_t now);
+
+/// @brief Returns the entity whose batch runs next, or NULL if all are idle.
+sap_sched_entity* sap_sched_next(sap_sched* s);
+
+/// @brief Charges a batch to an entity and to its queue.
+///
+/// @param start When the batch started; ends the queue delay of a newly runnable entity.
+/// @param cost Cost of the batch, or the entity's part of a batch shared by several.
+void sap_sched_charge(sap_sched* s, sap_sched_entity* e, uint64_t start, uint64_t cost);
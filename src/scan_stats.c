@@ -0,0 +1,186 @@
+#include "scan_stats.h"
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+/* slots[SAP_STATS_THREADS] is shared by the threads that found no free slot */
+static sap_stats_slot slots[SAP_STATS_THREADS + 1];
+static _Atomic size_t slots_used;
+static _Thread_local sap_stats_slot* self;
+static pthread_key_t exit_key;
+static pthread_once_t exit_once = PTHREAD_ONCE_INIT;
+
+static const char* const names[SAP_STAT_COUNTERS] = {
+    "scanned", "tag_hits", "decaps", "false_positives", "matches",
+    "decrypt_cycles", "tag_cycles", "confirm_cycles", "io_wait_cycles"
+};
+
+static void release_slot(void* slot)
+{
+    atomic_store(&((sap_stats_slot*)slot)->used, 0);
+}
+
+static void create_exit_key(void)
+{
+    pthread_key_create(&exit_key, release_slot);
+}
+
+/**
+ * Workflow:
+ *  1. Takes the first free slot and makes the thread hand it back when it exits.
+ *  2. Falls back to the shared slot if all of them are taken.
+ */
+sap_stats_slot* sap_stats_thread(void)
+{
+    if (self != NULL) {
+        return self;
+    }
+    pthread_once(&exit_once, create_exit_key);
+    for (size_t i = 0; i < SAP_STATS_THREADS; i++) {
+        int free_slot = 0;
+        if (atomic_compare_exchange_strong(&slots[i].used, &free_slot, 1)) {
+            self = &slots[i];
+            pthread_setspecific(exit_key, self);
+            size_t used = atomic_load(&slots_used);
+            while (used < i + 1 && !atomic_compare_exchange_weak(&slots_used, &used, i + 1)) {
+            }
+            return self;
+        }
+    }
+    self = &slots[SAP_STATS_THREADS];
+    atomic_store(&slots_used, SAP_STATS_THREADS + 1);
+    return self;
+}
+
+const char* sap_stats_name(sap_stats_counter c)
+{
+    return (unsigned int)c < SAP_STAT_COUNTERS ? names[c] : "unknown";
+}
+
+static void read_slot(sap_scan_stats* s, const sap_stats_slot* slot)
+{
+    for (int c = 0; c < SAP_STAT_COUNTERS; c++) {
+        s->v[c] = atomic_load_explicit(&slot->v[c], memory_order_relaxed);
+    }
+}
+
+void sap_stats_get(sap_scan_stats* total)
+{
+    memset(total, 0, sizeof(*total));
+    size_t n = atomic_load(&slots_used);
+    for (size_t i = 0; i < n; i++) {
+        sap_scan_stats s;
+        read_slot(&s, &slots[i]);
+        for (int c = 0; c < SAP_STAT_COUNTERS; c++) total->v[c] += s.v[c];
+    }
+}
+
+size_t sap_stats_get_threads(sap_scan_stats* per_thread, size_t max)
+{
+    size_t n = atomic_load(&slots_used);
+    for (size_t i = 0; i < n && i < max; i++) read_slot(&per_thread[i], &slots[i]);
+    return n;
+}
+
+void sap_stats_reset(void)
+{
+    for (size_t i = 0; i <= SAP_STATS_THREADS; i++) {
+        for (int c = 0; c < SAP_STAT_COUNTERS; c++) atomic_store_explicit(&slots[i].v[c], 0, memory_order_relaxed);
+    }
+}
+
+static int print_line(FILE* out, const char* label, const sap_scan_stats* s)
+{
+    int ret = fprintf(out, "%s", label);
+    for (int c = 0; ret >= 0 && c < SAP_STAT_COUNTERS; c++) {
+        ret = fprintf(out, " %s=%llu", names[c], (unsigned long long)s->v[c]);
+    }
+    return ret < 0 || fputc('\n', out) == EOF ? -1 : 0;
+}
+
+int sap_stats_print(FILE* out)
+{
+    sap_scan_stats total;
+    sap_stats_get(&total);
+    int ret = print_line(out, "scan stats: total", &total);
+
+    size_t n = atomic_load(&slots_used);
+    for (size_t i = 0; ret == 0 && i < n; i++) {
+        sap_scan_stats s;
+        read_slot(&s, &slots[i]);
+        char label[32];
+        snprintf(label, sizeof(label), "scan stats: %s %zu", i < SAP_STATS_THREADS ? "thread" : "shared", i);
+        ret = print_line(out, label, &s);
+    }
+    return ret == 0 && fflush(out) == 0 ? 0 : -1;
+}
+
+/* ---- periodic dump ---- */
+
+static pthread_mutex_t dump_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t dump_stop_cond;
+static pthread_t dump_thread;
+static int dump_running, dump_stopping;
+static FILE* dump_out;
+static unsigned int dump_interval_ms;
+
+static void* dump_loop(void* arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&dump_lock);
+    while (!dump_stopping) {
+        struct timespec at;
+        clock_gettime(CLOCK_MONOTONIC, &at);
+        at.tv_sec += dump_interval_ms / 1000;
+        at.tv_nsec += (long)(dump_interval_ms % 1000) * 1000000;
+        if (at.tv_nsec >= 1000000000) {
+            at.tv_sec++;
+            at.tv_nsec -= 1000000000;
+        }
+        while (!dump_stopping && pthread_cond_timedwait(&dump_stop_cond, &dump_lock, &at) != ETIMEDOUT) {
+        }
+        sap_stats_print(dump_out);
+    }
+    pthread_mutex_unlock(&dump_lock);
+    return NULL;
+}
+
+int sap_stats_dump_start(FILE* out, unsigned int interval_ms)
+{
+    pthread_mutex_lock(&dump_lock);
+    int ret = -1;
+    if (!dump_running) {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&dump_stop_cond, &attr);
+        pthread_condattr_destroy(&attr);
+        dump_out = out;
+        dump_interval_ms = interval_ms > 0 ? interval_ms : 1;
+        dump_stopping = 0;
+        ret = pthread_create(&dump_thread, NULL, dump_loop, NULL) == 0 ? 0 : -1;
+        dump_running = ret == 0;
+        if (ret != 0) pthread_cond_destroy(&dump_stop_cond);
+    }
+    pthread_mutex_unlock(&dump_lock);
+    return ret;
+}
+
+void sap_stats_dump_stop(void)
+{
+    pthread_mutex_lock(&dump_lock);
+    if (!dump_running) {
+        pthread_mutex_unlock(&dump_lock);
+        return;
+    }
+    dump_stopping = 1;
+    pthread_cond_signal(&dump_stop_cond);
+    pthread_mutex_unlock(&dump_lock);
+    pthread_join(dump_thread, NULL);
+
+    pthread_mutex_lock(&dump_lock);
+    pthread_cond_destroy(&dump_stop_cond);
+    dump_running = 0;
+    pthread_mutex_unlock(&dump_lock);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <x86intrin.h>
+
+/// @file scan_stats.h
+/// @brief Counters of the scan path, kept per thread and read by operators.
+///
+/// sap_scan() counts the announcements it scans, the view tags that match, the
+/// full decapsulations that confirm them, the false positives among them and
+/// the matches. It also adds up the TSC cycles of each stage: batch decryption,
+/// candidate derivation with view-tag hashing, and confirmation. The register
+/// reader and the shared-memory ring add the cycles their callers spend waiting
+/// for data.
+///
+/// Every thread counts into its own slot, on its own cache lines, so counting
+/// costs a few uncontended additions per group of SAP_SCAN_LANES announcements.
+/// Slots are given out on first use and handed back when the thread exits; a
+/// thread that takes a slot over keeps adding to its counts, so the totals
+/// never go back. sap_stats_get() adds all slots up, and
+/// sap_stats_dump_start() writes them to a stream at an interval.
+
+/// @def SAP_STATS_THREADS
+/// @brief Number of per-thread slots; further threads share one more slot.
+#define SAP_STATS_THREADS 256
+
+/// @brief The counters, in the order of sap_scan_stats::v.
+typedef enum {
+    SAP_STAT_SCANNED,           /**< Announcements scanned. */
+    SAP_STAT_TAG_HITS,          /**< Announcements whose candidate view tag matched. */
+    SAP_STAT_DECAPS,            /**< Full decapsulations to confirm a tag hit. */
+    SAP_STAT_FALSE_POSITIVES,   /**< Tag hits the decapsulation did not confirm. */
+    SAP_STAT_MATCHES,           /**< Confirmed hits. */
+    SAP_STAT_CYCLES_DECRYPT,    /**< Batch decryption. */
+    SAP_STAT_CYCLES_TAG,        /**< Candidate shared secrets and their view tags. */
+    SAP_STAT_CYCLES_CONFIRM,    /**< Decapsulation of the tag hits. */
+    SAP_STAT_CYCLES_IO_WAIT,    /**< Waiting for the register reader or the shared-memory ring. */
+    SAP_STAT_COUNTERS
+} sap_stats_counter;
+
+/// @brief A snapshot of the counters.
+typedef struct {
+    uint64_t v[SAP_STAT_COUNTERS];
+} sap_scan_stats;
+
+/// @brief The counters of one thread.
+typedef struct {
+    _Alignas(64) _Atomic uint64_t v[SAP_STAT_COUNTERS];
+    _Atomic int used;
+} sap_stats_slot;
+
+/// @brief Returns the slot of the calling thread, taking one on the first call.
+sap_stats_slot* sap_stats_thread(void);
+
+/// @brief Adds @p n to a counter of a slot.
+static inline void sap_stats_add(sap_stats_slot* s, sap_stats_counter c, uint64_t n)
+{
+    atomic_fetch_add_explicit(&s->v[c], n, memory_order_relaxed);
+}
+
+/// @brief Returns the time stamp counter, for the cycle counters.
+static inline uint64_t sap_stats_cycles(void)
+{
+    return __rdtsc();
+}
+
+/// @brief Returns the name of a counter, as printed by sap_stats_print().
+const char* sap_stats_name(sap_stats_counter c);
+
+/// @brief Adds up the counters of all threads.
+void sap_stats_get(sap_scan_stats* total);
+
+/// @brief Copies the counters of every slot that was ever used.
+///
+/// @param[out] per_thread Receives up to @p max snapshots; the last one is the
+/// shared slot if more than SAP_STATS_THREADS threads counted.
+/// @return The number of slots that were ever used.
+size_t sap_stats_get_threads(sap_scan_stats* per_thread, size_t max);
+
+/// @brief Sets all counters to zero; additions made at the same time may be lost.
+void sap_stats_reset(void);
+
+/// @brief Writes the totals, then one line per slot that was ever used.
+///
+/// @return 0 on success, -1 on a write error.
+int sap_stats_print(FILE* out);
+
+/// @brief Starts a thread that calls sap_stats_print() every @p interval_ms milliseconds.
+///
+/// @return 0 on success, -1 if a dump thread is already running or cannot be started.
+int sap_stats_dump_start(FILE* out, unsigned int interval_ms);
+
+/// @brief Stops the dump thread after one last dump.
+void sap_stats_dump_stop(void);
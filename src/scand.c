@@ -0,0 +1,932 @@
+#include "scand.h"
+#include "backend.h"
+#include "corpus.h"
+#include "keyblob.h"
+#include "scan_mixed.h"
+#include "scan_sched.h"
+#include "wipe.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+/// Largest and default sap_scand_config::chunk_entries; sizes the per-chunk buffers.
+#define SCAND_CHUNK 1024
+/// Default of sap_scand_config::tail_entries.
+#define SCAND_TAIL_ENTRIES (16 * SCAND_CHUNK)
+/// A client whose unsent output exceeds this is disconnected.
+#define SCAND_MAX_BACKLOG (4u << 20)
+#define SCAND_MAX_CLIENTS 256
+
+typedef struct {
+    uint64_t index;
+    uint8_t ss[32];
+    uint8_t stealth_pub_key[SAP_SCAND_STEALTH_BYTES(4)];
+} scand_match;
+
+typedef struct {
+    uint32_t id;
+    uint32_t kyber_k;
+    int from_file;
+    int mapped;                 /**< spend_pub and scan_key point into the daemon's key blob. */
+    int keep;                   /**< Scratch flag of reload_keys(). */
+    int in_batch;               /**< Scratch flag of scan_step(). */
+    size_t batch_end;           /**< Scratch of scan_step(): where the key's scan stopped. */
+    sap_sched_entity sched;
+    uint8_t* spend_pub;
+    void* scan_key;             /**< Prepared view key; it holds the secret view key too. */
+    size_t next;                /**< Next register entry to scan. */
+    scand_match* matches;
+    size_t n_matches, cap_matches;
+} scand_key;
+
+typedef struct {
+    int fd;
+    uint8_t* in;
+    size_t in_len, in_cap;
+    uint8_t* out;
+    size_t out_len, out_cap;
+    uint32_t* subs;
+    size_t n_subs;
+    int failed;                 /**< An event could not be queued; dropped by the loop. */
+    int waiting;                /**< A QUERY is held until its key catches up; later requests wait. */
+    uint32_t wait_key;
+    uint64_t wait_from;
+    uint64_t wait_until;        /**< now_ns() at which the QUERY is answered anyway. */
+} scand_client;
+
+struct sap_scand {
+    sap_scand_config config;
+    int listen_fd;
+    _Atomic int stop_requested;
+    _Atomic int reload_requested;
+
+    scand_key** keys;
+    size_t n_keys, cap_keys;
+    uint32_t next_id;
+    sap_sched sched;
+
+    scand_client* clients[SCAND_MAX_CLIENTS];
+    size_t n_clients;
+
+    corpus reg;
+    int have_reg;
+    struct stat reg_stat;
+    sap_keyblob blob;           /**< The key file, if it is a key blob. */
+    int have_blob;
+
+    /* scan_step() scratch: one chunk grouped by level */
+    const uint8_t* cts[SAP_SCAN_MIXED_LEVELS][SCAND_CHUNK];
+    uint8_t tags[SAP_SCAN_MIXED_LEVELS][SCAND_CHUNK];
+    uint32_t index[SAP_SCAN_MIXED_LEVELS][SCAND_CHUNK];
+    uint8_t hits[SCAND_CHUNK];
+    uint8_t ss[SCAND_CHUNK * 32];
+};
+
+static const sap_scan_level* const scan_levels[SAP_SCAN_MIXED_LEVELS] = {
+    &pqsap_kyber512_scan_level, &pqsap_kyber768_scan_level, &pqsap_kyber1024_scan_level
+};
+
+static const sap_backend* level_backend(uint32_t kyber_k)
+{
+    switch (kyber_k) {
+    case 2: return pqsap_kyber512_backend_active();
+    case 3: return pqsap_kyber768_backend_active();
+    default: return pqsap_kyber1024_backend_active();
+    }
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+/* ---- keys ---- */
+
+static void key_free(scand_key* k)
+{
+    const sap_scan_level* level = scan_levels[k->kyber_k - 2];
+    if (!k->mapped) {
+        sap_wipe(k->scan_key, level->key_bytes);
+        free(k->spend_pub);
+        free(k->scan_key);
+    }
+    if (k->matches != NULL) sap_wipe(k->matches, k->cap_matches * sizeof(scand_match));
+    free(k->matches);
+    free(k);
+}
+
+/**
+ * Parses a REGISTER body (u8 kyber_k, spend public key, secret view key) into a new
+ * key with its view key prepared for scanning.
+ *
+ * @return The key, or NULL if the body is malformed or out of memory.
+ */
+static scand_key* key_parse(const uint8_t* body, size_t len, size_t* used)
+{
+    size_t ct_bytes, pk_bytes, sk_bytes;
+    if (len < 1 || corpus_level_sizes(body[0], &ct_bytes, &pk_bytes, &sk_bytes) != 0
+        || len < 1 + pk_bytes + sk_bytes) {
+        return NULL;
+    }
+
+    const sap_scan_level* level = scan_levels[body[0] - 2];
+    scand_key* k = calloc(1, sizeof(*k));
+    if (k == NULL) {
+        return NULL;
+    }
+    k->kyber_k = body[0];
+    k->spend_pub = malloc(pk_bytes);
+    k->scan_key = malloc(level->key_bytes);
+    if (k->spend_pub == NULL || k->scan_key == NULL) {
+        free(k->spend_pub);
+        free(k->scan_key);
+        free(k);
+        return NULL;
+    }
+    memcpy(k->spend_pub, body + 1, pk_bytes);
+    level->key_init(k->scan_key, body + 1 + pk_bytes);
+    *used = 1 + pk_bytes + sk_bytes;
+    return k;
+}
+
+static int key_add(sap_scand* d, scand_key* k)
+{
+    if (d->n_keys == d->cap_keys) {
+        size_t cap = d->cap_keys ? 2 * d->cap_keys : 16;
+        scand_key** keys = realloc(d->keys, cap * sizeof(*keys));
+        if (keys == NULL) {
+            return -1;
+        }
+        d->keys = keys;
+        d->cap_keys = cap;
+    }
+    if (sap_sched_add(&d->sched, &k->sched, k) != 0) {
+        return -1;
+    }
+    k->id = ++d->next_id;
+    d->keys[d->n_keys++] = k;
+    return 0;
+}
+
+static scand_key* key_find(sap_scand* d, uint32_t id)
+{
+    for (size_t i = 0; i < d->n_keys; i++) {
+        if (d->keys[i]->id == id) return d->keys[i];
+    }
+    return NULL;
+}
+
+static void key_remove(sap_scand* d, size_t i)
+{
+    sap_sched_remove(&d->sched, &d->keys[i]->sched);
+    key_free(d->keys[i]);
+    d->keys[i] = d->keys[--d->n_keys];
+}
+
+/// Compares the public spending keys and the prepared view keys, so that a key
+/// read from a key file equals the same key mapped from a blob.
+static int same_key(const scand_key* a, const scand_key* b)
+{
+    size_t ct_bytes, pk_bytes, sk_bytes;
+    if (a->kyber_k != b->kyber_k || corpus_level_sizes(a->kyber_k, &ct_bytes, &pk_bytes, &sk_bytes) != 0) {
+        return 0;
+    }
+    return memcmp(a->spend_pub, b->spend_pub, pk_bytes) == 0
+        && memcmp(a->scan_key, b->scan_key, scan_levels[a->kyber_k - 2]->key_bytes) == 0;
+}
+
+/// Reads a key file (u8 kyber_k, spend public key, secret view key per key); returns the number of keys or -1.
+static long read_key_file(const char* path, scand_key*** out)
+{
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return -1;
+    }
+    uint8_t* buf = NULL;
+    size_t len = 0, cap = 0, got;
+    do {
+        if (len == cap) {
+            cap = cap ? 2 * cap : 1 << 16;
+            uint8_t* b = realloc(buf, cap);
+            if (b == NULL) {
+                break;
+            }
+            buf = b;
+        }
+        got = fread(buf + len, 1, cap - len, f);
+        len += got;
+    } while (got > 0);
+    int ok = !ferror(f) && buf != NULL && len < cap;
+    fclose(f);
+
+    scand_key** parsed = NULL;
+    size_t n = 0;
+    for (size_t off = 0; ok && off < len;) {
+        size_t used;
+        scand_key* k = key_parse(buf + off, len - off, &used);
+        scand_key** p = k != NULL ? realloc(parsed, (n + 1) * sizeof(*parsed)) : NULL;
+        if (p == NULL) {
+            if (k != NULL) key_free(k);
+            ok = 0;
+            break;
+        }
+        parsed = p;
+        parsed[n++] = k;
+        off += used;
+    }
+    if (buf != NULL) {
+        sap_wipe(buf, len);
+        free(buf);
+    }
+    if (!ok) {
+        for (size_t i = 0; i < n; i++) key_free(parsed[i]);
+        free(parsed);
+        return -1;
+    }
+    *out = parsed;
+    return (long)n;
+}
+
+/// Maps a key blob and makes a key pointing into it for every entry; returns the number of keys or -1.
+static long map_key_blob(const char* path, sap_keyblob* blob, scand_key*** out)
+{
+    if (sap_keyblob_open(blob, path, NULL, 0) != 0) {
+        return -1;
+    }
+    scand_key** parsed = calloc(blob->n > 0 ? blob->n : 1, sizeof(*parsed));
+    size_t n = 0;
+    for (; parsed != NULL && n < blob->n; n++) {
+        scand_key* k = calloc(1, sizeof(*k));
+        if (k == NULL) {
+            break;
+        }
+        k->kyber_k = blob->entries[n].kyber_k;
+        k->mapped = 1;
+        k->spend_pub = (uint8_t*)sap_keyblob_spend_pub(blob, n);
+        k->scan_key = (void*)sap_keyblob_scan_key(blob, n);
+        parsed[n] = k;
+    }
+    if (parsed == NULL || n < blob->n) {
+        for (size_t i = 0; parsed != NULL && i < n; i++) key_free(parsed[i]);
+        free(parsed);
+        sap_keyblob_close(blob);
+        return -1;
+    }
+    *out = parsed;
+    return (long)n;
+}
+
+/**
+ * Workflow:
+ *  1. Maps the key file if it is a key blob, otherwise parses it and prepares
+ *     its keys; a missing or malformed file leaves the keys unchanged.
+ *  2. Keeps the file keys that are still listed, with their ids and matches,
+ *     taking over the storage of the new copy so that none points into the
+ *     previous blob any more.
+ *  3. Adds the new ones, which start scanning from the beginning of the register,
+ *     removes the file keys that are no longer listed and unmaps the previous blob.
+ *
+ * @return The number of keys in the file, or -1 if it could not be read.
+ */
+static long reload_keys(sap_scand* d)
+{
+    if (d->config.key_path == NULL) {
+        return 0;
+    }
+    sap_keyblob blob;
+    int is_blob = sap_keyblob_is_blob(d->config.key_path);
+    scand_key** parsed = NULL;
+    long got = is_blob ? map_key_blob(d->config.key_path, &blob, &parsed) : read_key_file(d->config.key_path, &parsed);
+    if (got < 0) {
+        return -1;
+    }
+    size_t n = (size_t)got;
+
+    for (size_t i = 0; i < d->n_keys; i++) d->keys[i]->keep = !d->keys[i]->from_file;
+    for (size_t j = 0; j < n; j++) {
+        scand_key* existing = NULL;
+        parsed[j]->from_file = 1;
+        for (size_t i = 0; i < d->n_keys && existing == NULL; i++) {
+            if (d->keys[i]->from_file && !d->keys[i]->keep && same_key(d->keys[i], parsed[j])) {
+                existing = d->keys[i];
+            }
+        }
+        if (existing != NULL) {
+            scand_key old = *existing;
+            existing->keep = 1;
+            existing->mapped = parsed[j]->mapped;
+            existing->spend_pub = parsed[j]->spend_pub;
+            existing->scan_key = parsed[j]->scan_key;
+            parsed[j]->mapped = old.mapped;
+            parsed[j]->spend_pub = old.spend_pub;
+            parsed[j]->scan_key = old.scan_key;
+            key_free(parsed[j]);
+        } else if (key_add(d, parsed[j]) == 0) {
+            parsed[j]->keep = 1;
+        } else {
+            key_free(parsed[j]);
+        }
+    }
+    free(parsed);
+    for (size_t i = d->n_keys; i-- > 0;) {
+        if (!d->keys[i]->keep) key_remove(d, i);
+    }
+    if (d->have_blob) sap_keyblob_close(&d->blob);
+    d->have_blob = is_blob;
+    if (is_blob) d->blob = blob;
+    return (long)n;
+}
+
+/* ---- clients ---- */
+
+static int client_queue(scand_client* c, uint8_t type, const uint8_t* body, size_t len)
+{
+    size_t need = c->out_len + SAP_SCAND_HEADER_BYTES + len;
+    if (need > SCAND_MAX_BACKLOG) {
+        return -1;
+    }
+    if (need > c->out_cap) {
+        size_t cap = c->out_cap ? c->out_cap : 4096;
+        while (cap < need) cap *= 2;
+        uint8_t* out = realloc(c->out, cap);
+        if (out == NULL) {
+            return -1;
+        }
+        c->out = out;
+        c->out_cap = cap;
+    }
+    sap_scand_put32(c->out + c->out_len, (uint32_t)len);
+    c->out[c->out_len + 4] = type;
+    if (len > 0) memcpy(c->out + c->out_len + SAP_SCAND_HEADER_BYTES, body, len);
+    c->out_len = need;
+    return 0;
+}
+
+static int client_flush(scand_client* c)
+{
+    size_t off = 0;
+    while (off < c->out_len) {
+        ssize_t w = send(c->fd, c->out + off, c->out_len - off, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return -1;
+        }
+        off += (size_t)w;
+    }
+    memmove(c->out, c->out + off, c->out_len - off);
+    c->out_len -= off;
+    return 0;
+}
+
+static void client_close(sap_scand* d, size_t i)
+{
+    scand_client* c = d->clients[i];
+    close(c->fd);
+    free(c->in);
+    free(c->out);
+    free(c->subs);
+    free(c);
+    d->clients[i] = d->clients[--d->n_clients];
+}
+
+static size_t put_match(uint8_t* p, const scand_key* k, const scand_match* m)
+{
+    sap_scand_put64(p, m->index);
+    sap_scand_put32(p + 8, k->id);
+    p[12] = (uint8_t)k->kyber_k;
+    memcpy(p + 13, m->ss, 32);
+    memcpy(p + 45, m->stealth_pub_key, SAP_SCAND_STEALTH_BYTES(k->kyber_k));
+    return SAP_SCAND_MATCH_BYTES(k->kyber_k);
+}
+
+static int reply_ok32(scand_client* c, uint32_t v)
+{
+    uint8_t body[4];
+    sap_scand_put32(body, v);
+    return client_queue(c, SAP_SCAND_OK, body, sizeof(body));
+}
+
+static int key_caught_up(const sap_scand* d, const scand_key* k)
+{
+    return !d->have_reg || k->next >= d->reg.n;
+}
+
+/// Queues the MATCHES reply to a QUERY of @p k from @p from.
+static int reply_matches(scand_client* c, const scand_key* k, uint64_t from)
+{
+    size_t lo = 0, hi = k->n_matches;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (k->matches[mid].index < from) lo = mid + 1;
+        else hi = mid;
+    }
+    size_t count = k->n_matches - lo < SAP_SCAND_QUERY_MAX ? k->n_matches - lo : SAP_SCAND_QUERY_MAX;
+    uint8_t* out = malloc(13 + count * SAP_SCAND_MATCH_BYTES(k->kyber_k));
+    if (out == NULL) {
+        return -1;
+    }
+    sap_scand_put32(out, (uint32_t)count);
+    out[4] = lo + count < k->n_matches;
+    sap_scand_put64(out + 5, k->next);
+    size_t off = 13;
+    for (size_t i = 0; i < count; i++) off += put_match(out + off, k, &k->matches[lo + i]);
+    int ret = client_queue(c, SAP_SCAND_MATCHES, out, off);
+    sap_wipe(out, off);
+    free(out);
+    return ret;
+}
+
+/**
+ * Answers one request; returns -1 if the client has to be dropped (malformed
+ * frame or output backlog), otherwise 0, also for requests answered with an error.
+ */
+static int handle_request(sap_scand* d, scand_client* c, uint8_t type, const uint8_t* body, size_t len)
+{
+    static const char bad[] = "bad request";
+    static const char unknown[] = "unknown key";
+
+    switch (type) {
+    case SAP_SCAND_REGISTER: {
+        size_t used;
+        scand_key* k = key_parse(body, len, &used);
+        if (k == NULL || used != len || key_add(d, k) != 0) {
+            if (k != NULL) key_free(k);
+            return client_queue(c, SAP_SCAND_ERROR, (const uint8_t*)bad, sizeof(bad) - 1);
+        }
+        return reply_ok32(c, k->id);
+    }
+    case SAP_SCAND_UNREGISTER:
+        for (size_t i = 0; len == 4 && i < d->n_keys; i++) {
+            if (d->keys[i]->id == sap_scand_get32(body)) {
+                key_remove(d, i);
+                return client_queue(c, SAP_SCAND_OK, NULL, 0);
+            }
+        }
+        return client_queue(c, SAP_SCAND_ERROR, (const uint8_t*)unknown, sizeof(unknown) - 1);
+    case SAP_SCAND_QUERY: {
+        scand_key* k = len == 12 || len == 16 ? key_find(d, sap_scand_get32(body)) : NULL;
+        if (k == NULL) {
+            return client_queue(c, SAP_SCAND_ERROR, (const uint8_t*)unknown, sizeof(unknown) - 1);
+        }
+        uint64_t from = sap_scand_get64(body + 4);
+        uint32_t wait_ms = len == 16 ? sap_scand_get32(body + 12) : 0;
+        if (wait_ms > 0 && !key_caught_up(d, k)) {
+            c->waiting = 1;
+            c->wait_key = k->id;
+            c->wait_from = from;
+            c->wait_until = now_ns() + (uint64_t)wait_ms * 1000000u;
+            return 0;
+        }
+        return reply_matches(c, k, from);
+    }
+    case SAP_SCAND_SUBSCRIBE: {
+        scand_key* k = len == 4 ? key_find(d, sap_scand_get32(body)) : NULL;
+        uint32_t* subs = k != NULL ? realloc(c->subs, (c->n_subs + 1) * sizeof(uint32_t)) : NULL;
+        if (subs == NULL) {
+            return client_queue(c, SAP_SCAND_ERROR, (const uint8_t*)unknown, sizeof(unknown) - 1);
+        }
+        c->subs = subs;
+        c->subs[c->n_subs++] = k->id;
+        return client_queue(c, SAP_SCAND_OK, NULL, 0);
+    }
+    case SAP_SCAND_STATUS: {
+        uint8_t out[20];
+        uint64_t entries = d->have_reg ? d->reg.n : 0, scanned = entries;
+        for (size_t i = 0; i < d->n_keys; i++) {
+            if (d->keys[i]->next < scanned) scanned = d->keys[i]->next;
+        }
+        sap_scand_put64(out, entries);
+        sap_scand_put64(out + 8, scanned);
+        sap_scand_put32(out + 16, (uint32_t)d->n_keys);
+        return client_queue(c, SAP_SCAND_OK, out, sizeof(out));
+    }
+    case SAP_SCAND_RELOAD: {
+        long n = reload_keys(d);
+        if (n < 0) {
+            static const char failed[] = "key file unreadable";
+            return client_queue(c, SAP_SCAND_ERROR, (const uint8_t*)failed, sizeof(failed) - 1);
+        }
+        return reply_ok32(c, (uint32_t)n);
+    }
+    case SAP_SCAND_WEIGHT: {
+        scand_key* k = len == 8 ? key_find(d, sap_scand_get32(body)) : NULL;
+        if (k == NULL) {
+            return client_queue(c, SAP_SCAND_ERROR, (const uint8_t*)unknown, sizeof(unknown) - 1);
+        }
+        sap_sched_set_weight(&k->sched, sap_scand_get32(body + 4));
+        return client_queue(c, SAP_SCAND_OK, NULL, 0);
+    }
+    case SAP_SCAND_METRICS: {
+        uint8_t out[SAP_SCAND_METRICS_BYTES];
+        for (int q = 0; q < SAP_SCHED_QUEUES; q++) {
+            const sap_sched_queue_stats* st = &d->sched.stats[q];
+            uint8_t* p = out + q * SAP_SCAND_METRICS_BYTES / SAP_SCHED_QUEUES;
+            sap_scand_put32(p, (uint32_t)d->sched.runnable[q]);
+            sap_scand_put64(p + 4, st->batches);
+            sap_scand_put64(p + 12, st->cost);
+            sap_scand_put64(p + 20, st->waits);
+            sap_scand_put64(p + 28, st->wait_sum);
+            sap_scand_put64(p + 36, st->wait_max);
+        }
+        return client_queue(c, SAP_SCAND_OK, out, sizeof(out));
+    }
+    default:
+        return client_queue(c, SAP_SCAND_ERROR, (const uint8_t*)bad, sizeof(bad) - 1);
+    }
+}
+
+/**
+ * Answers the complete requests in the input buffer, up to a QUERY that waits.
+ * The buffer never holds more than one partial frame and one read, as no more is
+ * read while a QUERY waits.
+ */
+static int client_process(sap_scand* d, scand_client* c)
+{
+    size_t off = 0;
+    while (!c->waiting && c->in_len - off >= SAP_SCAND_HEADER_BYTES) {
+        size_t len = sap_scand_get32(c->in + off);
+        if (len > SAP_SCAND_MAX_BODY) return -1;
+        if (c->in_len - off < SAP_SCAND_HEADER_BYTES + len) break;
+        if (handle_request(d, c, c->in[off + 4], c->in + off + SAP_SCAND_HEADER_BYTES, len) != 0) return -1;
+        off += SAP_SCAND_HEADER_BYTES + len;
+    }
+    sap_wipe(c->in, off);
+    memmove(c->in, c->in + off, c->in_len - off);
+    c->in_len -= off;
+    return 0;
+}
+
+/**
+ * Reads what the client sent and answers every complete request.
+ * @return -1 if the client disconnected or has to be dropped.
+ */
+static int client_read(sap_scand* d, scand_client* c)
+{
+    for (;;) {
+        if (c->in_cap - c->in_len < 4096) {
+            size_t cap = c->in_cap ? 2 * c->in_cap : 8192;
+            uint8_t* in = realloc(c->in, cap);
+            if (in == NULL) return -1;
+            c->in = in;
+            c->in_cap = cap;
+        }
+        ssize_t r = recv(c->fd, c->in + c->in_len, c->in_cap - c->in_len, 0);
+        if (r == 0) return -1;
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        }
+        c->in_len += (size_t)r;
+        if (client_process(d, c) != 0) return -1;
+        if (c->waiting) return 0;
+    }
+}
+
+static void accept_clients(sap_scand* d)
+{
+    for (;;) {
+        int fd = accept(d->listen_fd, NULL, NULL);
+        if (fd < 0) return;
+        scand_client* c = d->n_clients < SCAND_MAX_CLIENTS ? calloc(1, sizeof(*c)) : NULL;
+        if (c == NULL) {
+            close(fd);
+            continue;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        c->fd = fd;
+        d->clients[d->n_clients++] = c;
+    }
+}
+
+/* ---- register ---- */
+
+/**
+ * Workflow:
+ *  1. Looks at the register file again if its inode, size or modification time
+ *     changed.
+ *  2. If it grew, reads only the entries past the known ones and appends them,
+ *     keeping the scan positions (corpus_extend()).
+ *  3. Otherwise reloads the whole file and restarts every key.
+ * A file that cannot be read is tried again at the next check.
+ */
+static void check_register(sap_scand* d)
+{
+    struct stat st;
+    size_t n;
+    if (stat(d->config.register_path, &st) != 0) {
+        return;
+    }
+    if (d->have_reg && st.st_ino == d->reg_stat.st_ino && st.st_size == d->reg_stat.st_size
+        && st.st_mtim.tv_sec == d->reg_stat.st_mtim.tv_sec && st.st_mtim.tv_nsec == d->reg_stat.st_mtim.tv_nsec) {
+        return;
+    }
+    if (corpus_entries(d->config.register_path, &n) != 0) {
+        return;
+    }
+    if (d->have_reg && n >= d->reg.n) {
+        if (corpus_extend(&d->reg, d->config.register_path) == 0) d->reg_stat = st;
+        return;
+    }
+
+    corpus reg;
+    if (corpus_load(&reg, d->config.register_path) != 0) {
+        return;
+    }
+    if (d->have_reg) {
+        for (size_t i = 0; i < d->n_keys; i++) {
+            scand_key* k = d->keys[i];
+            if (k->matches != NULL) sap_wipe(k->matches, k->n_matches * sizeof(scand_match));
+            k->next = 0;
+            k->n_matches = 0;
+        }
+    }
+    if (d->have_reg) corpus_free(&d->reg);
+    d->reg = reg;
+    d->have_reg = 1;
+    d->reg_stat = st;
+}
+
+/// Stores a match of @p k and sends it to the subscribers; returns -1 out of memory.
+static int record_match(sap_scand* d, scand_key* k, uint64_t index, const uint8_t ss[32])
+{
+    if (k->n_matches == k->cap_matches) {
+        size_t cap = k->cap_matches ? 2 * k->cap_matches : 8;
+        scand_match* m = malloc(cap * sizeof(*m));
+        if (m == NULL) {
+            return -1;
+        }
+        if (k->matches != NULL) {
+            memcpy(m, k->matches, k->n_matches * sizeof(*m));
+            sap_wipe(k->matches, k->cap_matches * sizeof(*m));
+            free(k->matches);
+        }
+        k->matches = m;
+        k->cap_matches = cap;
+    }
+    scand_match* m = &k->matches[k->n_matches++];
+    m->index = index;
+    memcpy(m->ss, ss, 32);
+    level_backend(k->kyber_k)->stealth_pub_key(m->stealth_pub_key, ss, k->spend_pub);
+
+    uint8_t event[SAP_SCAND_MATCH_BYTES(4)];
+    size_t len = put_match(event, k, m);
+    for (size_t i = 0; i < d->n_clients; i++) {
+        scand_client* c = d->clients[i];
+        for (size_t s = 0; s < c->n_subs; s++) {
+            if (c->subs[s] == k->id) {
+                if (client_queue(c, SAP_SCAND_EVENT, event, len) != 0) c->failed = 1;
+                break;
+            }
+        }
+    }
+    sap_wipe(event, len);
+    return 0;
+}
+
+/**
+ * Workflow:
+ *  1. Puts every key with entries left in the tail queue if it is at most
+ *     tail_entries behind the end of the register, otherwise in the backfill queue.
+ *  2. Lets the scheduler pick a key and takes the chunk of the register at its
+ *     position, grouped by level (levels without a key are skipped).
+ *  3. Scans the chunk with every key of the same queue at that position; the
+ *     ciphertexts stay in cache from one key to the next. Hits are recorded with
+ *     their stealth public keys and sent to subscribers.
+ *  4. Charges the scan time to those keys in equal parts and moves them past the
+ *     chunk. A key whose match cannot be recorded stops at that entry instead,
+ *     so the entry is scanned again later rather than lost.
+ *
+ * @return 1 if a chunk was scanned, 0 if every key is up to date.
+ */
+static int scan_step(sap_scand* d)
+{
+    if (!d->have_reg) {
+        return 0;
+    }
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < d->n_keys; i++) {
+        scand_key* k = d->keys[i];
+        size_t behind = d->reg.n - k->next;
+        int queue = behind == 0 ? SAP_SCHED_IDLE
+            : behind <= d->config.tail_entries ? SAP_SCHED_TAIL : SAP_SCHED_BACKFILL;
+        sap_sched_update(&d->sched, &k->sched, queue, start);
+    }
+    sap_sched_entity* picked = sap_sched_next(&d->sched);
+    if (picked == NULL) {
+        return 0;
+    }
+    int queue = picked->queue;
+    size_t lo = ((scand_key*)picked->owner)->next;
+    size_t hi = d->reg.n - lo < d->config.chunk_entries ? d->reg.n : lo + d->config.chunk_entries;
+
+    const uint8_t* (*cts)[SCAND_CHUNK] = d->cts;
+    uint8_t (*tags)[SCAND_CHUNK] = d->tags;
+    uint32_t (*index)[SCAND_CHUNK] = d->index;
+    uint8_t* hits = d->hits;
+    uint8_t* ss = d->ss;
+    size_t count[SAP_SCAN_MIXED_LEVELS] = { 0 };
+
+    for (size_t i = lo; i < hi; i++) {
+        unsigned int l = d->reg.levels[i] - 2u;
+        if (l >= SAP_SCAN_MIXED_LEVELS) continue;
+        cts[l][count[l]] = corpus_ct(&d->reg, i);
+        tags[l][count[l]] = corpus_tag(&d->reg, i)[0];
+        index[l][count[l]++] = (uint32_t)(i - lo);
+    }
+
+    size_t n_batch = 0;
+    for (size_t i = 0; i < d->n_keys; i++) {
+        scand_key* k = d->keys[i];
+        k->in_batch = k->next == lo && k->sched.queue == queue;
+        if (!k->in_batch) continue;
+
+        unsigned int l = k->kyber_k - 2;
+        k->batch_end = hi;
+        if (count[l] > 0 && scan_levels[l]->scan(hits, ss, cts[l], tags[l], count[l], k->scan_key) > 0) {
+            for (size_t j = 0; j < count[l]; j++) {
+                if (!hits[j]) continue;
+                if (k->batch_end == hi && record_match(d, k, lo + index[l][j], ss + j * 32) != 0) {
+                    k->batch_end = lo + index[l][j];
+                    fprintf(stderr, "sap_scand: out of memory recording a match of key %u at entry %zu\n", k->id,
+                        k->batch_end);
+                }
+                sap_wipe(ss + j * 32, 32);
+            }
+        }
+        n_batch++;
+    }
+
+    uint64_t cost = now_ns() - start;
+    for (size_t i = 0; i < d->n_keys; i++) {
+        scand_key* k = d->keys[i];
+        if (!k->in_batch) continue;
+        sap_sched_charge(&d->sched, &k->sched, start, cost / n_batch);
+        k->next = k->batch_end;
+    }
+    return 1;
+}
+
+/**
+ * Answers the held QUERY requests whose key has caught up or whose wait is over,
+ * then the requests that arrived behind them.
+ *
+ * @return Milliseconds until the next held QUERY times out, at most 50.
+ */
+static int answer_waiting(sap_scand* d)
+{
+    static const char unknown[] = "unknown key";
+    uint64_t now = now_ns();
+    int timeout = 50;
+
+    for (size_t i = 0; i < d->n_clients; i++) {
+        scand_client* c = d->clients[i];
+        if (!c->waiting) continue;
+
+        scand_key* k = key_find(d, c->wait_key);
+        if (k != NULL && !key_caught_up(d, k) && now < c->wait_until) {
+            uint64_t ms = (c->wait_until - now + 999999) / 1000000;
+            if (ms < (uint64_t)timeout) timeout = (int)ms;
+            continue;
+        }
+        c->waiting = 0;
+        int ret = k != NULL ? reply_matches(c, k, c->wait_from)
+                            : client_queue(c, SAP_SCAND_ERROR, (const uint8_t*)unknown, sizeof(unknown) - 1);
+        if (ret != 0 || client_process(d, c) != 0) {
+            c->failed = 1;
+        } else if (c->waiting) {
+            timeout = 0;
+        }
+    }
+    return timeout;
+}
+
+/* ---- daemon ---- */
+
+sap_scand* sap_scand_open(const sap_scand_config* config)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (config->socket_path == NULL || config->register_path == NULL
+        || strlen(config->socket_path) >= sizeof(addr.sun_path)) {
+        return NULL;
+    }
+    strcpy(addr.sun_path, config->socket_path);
+
+    sap_scand* d = calloc(1, sizeof(*d));
+    if (d == NULL) {
+        return NULL;
+    }
+    d->config = *config;
+    if (d->config.poll_ms == 0) d->config.poll_ms = 200;
+    if (d->config.tail_entries == 0) d->config.tail_entries = SCAND_TAIL_ENTRIES;
+    if (d->config.chunk_entries == 0 || d->config.chunk_entries > SCAND_CHUNK) d->config.chunk_entries = SCAND_CHUNK;
+    sap_sched_init(&d->sched, config->tail_share);
+
+    d->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    mode_t mask = umask(0077);
+    unlink(config->socket_path);
+    int bound = d->listen_fd >= 0 && bind(d->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+    umask(mask);
+    if (!bound || listen(d->listen_fd, 64) != 0 || reload_keys(d) < 0) {
+        if (d->listen_fd >= 0) close(d->listen_fd);
+        if (bound) unlink(config->socket_path);
+        for (size_t i = 0; i < d->n_keys; i++) key_free(d->keys[i]);
+        free(d->keys);
+        if (d->have_blob) sap_keyblob_close(&d->blob);
+        sap_sched_free(&d->sched);
+        free(d);
+        return NULL;
+    }
+    return d;
+}
+
+/**
+ * Workflow:
+ *  1. Polls the listening socket and the clients, without waiting while a scan
+ *     is in progress and for at most 50 ms (or until a held QUERY times out)
+ *     otherwise. Clients with a held QUERY are not read from.
+ *  2. Accepts clients, answers requests and flushes pending replies and events.
+ *  3. Handles reload requests and checks the register file every poll_ms.
+ *  4. Scans one chunk and answers the held QUERY requests that are due.
+ */
+int sap_scand_run(sap_scand* d)
+{
+    struct pollfd fds[SCAND_MAX_CLIENTS + 1];
+    struct timespec last = { 0, 0 };
+    int busy = 0, timeout = 50;
+
+    while (!atomic_load(&d->stop_requested)) {
+        fds[0] = (struct pollfd){ d->listen_fd, POLLIN, 0 };
+        for (size_t i = 0; i < d->n_clients; i++) {
+            const scand_client* c = d->clients[i];
+            fds[i + 1] = (struct pollfd){ c->fd,
+                (short)((c->waiting ? 0 : POLLIN) | (c->out_len > 0 ? POLLOUT : 0)), 0 };
+        }
+        size_t n_fds = d->n_clients + 1;
+        if (poll(fds, n_fds, busy ? 0 : timeout) < 0 && errno != EINTR) {
+            return -1;
+        }
+
+        for (size_t i = n_fds - 1; i >= 1; i--) {
+            scand_client* c = d->clients[i - 1];
+            int drop = c->failed || (fds[i].revents & (POLLERR | POLLNVAL)) != 0
+                || (c->waiting && (fds[i].revents & POLLHUP));
+            if (!drop && !c->waiting && (fds[i].revents & (POLLIN | POLLHUP))) drop = client_read(d, c) != 0;
+            if (!drop && c->out_len > 0) drop = client_flush(c) != 0;
+            if (drop) client_close(d, i - 1);
+        }
+        if (fds[0].revents & POLLIN) {
+            accept_clients(d);
+        }
+
+        if (atomic_exchange(&d->reload_requested, 0)) {
+            if (reload_keys(d) < 0) fprintf(stderr, "sap_scand: could not reload %s\n", d->config.key_path);
+        }
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if ((now.tv_sec - last.tv_sec) * 1000 + (now.tv_nsec - last.tv_nsec) / 1000000 >= d->config.poll_ms) {
+            check_register(d);
+            last = now;
+        }
+
+        busy = scan_step(d);
+        timeout = answer_waiting(d);
+    }
+    return 0;
+}
+
+void sap_scand_stop(sap_scand* d)
+{
+    atomic_store(&d->stop_requested, 1);
+}
+
+void sap_scand_reload(sap_scand* d)
+{
+    atomic_store(&d->reload_requested, 1);
+}
+
+void sap_scand_close(sap_scand* d)
+{
+    while (d->n_clients > 0) client_close(d, d->n_clients - 1);
+    close(d->listen_fd);
+    unlink(d->config.socket_path);
+    for (size_t i = 0; i < d->n_keys; i++) key_free(d->keys[i]);
+    free(d->keys);
+    if (d->have_blob) sap_keyblob_close(&d->blob);
+    sap_sched_free(&d->sched);
+    if (d->have_reg) corpus_free(&d->reg);
+    free(d);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "scand_proto.h"
+
+/// @file scand.h
+/// @brief Local scan daemon: one process scans the register for many wallets.
+///
+/// Without it, every wallet process loads its keys, expands them and scans the
+/// whole register alone. sap_scand keeps the prepared view keys (sap_scan_key) of
+/// all registered wallets in memory, watches the register file and scans new
+/// chunks of announcements while they are still in cache. Wallets register keys,
+/// query their matches and subscribe to new ones over a Unix domain socket
+/// (scand_proto.h).
+///
+/// Scan work is split by a weighted fair scheduler (scan_sched.h): keys within
+/// tail_entries of the end of the register are in the tail queue, keys further
+/// behind, such as a wallet restoring from the start, in the backfill queue. Each
+/// loop iteration scans one chunk for the key the scheduler picks, together with
+/// every key of its queue at the same position, so a new block waits for at most
+/// one backfill chunk and backfills get the rest of the time.
+///
+/// The register is treated as append-only: when the file is replaced by a longer
+/// one only the new entries are read and scanned, and a shorter one restarts every key.
+/// Keys come from REGISTER requests and from an optional key file, which is read
+/// again on sap_scand_reload() without dropping clients or the matches of keys that
+/// are still in the file. A key file that is an unencrypted key blob (see keyblob.h)
+/// is mapped and verified instead, and its prepared keys are scanned in place; replace
+/// a blob by renaming a new file over it, as sap_keyblob_write() does, never in place.
+///
+/// Everything runs on the thread that calls sap_scand_run(); scanning proceeds one
+/// chunk per loop iteration so that requests are answered between chunks.
+
+/// @brief Daemon settings.
+typedef struct {
+    const char* socket_path;    /**< Unix socket to listen on; replaced if it exists. */
+    const char* register_path;  /**< Register file (corpus.h format), may not exist yet. */
+    const char* key_path;       /**< Key file or key blob, or NULL. */
+    unsigned int poll_ms;       /**< Interval between checks of the register file (0: 200). */
+    unsigned int tail_share;    /**< Percent of the scan time for the tail queue while both have work (0: 90). */
+    size_t tail_entries;        /**< Largest lag of a key in the tail queue (0: 16384 entries). */
+    size_t chunk_entries;       /**< Register entries scanned per loop iteration, at most 1024 (0: 1024). */
+} sap_scand_config;
+
+typedef struct sap_scand sap_scand;
+
+/// @brief Creates a daemon: binds the socket and loads the key file.
+/// @return The daemon, or NULL on failure.
+sap_scand* sap_scand_open(const sap_scand_config* config);
+
+/// @brief Serves clients and scans until sap_scand_stop(); returns 0, or -1 on a fatal error.
+int sap_scand_run(sap_scand* d);
+
+/// @brief Asks sap_scand_run() to return; async-signal-safe and callable from any thread.
+void sap_scand_stop(sap_scand* d);
+
+/// @brief Asks the daemon to reload the key file; async-signal-safe and callable from any thread.
+void sap_scand_reload(sap_scand* d);
+
+/// @brief Closes the socket, removes it and releases all keys (wiping them).
+void sap_scand_close(sap_scand* d);
@@ -0,0 +1,282 @@
+#include "scand_client.h"
+#include "corpus.h"
+#include "wipe.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static int write_all(int fd, const uint8_t* p, size_t len)
+{
+    while (len > 0) {
+        ssize_t w = send(fd, p, len, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+static int read_all(int fd, uint8_t* p, size_t len)
+{
+    while (len > 0) {
+        ssize_t r = recv(fd, p, len, 0);
+        if (r == 0) return -1;
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += r;
+        len -= (size_t)r;
+    }
+    return 0;
+}
+
+/// Reads one frame into @p body (SAP_SCAND_MAX_BODY bytes); returns its length or -1.
+static long read_frame(int fd, uint8_t* type, uint8_t* body)
+{
+    uint8_t header[SAP_SCAND_HEADER_BYTES];
+    if (read_all(fd, header, sizeof(header)) != 0) {
+        return -1;
+    }
+    size_t len = sap_scand_get32(header);
+    if (len > SAP_SCAND_MAX_BODY || read_all(fd, body, len) != 0) {
+        return -1;
+    }
+    *type = header[4];
+    return (long)len;
+}
+
+static int parse_match(sap_scand_match* m, const uint8_t* p, size_t len)
+{
+    if (len < 13 || p[12] < 2 || p[12] > 4 || len < SAP_SCAND_MATCH_BYTES(p[12])) {
+        return -1;
+    }
+    m->index = sap_scand_get64(p);
+    m->key_id = sap_scand_get32(p + 8);
+    m->kyber_k = p[12];
+    memcpy(m->ss, p + 13, 32);
+    memcpy(m->stealth_pub_key, p + 45, SAP_SCAND_STEALTH_BYTES(m->kyber_k));
+    return 0;
+}
+
+static int queue_event(sap_scand_client* c, const uint8_t* body, size_t len)
+{
+    if (c->n_events == c->cap_events) {
+        size_t cap = c->cap_events ? 2 * c->cap_events : 8;
+        sap_scand_match* e = realloc(c->events, cap * sizeof(*e));
+        if (e == NULL) {
+            return -1;
+        }
+        c->events = e;
+        c->cap_events = cap;
+    }
+    if (parse_match(&c->events[c->n_events], body, len) != 0) {
+        return -1;
+    }
+    c->n_events++;
+    return 0;
+}
+
+/**
+ * Workflow:
+ *  1. Sends the request frame.
+ *  2. Reads frames until the reply, queueing the match events in between.
+ *
+ * @return The reply length with its type in @p type, or -1.
+ */
+static long request(sap_scand_client* c, uint8_t op, const uint8_t* body, size_t len, uint8_t* type, uint8_t* reply)
+{
+    uint8_t header[SAP_SCAND_HEADER_BYTES];
+    sap_scand_put32(header, (uint32_t)len);
+    header[4] = op;
+    if (write_all(c->fd, header, sizeof(header)) != 0 || write_all(c->fd, body, len) != 0) {
+        return -1;
+    }
+    for (;;) {
+        long n = read_frame(c->fd, type, reply);
+        if (n < 0 || *type != SAP_SCAND_EVENT) return n;
+        if (queue_event(c, reply, (size_t)n) != 0) return -1;
+    }
+}
+
+int sap_scand_connect(sap_scand_client* c, const char* path)
+{
+    struct sockaddr_un addr;
+    memset(c, 0, sizeof(*c));
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    c->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (c->fd < 0 || connect(c->fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        if (c->fd >= 0) close(c->fd);
+        c->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+void sap_scand_disconnect(sap_scand_client* c)
+{
+    if (c->fd >= 0) close(c->fd);
+    if (c->events != NULL) sap_wipe(c->events, c->cap_events * sizeof(*c->events));
+    free(c->events);
+    memset(c, 0, sizeof(*c));
+    c->fd = -1;
+}
+
+int sap_scand_register(sap_scand_client* c, uint32_t kyber_k, const uint8_t* spend_pub, const uint8_t* view_priv,
+    uint32_t* key_id)
+{
+    size_t ct_bytes, pk_bytes, sk_bytes;
+    if (corpus_level_sizes(kyber_k, &ct_bytes, &pk_bytes, &sk_bytes) != 0) {
+        return -1;
+    }
+    uint8_t body[1 + 1568 + 3168], type, reply[SAP_SCAND_MAX_BODY];
+    body[0] = (uint8_t)kyber_k;
+    memcpy(body + 1, spend_pub, pk_bytes);
+    memcpy(body + 1 + pk_bytes, view_priv, sk_bytes);
+    long n = request(c, SAP_SCAND_REGISTER, body, 1 + pk_bytes + sk_bytes, &type, reply);
+    sap_wipe(body, sizeof(body));
+    if (n != 4 || type != SAP_SCAND_OK) {
+        return -1;
+    }
+    *key_id = sap_scand_get32(reply);
+    return 0;
+}
+
+int sap_scand_unregister(sap_scand_client* c, uint32_t key_id)
+{
+    uint8_t body[4], type, reply[SAP_SCAND_MAX_BODY];
+    sap_scand_put32(body, key_id);
+    return request(c, SAP_SCAND_UNREGISTER, body, sizeof(body), &type, reply) >= 0 && type == SAP_SCAND_OK ? 0 : -1;
+}
+
+/**
+ * Repeats the query from after the last returned match while the daemon reports
+ * that its reply was cut and @p out has room; only the first request waits.
+ */
+long sap_scand_query_wait(sap_scand_client* c, uint32_t key_id, uint64_t from, uint32_t wait_ms,
+    sap_scand_match* out, size_t max, uint64_t* scanned)
+{
+    uint8_t reply[SAP_SCAND_MAX_BODY];
+    size_t total = 0;
+    int more = 1;
+
+    while (more && total < max) {
+        uint8_t body[16], type;
+        sap_scand_put32(body, key_id);
+        sap_scand_put64(body + 4, from);
+        sap_scand_put32(body + 12, total == 0 ? wait_ms : 0);
+        long n = request(c, SAP_SCAND_QUERY, body, sizeof(body), &type, reply);
+        if (n < 13 || type != SAP_SCAND_MATCHES) {
+            return -1;
+        }
+        size_t count = sap_scand_get32(reply), off = 13;
+        more = reply[4];
+        if (scanned != NULL) *scanned = sap_scand_get64(reply + 5);
+        for (size_t i = 0; i < count && total < max; i++) {
+            if (parse_match(&out[total], reply + off, (size_t)n - off) != 0) {
+                return -1;
+            }
+            off += SAP_SCAND_MATCH_BYTES(out[total].kyber_k);
+            from = out[total++].index + 1;
+        }
+        sap_wipe(reply, (size_t)n);
+    }
+    return (long)total;
+}
+
+long sap_scand_query(sap_scand_client* c, uint32_t key_id, uint64_t from, sap_scand_match* out, size_t max)
+{
+    return sap_scand_query_wait(c, key_id, from, 0, out, max, NULL);
+}
+
+int sap_scand_subscribe(sap_scand_client* c, uint32_t key_id)
+{
+    uint8_t body[4], type, reply[SAP_SCAND_MAX_BODY];
+    sap_scand_put32(body, key_id);
+    return request(c, SAP_SCAND_SUBSCRIBE, body, sizeof(body), &type, reply) >= 0 && type == SAP_SCAND_OK ? 0 : -1;
+}
+
+int sap_scand_next_event(sap_scand_client* c, sap_scand_match* m, int timeout_ms)
+{
+    uint8_t body[SAP_SCAND_MAX_BODY];
+
+    while (c->n_events == 0) {
+        struct pollfd p = { c->fd, POLLIN, 0 };
+        int r = poll(&p, 1, timeout_ms);
+        if (r == 0) return 0;
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        uint8_t type;
+        long n = read_frame(c->fd, &type, body);
+        if (n < 0 || type != SAP_SCAND_EVENT || queue_event(c, body, (size_t)n) != 0) {
+            return -1;
+        }
+        sap_wipe(body, (size_t)n);
+    }
+    *m = c->events[0];
+    memmove(c->events, c->events + 1, --c->n_events * sizeof(*c->events));
+    sap_wipe(&c->events[c->n_events], sizeof(*c->events));
+    return 1;
+}
+
+int sap_scand_get_status(sap_scand_client* c, sap_scand_status* status)
+{
+    uint8_t type, reply[SAP_SCAND_MAX_BODY];
+    if (request(c, SAP_SCAND_STATUS, NULL, 0, &type, reply) != 20 || type != SAP_SCAND_OK) {
+        return -1;
+    }
+    status->entries = sap_scand_get64(reply);
+    status->scanned = sap_scand_get64(reply + 8);
+    status->keys = sap_scand_get32(reply + 16);
+    return 0;
+}
+
+int sap_scand_set_weight(sap_scand_client* c, uint32_t key_id, uint32_t weight)
+{
+    uint8_t body[8], type, reply[SAP_SCAND_MAX_BODY];
+    sap_scand_put32(body, key_id);
+    sap_scand_put32(body + 4, weight);
+    return request(c, SAP_SCAND_WEIGHT, body, sizeof(body), &type, reply) >= 0 && type == SAP_SCAND_OK ? 0 : -1;
+}
+
+int sap_scand_get_metrics(sap_scand_client* c, sap_scand_queue_metrics metrics[2])
+{
+    uint8_t type, reply[SAP_SCAND_MAX_BODY];
+    if (request(c, SAP_SCAND_METRICS, NULL, 0, &type, reply) != SAP_SCAND_METRICS_BYTES || type != SAP_SCAND_OK) {
+        return -1;
+    }
+    for (int q = 0; q < 2; q++) {
+        const uint8_t* p = reply + q * SAP_SCAND_METRICS_BYTES / 2;
+        metrics[q].keys = sap_scand_get32(p);
+        metrics[q].batches = sap_scand_get64(p + 4);
+        metrics[q].busy_ns = sap_scand_get64(p + 12);
+        metrics[q].waits = sap_scand_get64(p + 20);
+        metrics[q].wait_sum_ns = sap_scand_get64(p + 28);
+        metrics[q].wait_max_ns = sap_scand_get64(p + 36);
+    }
+    return 0;
+}
+
+long sap_scand_reload_keys(sap_scand_client* c)
+{
+    uint8_t type, reply[SAP_SCAND_MAX_BODY];
+    if (request(c, SAP_SCAND_RELOAD, NULL, 0, &type, reply) != 4 || type != SAP_SCAND_OK) {
+        return -1;
+    }
+    return (long)sap_scand_get32(reply);
+}
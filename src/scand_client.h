@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "scand_proto.h"
+
+/// @file scand_client.h
+/// @brief Blocking client of sap_scand (see scand.h and scand_proto.h).
+///
+/// Every request waits for its reply. Match events of subscribed keys that arrive
+/// in the meantime are queued and returned by sap_scand_next_event().
+
+/// @brief A match reported by the daemon.
+typedef struct {
+    uint64_t index;                                         /**< Register entry. */
+    uint32_t key_id;                                        /**< Key that matched. */
+    uint32_t kyber_k;                                       /**< Level of the key and the entry. */
+    uint8_t ss[32];                                         /**< Shared secret. */
+    uint8_t stealth_pub_key[SAP_SCAND_STEALTH_BYTES(4)];    /**< SAP_SCAND_STEALTH_BYTES(kyber_k) bytes. */
+} sap_scand_match;
+
+/// @brief Progress reported by SAP_SCAND_STATUS.
+typedef struct {
+    uint64_t entries;   /**< Entries in the register. */
+    uint64_t scanned;   /**< Entries scanned by every key. */
+    uint32_t keys;      /**< Registered keys. */
+} sap_scand_status;
+
+/// @brief Scheduler counters of one queue, reported by SAP_SCAND_METRICS.
+typedef struct {
+    uint32_t keys;          /**< Keys currently in the queue. */
+    uint64_t batches;       /**< Key batches scanned. */
+    uint64_t busy_ns;       /**< Scan time. */
+    uint64_t waits;         /**< Times a key entered the queue and was scanned. */
+    uint64_t wait_sum_ns;   /**< Total queue delay. */
+    uint64_t wait_max_ns;   /**< Largest queue delay. */
+} sap_scand_queue_metrics;
+
+/// @brief A connection.
+typedef struct {
+    int fd;
+    sap_scand_match* events;    /**< Queued events. */
+    size_t n_events, cap_events;
+} sap_scand_client;
+
+/// @brief Connects to the daemon listening on @p path; returns 0 or -1.
+int sap_scand_connect(sap_scand_client* c, const char* path);
+
+/// @brief Closes the connection and wipes queued events.
+void sap_scand_disconnect(sap_scand_client* c);
+
+/// @brief Registers a recipient; returns 0 and the key id, or -1.
+int sap_scand_register(sap_scand_client* c, uint32_t kyber_k, const uint8_t* spend_pub, const uint8_t* view_priv,
+    uint32_t* key_id);
+
+/// @brief Removes a key; returns 0 or -1.
+int sap_scand_unregister(sap_scand_client* c, uint32_t key_id);
+
+/// @brief Fetches up to @p max matches of a key with index >= @p from, in ascending order.
+/// @return The number of matches, or -1 on error.
+long sap_scand_query(sap_scand_client* c, uint32_t key_id, uint64_t from, sap_scand_match* out, size_t max);
+
+/// @brief sap_scand_query() that first waits up to @p wait_ms for the key to scan the whole register.
+///
+/// Answers within about @p wait_ms even if the key is far behind, for example
+/// while it backfills; the daemon keeps scanning, and a later query continues from
+/// @p scanned.
+/// @param[out] scanned If not NULL, the key's scan position: the matches below it are complete.
+/// @return The number of matches, or -1 on error.
+long sap_scand_query_wait(sap_scand_client* c, uint32_t key_id, uint64_t from, uint32_t wait_ms,
+    sap_scand_match* out, size_t max, uint64_t* scanned);
+
+/// @brief Subscribes to the future matches of a key; returns 0 or -1.
+int sap_scand_subscribe(sap_scand_client* c, uint32_t key_id);
+
+/// @brief Waits up to @p timeout_ms (negative: forever) for a match event.
+/// @return 1 with @p m filled, 0 on timeout, -1 on error.
+int sap_scand_next_event(sap_scand_client* c, sap_scand_match* m, int timeout_ms);
+
+/// @brief Reads the scan progress; returns 0 or -1.
+int sap_scand_get_status(sap_scand_client* c, sap_scand_status* status);
+
+/// @brief Sets the scheduling weight of a key; returns 0 or -1.
+int sap_scand_set_weight(sap_scand_client* c, uint32_t key_id, uint32_t weight);
+
+/// @brief Reads the scheduler counters of the tail (0) and backfill (1) queues; returns 0 or -1.
+int sap_scand_get_metrics(sap_scand_client* c, sap_scand_queue_metrics metrics[2]);
+
+/// @brief Makes the daemon reload its key file; returns the number of keys in it, or -1.
+long sap_scand_reload_keys(sap_scand_client* c);
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @file scand_proto.h
+/// @brief Wire format between sap_scand and its clients.
+///
+/// Every message is a frame: a 32-bit body length, a one-byte type and the body.
+/// All integers are little-endian. A client sends requests (SAP_SCAND_REGISTER ...
+/// SAP_SCAND_RELOAD) and receives exactly one reply per request, in order
+/// (SAP_SCAND_OK, SAP_SCAND_MATCHES or SAP_SCAND_ERROR). After SAP_SCAND_SUBSCRIBE,
+/// SAP_SCAND_EVENT frames for new matches of the key may arrive between replies.
+///
+/// Request bodies:
+///  - REGISTER:   u8 kyber_k, spend public key, secret view key (sizes of kyber_k)
+///                -> OK: u32 key_id
+///  - UNREGISTER: u32 key_id -> OK
+///  - QUERY:      u32 key_id, u64 from, optionally u32 wait_ms -> MATCHES: u32 count,
+///                u8 more, u64 scanned, count match records with index >= from in
+///                ascending order; more is 1 if the reply was cut at
+///                SAP_SCAND_QUERY_MAX records, and the matches below scanned are
+///                complete. With wait_ms the reply is held until the key has scanned
+///                the whole register or wait_ms has passed, whichever comes first;
+///                the key keeps scanning in the background either way, and the
+///                client's later requests are answered after it
+///  - SUBSCRIBE:  u32 key_id -> OK
+///  - STATUS:     empty -> OK: u64 register entries, u64 entries scanned by every key, u32 keys
+///  - RELOAD:     empty -> OK: u32 keys loaded from the key file
+///  - WEIGHT:     u32 key_id, u32 weight -> OK; the key's share of the scan time
+///                relative to the other keys of its queue (default 100)
+///  - METRICS:    empty -> OK: for the tail and then the backfill queue u32 keys
+///                queued, u64 batches, u64 scan time, u64 waits, u64 total and u64
+///                largest queue delay (times in nanoseconds; see scan_sched.h)
+///
+/// A match record (also the body of an EVENT) is u64 index, u32 key_id, u8 kyber_k,
+/// the 32-byte shared secret and the stealth public key (SAP_SCAND_STEALTH_BYTES).
+/// The key file holds REGISTER bodies back to back.
+
+/// @brief Frame types.
+enum {
+    SAP_SCAND_REGISTER = 1,
+    SAP_SCAND_UNREGISTER = 2,
+    SAP_SCAND_QUERY = 3,
+    SAP_SCAND_SUBSCRIBE = 4,
+    SAP_SCAND_STATUS = 5,
+    SAP_SCAND_RELOAD = 6,
+    SAP_SCAND_WEIGHT = 7,
+    SAP_SCAND_METRICS = 8,
+    SAP_SCAND_OK = 0x80,
+    SAP_SCAND_MATCHES = 0x81,
+    SAP_SCAND_EVENT = 0x82,
+    SAP_SCAND_ERROR = 0x83
+};
+
+/// @def SAP_SCAND_HEADER_BYTES
+/// @brief Length and type of a frame.
+#define SAP_SCAND_HEADER_BYTES 5
+
+/// @def SAP_SCAND_MAX_BODY
+/// @brief Largest frame body either side accepts.
+#define SAP_SCAND_MAX_BODY (1 << 16)
+
+/// @def SAP_SCAND_STEALTH_BYTES
+/// @brief Stealth public key size of a level, KYBER_K * KYBER_POLYBYTES.
+#define SAP_SCAND_STEALTH_BYTES(k) ((size_t)(k) * 384)
+
+/// @def SAP_SCAND_MATCH_BYTES
+/// @brief Size of a match record of a level.
+#define SAP_SCAND_MATCH_BYTES(k) (8 + 4 + 1 + 32 + SAP_SCAND_STEALTH_BYTES(k))
+
+/// @def SAP_SCAND_METRICS_BYTES
+/// @brief Body of the METRICS reply.
+#define SAP_SCAND_METRICS_BYTES (2 * (4 + 5 * 8))
+
+/// @def SAP_SCAND_QUERY_MAX
+/// @brief Most match records in one MATCHES reply (fits SAP_SCAND_MAX_BODY at every level).
+#define SAP_SCAND_QUERY_MAX 32
+
+static inline void sap_scand_put32(uint8_t* p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static inline void sap_scand_put64(uint8_t* p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static inline uint32_t sap_scand_get32(const uint8_t* p)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+static inline uint64_t sap_scand_get64(const uint8_t* p)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
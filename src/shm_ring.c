@@ -0,0 +1,326 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "shm_ring.h"
+#include "scan_stats.h"
+#include "wipe.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SHM_MAGIC "PQSAPSHM"
+#define SHM_VERSION 1
+/// The slots start on their own page.
+#define SHM_HEADER_BYTES 4096
+
+static size_t ring_bytes(uint64_t capacity)
+{
+    return SHM_HEADER_BYTES + capacity * sizeof(sap_shm_slot);
+}
+
+/**
+ * Workflow:
+ *  1. Creates the shared memory: a sealable memfd, or a named object that must
+ *     not exist yet.
+ *  2. Sizes and maps it, writes the header and marks every slot as never
+ *     published. The size of a memfd is sealed, so that a reader can rely on
+ *     the mapping.
+ */
+int sap_shm_writer_create(sap_shm_writer* w, const char* name, size_t capacity)
+{
+    uint64_t n = 2;
+    while (n < capacity) n <<= 1;
+    memset(w, 0, sizeof(*w));
+    w->map_bytes = ring_bytes(n);
+
+    if (name != NULL) {
+        if (strlen(name) >= sizeof(w->name)) {
+            return -1;
+        }
+        w->fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+        if (w->fd >= 0) strcpy(w->name, name);
+    } else {
+        w->fd = memfd_create("pqsap-ring", MFD_ALLOW_SEALING);
+    }
+    if (w->fd < 0) {
+        return -1;
+    }
+    void* p = MAP_FAILED;
+    if (ftruncate(w->fd, (off_t)w->map_bytes) == 0) {
+        p = mmap(NULL, w->map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, w->fd, 0);
+    }
+    if (p == MAP_FAILED) {
+        close(w->fd);
+        if (name != NULL) shm_unlink(name);
+        return -1;
+    }
+    if (name == NULL) fcntl(w->fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+
+    w->header = p;
+    w->slots = (sap_shm_slot*)((uint8_t*)p + SHM_HEADER_BYTES);
+    for (uint64_t i = 0; i < n; i++) atomic_init(&w->slots[i].seq, 0);
+    w->header->version = SHM_VERSION;
+    w->header->slot_bytes = sizeof(sap_shm_slot);
+    w->header->capacity = n;
+    atomic_init(&w->header->head, 0);
+    atomic_init(&w->header->wake, 0);
+    atomic_thread_fence(memory_order_release);
+    memcpy(w->header->magic, SHM_MAGIC, sizeof(w->header->magic));
+    return 0;
+}
+
+sap_shm_slot* sap_shm_writer_reserve(sap_shm_writer* w)
+{
+    sap_shm_slot* s = &w->slots[w->head & (w->header->capacity - 1)];
+    atomic_store_explicit(&s->seq, 2 * w->head + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    return s;
+}
+
+void sap_shm_writer_commit(sap_shm_writer* w, sap_shm_slot* slot)
+{
+    atomic_store_explicit(&slot->seq, 2 * w->head + 2, memory_order_release);
+    w->head++;
+    atomic_store_explicit(&w->header->head, w->head, memory_order_release);
+}
+
+int sap_shm_writer_push(sap_shm_writer* w, uint8_t level, const uint8_t* ct, size_t ct_bytes, uint8_t view_tag)
+{
+    if (ct_bytes > SAP_SHM_CT_BYTES) {
+        return -1;
+    }
+    sap_shm_slot* s = sap_shm_writer_reserve(w);
+    s->level = level;
+    s->view_tag = view_tag;
+    memcpy(s->ct, ct, ct_bytes);
+    sap_shm_writer_commit(w, s);
+    return 0;
+}
+
+void sap_shm_writer_flush(sap_shm_writer* w)
+{
+    atomic_store_explicit(&w->header->wake, (uint32_t)w->head, memory_order_release);
+    syscall(SYS_futex, &w->header->wake, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+void sap_shm_writer_close(sap_shm_writer* w)
+{
+    if (w->header != NULL) munmap(w->header, w->map_bytes);
+    if (w->fd >= 0) close(w->fd);
+    if (w->name[0] != '\0') shm_unlink(w->name);
+    memset(w, 0, sizeof(*w));
+    w->fd = -1;
+}
+
+/**
+ * Workflow:
+ *  1. Maps the header read-only and checks magic, version and slot layout.
+ *  2. Maps the whole ring read-only once the capacity is known, and checks that
+ *     the object is that large.
+ *  3. Starts at the oldest position the ring still holds.
+ */
+int sap_shm_reader_attach(sap_shm_reader* r, int fd)
+{
+    memset(r, 0, sizeof(*r));
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < SHM_HEADER_BYTES) {
+        return -1;
+    }
+    const sap_shm_header* h = mmap(NULL, SHM_HEADER_BYTES, PROT_READ, MAP_SHARED, fd, 0);
+    if (h == MAP_FAILED) {
+        return -1;
+    }
+    uint64_t n = h->capacity;
+    int ok = memcmp(h->magic, SHM_MAGIC, sizeof(h->magic)) == 0 && h->version == SHM_VERSION
+        && h->slot_bytes == sizeof(sap_shm_slot) && n >= 2 && (n & (n - 1)) == 0
+        && n <= ((uint64_t)st.st_size - SHM_HEADER_BYTES) / sizeof(sap_shm_slot);
+    munmap((void*)h, SHM_HEADER_BYTES);
+    if (!ok) {
+        return -1;
+    }
+
+    r->map_bytes = ring_bytes(n);
+    void* p = mmap(NULL, r->map_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        return -1;
+    }
+    r->header = p;
+    r->slots = (const sap_shm_slot*)((const uint8_t*)p + SHM_HEADER_BYTES);
+    r->mask = n - 1;
+    uint64_t head = atomic_load_explicit(&r->header->head, memory_order_acquire);
+    r->next = head > n ? head - n : 0;
+    return 0;
+}
+
+int sap_shm_reader_open(sap_shm_reader* r, const char* name)
+{
+    int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        memset(r, 0, sizeof(*r));
+        return -1;
+    }
+    int ret = sap_shm_reader_attach(r, fd);
+    close(fd);
+    return ret;
+}
+
+void sap_shm_reader_close(sap_shm_reader* r)
+{
+    if (r->header != NULL) munmap((void*)r->header, r->map_bytes);
+    memset(r, 0, sizeof(*r));
+}
+
+/// Adds the time since @p start to the caller's io_wait_cycles and returns @p ret.
+static int waited(uint64_t start, int ret)
+{
+    sap_stats_add(sap_stats_thread(), SAP_STAT_CYCLES_IO_WAIT, sap_stats_cycles() - start);
+    return ret;
+}
+
+int sap_shm_reader_wait(sap_shm_reader* r, int timeout_ms)
+{
+    uint64_t start = sap_stats_cycles();
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    end.tv_sec += timeout_ms / 1000;
+    end.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (end.tv_nsec >= 1000000000) {
+        end.tv_sec++;
+        end.tv_nsec -= 1000000000;
+    }
+
+    for (;;) {
+        uint32_t wake = atomic_load_explicit(&r->header->wake, memory_order_acquire);
+        if (atomic_load_explicit(&r->header->head, memory_order_acquire) > r->next) {
+            return waited(start, 1);
+        }
+        struct timespec now, left, *timeout = NULL;
+        if (timeout_ms >= 0) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            left.tv_sec = end.tv_sec - now.tv_sec;
+            left.tv_nsec = end.tv_nsec - now.tv_nsec;
+            if (left.tv_nsec < 0) {
+                left.tv_sec--;
+                left.tv_nsec += 1000000000;
+            }
+            if (left.tv_sec < 0) {
+                return waited(start, 0);
+            }
+            timeout = &left;
+        }
+        /* sleeps only if no flush happened since wake was read */
+        if (syscall(SYS_futex, &r->header->wake, FUTEX_WAIT, wake, timeout, NULL, 0) != 0 && errno == ETIMEDOUT) {
+            return waited(start, atomic_load_explicit(&r->header->head, memory_order_acquire) > r->next);
+        }
+    }
+}
+
+size_t sap_shm_reader_peek(sap_shm_reader* r, const sap_shm_slot** slots, uint64_t* seqs, size_t max)
+{
+    uint64_t head = atomic_load_explicit(&r->header->head, memory_order_acquire);
+    if (head > r->next + r->mask + 1) {
+        r->lost += head - (r->mask + 1) - r->next;
+        r->next = head - (r->mask + 1);
+    }
+    size_t n = 0;
+    for (; n < max && n <= r->mask; n++) {
+        uint64_t pos = r->next + n;
+        const sap_shm_slot* s = &r->slots[pos & r->mask];
+        uint64_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+        if (seq != 2 * pos + 2) {
+            if (n == 0 && seq > 2 * pos + 2) {
+                /* lapped since head was read */
+                r->lost++;
+                r->next++;
+                n--;
+                continue;
+            }
+            break;
+        }
+        slots[n] = s;
+        seqs[n] = seq;
+    }
+    return n;
+}
+
+size_t sap_shm_reader_release(sap_shm_reader* r, const sap_shm_slot* const* slots, const uint64_t* seqs, size_t n,
+    uint8_t* valid)
+{
+    size_t overwritten = 0;
+    atomic_thread_fence(memory_order_acquire);
+    for (size_t i = 0; i < n; i++) {
+        int same = atomic_load_explicit(&slots[i]->seq, memory_order_relaxed) == seqs[i];
+        if (valid != NULL) valid[i] = (uint8_t)same;
+        overwritten += !same;
+    }
+    r->next += n;
+    r->lost += overwritten;
+    return overwritten;
+}
+
+/**
+ * Workflow:
+ *  1. Takes the published run at the reader's position (see sap_shm_reader_peek()).
+ *  2. Scans it in place with sap_scan_mixed().
+ *  3. Checks the sequence numbers again and reports only the hits whose slot
+ *     was not overwritten during the scan.
+ *  4. Hands every hit to @p on_hit as a private copy of its slot. The sequence
+ *     number is checked once more after the copy, since the writer may have
+ *     reused the slot after step 3; such a hit is dropped and counted as lost.
+ */
+size_t sap_shm_reader_scan(sap_shm_reader* r, const sap_scan_keyset* ks, sap_shm_hit_fn on_hit, void* arg,
+    size_t* hits)
+{
+    const sap_shm_slot* slots[SAP_SHM_BATCH];
+    uint64_t seqs[SAP_SHM_BATCH];
+    const uint8_t* cts[SAP_SHM_BATCH];
+    uint8_t levels[SAP_SHM_BATCH], tags[SAP_SHM_BATCH], found[SAP_SHM_BATCH], valid[SAP_SHM_BATCH];
+    uint8_t ss[SAP_SHM_BATCH * 32];
+    sap_shm_slot copy;
+
+    uint64_t first = r->next;
+    size_t n = sap_shm_reader_peek(r, slots, seqs, SAP_SHM_BATCH);
+    size_t count = 0;
+    if (hits != NULL) *hits = 0;
+    if (n == 0) {
+        return r->next - first;
+    }
+    for (size_t i = 0; i < n; i++) {
+        cts[i] = slots[i]->ct;
+        levels[i] = slots[i]->level;
+        tags[i] = slots[i]->view_tag;
+    }
+    size_t found_n = sap_scan_mixed(found, ss, cts, levels, tags, n, ks);
+    if (found_n == SIZE_MAX) {
+        return SIZE_MAX;
+    }
+    uint64_t at = r->next;
+    sap_shm_reader_release(r, slots, seqs, n, valid);
+    for (size_t i = 0; found_n > 0 && i < n; i++) {
+        if (!found[i]) continue;
+        if (valid[i] && on_hit != NULL) {
+            copy.level = slots[i]->level;
+            copy.view_tag = slots[i]->view_tag;
+            memcpy(copy.ct, slots[i]->ct, sizeof(copy.ct));
+            atomic_thread_fence(memory_order_acquire);
+            valid[i] = atomic_load_explicit(&slots[i]->seq, memory_order_relaxed) == seqs[i];
+            atomic_init(&copy.seq, seqs[i]);
+            r->lost += !valid[i];
+        }
+        if (valid[i]) {
+            count++;
+            if (on_hit != NULL) on_hit(arg, at + i, &copy, ss + i * 32);
+        }
+        sap_wipe(ss + i * 32, 32);
+    }
+    if (hits != NULL) *hits = count;
+    return r->next - first;
+}
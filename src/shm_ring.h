@@ -0,0 +1,158 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "scan_mixed.h"
+
+/// @file shm_ring.h
+/// @brief Announcements passed from an ingest process to scanner processes in shared memory.
+///
+/// The ingest process creates a ring of fixed-size slots in a memfd, or in a named
+/// POSIX shared memory object, and writes every announcement it receives into the
+/// next slot. Scanner processes map the same memory read-only and scan the slots
+/// where they are. Nothing is copied after the writer's own copy, and nothing goes
+/// through a file. sap_shm_writer_reserve() even lets the writer receive an
+/// announcement straight into its slot.
+///
+/// Readers cannot write to the ring, so the writer never waits for them. It
+/// overwrites the oldest slot when the ring is full. Each slot carries a sequence
+/// number in the manner of a seqlock: odd while the writer fills the slot for
+/// position p (2p + 1), 2p + 2 once it is published. A reader takes the published
+/// run at its position, scans it in place, and then checks that the sequence
+/// numbers are unchanged. Slots overwritten in the meantime are dropped from the
+/// results and counted as lost, as are positions the writer lapped before the
+/// reader got to them.
+///
+/// An idle reader sleeps on a futex on the low 32 bits of the published count.
+/// The writer wakes all sleepers with sap_shm_writer_flush(), once per burst of
+/// announcements rather than per slot.
+
+/// @def SAP_SHM_CT_BYTES
+/// @brief Room for the largest ephemeral public key (Kyber1024).
+#define SAP_SHM_CT_BYTES 1568
+
+/// @def SAP_SHM_BATCH
+/// @brief Most announcements sap_shm_reader_scan() takes at a time.
+#define SAP_SHM_BATCH 256
+
+/// @brief One announcement; the ciphertext starts on a cache line.
+typedef struct {
+    _Atomic uint64_t seq;               /**< 2p + 1 while written for position p, 2p + 2 when published. */
+    uint8_t level;                      /**< KYBER_K of the announcement. */
+    uint8_t view_tag;
+    _Alignas(64) uint8_t ct[SAP_SHM_CT_BYTES];
+} sap_shm_slot;
+
+/// @brief Start of the shared memory, followed by the slots.
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t slot_bytes;                /**< sizeof(sap_shm_slot) of the writer. */
+    uint64_t capacity;                  /**< Number of slots, a power of two. */
+    _Alignas(64) _Atomic uint64_t head; /**< Positions published so far. */
+    _Atomic uint32_t wake;              /**< Low 32 bits of head at the last flush; the futex word. */
+} sap_shm_header;
+
+/// @brief The ingest side of a ring.
+typedef struct {
+    sap_shm_header* header;
+    sap_shm_slot* slots;
+    size_t map_bytes;
+    int fd;
+    uint64_t head;                      /**< Next position to write. */
+    char name[256];                     /**< Shared memory object name, empty for a memfd. */
+} sap_shm_writer;
+
+/// @brief The scanner side of a ring.
+typedef struct {
+    const sap_shm_header* header;
+    const sap_shm_slot* slots;
+    size_t map_bytes;
+    uint64_t mask;
+    uint64_t next;                      /**< Next position to read. */
+    uint64_t lost;                      /**< Positions overwritten before they were scanned. */
+} sap_shm_reader;
+
+/// @brief Called by sap_shm_reader_scan() for every hit.
+///
+/// @p slot is a private copy of the ring slot, taken after the hit was found and
+/// checked against the sequence number, so the writer cannot change it during
+/// the call. It is valid during the call only.
+typedef void (*sap_shm_hit_fn)(void* arg, uint64_t pos, const sap_shm_slot* slot, const uint8_t ss[32]);
+
+/// @brief Creates a ring.
+///
+/// @param[out] w Writer; release with sap_shm_writer_close().
+/// @param[in] name Name for shm_open() (such as "/pqsap-ring"), or NULL for an
+/// anonymous memfd whose descriptor readers inherit or receive.
+/// @param[in] capacity Number of slots, rounded up to a power of two.
+/// @return 0 on success, -1 if the memory cannot be created or mapped.
+int sap_shm_writer_create(sap_shm_writer* w, const char* name, size_t capacity);
+
+/// @brief Returns the slot for the next position, to be filled and passed to sap_shm_writer_commit().
+///
+/// The slot is marked as being written, so that readers in the middle of
+/// scanning its previous contents drop their results.
+sap_shm_slot* sap_shm_writer_reserve(sap_shm_writer* w);
+
+/// @brief Publishes the slot returned by sap_shm_writer_reserve().
+void sap_shm_writer_commit(sap_shm_writer* w, sap_shm_slot* slot);
+
+/// @brief Copies an announcement into the next slot and publishes it.
+///
+/// @return 0 on success, -1 if @p ct_bytes does not fit a slot.
+int sap_shm_writer_push(sap_shm_writer* w, uint8_t level, const uint8_t* ct, size_t ct_bytes, uint8_t view_tag);
+
+/// @brief Wakes the readers sleeping in sap_shm_reader_wait().
+void sap_shm_writer_flush(sap_shm_writer* w);
+
+/// @brief Unmaps the ring, closes it and removes its name.
+void sap_shm_writer_close(sap_shm_writer* w);
+
+/// @brief Maps the ring behind a descriptor read-only (the descriptor may be closed afterwards).
+///
+/// Reading starts at the oldest position still in the ring.
+///
+/// @return 0 on success, -1 if it is not a ring or cannot be mapped.
+int sap_shm_reader_attach(sap_shm_reader* r, int fd);
+
+/// @brief Maps a named ring read-only.
+int sap_shm_reader_open(sap_shm_reader* r, const char* name);
+
+/// @brief Unmaps the ring.
+void sap_shm_reader_close(sap_shm_reader* r);
+
+/// @brief Waits until a position at or after the reader's is published.
+///
+/// @param[in] timeout_ms Longest wait, or -1 for no limit.
+/// @return 1 if something is published, 0 on timeout.
+int sap_shm_reader_wait(sap_shm_reader* r, int timeout_ms);
+
+/// @brief Returns the published run at the reader's position, in place.
+///
+/// Positions that were overwritten before the call are skipped and counted.
+///
+/// @param[out] slots Receives up to @p max slots, oldest first.
+/// @param[out] seqs Receives their sequence numbers, for sap_shm_reader_release().
+/// @return The number of slots; the first one is at position r->next.
+size_t sap_shm_reader_peek(sap_shm_reader* r, const sap_shm_slot** slots, uint64_t* seqs, size_t max);
+
+/// @brief Moves past @p n slots from sap_shm_reader_peek() and checks that they were not overwritten.
+///
+/// @param[out] valid If not NULL, valid[i] is set to 1 if slot i still held the
+/// same announcement, otherwise to 0.
+/// @return The number of slots that were overwritten while in use.
+size_t sap_shm_reader_release(sap_shm_reader* r, const sap_shm_slot* const* slots, const uint64_t* seqs, size_t n,
+    uint8_t* valid);
+
+/// @brief Scans the next published run in place with sap_scan_mixed() and reports the hits that are still valid.
+///
+/// @param[in] ks Prepared keys.
+/// @param[in] on_hit Called for every hit, or NULL.
+/// @param[in] arg Passed to @p on_hit.
+/// @param[out] hits If not NULL, receives the number of hits reported.
+/// @return The number of positions consumed, 0 if nothing new is published, or
+/// SIZE_MAX if out of memory.
+size_t sap_shm_reader_scan(sap_shm_reader* r, const sap_scan_keyset* ks, sap_shm_hit_fn on_hit, void* arg,
+    size_t* hits);
@@ -0,0 +1,175 @@
+#include "stealth_avx2.h"
+#include <string.h>
+#include <immintrin.h>
+
+/*
+ * Compiled once per KYBER_K against the AVX2 library headers, with -mavx2; it is
+ * only called by the AVX2 backend, after the CPUID check.
+ *
+ * In the NTT domain of the AVX2 library each 128-coefficient half h of a
+ * polynomial is a 16x8 block stored row by row: the vector at h + 16*row holds the
+ * standard-order coefficients h + 8*col + row in lane col. Rows 2m and 2m+1 thus
+ * hold both halves of the base multiplication pairs 4*col + m (plus 64 for the
+ * upper half), so a pair of rows can be multiplied, accumulated, reduced and
+ * packed without any shuffles until the final 12-bit packing.
+ */
+
+#define V_Q    _mm256_set1_epi16(KYBER_Q)
+#define V_QINV _mm256_set1_epi16(-3327)
+
+/* (-1)^m * zetas[64 + 32*(h/128) + 2*col + m/2] of libs/ref/ntt.c, indexed [h/128][m][col] */
+static const int16_t basemul_zetas[2][4][16] __attribute__((aligned(32))) = {
+    {
+        { -1103, 555, -1251, 1550, 422, 177, -291, 1574, -246, 1159, -777, -602, -1590, -872, 418, -156 },
+        { 1103, -555, 1251, -1550, -422, -177, 291, -1574, 246, -1159, 777, 602, 1590, 872, -418, 156 },
+        { 430, 843, 871, 105, 587, -235, -460, 1653, 778, -147, 1483, 1119, 644, 349, 329, -75 },
+        { -430, -843, -871, -105, -587, 235, 460, -1653, -778, 147, -1483, -1119, -644, -349, -329, 75 },
+    },
+    {
+        { 817, 603, 1322, -1465, -1215, 1218, -874, -1187, -1185, -1278, -1510, -870, -108, 996, 958, 1522 },
+        { -817, -603, -1322, 1465, 1215, -1218, 874, 1187, 1185, 1278, 1510, 870, 108, -996, -958, -1522 },
+        { 1097, 610, -1285, 384, -136, -1335, 220, -1659, -1530, 794, -854, 478, -308, 991, -1460, 1628 },
+        { -1097, -610, 1285, -384, 136, 1335, -220, 1659, 1530, -794, 854, -478, 308, -991, 1460, -1628 },
+    },
+};
+
+static const int16_t basemul_zetas_qinv[2][4][16] __attribute__((aligned(32))) = {
+    {
+        { -335, -11477, -32227, 20494, -27738, 945, -14883, 6182, 32010, 10631, 29175, -28762, -18486, 17560, -14430, -5276 },
+        { 335, 11477, 32227, -20494, 27738, -945, 14883, -6182, -32010, -10631, -29175, 28762, 18486, -17560, 14430, 5276 },
+        { 11182, 13387, -14233, -21655, 13131, -4587, 23092, 5493, -32502, 30317, -18741, 12639, 20100, 18525, 19529, -12619 },
+        { -11182, -13387, 14233, 21655, -13131, 4587, -23092, -5493, 32502, -30317, 18741, -12639, -20100, -18525, -19529, 12619 },
+    },
+    {
+        { -31183, 25435, -7382, 24391, -20927, 10946, 24214, 16989, 10335, -7934, -22502, 10906, 31636, 28644, 23998, -17422 },
+        { 31183, -25435, 7382, -24391, 20927, -10946, -24214, -16989, -10335, 7934, 22502, -10906, -31636, -28644, -23998, 17422 },
+        { 20297, 2146, 15355, -32384, -6280, -14903, -11044, 14469, -21498, -20198, 23210, -17442, -23860, -20257, 7756, 23132 },
+        { -20297, -2146, -15355, 32384, 6280, 14903, 11044, -14469, 21498, 20198, -23210, 17442, 23860, 20257, -7756, -23132 },
+    },
+};
+
+/* Montgomery multiplication a*b*2^-16 with bqinv = b*QINV mod 2^16 */
+static inline __m256i fqmul(__m256i a, __m256i b, __m256i bqinv)
+{
+    __m256i lo = _mm256_mullo_epi16(a, bqinv);
+    __m256i hi = _mm256_mulhi_epi16(a, b);
+    lo = _mm256_mulhi_epi16(lo, V_Q);
+    return _mm256_sub_epi16(hi, lo);
+}
+
+/* barrett_reduce() followed by the conditional addition of q in poly_tobytes() */
+static inline __m256i reduce_canonical(__m256i a)
+{
+    __m256i t = _mm256_mulhi_epi16(a, _mm256_set1_epi16(20159));
+    t = _mm256_mulhrs_epi16(t, _mm256_set1_epi16(1 << 5));
+    a = _mm256_sub_epi16(a, _mm256_mullo_epi16(t, V_Q));
+    return _mm256_add_epi16(a, _mm256_and_si256(_mm256_srai_epi16(a, 15), V_Q));
+}
+
+/* Writes the 12 low bytes of each 128-bit lane to p and p + 96 */
+static inline void store_pair(uint8_t* p, __m256i v)
+{
+    __m128i lo = _mm256_castsi256_si128(v);
+    __m128i hi = _mm256_extracti128_si256(v, 1);
+    int32_t w;
+
+    _mm_storel_epi64((__m128i*)p, lo);
+    w = _mm_extract_epi32(lo, 2);
+    memcpy(p + 8, &w, 4);
+    _mm_storel_epi64((__m128i*)(p + 96), hi);
+    w = _mm_extract_epi32(hi, 2);
+    memcpy(p + 104, &w, 4);
+}
+
+/*
+ * Packs one half of a polynomial. v[2m] and v[2m+1] hold the canonical pair
+ * (c0, c1) of pair 4*col + m in lane col; the 3 bytes of pair P go to r + 3*P.
+ */
+static inline void pack_half(uint8_t r[192], const __m256i v[8])
+{
+    const __m256i f = _mm256_set1_epi32(1 | (4096 << 16));
+    const __m256i idx = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                         0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    __m256i lo[4], hi[4], t0, t1, t2, t3;
+    int m;
+
+    /* c0 | c1 << 12 per 32-bit lane: cols 0-3 and 8-11 in lo, 4-7 and 12-15 in hi */
+    for (m = 0; m < 4; m++) {
+        lo[m] = _mm256_madd_epi16(_mm256_unpacklo_epi16(v[2 * m], v[2 * m + 1]), f);
+        hi[m] = _mm256_madd_epi16(_mm256_unpackhi_epi16(v[2 * m], v[2 * m + 1]), f);
+    }
+
+    /* 4x4 transposes so that each 128-bit lane holds the pairs m = 0..3 of one col */
+    for (int k = 0; k < 2; k++) {
+        __m256i* d = k ? hi : lo;
+        uint8_t* p = r + 48 * k;
+
+        t0 = _mm256_unpacklo_epi32(d[0], d[1]);
+        t1 = _mm256_unpacklo_epi32(d[2], d[3]);
+        t2 = _mm256_unpackhi_epi32(d[0], d[1]);
+        t3 = _mm256_unpackhi_epi32(d[2], d[3]);
+        store_pair(p, _mm256_shuffle_epi8(_mm256_unpacklo_epi64(t0, t1), idx));
+        store_pair(p + 12, _mm256_shuffle_epi8(_mm256_unpackhi_epi64(t0, t1), idx));
+        store_pair(p + 24, _mm256_shuffle_epi8(_mm256_unpacklo_epi64(t2, t3), idx));
+        store_pair(p + 36, _mm256_shuffle_epi8(_mm256_unpackhi_epi64(t2, t3), idx));
+    }
+}
+
+_Static_assert(KYBER_K * KYBER_ETA1 * KYBER_Q + 4096 < 32768, "accumulators would overflow");
+
+/* Maps coefficients in [0, q) to (-q/2, q/2] */
+static inline __m256i center(__m256i a)
+{
+    const __m256i half = _mm256_set1_epi16(KYBER_Q / 2);
+    return _mm256_sub_epi16(a, _mm256_and_si256(_mm256_cmpgt_epi16(a, half), V_Q));
+}
+
+/**
+ * The multi-pass code multiplies with Montgomery reductions (a factor 2^-16 per
+ * product) and undoes them with poly_tomont(). Because the coefficients of s are
+ * at most KYBER_ETA1 in absolute value, the products with the centered entries of A
+ * are below 2^13 and are computed exactly with 16-bit multiplications instead;
+ * only the product with zeta (in Montgomery form) needs a reduction, which also
+ * cancels its factor. Both sums stay below KYBER_K * KYBER_ETA1 * q in absolute
+ * value, so they fit an int16 together with pkpv without intermediate reductions.
+ *
+ * Workflow:
+ *  1. For every output polynomial and every pair of rows, accumulates the base
+ *     products a[i][j] * s[j] over j.
+ *  2. Adds pkpv and reduces the result to [0, q).
+ *  3. Packs the 128 coefficients of each half into 192 bytes.
+ */
+void stealth_pub_key_fused_avx2(uint8_t r[KYBER_POLYVECBYTES], const polyvec a[KYBER_K],
+    const polyvec* s, const polyvec* pkpv)
+{
+    __m256i v[8];
+
+    for (int i = 0; i < KYBER_K; i++) {
+        for (int h = 0; h < 2; h++) {
+            for (int m = 0; m < 4; m++) {
+                const int k = 8 * h + 2 * m;
+                const __m256i z = _mm256_load_si256((const __m256i*)basemul_zetas[h][m]);
+                const __m256i zq = _mm256_load_si256((const __m256i*)basemul_zetas_qinv[h][m]);
+                __m256i c0 = _mm256_load_si256(&pkpv->vec[i].vec[k]);
+                __m256i c1 = _mm256_load_si256(&pkpv->vec[i].vec[k + 1]);
+
+                for (int j = 0; j < KYBER_K; j++) {
+                    const __m256i a0 = center(_mm256_load_si256(&a[i].vec[j].vec[k]));
+                    const __m256i a1 = center(_mm256_load_si256(&a[i].vec[j].vec[k + 1]));
+                    const __m256i b0 = _mm256_load_si256(&s->vec[j].vec[k]);
+                    const __m256i b1 = _mm256_load_si256(&s->vec[j].vec[k + 1]);
+
+                    /* c0 += a1*b1*zeta + a0*b0, c1 += a0*b1 + a1*b0 */
+                    c0 = _mm256_add_epi16(c0, fqmul(_mm256_mullo_epi16(a1, b1), z, zq));
+                    c0 = _mm256_add_epi16(c0, _mm256_mullo_epi16(a0, b0));
+                    c1 = _mm256_add_epi16(c1, _mm256_mullo_epi16(a0, b1));
+                    c1 = _mm256_add_epi16(c1, _mm256_mullo_epi16(a1, b0));
+                }
+
+                v[2 * m] = reduce_canonical(c0);
+                v[2 * m + 1] = reduce_canonical(c1);
+            }
+            pack_half(r + KYBER_POLYBYTES * i + 192 * h, v);
+        }
+    }
+}
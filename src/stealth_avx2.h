@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include "protocol_api.h"
+
+/// @file stealth_avx2.h
+/// @brief Fused stealth public key computation for the AVX2 backend.
+///
+/// The stealth public key is A * s + k_pub, reduced and serialized. Computing it
+/// with the polynomial API takes five passes over the K x 256 coefficients
+/// (polyvec_basemul_acc_montgomery(), poly_tomont(), polyvec_add(),
+/// polyvec_reduce() and polyvec_tobytes()). The kernel below does all of it per
+/// group of 16 coefficient pairs while they stay in registers, and writes the
+/// 12-bit packed output directly.
+
+#define stealth_pub_key_fused_avx2 SAP_NAMESPACE(stealth_pub_key_fused_avx2)
+/// @brief Computes polyvec_tobytes(reduce(A * s * 2^16 + pkpv)) in one pass.
+///
+/// All operands are in the NTT domain and in the coefficient order of the AVX2
+/// library, as returned by gen_matrix(), poly_getnoise_eta1() and unpack_pk().
+/// The output is byte-identical to the multi-pass computation. The CPU must
+/// support AVX2.
+///
+/// @param[out] r KYBER_POLYVECBYTES bytes of packed output.
+/// @param[in] a Rows of the matrix A (coefficients in [0, q)).
+/// @param[in] s The secret vector (small coefficients, as sampled by CBD).
+/// @param[in] pkpv The public key vector (12-bit coefficients).
+void stealth_pub_key_fused_avx2(uint8_t r[KYBER_POLYVECBYTES], const polyvec a[KYBER_K],
+    const polyvec* s, const polyvec* pkpv);
@@ -0,0 +1,130 @@
+#include "protocol_api.h"
+#include "wipe.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/// Outputs whose secrets are sampled in one stealth_noise_batch() call.
+#define STEALTH_KEY_CHUNK 16
+
+typedef struct {
+    uint8_t* out;
+    const uint8_t* ss;
+    size_t n;
+    const sap_spend_key* key;
+} stealth_key_job;
+
+void sap_spend_key_init(sap_spend_key* key, const uint8_t k_priv[SECRET_KEY_BYTES])
+{
+    for (int j = 0; j < KYBER_K; j++) {
+        const uint8_t* b = k_priv + j * KYBER_POLYBYTES;
+        for (int i = 0; i < KYBER_N / 2; i++) {
+            int16_t a0 = (int16_t)((b[3 * i] | (uint16_t)b[3 * i + 1] << 8) & 0xfff);
+            int16_t a1 = (int16_t)((b[3 * i + 1] >> 4 | (uint16_t)b[3 * i + 2] << 4) & 0xfff);
+            key->s[j][2 * i] = a0 >= KYBER_Q ? a0 - KYBER_Q : a0;
+            key->s[j][2 * i + 1] = a1 >= KYBER_Q ? a1 - KYBER_Q : a1;
+        }
+    }
+}
+
+/**
+ * Workflow:
+ *  1. Reads the sampled secret s in the coefficient order in which
+ *     calculate_stealth_pub_key() uses it as an NTT-domain operand: each
+ *     128-coefficient half as a transposed 16x8 block (the AVX2 order, see
+ *     backend_impl.c), so that coefficient 8 * col + row is sample 16 * row + col.
+ *  2. Adds it to the spending key's secret vector, which is in standard order,
+ *     reduces into [0, q) and packs two 12-bit coefficients into three bytes.
+ */
+static void add_and_pack(uint8_t out[STEALTH_SECRET_KEY_BYTES], const int16_t s[KYBER_K][KYBER_N],
+    const sap_spend_key* key)
+{
+    for (int j = 0; j < KYBER_K; j++) {
+        uint8_t* b = out + j * KYBER_POLYBYTES;
+        for (int i = 0; i < KYBER_N / 2; i++) {
+            uint16_t t[2];
+            for (int k = 0; k < 2; k++) {
+                int c = 2 * i + k, h = c & ~127, row = c & 7, col = (c & 127) >> 3;
+                int16_t r = (int16_t)(key->s[j][c] + s[j][h + 16 * row + col]);
+                r += (r >> 15) & KYBER_Q;
+                r -= KYBER_Q;
+                r += (r >> 15) & KYBER_Q;
+                t[k] = (uint16_t)r;
+            }
+            b[3 * i] = (uint8_t)t[0];
+            b[3 * i + 1] = (uint8_t)(t[0] >> 8 | t[1] << 4);
+            b[3 * i + 2] = (uint8_t)(t[1] >> 4);
+        }
+    }
+}
+
+void calculate_stealth_priv_key(uint8_t stealth_priv_key[STEALTH_SECRET_KEY_BYTES],
+    const uint8_t ss[SS_BYTES],
+    const sap_spend_key* key)
+{
+    _Alignas(64) int16_t s[KYBER_K][KYBER_N];
+    sap_stealth_noise_batch(&s[0][0], ss, 1);
+    add_and_pack(stealth_priv_key, s, key);
+    sap_wipe(s, sizeof(s));
+}
+
+static void* stealth_key_worker(void* arg)
+{
+    stealth_key_job* job = arg;
+    _Alignas(64) int16_t s[STEALTH_KEY_CHUNK][KYBER_K][KYBER_N];
+    for (size_t i = 0; i < job->n; i += STEALTH_KEY_CHUNK) {
+        size_t m = job->n - i < STEALTH_KEY_CHUNK ? job->n - i : STEALTH_KEY_CHUNK;
+        sap_stealth_noise_batch(&s[0][0][0], job->ss + i * SS_BYTES, m);
+        for (size_t j = 0; j < m; j++) {
+            add_and_pack(job->out + (i + j) * STEALTH_SECRET_KEY_BYTES, s[j], job->key);
+        }
+    }
+    sap_wipe(s, sizeof(s));
+    return NULL;
+}
+
+/**
+ * Workflow:
+ *  1. Uses at most one thread per STEALTH_KEY_CHUNK outputs.
+ *  2. Splits [0, n) into contiguous ranges, one per thread; a range whose thread
+ *     cannot be started runs on the calling thread.
+ *  3. Each thread samples the secrets of STEALTH_KEY_CHUNK outputs at a time with
+ *     the backend's stealth_noise_batch() and packs the keys.
+ */
+int calculate_stealth_priv_keys(uint8_t* stealth_priv_keys, const uint8_t* ss, size_t n,
+    const sap_spend_key* key, unsigned int threads)
+{
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (unsigned int)cpus : 1;
+    }
+    size_t chunks = (n + STEALTH_KEY_CHUNK - 1) / STEALTH_KEY_CHUNK;
+    if (threads > chunks) threads = chunks > 0 ? (unsigned int)chunks : 1;
+
+    pthread_t* tids = malloc(threads * sizeof(pthread_t));
+    stealth_key_job* jobs = malloc(threads * sizeof(stealth_key_job));
+    if (tids == NULL || jobs == NULL) {
+        free(tids);
+        free(jobs);
+        return -1;
+    }
+    unsigned int started = 0;
+    for (unsigned int t = 0; t < threads; t++) {
+        size_t begin = chunks * t / threads * STEALTH_KEY_CHUNK;
+        size_t end = chunks * (t + 1) / threads * STEALTH_KEY_CHUNK;
+        if (end > n) end = n;
+        jobs[t] = (stealth_key_job){ stealth_priv_keys + begin * STEALTH_SECRET_KEY_BYTES, ss + begin * SS_BYTES,
+            end - begin, key };
+        if (t + 1 == threads || pthread_create(&tids[started], NULL, stealth_key_worker, &jobs[t]) != 0) {
+            stealth_key_worker(&jobs[t]);
+        } else {
+            started++;
+        }
+    }
+    for (unsigned int t = 0; t < started; t++) {
+        pthread_join(tids[t], NULL);
+    }
+    free(tids);
+    free(jobs);
+    return 0;
+}
@@ -0,0 +1,448 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "tune.h"
+#include "corpus.h"
+#include "scan_mixed.h"
+#include "wipe.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TUNE_VERSION 1
+/// Distinct announcements of the synthetic register; a multiple of every batch size tried.
+#define TUNE_N 1024
+/// Batch sizes tried, all dividing TUNE_N.
+static const size_t tune_batches[] = { 16, 64, 256, 1024 };
+/// Ciphertext bytes of the register when the last-level cache size is unknown.
+#define TUNE_DEFAULT_LLC (32u << 20)
+/// Upper bound of the register's ciphertext bytes.
+#define TUNE_MAX_BYTES ((size_t)1 << 30)
+/// Shortest measurement of one configuration.
+#define TUNE_MIN_SLICE_MS 10
+
+static const char* const backend_names[SAP_BACKEND_COUNT] = { "ref", "avx2", "avx512" };
+
+static const sap_scan_level* const levels[SAP_SCAN_MIXED_LEVELS] = {
+    &pqsap_kyber512_scan_level, &pqsap_kyber768_scan_level, &pqsap_kyber1024_scan_level
+};
+
+static const sap_backend* (*const level_active[SAP_SCAN_MIXED_LEVELS])(void) = {
+    pqsap_kyber512_backend_active, pqsap_kyber768_backend_active, pqsap_kyber1024_backend_active
+};
+
+static const sap_backend* (*const level_get[SAP_SCAN_MIXED_LEVELS])(sap_backend_id) = {
+    pqsap_kyber512_backend_get, pqsap_kyber768_backend_get, pqsap_kyber1024_backend_get
+};
+
+static int (*const level_use[SAP_SCAN_MIXED_LEVELS])(sap_backend_id) = {
+    pqsap_kyber512_backend_use, pqsap_kyber768_backend_use, pqsap_kyber1024_backend_use
+};
+
+static uint64_t now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static unsigned int usable_cpus(void)
+{
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return 1;
+    }
+    int n = CPU_COUNT(&set);
+    return n > 0 ? (unsigned int)n : 1;
+}
+
+/// Returns the size of the last-level cache in bytes, TUNE_DEFAULT_LLC if unknown.
+static size_t llc_bytes(void)
+{
+    long size = 0;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (size <= 0) size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    return size > 0 ? (size_t)size : TUNE_DEFAULT_LLC;
+}
+
+/// Copies the "model name" of /proc/cpuinfo, or "unknown".
+static void cpu_model(char* out, size_t len)
+{
+    snprintf(out, len, "unknown");
+    FILE* f = fopen("/proc/cpuinfo", "r");
+    if (f == NULL) {
+        return;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char* colon = strchr(line, ':');
+        if (strncmp(line, "model name", 10) == 0 && colon != NULL) {
+            colon += 1 + (colon[1] == ' ');
+            colon[strcspn(colon, "\n")] = '\0';
+            snprintf(out, len, "%s", colon);
+            break;
+        }
+    }
+    fclose(f);
+}
+
+/* ---- scanning with a batch size and threads ---- */
+
+typedef struct {
+    const sap_scan_level* level;
+    uint8_t* hits;
+    uint8_t* ss;
+    const uint8_t* const* cts;
+    const uint8_t* view_tags;
+    size_t n;
+    size_t batch;
+    const void* key;
+    uint64_t deadline_ns;       /**< 0: one pass over the register; otherwise loop over it until then. */
+    _Atomic size_t next;
+    _Atomic size_t found;       /**< Hits, or announcements scanned when looping. */
+} scan_job;
+
+static void* scan_worker(void* arg)
+{
+    scan_job* j = arg;
+    for (;;) {
+        if (j->deadline_ns != 0 && now_ns() >= j->deadline_ns) {
+            break;
+        }
+        size_t at = atomic_fetch_add(&j->next, j->batch);
+        if (j->deadline_ns != 0) {
+            at %= j->n;
+        } else if (at >= j->n) {
+            break;
+        }
+        size_t len = j->n - at < j->batch ? j->n - at : j->batch;
+        size_t f = j->level->scan(j->hits + at, j->ss != NULL ? j->ss + at * 32 : NULL, j->cts + at,
+            j->view_tags + at, len, j->key);
+        atomic_fetch_add(&j->found, j->deadline_ns != 0 ? len : f);
+    }
+    return NULL;
+}
+
+/// Runs @p j on @p threads threads, the calling one included.
+static int run_job(scan_job* j, unsigned int threads)
+{
+    pthread_t ids[threads > 1 ? threads - 1 : 1];
+    unsigned int started = 0;
+    while (started + 1 < threads && pthread_create(&ids[started], NULL, scan_worker, j) == 0) started++;
+    scan_worker(j);
+    for (unsigned int i = 0; i < started; i++) pthread_join(ids[i], NULL);
+    return started + 1 == threads ? 0 : -1;
+}
+
+size_t sap_tune_scan(const sap_tune_profile* p, uint8_t* hits, uint8_t* ss, const uint8_t* const* cts,
+    const uint8_t* view_tags, size_t n, const void* key)
+{
+    if (p->kyber_k < 2 || p->kyber_k > 4) {
+        return SIZE_MAX;
+    }
+    scan_job j = { .level = levels[p->kyber_k - 2], .hits = hits, .ss = ss, .cts = cts, .view_tags = view_tags,
+        .n = n, .batch = p->batch > 0 ? p->batch : 256, .key = key };
+    atomic_init(&j.next, 0);
+    atomic_init(&j.found, 0);
+    unsigned int threads = p->threads > 0 ? p->threads : 1;
+    size_t batches = (n + j.batch - 1) / j.batch;
+    if (threads > batches) threads = batches > 0 ? (unsigned int)batches : 1;
+    if (run_job(&j, threads) != 0) {
+        return SIZE_MAX;
+    }
+    return atomic_load(&j.found);
+}
+
+/* ---- tuning ---- */
+
+typedef struct {
+    const sap_scan_level* level;
+    const uint8_t* const* cts;
+    const uint8_t* view_tags;
+    uint8_t* hits;
+    const void* key;
+    uint64_t slice_ns;
+    size_t n;
+    size_t next;                /**< Where the next measurement starts, so it reads announcements not in cache. */
+} bench_ctx;
+
+/// Returns the announcements per second of one configuration, 0 if it could not run.
+static double measure(bench_ctx* b, size_t batch, unsigned int threads)
+{
+    uint64_t start = now_ns();
+    scan_job j = { .level = b->level, .hits = b->hits, .cts = b->cts, .view_tags = b->view_tags, .n = b->n,
+        .batch = batch, .key = b->key, .deadline_ns = start + b->slice_ns };
+    atomic_init(&j.next, b->next);
+    atomic_init(&j.found, 0);
+    if (run_job(&j, threads) != 0) {
+        return 0;
+    }
+    b->next = atomic_load(&j.next) % b->n / TUNE_N * TUNE_N;
+    return atomic_load(&j.found) / ((now_ns() - start) / 1e9);
+}
+
+/**
+ * Workflow:
+ *  1. Generates TUNE_N announcements and prepares their key, then repeats their
+ *     ciphertexts into a register a quarter larger than the last-level cache, so
+ *     that scanning reads them from memory as with a real register.
+ *  2. Splits the budget among the measurements: one per supported backend, one
+ *     per batch size and one per thread count (1, 2, 4, ... and all usable CPUs).
+ *  3. Measures the backends with 256-announcement batches on one thread, then the
+ *     batch sizes with the fastest backend, then the thread counts, keeping the
+ *     fastest setting at each step.
+ *  4. Restores the backend that was active before.
+ */
+int sap_tune_run(sap_tune_profile* p, uint32_t kyber_k, unsigned int budget_ms)
+{
+    if (kyber_k < 2 || kyber_k > 4) {
+        return -1;
+    }
+    memset(p, 0, sizeof(*p));
+    p->kyber_k = kyber_k;
+    p->cpus = usable_cpus();
+    cpu_model(p->cpu, sizeof(p->cpu));
+    if (budget_ms == 0) budget_ms = SAP_TUNE_BUDGET_MS;
+
+    corpus_params params = { .kyber_k = kyber_k, .n = TUNE_N, .match_rate = 1.0 / 64, .threads = p->cpus };
+    for (int i = 0; i < CORPUS_SEED_BYTES; i++) params.seed[i] = (uint8_t)(0x5a ^ i);
+    corpus c;
+    if (corpus_generate(&c, &params) != 0) {
+        return -1;
+    }
+    const sap_scan_level* level = levels[kyber_k - 2];
+    size_t ct_bytes, pk_bytes, sk_bytes;
+    corpus_level_sizes(kyber_k, &ct_bytes, &pk_bytes, &sk_bytes);
+    size_t llc = llc_bytes(), bytes = llc + llc / 4;
+    if (bytes > TUNE_MAX_BYTES) bytes = TUNE_MAX_BYTES;
+    size_t n = (bytes / ct_bytes + TUNE_N - 1) / TUNE_N * TUNE_N;
+    uint8_t* tiled = malloc(n * ct_bytes);
+    const uint8_t** cts = malloc(n * sizeof(*cts));
+    uint8_t* view_tags = malloc(n);
+    uint8_t* hits = malloc(n);
+    void* key = malloc(level->key_bytes);
+    int ret = -1;
+    if (tiled == NULL || cts == NULL || view_tags == NULL || hits == NULL || key == NULL) {
+        goto out;
+    }
+    for (size_t i = 0; i < n; i++) {
+        memcpy(tiled + i * ct_bytes, corpus_ct(&c, i % TUNE_N), ct_bytes);
+        cts[i] = tiled + i * ct_bytes;
+        view_tags[i] = corpus_tag(&c, i % TUNE_N)[0];
+    }
+    level->key_init(key, c.v_priv);
+
+    unsigned int thread_counts[34], n_threads = 0;
+    for (unsigned int t = 1; t < p->cpus && n_threads < 32; t *= 2) thread_counts[n_threads++] = t;
+    thread_counts[n_threads++] = p->cpus;
+    unsigned int n_backends = 0;
+    for (int b = 0; b < SAP_BACKEND_COUNT; b++) n_backends += sap_backend_supported((sap_backend_id)b);
+    unsigned int trials = n_backends + sizeof(tune_batches) / sizeof(tune_batches[0]) + n_threads;
+    uint64_t slice_ms = budget_ms / trials > TUNE_MIN_SLICE_MS ? budget_ms / trials : TUNE_MIN_SLICE_MS;
+    bench_ctx b = { level, cts, view_tags, hits, key, slice_ms * 1000000, n, 0 };
+
+    const sap_backend* before = level_active[kyber_k - 2]();
+    p->batch = 256;
+    p->threads = 1;
+    for (int id = 0; id < SAP_BACKEND_COUNT; id++) {
+        if (level_use[kyber_k - 2]((sap_backend_id)id) != 0) continue;
+        double t = measure(&b, p->batch, 1);
+        if (t > p->throughput) {
+            p->throughput = t;
+            p->backend = (sap_backend_id)id;
+        }
+    }
+    level_use[kyber_k - 2](p->backend);
+    for (size_t i = 0; i < sizeof(tune_batches) / sizeof(tune_batches[0]); i++) {
+        double t = measure(&b, tune_batches[i], 1);
+        if (t > p->throughput) {
+            p->throughput = t;
+            p->batch = tune_batches[i];
+        }
+    }
+    for (unsigned int i = 0; i < n_threads; i++) {
+        double t = measure(&b, p->batch, thread_counts[i]);
+        if (t > p->throughput) {
+            p->throughput = t;
+            p->threads = thread_counts[i];
+        }
+    }
+    for (int id = 0; id < SAP_BACKEND_COUNT; id++) {
+        if (level_get[kyber_k - 2]((sap_backend_id)id) == before) level_use[kyber_k - 2]((sap_backend_id)id);
+    }
+    ret = 0;
+
+out:
+    free(tiled);
+    free(cts);
+    free(view_tags);
+    free(hits);
+    if (key != NULL) {
+        sap_wipe(key, level->key_bytes);
+        free(key);
+    }
+    corpus_free(&c);
+    return ret;
+}
+
+/* ---- profile file ---- */
+
+/// Creates the missing directories above @p path, readable by the owner only.
+static void make_parent_dirs(const char* path)
+{
+    char dir[4096];
+    size_t len = strlen(path);
+    if (len >= sizeof(dir)) {
+        return;
+    }
+    memcpy(dir, path, len + 1);
+    for (char* slash = strchr(dir + 1, '/'); slash != NULL; slash = strchr(slash + 1, '/')) {
+        *slash = '\0';
+        mkdir(dir, 0700);
+        *slash = '/';
+    }
+}
+
+int sap_tune_save(const sap_tune_profile* p, const char* path)
+{
+    char tmp[4096];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) {
+        return -1;
+    }
+    make_parent_dirs(path);
+    FILE* f = fopen(tmp, "w");
+    if (f == NULL) {
+        return -1;
+    }
+    int ok = fprintf(f,
+        "# pqsap scan profile, written by sap_tune\n"
+        "version=%d\nkyber_k=%u\ncpu=%s\ncpus=%u\nbackend=%s\nbatch=%zu\nthreads=%u\nthroughput=%.0f\n",
+        TUNE_VERSION, p->kyber_k, p->cpu, p->cpus, backend_names[p->backend], p->batch, p->threads,
+        p->throughput) > 0;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Workflow:
+ *  1. Reads key=value lines, skipping comments; unknown keys are ignored.
+ *  2. Accepts the profile only if it has the current version, the requested
+ *     level, this machine's CPU model and CPU count, a backend the CPU can run
+ *     and a batch size and thread count.
+ */
+int sap_tune_load(sap_tune_profile* p, const char* path, uint32_t kyber_k)
+{
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    sap_tune_profile q;
+    memset(&q, 0, sizeof(q));
+    int version = 0, backend = -1;
+    char line[512];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        line[strcspn(line, "\n")] = '\0';
+        char* value = strchr(line, '=');
+        if (line[0] == '#' || value == NULL) continue;
+        *value++ = '\0';
+        if (strcmp(line, "version") == 0) version = atoi(value);
+        else if (strcmp(line, "kyber_k") == 0) q.kyber_k = (uint32_t)strtoul(value, NULL, 10);
+        else if (strcmp(line, "cpu") == 0) snprintf(q.cpu, sizeof(q.cpu), "%s", value);
+        else if (strcmp(line, "cpus") == 0) q.cpus = (unsigned int)strtoul(value, NULL, 10);
+        else if (strcmp(line, "batch") == 0) q.batch = strtoull(value, NULL, 10);
+        else if (strcmp(line, "threads") == 0) q.threads = (unsigned int)strtoul(value, NULL, 10);
+        else if (strcmp(line, "throughput") == 0) q.throughput = strtod(value, NULL);
+        else if (strcmp(line, "backend") == 0) {
+            sap_backend_id id;
+            if (sap_backend_parse(value, &id) == 0) backend = (int)id;
+        }
+    }
+    fclose(f);
+
+    char cpu[sizeof(q.cpu)];
+    cpu_model(cpu, sizeof(cpu));
+    if (version != TUNE_VERSION || q.kyber_k != kyber_k || strcmp(q.cpu, cpu) != 0 || q.cpus != usable_cpus()
+        || backend < 0 || !sap_backend_supported((sap_backend_id)backend) || q.batch == 0 || q.threads == 0) {
+        return -1;
+    }
+    q.backend = (sap_backend_id)backend;
+    *p = q;
+    return 0;
+}
+
+int sap_tune_load_or_run(sap_tune_profile* p, const char* path, uint32_t kyber_k, unsigned int budget_ms)
+{
+    if (sap_tune_load(p, path, kyber_k) == 0) {
+        return 0;
+    }
+    if (sap_tune_run(p, kyber_k, budget_ms) != 0) {
+        return -1;
+    }
+    sap_tune_save(p, path);
+    return 1;
+}
+
+void sap_tune_default_path(char* path, size_t len, uint32_t kyber_k)
+{
+    const char* cache = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    if (cache != NULL && cache[0] != '\0') {
+        snprintf(path, len, "%s/pqsap/scan-k%u.profile", cache, kyber_k);
+    } else {
+        snprintf(path, len, "%s/.cache/pqsap/scan-k%u.profile", home != NULL ? home : ".", kyber_k);
+    }
+}
+
+int sap_tune_apply(const sap_tune_profile* p)
+{
+    if (p->kyber_k < 2 || p->kyber_k > 4) {
+        return -1;
+    }
+    return level_use[p->kyber_k - 2](p->backend);
+}
+
+/**
+ * Workflow:
+ *  1. Clears the profiles, so that levels left untuned report batch and threads 0.
+ *  2. Leaves the backends alone if SAP_BACKEND is set.
+ *  3. For each level, loads the profile at its default path, or with @p tune
+ *     tunes and saves one, and makes its backend the active one.
+ */
+int sap_tune_startup(sap_tune_profile profiles[3], int tune)
+{
+    if (profiles != NULL) {
+        memset(profiles, 0, SAP_SCAN_MIXED_LEVELS * sizeof(*profiles));
+        for (uint32_t k = 2; k <= 4; k++) profiles[k - 2].kyber_k = k;
+    }
+    if (getenv("SAP_BACKEND") != NULL) {
+        return 0;
+    }
+    int applied = 0;
+    for (uint32_t k = 2; k <= 4; k++) {
+        char path[4096];
+        sap_tune_profile p;
+        sap_tune_default_path(path, sizeof(path), k);
+        int r = tune ? sap_tune_load_or_run(&p, path, k, 0) : sap_tune_load(&p, path, k);
+        if (r == 1) {
+            fprintf(stderr, "tuned Kyber K=%u scanning: %s backend, batch %zu, %u threads (%s)\n", k,
+                backend_names[p.backend], p.batch, p.threads, path);
+        }
+        if (r < 0 || sap_tune_apply(&p) != 0) continue;
+        if (profiles != NULL) profiles[k - 2] = p;
+        applied++;
+    }
+    return applied;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "backend.h"
+
+/// @file tune.h
+/// @brief Startup tuning of backend, batch size and thread count for register scanning.
+///
+/// The fastest way to scan differs between machines: AVX-512 is not always ahead
+/// of AVX2, the batch that keeps ciphertexts and keys in cache depends on the
+/// cache sizes, and extra threads stop paying once the cores are saturated.
+/// sap_tune_run() measures these choices on a synthetic register of one security
+/// level, larger than the last-level cache so that the ciphertexts stream from
+/// memory as they do in a real register. It tries every backend the CPU
+/// supports, then batch sizes, then thread counts, each time keeping the fastest
+/// setting, within a budget of a few hundred milliseconds.
+///
+/// The result is kept in a small text profile. sap_tune_load_or_run() reuses a
+/// profile written on the same machine (same CPU model and number of usable
+/// CPUs) and tunes again otherwise. sap_tune_apply() switches the backend, and
+/// sap_tune_scan() scans with the tuned batch size and threads. Scanners call
+/// sap_tune_startup() once to apply the profiles of every level and size their
+/// own batches and worker counts from them.
+
+/// @def SAP_TUNE_BUDGET_MS
+/// @brief Default time sap_tune_run() spends measuring.
+#define SAP_TUNE_BUDGET_MS 400
+
+/// @brief A tuned configuration of one security level.
+typedef struct {
+    uint32_t kyber_k;
+    sap_backend_id backend;
+    size_t batch;               /**< Announcements per sap_scan() call. */
+    unsigned int threads;
+    double throughput;          /**< Announcements per second measured with this configuration. */
+    char cpu[128];              /**< CPU model the profile was measured on. */
+    unsigned int cpus;          /**< Usable CPUs when it was measured. */
+} sap_tune_profile;
+
+/// @brief Measures the configurations for level @p kyber_k and returns the fastest.
+///
+/// The active backend of that level is switched while measuring and restored
+/// afterwards, so no other thread should scan at that level meanwhile.
+///
+/// @param[in] budget_ms Time to spend measuring, 0 for SAP_TUNE_BUDGET_MS; the
+/// synthetic register is generated on top of it. Its ciphertexts take a quarter
+/// more than the last-level cache, at most 1 GiB.
+/// @return 0 on success, -1 on an invalid level or out of memory.
+int sap_tune_run(sap_tune_profile* p, uint32_t kyber_k, unsigned int budget_ms);
+
+/// @brief Writes a profile, creating the missing directories above it with mode 0700.
+///
+/// @return 0 on success, -1 if the file cannot be written.
+int sap_tune_save(const sap_tune_profile* p, const char* path);
+
+/// @brief Reads a profile written for level @p kyber_k on this machine.
+///
+/// @return 0 on success, -1 if the file is missing, malformed, for another level
+/// or from another machine.
+int sap_tune_load(sap_tune_profile* p, const char* path, uint32_t kyber_k);
+
+/// @brief Loads the profile at @p path, or tunes and saves it if there is no usable one.
+///
+/// @return 0 if loaded, 1 if tuned (even if it could not be saved), -1 on failure.
+int sap_tune_load_or_run(sap_tune_profile* p, const char* path, uint32_t kyber_k, unsigned int budget_ms);
+
+/// @brief Writes the default profile path of a level, under $XDG_CACHE_HOME or ~/.cache.
+///
+/// Only builds the path; sap_tune_save() creates the directories.
+void sap_tune_default_path(char* path, size_t len, uint32_t kyber_k);
+
+/// @brief Makes the profile's backend the active one at its level.
+///
+/// @return 0 on success, -1 if the CPU cannot run it.
+int sap_tune_apply(const sap_tune_profile* p);
+
+/// @brief Scans like sap_scan() at the profile's level, with its batch size and threads.
+///
+/// @param[in] key The prepared key of that level (sap_scan_key).
+/// @return The number of hits, or SIZE_MAX if a thread cannot be started.
+size_t sap_tune_scan(const sap_tune_profile* p, uint8_t* hits, uint8_t* ss, const uint8_t* const* cts,
+    const uint8_t* view_tags, size_t n, const void* key);
+
+/// @brief Applies the default profile of every level; scanners call it once at startup.
+///
+/// Levels without a usable profile keep their backend, unless @p tune is set:
+/// then they are tuned with SAP_TUNE_BUDGET_MS, a note is printed to standard
+/// error and the profile is saved for later runs. Does nothing if SAP_BACKEND
+/// is set, since that choice overrides any profile. Call it before starting
+/// scanning threads.
+///
+/// @param[out] profiles If not NULL, receives the applied profile of Kyber512,
+/// Kyber768 and Kyber1024 in that order; a level without one has batch and
+/// threads 0, for the caller's defaults.
+/// @return The number of levels whose profile was applied.
+int sap_tune_startup(sap_tune_profile profiles[3], int tune);
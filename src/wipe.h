@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @file wipe.h
+/// @brief Zeroing of secret material that the compiler cannot drop.
+///
+/// A memset() of a buffer that is freed or goes out of scope right afterwards is
+/// a dead store, and optimizing compilers remove it. sap_wipe() writes through a
+/// volatile pointer instead, so keys, shared secrets and noise seeds really are
+/// gone once it returns.
+
+/// @brief Sets @p len bytes at @p p to zero.
+static inline void sap_wipe(void* p, size_t len)
+{
+    volatile uint8_t* b = (volatile uint8_t*)p;
+    for (size_t i = 0; i < len; i++) b[i] = 0;
+}
@@ -0,0 +1,124 @@
+#include "protocol_api.h"
+#include "randombytes.h"
+#include <stdio.h>
+
+#define TRIALS 100
+
+typedef struct {
+    const char* name;
+    const sap_backend* (*get)(sap_backend_id id);
+    size_t pk_bytes, sk_bytes, ct_bytes, stealth_bytes;
+} level;
+
+static const level levels[] = {
+    { "Kyber512",  pqsap_kyber512_backend_get,  800,  1632, 768,  2 * 384 },
+    { "Kyber768",  pqsap_kyber768_backend_get,  1184, 2400, 1088, 3 * 384 },
+    { "Kyber1024", pqsap_kyber1024_backend_get, 1568, 3168, 1568, 4 * 384 },
+};
+
+/**
+ * Workflow:
+ *  1. Derives a key pair and an encapsulation from the same coins on both backends
+ *     and compares keys, ciphertexts and shared secrets.
+ *  2. Decapsulates the ciphertext, and a tampered copy, on each backend with the
+ *     key pair of the other and compares the (implicitly rejected) shared secrets.
+ *  3. Compares the stealth public keys computed from the shared secret.
+ */
+static int compare_level(const level* l, const sap_backend* x, const sap_backend* y)
+{
+    uint8_t pk[2][1568], sk[2][3168], ct[2][1568], ss[2][32], ss_dec[2][32];
+    uint8_t stealth[2][4 * 384];
+    uint8_t coins[3 * 32];
+    const sap_backend* b[2] = { x, y };
+
+    for (int trial = 0; trial < TRIALS; trial++) {
+        randombytes(coins, sizeof(coins));
+        for (int j = 0; j < 2; j++) {
+            b[j]->kem_keypair_derand(pk[j], sk[j], coins);
+            b[j]->kem_enc_derand(ct[j], ss[j], pk[j], coins + 64);
+        }
+        if (memcmp(pk[0], pk[1], l->pk_bytes) != 0 || memcmp(sk[0], sk[1], l->sk_bytes) != 0
+            || memcmp(ct[0], ct[1], l->ct_bytes) != 0 || memcmp(ss[0], ss[1], 32) != 0) {
+            return -1;
+        }
+
+        for (int tamper = 0; tamper < 2; tamper++) {
+            if (tamper) ct[0][trial % l->ct_bytes] ^= 1;
+            for (int j = 0; j < 2; j++) b[j]->kem_dec(ss_dec[j], ct[0], sk[1 - j]);
+            if (memcmp(ss_dec[0], ss_dec[1], 32) != 0
+                || (memcmp(ss_dec[0], ss[0], 32) == 0) == tamper) {
+                return -1;
+            }
+        }
+
+        for (int j = 0; j < 2; j++) b[j]->stealth_pub_key(stealth[j], ss[0], pk[0]);
+        if (memcmp(stealth[0], stealth[1], l->stealth_bytes) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int compare_hashes(const sap_backend* x, const sap_backend* y)
+{
+    uint8_t in[512], out[2][600];
+    randombytes(in, sizeof(in));
+    for (size_t len = 0; len <= sizeof(in); len += 17) {
+        x->hash_shake128(out[0], len + 80, in, len);
+        y->hash_shake128(out[1], len + 80, in, len);
+        if (memcmp(out[0], out[1], len + 80) != 0) return -1;
+        x->hash_shake256(out[0], len + 80, in, len);
+        y->hash_shake256(out[1], len + 80, in, len);
+        if (memcmp(out[0], out[1], len + 80) != 0) return -1;
+    }
+    return 0;
+}
+
+static int compare_view_tags(const sap_backend* x, const sap_backend* y)
+{
+    uint8_t ss[19 * 32], out[2][19 * 32];
+    randombytes(ss, sizeof(ss));
+    for (size_t n = 1; n <= 19; n += 3) {
+        x->hash_ss_batch(out[0], ss, n);
+        y->hash_ss_batch(out[1], ss, n);
+        if (memcmp(out[0], out[1], n * 32) != 0) return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Main function that runs the backend equivalence test.
+ *
+ * For every security level each backend the CPU supports must produce the same
+ * keys, ciphertexts, shared secrets, stealth public keys and hashes as the
+ * portable reference backend. On CPUs without AVX2 or AVX-512 those backends are
+ * skipped.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main() {
+    static const char* const names[SAP_BACKEND_COUNT] = { "Ref", "AVX2", "AVX512" };
+    int ok = 1;
+
+    printf("Backend Ref");
+    for (int id = SAP_BACKEND_REF + 1; id < SAP_BACKEND_COUNT; id++) {
+        if (sap_backend_supported((sap_backend_id)id)) printf("-%s", names[id]);
+    }
+    printf(": ");
+
+    for (int id = SAP_BACKEND_REF + 1; id < SAP_BACKEND_COUNT; id++) {
+        if (!sap_backend_supported((sap_backend_id)id)) continue;
+        for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+            const sap_backend* ref = levels[i].get(SAP_BACKEND_REF);
+            const sap_backend* fast = levels[i].get((sap_backend_id)id);
+            if (compare_level(&levels[i], ref, fast) != 0 || compare_hashes(ref, fast) != 0
+                || compare_view_tags(ref, fast) != 0) {
+                printf("%s %s mismatch, ", names[id], levels[i].name);
+                ok = 0;
+            }
+        }
+    }
+
+    printf(ok ? "Test PASSED!\n" : "Test FAILED!\n");
+    return ok ? 0 : 1;
+}
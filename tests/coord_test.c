@@ -0,0 +1,139 @@
+#include "coord.h"
+#include "corpus.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define TEST_N 300
+#define TEST_REGISTER "tests/coord_test.sap"
+#define TEST_KEYS "tests/coord_test.keys"
+
+/// Forks workers of which the first exits during its shard and the second hangs in it.
+typedef struct {
+    unsigned int spawns;
+} faulty;
+
+static int faulty_spawn(void* ctx, unsigned int worker, int* fd, long* handle)
+{
+    faulty* f = ctx;
+    unsigned int spawn = f->spawns++;
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        return -1;
+    }
+    if (pid == 0) {
+        uint8_t b;
+        close(sv[0]);
+        if (spawn < 2 && read(sv[1], &b, 1) == 1) {
+            if (spawn == 1) sleep(30);
+            _exit(3);
+        }
+        _exit(sap_coord_worker_serve(sv[1], sv[1]) == 0 ? 0 : 1);
+    }
+    (void)worker;
+    close(sv[1]);
+    *fd = sv[0];
+    *handle = pid;
+    return 0;
+}
+
+static void faulty_reap(void* ctx, long handle, int kill_it)
+{
+    sap_coord_fork_transport.reap(ctx, handle, kill_it);
+}
+
+/// Checks that @p r holds exactly the matches of the mixed corpus @p c, each under the key of its level.
+static int same_matches(const sap_coord_result* r, const corpus* c)
+{
+    if (r->n_matches != c->n_matches || r->scanned != TEST_N || r->entries != TEST_N) {
+        return 0;
+    }
+    for (size_t i = 0; i < r->n_matches; i++) {
+        if (r->matches[i].index != c->matches[i] || r->matches[i].key != c->levels[c->matches[i]] - 2u) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Main function that runs the multi-process scan test.
+ *
+ * A mixed register and a key file with the recipient's three keys are written
+ * to disk. A range loaded with corpus_load_range() must equal the same part of
+ * the register. The coordinator then scans the register with three forked
+ * workers over seven shards, and again through a transport whose first worker
+ * exits and whose second hangs during their shards. The test is passed if both
+ * runs report exactly the recorded matches, in order and each under the key of
+ * its level, and the second run failed two workers and handed their shards to
+ * new ones.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main() {
+    corpus_params params = { .kyber_k = CORPUS_MIXED, .n = TEST_N, .match_rate = 0.05, .threads = 1 };
+    for (int i = 0; i < CORPUS_SEED_BYTES; i++) params.seed[i] = (uint8_t)(3 * i);
+
+    printf("Coordinator: ");
+    fflush(stdout);
+
+    corpus c, part;
+    if (corpus_generate(&c, &params) != 0) {
+        printf("Test FAILED!\n");
+        return 1;
+    }
+    int ok = corpus_save(&c, TEST_REGISTER) == 0;
+    FILE* f = fopen(TEST_KEYS, "wb");
+    ok = ok && f != NULL;
+    for (uint32_t l = 0; ok && l < CORPUS_LEVELS; l++) {
+        size_t ct_bytes, pk_bytes, sk_bytes;
+        uint8_t k = (uint8_t)(l + 2);
+        corpus_level_sizes(k, &ct_bytes, &pk_bytes, &sk_bytes);
+        ok = fwrite(&k, 1, 1, f) == 1 && fwrite(c.keys[l].k_pub, 1, pk_bytes, f) == pk_bytes
+            && fwrite(c.keys[l].v_priv, 1, sk_bytes, f) == sk_bytes;
+    }
+    if (f != NULL && fclose(f) != 0) ok = 0;
+
+    size_t n = 0, in_range = 0;
+    for (size_t i = 0; i < c.n_matches; i++) in_range += c.matches[i] >= 100 && c.matches[i] < 170;
+    ok = ok && corpus_entries(TEST_REGISTER, &n) == 0 && n == TEST_N;
+    if (ok && corpus_load_range(&part, TEST_REGISTER, 100, 170) == 0) {
+        ok = part.n == 70 && part.n_matches == in_range
+            && memcmp(part.levels, c.levels + 100, 70) == 0
+            && memcmp(part.ephemeral_pub_keys, corpus_ct(&c, 100), c.ct_offsets[170] - c.ct_offsets[100]) == 0
+            && memcmp(part.tags, corpus_tag(&c, 100), 70 * CORPUS_TAG_BYTES) == 0
+            && (in_range == 0 || part.matches[0] + 100 >= c.matches[0]);
+        corpus_free(&part);
+    } else {
+        ok = 0;
+    }
+
+    sap_coord_config config = { .register_path = TEST_REGISTER, .key_path = TEST_KEYS, .workers = 3, .shards = 7 };
+    sap_coord_result r;
+    ok = ok && sap_coord_run(&config, &r) == 0 && same_matches(&r, &c) && r.shards == 7 && r.failures == 0
+        && r.spawned == 3;
+    sap_coord_result_free(&r);
+
+    faulty state = { 0 };
+    sap_coord_transport transport = { faulty_spawn, faulty_reap, &state };
+    config.transport = &transport;
+    config.timeout_ms = 500;
+    ok = ok && sap_coord_run(&config, &r) == 0 && same_matches(&r, &c) && r.failures == 2 && r.spawned == 5;
+    sap_coord_result_free(&r);
+
+    remove(TEST_REGISTER);
+    remove(TEST_KEYS);
+    corpus_free(&c);
+
+    if (ok) {
+        printf("Test PASSED!\n");
+        return 0;
+    }
+    printf("Test FAILED!\n");
+    return 1;
+}
@@ -0,0 +1,180 @@
+#include "protocol_api.h"
+#include "corpus.h"
+#include "scan.h"
+#include "scan_mixed.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_N 64
+#define TEST_PATH "tests/corpus_test.sap"
+
+/**
+ * @brief Main function that runs the announcement corpus test.
+ *
+ * The test generates the same small corpus with one and with four threads and
+ * checks that both are identical, writes it to disk and loads it back, and then
+ * scans the loaded register with the recipient's view key. The test is passed
+ * if the announcements whose shared-secret hash matches are exactly the
+ * recorded match indices, every stored tag has the expected view tag, and the
+ * batch scan (sap_scan(), over all announcements and over a prefix that ends in
+ * a partial group) reports the same view-tag hits as decapsulating one by one.
+ * sap_scan_until() resumed after every hit over a subrange must find the same
+ * hits, and must not scan at all with a cancelled token or a past deadline.
+ * A mixed-level corpus with the same seed must survive the same round trip, hold
+ * the announcements of the pure corpus at the positions of level KYBER_K, and
+ * sap_scan_mixed() must find exactly its recorded matches. Its first third,
+ * extended with corpus_extend(), must equal the whole corpus.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main() {
+    corpus_params params = { .kyber_k = KYBER_K, .n = TEST_N, .match_rate = 0.125, .threads = 1 };
+    for (int i = 0; i < CORPUS_SEED_BYTES; i++) params.seed[i] = (uint8_t)i;
+
+    printf("Corpus: ");
+
+    corpus a, b, loaded;
+    if (corpus_generate(&a, &params) != 0) {
+        printf("Test FAILED!\n");
+        return 1;
+    }
+    params.threads = 4;
+    if (corpus_generate(&b, &params) != 0) {
+        printf("Test FAILED!\n");
+        return 1;
+    }
+
+    int ok = a.n_matches == 8 && b.n_matches == a.n_matches
+        && memcmp(a.ephemeral_pub_keys, b.ephemeral_pub_keys, TEST_N * a.ct_bytes) == 0
+        && memcmp(a.tags, b.tags, TEST_N * CORPUS_TAG_BYTES) == 0
+        && memcmp(a.matches, b.matches, a.n_matches * sizeof(uint64_t)) == 0;
+
+    ok = ok && corpus_save(&a, TEST_PATH) == 0 && corpus_load(&loaded, TEST_PATH) == 0;
+    remove(TEST_PATH);
+
+    if (ok) {
+        ok = loaded.n == a.n && loaded.n_matches == a.n_matches
+            && memcmp(loaded.v_priv, a.v_priv, a.sk_bytes) == 0
+            && memcmp(loaded.ephemeral_pub_keys, a.ephemeral_pub_keys, TEST_N * a.ct_bytes) == 0;
+
+        size_t found = 0;
+        uint8_t expected[TEST_N], hits[TEST_N], view_tags[TEST_N];
+        const uint8_t* cts[TEST_N];
+        for (size_t i = 0; ok && i < loaded.n; i++) {
+            uint8_t ss[SS_BYTES];
+            sap_kem_dec(ss, corpus_ct(&loaded, i), loaded.v_priv);
+            uint8_t* hash = calculate_ss_hash(ss);
+
+            cts[i] = corpus_ct(&loaded, i);
+            view_tags[i] = corpus_tag(&loaded, i)[0];
+            expected[i] = calculate_view_tag(ss) == view_tags[i];
+
+            if (memcmp(hash, corpus_tag(&loaded, i), CORPUS_TAG_BYTES) == 0) {
+                ok = found < loaded.n_matches && loaded.matches[found] == i
+                    && calculate_view_tag(ss) == corpus_tag(&loaded, i)[0];
+                found++;
+            }
+            free(hash);
+        }
+        ok = ok && found == loaded.n_matches;
+
+        sap_scan_key key;
+        sap_scan_key_init(&key, loaded.v_priv);
+        size_t n_expected = 0;
+        for (size_t i = 0; i < TEST_N; i++) n_expected += expected[i];
+        ok = ok && sap_scan(hits, NULL, cts, view_tags, TEST_N, &key) == n_expected
+            && memcmp(hits, expected, TEST_N) == 0;
+        ok = ok && sap_scan(hits, NULL, cts, view_tags, TEST_N - 5, &key) <= n_expected
+            && memcmp(hits, expected, TEST_N - 5) == 0;
+
+        /* one hit per call, resumed from the cursor, within [3, TEST_N - 5) */
+        sap_scan_limits limits = { .max_hits = 1, .end = TEST_N - 5 };
+        sap_scan_cursor cursor;
+        sap_scan_cursor_init(&cursor, 3);
+        size_t resumed = 0, in_range = 0, calls = 0;
+        memset(hits, 0, TEST_N);
+        for (size_t i = 3; i < TEST_N - 5; i++) in_range += expected[i];
+        do {
+            limits.max_hits = cursor.hits + 1;
+            resumed += sap_scan_until(hits, NULL, cts, view_tags, TEST_N, &key, &limits, &cursor);
+            calls++;
+        } while (ok && cursor.status == SAP_SCAN_HIT_LIMIT && calls <= TEST_N);
+        ok = ok && cursor.status == SAP_SCAN_COMPLETE && cursor.next == TEST_N - 5 && resumed == in_range
+            && cursor.hits == in_range && calls == in_range + 1
+            && memcmp(hits + 3, expected + 3, TEST_N - 8) == 0;
+
+        /* a cancelled token or a past deadline stops before the first group */
+        sap_scan_cancel token = { 0 };
+        sap_scan_cancel_request(&token);
+        sap_scan_limits cancelled = { .cancel = &token }, late = { .deadline_ns = 1 };
+        sap_scan_cursor_init(&cursor, 0);
+        ok = ok && sap_scan_until(hits, NULL, cts, view_tags, TEST_N, &key, &cancelled, &cursor) == 0
+            && cursor.status == SAP_SCAN_CANCELLED && cursor.next == 0;
+        ok = ok && sap_scan_until(hits, NULL, cts, view_tags, TEST_N, &key, &late, &cursor) == 0
+            && cursor.status == SAP_SCAN_DEADLINE && cursor.next == 0;
+        corpus_free(&loaded);
+    }
+
+    corpus mixed;
+    params.kyber_k = CORPUS_MIXED;
+    if (ok && corpus_generate(&mixed, &params) == 0) {
+        ok = corpus_save(&mixed, TEST_PATH) == 0 && corpus_load(&loaded, TEST_PATH) == 0;
+
+        corpus part;
+        if (ok && corpus_load_range(&part, TEST_PATH, 0, TEST_N / 3) == 0) {
+            ok = corpus_extend(&part, TEST_PATH) == 0 && part.n == TEST_N && part.n_matches == mixed.n_matches
+                && memcmp(part.levels, mixed.levels, TEST_N) == 0
+                && memcmp(part.ct_offsets, mixed.ct_offsets, (TEST_N + 1) * sizeof(uint64_t)) == 0
+                && memcmp(part.ephemeral_pub_keys, mixed.ephemeral_pub_keys, mixed.ct_offsets[TEST_N]) == 0
+                && memcmp(part.tags, mixed.tags, TEST_N * CORPUS_TAG_BYTES) == 0
+                && memcmp(part.matches, mixed.matches, mixed.n_matches * sizeof(uint64_t)) == 0
+                && corpus_extend(&part, TEST_PATH) == 0 && part.n == TEST_N;
+            corpus_free(&part);
+        } else {
+            ok = 0;
+        }
+        remove(TEST_PATH);
+
+        ok = ok && loaded.kyber_k == CORPUS_MIXED && loaded.v_priv == NULL
+            && memcmp(loaded.levels, mixed.levels, TEST_N) == 0
+            && memcmp(loaded.ephemeral_pub_keys, mixed.ephemeral_pub_keys, mixed.ct_offsets[TEST_N]) == 0
+            && memcmp(loaded.matches, a.matches, a.n_matches * sizeof(uint64_t)) == 0;
+
+        int seen[CORPUS_LEVELS] = { 0 };
+        const uint8_t* cts[TEST_N];
+        uint8_t view_tags[TEST_N], hits[TEST_N];
+        for (size_t i = 0; ok && i < TEST_N; i++) {
+            seen[loaded.levels[i] - 2] = 1;
+            cts[i] = corpus_ct(&loaded, i);
+            view_tags[i] = corpus_tag(&loaded, i)[0];
+            if (loaded.levels[i] == KYBER_K) {
+                ok = memcmp(cts[i], corpus_ct(&a, i), a.ct_bytes) == 0;
+            }
+        }
+        ok = ok && seen[0] && seen[1] && seen[2];
+
+        sap_scan_keyset ks;
+        const uint8_t* v_priv[CORPUS_LEVELS] = { loaded.keys[0].v_priv, loaded.keys[1].v_priv, loaded.keys[2].v_priv };
+        if (ok && sap_scan_keyset_init(&ks, v_priv) == 0) {
+            ok = sap_scan_mixed(hits, NULL, cts, loaded.levels, view_tags, TEST_N, &ks) == loaded.n_matches;
+            for (size_t m = 0; ok && m < loaded.n_matches; m++) ok = hits[loaded.matches[m]] == 1;
+            sap_scan_keyset_free(&ks);
+        } else {
+            ok = 0;
+        }
+        corpus_free(&loaded);
+        corpus_free(&mixed);
+    } else {
+        ok = 0;
+    }
+
+    corpus_free(&a);
+    corpus_free(&b);
+
+    if (!ok) {
+        printf("Test FAILED!\n");
+        return 1;
+    }
+    printf("Test PASSED!\n");
+    return 0;
+}
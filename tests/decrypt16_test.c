@@ -0,0 +1,80 @@
+#include "scan.h"
+#include "randombytes.h"
+#include <stdio.h>
+
+#define GROUPS 64
+
+/**
+ * Fills the 16 ciphertexts of group @p g. The first group holds edge cases: all
+ * zero, all one bits (every compressed coefficient at its maximum), alternating
+ * bit patterns, u and v set to opposite extremes, a single set bit and a single
+ * cleared bit. The other groups mix random bytes with honest encryptions to
+ * @p pk, and every fourth group repeats one pointer in its upper lanes as
+ * sap_scan() does for a short group.
+ */
+static void fill(uint8_t cts[SAP_SCAN_LANES][CIPHERTEXT_BYTES], const uint8_t* ptrs[SAP_SCAN_LANES], int g,
+    const uint8_t pk[PUBLIC_KEY_BYTES])
+{
+    static const uint8_t patterns[4] = { 0x00, 0xff, 0xaa, 0x55 };
+    uint8_t ss[SS_BYTES];
+
+    for (int l = 0; l < SAP_SCAN_LANES; l++) {
+        ptrs[l] = cts[l];
+        if (g == 0 && l < 4) {
+            memset(cts[l], patterns[l], CIPHERTEXT_BYTES);
+        } else if (g == 0 && l < 6) {
+            memset(cts[l], l == 4 ? 0x00 : 0xff, KYBER_POLYVECCOMPRESSEDBYTES);
+            memset(cts[l] + KYBER_POLYVECCOMPRESSEDBYTES, l == 4 ? 0xff : 0x00, KYBER_POLYCOMPRESSEDBYTES);
+        } else if (g == 0 && l < 8) {
+            memset(cts[l], l == 6 ? 0x00 : 0xff, CIPHERTEXT_BYTES);
+            cts[l][CIPHERTEXT_BYTES / 2] ^= 0x10;
+        } else if (l % 2 == 1) {
+            sap_kem_enc(cts[l], ss, pk);
+        } else {
+            randombytes(cts[l], CIPHERTEXT_BYTES);
+        }
+    }
+    if (g % 4 == 3) {
+        for (int l = SAP_SCAN_LANES / 2; l < SAP_SCAN_LANES; l++) ptrs[l] = cts[0];
+    }
+}
+
+/**
+ * @brief Main function that runs the lane-parallel decryption test.
+ *
+ * Edge-case, random and honestly encrypted ciphertexts are decrypted with
+ * sap_scan_decrypt16() under every backend the CPU supports. All 16 messages
+ * must equal those of the reference indcpa_dec() byte for byte.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main() {
+    uint8_t pk[PUBLIC_KEY_BYTES], sk[SECRET_KEY_BYTES];
+    uint8_t cts[SAP_SCAN_LANES][CIPHERTEXT_BYTES];
+    uint8_t m[SAP_SCAN_LANES][KYBER_INDCPA_MSGBYTES], expected[SAP_SCAN_LANES][KYBER_INDCPA_MSGBYTES];
+    const uint8_t* ptrs[SAP_SCAN_LANES];
+    sap_scan_key key;
+    int ok;
+
+    printf("Lane-parallel decryption K=%d: ", KYBER_K);
+    ok = sap_kem_keypair(pk, sk) == 0;
+    sap_scan_key_init(&key, sk);
+
+    for (int g = 0; ok && g < GROUPS; g++) {
+        fill(cts, ptrs, g, pk);
+        for (int l = 0; l < SAP_SCAN_LANES; l++) {
+            indcpa_dec(expected[l], ptrs[l], sk);
+        }
+        for (int b = 0; ok && b < SAP_BACKEND_COUNT; b++) {
+            if (sap_backend_use((sap_backend_id)b) != 0) continue;
+            memset(m, 0, sizeof(m));
+            sap_scan_decrypt16(m, ptrs, &key);
+            ok = memcmp(m, expected, sizeof(m)) == 0;
+            if (!ok) printf("group %d differs on the %s backend: ", g, sap_backend_active()->name);
+        }
+        sap_backend_use(sap_backend_detect());
+    }
+
+    printf(ok ? "Test PASSED!\n" : "Test FAILED!\n");
+    return ok ? 0 : 1;
+}
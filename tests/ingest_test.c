@@ -0,0 +1,133 @@
+#include "protocol_api.h"
+#include "corpus.h"
+#include "ingest.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_N 1500
+#define TEST_PRODUCERS 4
+#define TEST_CAPACITY 64
+
+typedef struct {
+    sap_ingest_ring* ring;
+    const corpus* c;
+    size_t producer;
+} producer_job;
+
+typedef struct {
+    const corpus* c;
+    size_t hits;
+    int ok;
+} hit_check;
+
+/// Pushes every TEST_PRODUCERS-th announcement, retrying while the ring is full.
+static void* producer(void* arg)
+{
+    producer_job* job = arg;
+    for (size_t i = job->producer; i < job->c->n; i += TEST_PRODUCERS) {
+        while (sap_ingest_push(job->ring, corpus_ct(job->c, i), corpus_tag(job->c, i)[0]) != 0) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static uint64_t prefix(const uint8_t* ct)
+{
+    uint64_t v;
+    memcpy(&v, ct, sizeof(v));
+    return v;
+}
+
+static void on_hit(void* arg, const uint8_t* ct, uint8_t view_tag, const uint8_t ss[SS_BYTES])
+{
+    hit_check* h = arg;
+    int known = 0;
+    for (size_t m = 0; m < h->c->n_matches; m++) {
+        known |= memcmp(ct, corpus_ct(h->c, h->c->matches[m]), CIPHERTEXT_BYTES) == 0;
+    }
+    h->ok = h->ok && known && calculate_view_tag((uint8_t*)ss) == view_tag;
+    h->hits++;
+}
+
+/// Runs the producers against a small ring while the calling thread consumes.
+static int run(sap_ingest_ring* ring, const corpus* c, int scan, const sap_scan_key* key, hit_check* h)
+{
+    pthread_t tids[TEST_PRODUCERS];
+    producer_job jobs[TEST_PRODUCERS];
+    for (size_t p = 0; p < TEST_PRODUCERS; p++) {
+        jobs[p] = (producer_job){ ring, c, p };
+        pthread_create(&tids[p], NULL, producer, &jobs[p]);
+    }
+
+    uint64_t sum = 0, x = 0;
+    for (size_t i = 0; i < c->n; i++) {
+        sum += prefix(corpus_ct(c, i));
+        x ^= prefix(corpus_ct(c, i));
+    }
+
+    size_t consumed = 0;
+    const uint8_t* cts[32];
+    uint8_t tags[32];
+    while (consumed < c->n) {
+        if (scan) {
+            consumed += sap_ingest_scan(ring, key, on_hit, h, NULL);
+            continue;
+        }
+        size_t n = sap_ingest_peek(ring, cts, tags, 32);
+        for (size_t j = 0; j < n; j++) {
+            sum -= prefix(cts[j]);
+            x ^= prefix(cts[j]);
+        }
+        sap_ingest_release(ring, n);
+        consumed += n;
+    }
+
+    for (size_t p = 0; p < TEST_PRODUCERS; p++) pthread_join(tids[p], NULL);
+    return consumed == c->n && (scan || (sum == 0 && x == 0)) && sap_ingest_peek(ring, cts, tags, 1) == 0;
+}
+
+/**
+ * @brief Main function that runs the ingestion ring test.
+ *
+ * Four producer threads push a register through a 64-slot ring while the main
+ * thread consumes it, once with sap_ingest_peek()/sap_ingest_release() and once
+ * with sap_ingest_scan(). The test is passed if every announcement comes out
+ * exactly once and the scan reports exactly the register's matches with their
+ * shared secrets.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main() {
+    corpus_params params = { .kyber_k = KYBER_K, .n = TEST_N, .match_rate = 0.01, .threads = 1 };
+    for (int i = 0; i < CORPUS_SEED_BYTES; i++) params.seed[i] = (uint8_t)(0x40 + i);
+
+    printf("Ingest: ");
+
+    corpus c;
+    sap_ingest_ring ring;
+    if (corpus_generate(&c, &params) != 0 || sap_ingest_init(&ring, TEST_CAPACITY) != 0) {
+        printf("Test FAILED!\n");
+        return 1;
+    }
+
+    sap_scan_key key;
+    sap_scan_key_init(&key, c.v_priv);
+    hit_check h = { &c, 0, 1 };
+
+    int ok = ring.mask + 1 == TEST_CAPACITY && ((uintptr_t)ring.slots[1].ct & 63) == 0;
+    ok = ok && run(&ring, &c, 0, &key, &h);
+    ok = ok && run(&ring, &c, 1, &key, &h) && h.ok && h.hits == c.n_matches;
+
+    sap_ingest_free(&ring);
+    corpus_free(&c);
+
+    if (!ok) {
+        printf("Test FAILED!\n");
+        return 1;
+    }
+    printf("Test PASSED!\n");
+    return 0;
+}
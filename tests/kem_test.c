@@ -1,4 +1,4 @@
-#include "kem.h"
+#include "protocol_api.h"
 #include <stdint.h>
 #include <stdio.h>
 
@@ -21,9 +21,9 @@
  * - ss2[#KYBER_SSBYTES]: Shared secret from decapsulation.
  *
  * The main function performs the following steps:
- * 1. It generates a public and secret key pair using the Kyber KEM key generation function ( crypto_kem_keypair(pk, sk) )
- * 2. It encapsulates a shared secret using the public key to create a ciphertext and a shared secret ( crypto_kem_enc(ct, ss1, pk) ).
- * 3. It decapsulates the ciphertext using the secret key to recover the shared secret ( crypto_kem_dec(ss2, ct, sk) ).
+ * 1. It generates a public and secret key pair using the Kyber KEM key generation function ( sap_kem_keypair(pk, sk) )
+ * 2. It encapsulates a shared secret using the public key to create a ciphertext and a shared secret ( sap_kem_enc(ct, ss1, pk) ).
+ * 3. It decapsulates the ciphertext using the secret key to recover the shared secret ( sap_kem_dec(ss2, ct, sk) ).
  * 4. It compares the encapsulated and decapsulated shared secrets to ensure they match.
  * 5. It prints the number of bytes required for the ciphertext in the Kyber scheme.
  * 6. It prints the result of the test, whether it passed or failed based on the shared secret comparison.
@@ -47,11 +47,11 @@ int main() {
 
     printf("Kem Enc-Dec: ");
 
-    crypto_kem_keypair(pk, sk);
+    sap_kem_keypair(pk, sk);
 
-    crypto_kem_enc(ct, ss1, pk);
+    sap_kem_enc(ct, ss1, pk);
 
-    crypto_kem_dec(ss2, ct, sk);
+    sap_kem_dec(ss2, ct, sk);
 
     for (size_t i = 0; i < KYBER_SSBYTES; i++) {
         if(ss1[i] != ss2[i]){
@@ -0,0 +1,145 @@
+#include "coord.h"
+#include "corpus.h"
+#include "keyblob.h"
+#include "scan_mixed.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define TEST_N 240
+#define TEST_REGISTER "tests/keyblob_test.register"
+#define TEST_KEYS "tests/keyblob_test.keys"
+#define TEST_BLOB "tests/keyblob_test.blob"
+#define TEST_SEALED "tests/keyblob_test.sealed"
+
+static const sap_scan_level* const scan_levels[SAP_SCAN_MIXED_LEVELS] = {
+    &pqsap_kyber512_scan_level, &pqsap_kyber768_scan_level, &pqsap_kyber1024_scan_level
+};
+
+/// Scans the register with every key of the blob; returns the number of hits.
+static size_t scan_blob(const sap_keyblob* b, const corpus* c)
+{
+    const uint8_t* cts[TEST_N];
+    uint8_t tags[TEST_N], hits[TEST_N];
+    size_t found = 0;
+    for (size_t k = 0; k < b->n; k++) {
+        size_t n = 0;
+        for (size_t i = 0; i < c->n; i++) {
+            if (c->levels[i] != b->entries[k].kyber_k) continue;
+            cts[n] = corpus_ct(c, i);
+            tags[n++] = corpus_tag(c, i)[0];
+        }
+        found += scan_levels[b->entries[k].kyber_k - 2]->scan(hits, NULL, cts, tags, n, sap_keyblob_scan_key(b, k));
+    }
+    return found;
+}
+
+/// Flips one byte of a file.
+static int corrupt(const char* path, long offset)
+{
+    FILE* f = fopen(path, "r+b");
+    if (f == NULL) {
+        return -1;
+    }
+    int ok = fseek(f, offset, SEEK_SET) == 0;
+    int c = ok ? fgetc(f) : EOF;
+    ok = c != EOF && fseek(f, offset, SEEK_SET) == 0 && fputc(c ^ 1, f) != EOF;
+    return fclose(f) == 0 && ok ? 0 : -1;
+}
+
+/**
+ * @brief Main function that runs the key blob test.
+ *
+ * The three keys of a mixed register's recipient are written to a key file and
+ * converted into a plain and an encrypted key blob. Only their owner may read
+ * them, and both must map with the recipient's public keys and find every
+ * match. The encrypted one must not open without its key or with another one.
+ * The coordinator must scan with the plain blob as its key file. A flipped byte
+ * must be caught by the checksum, but not with SAP_KEYBLOB_NO_VERIFY.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main() {
+    corpus_params params = { .kyber_k = CORPUS_MIXED, .n = TEST_N, .match_rate = 0.05, .threads = 1 };
+    for (int i = 0; i < CORPUS_SEED_BYTES; i++) params.seed[i] = (uint8_t)(5 * i + 1);
+    uint8_t enc_key[SAP_KEYBLOB_KEY_BYTES], other_key[SAP_KEYBLOB_KEY_BYTES];
+    for (int i = 0; i < SAP_KEYBLOB_KEY_BYTES; i++) {
+        enc_key[i] = (uint8_t)(i + 1);
+        other_key[i] = (uint8_t)(i + 2);
+    }
+
+    printf("Key blobs: ");
+    fflush(stdout);
+
+    corpus c;
+    if (corpus_generate(&c, &params) != 0) {
+        printf("Test FAILED!\n");
+        return 1;
+    }
+    int ok = corpus_save(&c, TEST_REGISTER) == 0;
+    FILE* f = fopen(TEST_KEYS, "wb");
+    ok = ok && f != NULL;
+    for (uint32_t l = 0; ok && l < CORPUS_LEVELS; l++) {
+        size_t ct_bytes, pk_bytes, sk_bytes;
+        uint8_t k = (uint8_t)(l + 2);
+        corpus_level_sizes(k, &ct_bytes, &pk_bytes, &sk_bytes);
+        ok = fwrite(&k, 1, 1, f) == 1 && fwrite(c.keys[l].k_pub, 1, pk_bytes, f) == pk_bytes
+            && fwrite(c.keys[l].v_priv, 1, sk_bytes, f) == sk_bytes;
+    }
+    if (f != NULL && fclose(f) != 0) ok = 0;
+
+    ok = ok && sap_keyblob_convert(TEST_BLOB, TEST_KEYS, NULL) == CORPUS_LEVELS
+        && sap_keyblob_convert(TEST_SEALED, TEST_KEYS, enc_key) == CORPUS_LEVELS
+        && sap_keyblob_is_blob(TEST_BLOB) && !sap_keyblob_is_blob(TEST_KEYS);
+    struct stat st;
+    ok = ok && stat(TEST_BLOB, &st) == 0 && (st.st_mode & 077) == 0
+        && stat(TEST_SEALED, &st) == 0 && (st.st_mode & 077) == 0;
+
+    sap_keyblob plain, sealed;
+    if (ok && sap_keyblob_open(&plain, TEST_BLOB, NULL, 0) == 0) {
+        ok = plain.n == CORPUS_LEVELS && scan_blob(&plain, &c) == c.n_matches;
+        for (size_t k = 0; ok && k < plain.n; k++) {
+            ok = plain.entries[k].kyber_k == k + 2 && plain.entries[k].key_offset % 64 == 0
+                && memcmp(sap_keyblob_spend_pub(&plain, k), c.keys[k].k_pub, plain.entries[k].pub_bytes) == 0;
+        }
+        if (ok && sap_keyblob_open(&sealed, TEST_SEALED, enc_key, 0) == 0) {
+            ok = sealed.n == plain.n && scan_blob(&sealed, &c) == c.n_matches;
+            for (size_t k = 0; ok && k < plain.n; k++) {
+                ok = memcmp(sap_keyblob_scan_key(&sealed, k), sap_keyblob_scan_key(&plain, k),
+                    scan_levels[k]->key_bytes) == 0;
+            }
+            sap_keyblob_close(&sealed);
+        } else {
+            ok = 0;
+        }
+        sap_keyblob_close(&plain);
+    } else {
+        ok = 0;
+    }
+    ok = ok && sap_keyblob_open(&sealed, TEST_SEALED, other_key, 0) == -1
+        && sap_keyblob_open(&sealed, TEST_SEALED, NULL, 0) == -1
+        && sap_keyblob_open(&plain, TEST_BLOB, enc_key, 0) == -1;
+
+    sap_coord_config config = { .register_path = TEST_REGISTER, .key_path = TEST_BLOB, .workers = 2, .shards = 3 };
+    sap_coord_result r;
+    ok = ok && sap_coord_run(&config, &r) == 0 && r.n_matches == c.n_matches && r.failures == 0;
+    if (ok) sap_coord_result_free(&r);
+
+    ok = ok && corrupt(TEST_BLOB, SAP_KEYBLOB_HEADER_BYTES + 4096) == 0
+        && sap_keyblob_open(&plain, TEST_BLOB, NULL, 0) == -1
+        && sap_keyblob_open(&plain, TEST_BLOB, NULL, SAP_KEYBLOB_NO_VERIFY) == 0;
+    if (ok) sap_keyblob_close(&plain);
+
+    remove(TEST_REGISTER);
+    remove(TEST_KEYS);
+    remove(TEST_BLOB);
+    remove(TEST_SEALED);
+    corpus_free(&c);
+
+    if (ok) {
+        printf("Test PASSED!\n");
+        return 0;
+    }
+    printf("Test FAILED!\n");
+    return 1;
+}
@@ -0,0 +1,135 @@
+#include "corpus.h"
+#include "keyring.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_N 48
+#define TEST_THREADS 3
+#define TEST_CHANGES 60
+
+typedef struct {
+    sap_keyring* kr;
+    const corpus* c;
+    const uint8_t* const* cts;
+    const uint8_t* view_tags;
+    _Atomic int* stop;
+    _Atomic size_t batches;
+    int ok;
+} worker;
+
+/// Scans the register over and over with whatever set is current; every wallet must find exactly the matches.
+static void* scan_loop(void* arg)
+{
+    worker* t = arg;
+    int slot = sap_keyring_join(t->kr);
+    uint8_t hits[TEST_N];
+    uint64_t last = 0;
+    t->ok = slot >= 0;
+    while (t->ok && !atomic_load(t->stop)) {
+        const sap_keyring_set* s = sap_keyring_enter(t->kr, slot);
+        t->ok = s->version >= last;
+        last = s->version;
+        for (size_t w = 0; t->ok && w < s->n; w++) {
+            t->ok = sap_scan_mixed(hits, NULL, t->cts, t->c->levels, t->view_tags, TEST_N, &s->wallets[w]->ks)
+                == t->c->n_matches;
+            for (size_t m = 0; t->ok && m < t->c->n_matches; m++) t->ok = hits[t->c->matches[m]] == 1;
+        }
+        sap_keyring_exit(t->kr, slot);
+        atomic_fetch_add(&t->batches, 1);
+    }
+    if (slot >= 0) sap_keyring_leave(t->kr, slot);
+    return NULL;
+}
+
+static void count_hit(void* arg, uint64_t wallet_id, size_t index, const uint8_t ss[32])
+{
+    (void)index;
+    (void)ss;
+    ((size_t*)arg)[wallet_id]++;
+}
+
+/**
+ * @brief Main function that runs the keyring test.
+ *
+ * Three worker threads scan a mixed register with the current set of wallets,
+ * batch after batch, while the test keeps adding and removing wallets. All
+ * wallets hold the recipient's keys, so in every batch every wallet must find
+ * exactly the register's matches. A wallet whose keys were wiped before the
+ * batch ended would not. The versions a worker sees must never go back, and
+ * once the workers have left every retired set and wallet must be freed.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main() {
+    corpus_params params = { .kyber_k = CORPUS_MIXED, .n = TEST_N, .match_rate = 0.2, .threads = 1 };
+    for (int i = 0; i < CORPUS_SEED_BYTES; i++) params.seed[i] = (uint8_t)(11 * i + 2);
+
+    printf("Keyring: ");
+
+    corpus c;
+    sap_keyring kr;
+    if (corpus_generate(&c, &params) != 0 || sap_keyring_init(&kr) != 0) {
+        printf("Test FAILED!\n");
+        return 1;
+    }
+    const uint8_t* cts[TEST_N];
+    uint8_t view_tags[TEST_N];
+    for (size_t i = 0; i < TEST_N; i++) {
+        cts[i] = corpus_ct(&c, i);
+        view_tags[i] = corpus_tag(&c, i)[0];
+    }
+    const uint8_t* v_priv[CORPUS_LEVELS] = { c.keys[0].v_priv, c.keys[1].v_priv, c.keys[2].v_priv };
+
+    int ok = c.n_matches > 0 && sap_keyring_add(&kr, 0, v_priv) == 0 && sap_keyring_add(&kr, 0, v_priv) == -1
+        && sap_keyring_remove(&kr, 7) == -1;
+
+    _Atomic int stop = 0;
+    worker t[TEST_THREADS];
+    pthread_t ids[TEST_THREADS];
+    for (int i = 0; i < TEST_THREADS; i++) {
+        t[i] = (worker){ &kr, &c, cts, view_tags, &stop, 0, 1 };
+        pthread_create(&ids[i], NULL, scan_loop, &t[i]);
+    }
+    /* wallets 1 to 3 come and go while the workers scan; wallet 0 stays */
+    size_t batches = 0;
+    for (unsigned int i = 0; ok && i < TEST_CHANGES; i++) {
+        uint64_t id = 1 + i % 3;
+        ok = (i / 3) % 2 == 0 ? sap_keyring_add(&kr, id, v_priv) == 0 : sap_keyring_remove(&kr, id) == 0;
+        for (size_t seen = batches; ok && batches == seen;) {
+            sched_yield();
+            batches = 0;
+            for (int k = 0; k < TEST_THREADS; k++) {
+                batches += atomic_load(&t[k].batches);
+                ok = ok && t[k].ok;
+            }
+        }
+    }
+    atomic_store(&stop, 1);
+    for (int i = 0; i < TEST_THREADS; i++) {
+        pthread_join(ids[i], NULL);
+        ok = ok && t[i].ok;
+    }
+    ok = ok && sap_keyring_collect(&kr) == 0;
+
+    int slot = sap_keyring_join(&kr);
+    size_t per_wallet[4] = { 0 };
+    uint8_t hits[TEST_N], ss[TEST_N * 32];
+    uint64_t version = 0;
+    ok = ok && slot >= 0
+        && sap_keyring_scan(&kr, slot, hits, ss, cts, c.levels, view_tags, TEST_N, count_hit, per_wallet, &version)
+            == c.n_matches
+        && version == TEST_CHANGES + 1 && per_wallet[0] == c.n_matches;
+    if (slot >= 0) sap_keyring_leave(&kr, slot);
+
+    sap_keyring_free(&kr);
+    corpus_free(&c);
+
+    if (ok) {
+        printf("Test PASSED!\n");
+        return 0;
+    }
+    printf("Test FAILED!\n");
+    return 1;
+}
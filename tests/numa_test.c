@@ -0,0 +1,86 @@
+#include "protocol_api.h"
+#include "corpus.h"
+#include "numa_scan.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_N 100
+
+/**
+ * @brief Main function that runs the NUMA-sharded scan test.
+ *
+ * The test reads the topology, which must list at least one node with CPUs, and
+ * scans a small corpus with sap_scan() and with the sharded scanner under every
+ * combination of flags and with one, three and the default number of threads.
+ * The test is passed if every sharded scan reports the same hits and shared
+ * secrets as sap_scan(), the shards cover the register without gaps, and a huge
+ * page mapping is 2 MiB aligned.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main() {
+    corpus_params params = { .kyber_k = KYBER_K, .n = TEST_N, .match_rate = 0.1, .threads = 1 };
+    for (int i = 0; i < CORPUS_SEED_BYTES; i++) params.seed[i] = (uint8_t)(i + 7);
+
+    printf("NUMA scan: ");
+
+    corpus c;
+    if (corpus_generate(&c, &params) != 0) {
+        printf("Test FAILED!\n");
+        return 1;
+    }
+
+    sap_numa_topology topology;
+    sap_numa_topology_read(&topology);
+    int ok = topology.n_nodes >= 1 && topology.nodes[0].n_cpus >= 1;
+
+    const uint8_t* cts[TEST_N];
+    uint8_t view_tags[TEST_N], expected[TEST_N], hits[TEST_N];
+    static uint8_t expected_ss[TEST_N * SS_BYTES], ss[TEST_N * SS_BYTES];
+    for (size_t i = 0; i < TEST_N; i++) {
+        cts[i] = corpus_ct(&c, i);
+        view_tags[i] = corpus_tag(&c, i)[0];
+    }
+    sap_scan_key key;
+    sap_scan_key_init(&key, c.v_priv);
+    size_t n_expected = sap_scan(expected, expected_ss, cts, view_tags, TEST_N, &key);
+    ok = ok && n_expected >= c.n_matches;
+
+    static const int flags[] = { 0, SAP_NUMA_HUGE, SAP_NUMA_SHARDS, SAP_NUMA_SHARDS | SAP_NUMA_HUGE };
+    static const unsigned int threads[] = { 1, 3, 0 };
+    for (size_t f = 0; ok && f < sizeof(flags) / sizeof(flags[0]); f++) {
+        sap_numa_scanner s;
+        if (sap_numa_scanner_init(&s, cts, view_tags, TEST_N, c.v_priv, flags[f]) != 0) {
+            ok = 0;
+            break;
+        }
+        size_t covered = 0;
+        for (unsigned int i = 0; i < s.n_shards; i++) {
+            ok = ok && s.shards[i].begin == covered;
+            covered += s.shards[i].n;
+            if (s.shards[i].mem.pages != SAP_NUMA_PAGES_SMALL) {
+                ok = ok && ((uintptr_t)s.shards[i].mem.base & (SAP_NUMA_HUGE_PAGE - 1)) == 0;
+            }
+        }
+        ok = ok && covered == TEST_N;
+
+        for (size_t t = 0; ok && t < sizeof(threads) / sizeof(threads[0]); t++) {
+            memset(hits, 0xff, sizeof(hits));
+            memset(ss, 0, sizeof(ss));
+            ok = sap_numa_scanner_scan(&s, hits, ss, threads[t]) == n_expected
+                && memcmp(hits, expected, TEST_N) == 0;
+            for (size_t i = 0; ok && i < TEST_N; i++) {
+                ok = !expected[i] || memcmp(ss + i * SS_BYTES, expected_ss + i * SS_BYTES, SS_BYTES) == 0;
+            }
+        }
+        sap_numa_scanner_free(&s);
+    }
+    corpus_free(&c);
+
+    if (ok) {
+        printf("Test PASSED!\n");
+        return 0;
+    }
+    printf("Test FAILED!\n");
+    return 1;
+}
@@ -31,8 +31,8 @@ int main() {
 
     printf("SAP Protocol: ");
 
-    crypto_kem_keypair(k_pub, k_priv);
-    crypto_kem_keypair(v_pub, v_priv);
+    sap_kem_keypair(k_pub, k_priv);
+    sap_kem_keypair(v_pub, v_priv);
 
     printf("KYBER_K: %d\n", KYBER_K);
 
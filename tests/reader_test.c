@@ -0,0 +1,107 @@
+#include "corpus.h"
+#include "reader.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_N 500
+#define TEST_THREADS 3
+#define TEST_PATH "tests/reader_test.sap"
+
+typedef struct {
+    sap_reader* reader;
+    const corpus* c;
+    unsigned int* seen;
+    pthread_mutex_t* lock;
+    int ok;
+} consumer;
+
+/// Takes batches until the reader is done and checks every announcement against the corpus.
+static void* consume(void* arg)
+{
+    consumer* t = arg;
+    sap_reader_batch b;
+    int r;
+    while ((r = sap_reader_next(t->reader, &b)) == 1) {
+        for (size_t i = 0; i < b.n && t->ok; i++) {
+            size_t at = b.begin + i;
+            t->ok = at < TEST_N && b.levels[i] == t->c->levels[at]
+                && memcmp(b.cts[i], corpus_ct(t->c, at), t->c->ct_offsets[at + 1] - t->c->ct_offsets[at]) == 0
+                && memcmp(b.tags + i * CORPUS_TAG_BYTES, corpus_tag(t->c, at), CORPUS_TAG_BYTES) == 0
+                && b.view_tags[i] == corpus_tag(t->c, at)[0];
+            pthread_mutex_lock(t->lock);
+            if (t->ok) t->seen[at]++;
+            pthread_mutex_unlock(t->lock);
+        }
+        sap_reader_release(t->reader, &b);
+    }
+    t->ok = t->ok && r == 0;
+    return NULL;
+}
+
+/**
+ * @brief Main function that runs the register reader test.
+ *
+ * A mixed register is written to disk and streamed with io_uring, with pread()
+ * and through the page cache, in small batches that start and end at unaligned
+ * offsets, by three threads at once. The test is passed if every announcement
+ * is handed out exactly once, with the levels, ephemeral public keys and tags
+ * of the register, and the reader without io_uring reports so.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main() {
+    corpus_params params = { .kyber_k = CORPUS_MIXED, .n = TEST_N, .match_rate = 0.01, .threads = 1 };
+    for (int i = 0; i < CORPUS_SEED_BYTES; i++) params.seed[i] = (uint8_t)(5 * i + 1);
+
+    printf("Register reader: ");
+
+    corpus c;
+    if (corpus_generate(&c, &params) != 0) {
+        printf("Test FAILED!\n");
+        return 1;
+    }
+    int ok = corpus_save(&c, TEST_PATH) == 0;
+
+    static const sap_reader_config configs[] = {
+        { TEST_PATH, 4, 10000, 0 },
+        { TEST_PATH, 3, 5000, SAP_READER_NO_URING },
+        { TEST_PATH, 2, 1, SAP_READER_NO_DIRECT },
+    };
+    for (size_t k = 0; ok && k < sizeof(configs) / sizeof(configs[0]); k++) {
+        sap_reader* reader = sap_reader_open(&configs[k]);
+        if (reader == NULL) {
+            ok = 0;
+            break;
+        }
+        unsigned int seen[TEST_N] = { 0 };
+        pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+        consumer t[TEST_THREADS];
+        pthread_t ids[TEST_THREADS];
+        for (int i = 0; i < TEST_THREADS; i++) {
+            t[i] = (consumer){ reader, &c, seen, &lock, 1 };
+            pthread_create(&ids[i], NULL, consume, &t[i]);
+        }
+        for (int i = 0; i < TEST_THREADS; i++) {
+            pthread_join(ids[i], NULL);
+            ok = ok && t[i].ok;
+        }
+        for (size_t i = 0; i < TEST_N; i++) ok = ok && seen[i] == 1;
+
+        sap_reader_stats stats;
+        sap_reader_get_stats(reader, &stats);
+        ok = ok && sap_reader_entries(reader) == TEST_N && stats.reads > 2;
+        ok = ok && !((configs[k].flags & SAP_READER_NO_URING) && stats.uring);
+        ok = ok && !((configs[k].flags & SAP_READER_NO_DIRECT) && stats.direct);
+        sap_reader_close(reader);
+    }
+    remove(TEST_PATH);
+    corpus_free(&c);
+
+    if (ok) {
+        printf("Test PASSED!\n");
+        return 0;
+    }
+    printf("Test FAILED!\n");
+    return 1;
+}
@@ -0,0 +1,82 @@
+#include "sap.hpp"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static_assert(!std::is_copy_constructible_v<sap::SecretKey<3>>, "secret keys are move-only");
+static_assert(!std::is_copy_constructible_v<sap::Recipient<3>>, "recipients are move-only");
+static_assert(!std::is_copy_constructible_v<sap::Context<3>> && std::is_nothrow_move_constructible_v<sap::Context<3>>,
+    "contexts are move-only");
+static_assert(!std::is_same_v<sap::Ciphertext<2>, sap::StealthAddress<2>>, "buffers are distinct types");
+
+/**
+ * Workflow:
+ *  1. Creates a recipient with fresh spend and view keys and a few other addresses.
+ *  2. Sends a batch of announcements, every third one to the recipient.
+ *  3. Checks that receive() and both batch scans find exactly those and yield the
+ *     stealth address the sender computed.
+ */
+template <int K>
+static bool run_level()
+{
+    constexpr std::size_t n = 40;
+    sap::Context<K> ctx;
+
+    sap::KeyPair<K> spend = ctx.keypair();
+    sap::KeyPair<K> view = ctx.keypair();
+    sap::MetaAddress<K> self { spend.pub, view.pub };
+    sap::MetaAddress<K> other { ctx.keypair().pub, ctx.keypair().pub };
+    sap::Recipient<K> recipient(spend.pub, std::move(view.sec), sap::Context<K>(ctx.backend().id));
+
+    std::vector<sap::MetaAddress<K>> to(n, other);
+    for (std::size_t i = 0; i < n; i += 3) to[i] = self;
+    std::vector<sap::Announcement<K>> ann(n);
+    ctx.send(to, ann);
+
+    std::vector<sap::Ciphertext<K>> cts(n);
+    std::vector<std::uint8_t> tags(n), hits(n), hits_ann(n);
+    std::vector<sap::SharedSecret> ss(n);
+    for (std::size_t i = 0; i < n; i++) {
+        cts[i] = ann[i].ephemeral_pub_key;
+        tags[i] = ann[i].view_tag;
+    }
+    std::size_t found = recipient.scan(cts, tags, hits, ss);
+    bool ok = found == (n + 2) / 3 && recipient.scan(ann, hits_ann) == found;
+
+    for (std::size_t i = 0; ok && i < n; i++) {
+        bool mine = i % 3 == 0;
+        auto stealth = recipient.receive(ann[i]);
+        ok = hits[i] == mine && hits_ann[i] == mine;
+        if (mine) {
+            ok = ok && stealth && *stealth == ann[i].stealth_pub_key
+                && ctx.stealth_address(ss[i], recipient.spend_key()) == ann[i].stealth_pub_key;
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief Main function that runs the C++ API test.
+ *
+ * Runs the same send and scan round trip at all three security levels in one
+ * process, and checks that batch arguments of different lengths are rejected.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main()
+{
+    std::printf("C++ API: ");
+    bool ok = run_level<2>() && run_level<3>() && run_level<4>();
+
+    try {
+        sap::Context<2> ctx;
+        std::vector<sap::SharedSecret> ss(3);
+        std::vector<std::uint8_t> tags(2);
+        ctx.view_tags(ss, tags);
+        ok = false;
+    } catch (const std::invalid_argument&) {
+    }
+
+    std::printf(ok ? "Test PASSED!\n" : "Test FAILED!\n");
+    return ok ? 0 : 1;
+}
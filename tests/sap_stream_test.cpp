@@ -0,0 +1,96 @@
+#include "sap_stream.hpp"
+#include <cstdio>
+#include <vector>
+
+static_assert(!std::is_copy_constructible_v<sap::Generator<sap::Match<3>>>, "generators are move-only");
+static_assert(!std::is_copy_constructible_v<sap::SharedSecretHandle>, "secret handles are move-only");
+
+/**
+ * Workflow:
+ *  1. Sends announcements spanning several scan chunks, every seventh one to the recipient.
+ *  2. Streams both kinds of scan to the end and checks that exactly those indices are
+ *     yielded in order, with the sender's stealth address and a matching shared secret.
+ *  3. Stops a stream after its first match, which destroys the suspended coroutine.
+ */
+template <int K>
+static bool run_level()
+{
+    constexpr std::size_t n = 2 * sap::Recipient<K>::chunk + 88;
+    sap::Context<K> ctx;
+
+    sap::KeyPair<K> spend = ctx.keypair();
+    sap::KeyPair<K> view = ctx.keypair();
+    sap::MetaAddress<K> self { spend.pub, view.pub };
+    sap::MetaAddress<K> other { ctx.keypair().pub, ctx.keypair().pub };
+    sap::Recipient<K> recipient(spend.pub, std::move(view.sec), sap::Context<K>(ctx.backend().id));
+
+    std::vector<sap::MetaAddress<K>> to(n, other);
+    for (std::size_t i = 3; i < n; i += 7) to[i] = self;
+    std::vector<sap::Announcement<K>> ann(n);
+    ctx.send(to, ann);
+
+    std::vector<sap::Ciphertext<K>> cts(n);
+    std::vector<std::uint8_t> tags(n);
+    for (std::size_t i = 0; i < n; i++) {
+        cts[i] = ann[i].ephemeral_pub_key;
+        tags[i] = ann[i].view_tag;
+    }
+
+    bool ok = true;
+    std::size_t expected = 3;
+    for (auto& m : sap::scan_stream(recipient, ann)) {
+        ok = ok && m.index == expected && m.stealth_pub_key == ann[m.index].stealth_pub_key
+            && ctx.stealth_address(m.shared_secret.get(), spend.pub) == m.stealth_pub_key;
+        expected += 7;
+    }
+    ok = ok && expected - 7 < n && expected >= n;
+
+    expected = 3;
+    for (auto& m : sap::scan_stream(recipient, cts, tags)) {
+        sap::SharedSecretHandle ss = std::move(m.shared_secret);
+        ok = ok && m.index == expected && m.stealth_pub_key == ann[m.index].stealth_pub_key;
+        expected += 7;
+    }
+    ok = ok && expected >= n;
+
+    std::size_t seen = 0;
+    {
+        auto stream = sap::scan_stream(recipient, ann);
+        for (auto& m : stream) {
+            ok = ok && m.index == 3;
+            seen++;
+            break;
+        }
+    }
+    return ok && seen == 1;
+}
+
+/**
+ * @brief Main function that runs the C++20 streaming scan test.
+ *
+ * Streams the matches of the same register at all three security levels, and
+ * checks that arguments of different lengths are rejected before the first
+ * iteration.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main()
+{
+    std::printf("C++ scan stream: ");
+    bool ok = run_level<2>() && run_level<3>() && run_level<4>();
+
+    sap::Context<2> ctx;
+    sap::KeyPair<2> spend = ctx.keypair();
+    sap::KeyPair<2> view = ctx.keypair();
+    sap::Recipient<2> recipient(spend.pub, std::move(view.sec), std::move(ctx));
+    std::vector<sap::Ciphertext<2>> cts(3);
+    std::vector<std::uint8_t> tags(2);
+    try {
+        auto stream = sap::scan_stream(recipient, cts, tags);
+        ok = false;
+    } catch (const std::invalid_argument&) {
+    }
+
+    std::printf(ok ? "Test PASSED!\n" : "Test FAILED!\n");
+    return ok ? 0 : 1;
+}
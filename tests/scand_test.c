@@ -0,0 +1,269 @@
+#include "corpus.h"
+#include "keyblob.h"
+#include "scand.h"
+#include "scand_client.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_N 192
+#define TEST_PREFIX 96
+#define TEST_REGISTER "tests/scand_test.sap"
+#define TEST_REGISTER_TMP "tests/scand_test.sap.tmp"
+#define TEST_KEYS "tests/scand_test.keys"
+#define TEST_KEYS_PLAIN "tests/scand_test.keys.plain"
+#define TEST_SOCKET "tests/scand_test.sock"
+
+static void* run_daemon(void* arg)
+{
+    sap_scand_run(arg);
+    return NULL;
+}
+
+static void sleep_ms(long ms)
+{
+    struct timespec t = { ms / 1000, (ms % 1000) * 1000000 };
+    nanosleep(&t, NULL);
+}
+
+/// Writes the keys of levels @p first and above as a new key file; the old one
+/// is unlinked rather than truncated, as the daemon may still map it as a blob.
+static int write_keys(const corpus* c, uint32_t first)
+{
+    remove(TEST_KEYS);
+    FILE* f = fopen(TEST_KEYS, "wb");
+    if (f == NULL) {
+        return -1;
+    }
+    int ok = 1;
+    for (uint32_t l = first; l < CORPUS_LEVELS; l++) {
+        size_t ct_bytes, pk_bytes, sk_bytes;
+        uint8_t k = (uint8_t)(l + 2);
+        corpus_level_sizes(k, &ct_bytes, &pk_bytes, &sk_bytes);
+        ok &= fwrite(&k, 1, 1, f) == 1;
+        ok &= fwrite(c->keys[l].k_pub, 1, pk_bytes, f) == pk_bytes;
+        ok &= fwrite(c->keys[l].v_priv, 1, sk_bytes, f) == sk_bytes;
+    }
+    ok &= fclose(f) == 0;
+    return ok ? 0 : -1;
+}
+
+/// Replaces the key file with a key blob holding the keys of levels @p first and above.
+static int write_blob(const corpus* c, uint32_t first)
+{
+    return write_keys(c, first) == 0 && rename(TEST_KEYS, TEST_KEYS_PLAIN) == 0
+        && sap_keyblob_convert(TEST_KEYS, TEST_KEYS_PLAIN, NULL) == (long)(CORPUS_LEVELS - first)
+        && remove(TEST_KEYS_PLAIN) == 0 ? 0 : -1;
+}
+
+/// Replaces the register file at once, as an appending writer would.
+static int publish(const corpus* c)
+{
+    return corpus_save(c, TEST_REGISTER_TMP) == 0 && rename(TEST_REGISTER_TMP, TEST_REGISTER) == 0 ? 0 : -1;
+}
+
+/// Copies the first @p n announcements of @p c, with its keys, into @p out.
+static int corpus_prefix(corpus* out, const corpus* c, size_t n)
+{
+    size_t n_matches = 0;
+    while (n_matches < c->n_matches && c->matches[n_matches] < n) n_matches++;
+    if (corpus_alloc_mixed(out, c->levels, n, n_matches) != 0) {
+        return -1;
+    }
+    memcpy(out->seed, c->seed, CORPUS_SEED_BYTES);
+    for (uint32_t l = 0; l < CORPUS_LEVELS; l++) {
+        size_t ct_bytes, pk_bytes, sk_bytes;
+        if (out->keys[l].k_pub == NULL) continue;
+        corpus_level_sizes(l + 2, &ct_bytes, &pk_bytes, &sk_bytes);
+        memcpy(out->keys[l].k_pub, c->keys[l].k_pub, pk_bytes);
+        memcpy(out->keys[l].k_priv, c->keys[l].k_priv, sk_bytes);
+        memcpy(out->keys[l].v_pub, c->keys[l].v_pub, pk_bytes);
+        memcpy(out->keys[l].v_priv, c->keys[l].v_priv, sk_bytes);
+    }
+    memcpy(out->ephemeral_pub_keys, c->ephemeral_pub_keys, c->ct_offsets[n]);
+    memcpy(out->tags, c->tags, n * CORPUS_TAG_BYTES);
+    memcpy(out->matches, c->matches, n_matches * sizeof(uint64_t));
+    return 0;
+}
+
+/// Waits until every key has scanned @p n entries.
+static int wait_scanned(sap_scand_client* client, uint64_t n, uint32_t keys)
+{
+    for (int i = 0; i < 1000; i++) {
+        sap_scand_status s;
+        if (sap_scand_get_status(client, &s) != 0) {
+            return -1;
+        }
+        if (s.entries == n && s.scanned == n && s.keys == keys) {
+            return 0;
+        }
+        sleep_ms(10);
+    }
+    return -1;
+}
+
+/// Checks that the matches of @p id from @p from are the matches of @p c at level @p k.
+static int check_query(sap_scand_client* client, uint32_t id, uint32_t k, uint64_t from, const corpus* c)
+{
+    sap_scand_match m[TEST_N];
+    long n = sap_scand_query(client, id, from, m, TEST_N);
+    long j = 0;
+    for (size_t i = 0; i < c->n_matches; i++) {
+        uint64_t index = c->matches[i];
+        if (index < from || c->levels[index] != k) continue;
+        if (j >= n || m[j].index != index || m[j].key_id != id || m[j].kyber_k != k) {
+            return -1;
+        }
+        j++;
+    }
+    return j == n ? 0 : -1;
+}
+
+/**
+ * @brief Main function that runs the scan daemon test.
+ *
+ * The daemon runs on a thread over a mixed-level register of TEST_PREFIX
+ * announcements, and the test talks to it through the client library. After
+ * the recipient's three keys are registered, a query that waits for the last
+ * one must be answered once it has scanned the register. Querying each key
+ * must return exactly the register's matches at that level, and the scheduler
+ * must report one tail batch per key. The register is then
+ * replaced by its extension to TEST_N announcements: a subscribed client must
+ * receive an event for every new match and none for the old ones, with stealth
+ * public keys equal to those of the query replies. A second daemon loads the
+ * keys from a key file and, scanning chunks of 16 entries, must find the same
+ * matches; reloading the unchanged file must keep its keys scanned, and
+ * reloading it without one key must drop that key. The test is passed if every
+ * check holds.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main() {
+    corpus_params params = { .kyber_k = CORPUS_MIXED, .n = TEST_N, .match_rate = 0.125, .threads = 1 };
+    for (int i = 0; i < CORPUS_SEED_BYTES; i++) params.seed[i] = (uint8_t)(7 * i);
+
+    printf("Scan daemon: ");
+
+    corpus full, prefix;
+    if (corpus_generate(&full, &params) != 0) {
+        printf("Test FAILED!\n");
+        return 1;
+    }
+    if (corpus_prefix(&prefix, &full, TEST_PREFIX) != 0 || publish(&prefix) != 0) {
+        corpus_free(&full);
+        printf("Test FAILED!\n");
+        return 1;
+    }
+    remove(TEST_KEYS);
+
+    sap_scand_config config = { .socket_path = TEST_SOCKET, .register_path = TEST_REGISTER, .key_path = TEST_KEYS,
+        .poll_ms = 10 };
+    sap_scand* d = sap_scand_open(&config);
+    int ok = d == NULL;
+    config.key_path = NULL;
+    if (ok) d = sap_scand_open(&config);
+    ok = d != NULL;
+
+    sap_scand_client client = { .fd = -1 }, watcher = { .fd = -1 }, reloader = { .fd = -1 };
+    pthread_t thread;
+    ok = ok && pthread_create(&thread, NULL, run_daemon, d) == 0;
+    int running = ok;
+
+    ok = ok && sap_scand_connect(&client, TEST_SOCKET) == 0;
+    ok = ok && sap_scand_connect(&watcher, TEST_SOCKET) == 0;
+
+    uint32_t ids[CORPUS_LEVELS];
+    for (uint32_t l = 0; ok && l < CORPUS_LEVELS; l++) {
+        ok = sap_scand_register(&client, l + 2, full.keys[l].k_pub, full.keys[l].v_priv, &ids[l]) == 0;
+    }
+    sap_scand_match first[TEST_PREFIX];
+    uint64_t scanned = 0;
+    ok = ok && sap_scand_query_wait(&client, ids[CORPUS_LEVELS - 1], 0, 5000, first, TEST_PREFIX, &scanned) >= 0
+        && scanned == TEST_PREFIX;
+    ok = ok && wait_scanned(&client, TEST_PREFIX, CORPUS_LEVELS) == 0;
+    for (uint32_t l = 0; ok && l < CORPUS_LEVELS; l++) {
+        ok = check_query(&client, ids[l], l + 2, 0, &prefix) == 0;
+    }
+    sap_scand_queue_metrics metrics[2];
+    ok = ok && sap_scand_get_metrics(&client, metrics) == 0 && metrics[0].waits == CORPUS_LEVELS
+        && metrics[0].batches == CORPUS_LEVELS && metrics[1].batches == 0 && metrics[0].keys == 0;
+    ok = ok && sap_scand_set_weight(&client, ids[1], 300) == 0 && sap_scand_set_weight(&client, 1000, 300) != 0;
+
+    /* follow the appended announcements */
+    for (uint32_t l = 0; ok && l < CORPUS_LEVELS; l++) {
+        ok = sap_scand_subscribe(&watcher, ids[l]) == 0;
+    }
+    ok = ok && publish(&full) == 0;
+    size_t expected = full.n_matches - prefix.n_matches;
+    for (size_t i = 0; ok && i < expected; i++) {
+        sap_scand_match e, q;
+        ok = sap_scand_next_event(&watcher, &e, 5000) == 1 && e.index >= TEST_PREFIX
+            && sap_scand_query(&client, e.key_id, e.index, &q, 1) == 1 && q.index == e.index
+            && memcmp(q.ss, e.ss, 32) == 0
+            && memcmp(q.stealth_pub_key, e.stealth_pub_key, SAP_SCAND_STEALTH_BYTES(e.kyber_k)) == 0;
+    }
+    ok = ok && wait_scanned(&client, TEST_N, CORPUS_LEVELS) == 0;
+    for (uint32_t l = 0; ok && l < CORPUS_LEVELS; l++) {
+        ok = check_query(&client, ids[l], l + 2, 0, &full) == 0;
+    }
+    sap_scand_match extra;
+    ok = ok && sap_scand_next_event(&watcher, &extra, 50) == 0;
+
+    /* unregistering; without a key file a reload finds no keys */
+    ok = ok && sap_scand_unregister(&client, ids[0]) == 0 && sap_scand_unregister(&client, ids[0]) != 0;
+    ok = ok && sap_scand_reload_keys(&client) == 0 && wait_scanned(&client, TEST_N, CORPUS_LEVELS - 1) == 0;
+
+    if (running) {
+        sap_scand_stop(d);
+        pthread_join(thread, NULL);
+    }
+    if (d != NULL) sap_scand_close(d);
+
+    /* key file loaded at start and on reload */
+    config.key_path = TEST_KEYS;
+    config.chunk_entries = 16;
+    d = ok && write_keys(&full, 0) == 0 ? sap_scand_open(&config) : NULL;
+    ok = d != NULL && pthread_create(&thread, NULL, run_daemon, d) == 0;
+    running = ok;
+
+    ok = ok && sap_scand_connect(&reloader, TEST_SOCKET) == 0;
+    ok = ok && wait_scanned(&reloader, TEST_N, CORPUS_LEVELS) == 0;
+    for (uint32_t l = 0; ok && l < CORPUS_LEVELS; l++) {
+        uint32_t id;
+        ok = sap_scand_register(&reloader, l + 2, full.keys[l].k_pub, full.keys[l].v_priv, &id) == 0
+            && wait_scanned(&reloader, TEST_N, CORPUS_LEVELS + l + 1) == 0
+            && check_query(&reloader, id, l + 2, 0, &full) == 0;
+    }
+    ok = ok && sap_scand_reload_keys(&reloader) == CORPUS_LEVELS
+        && wait_scanned(&reloader, TEST_N, 2 * CORPUS_LEVELS) == 0;
+    ok = ok && write_keys(&full, 1) == 0 && sap_scand_reload_keys(&reloader) == CORPUS_LEVELS - 1
+        && wait_scanned(&reloader, TEST_N, 2 * CORPUS_LEVELS - 1) == 0;
+
+    /* a key blob in place of the key file; the new key scans from the mapping */
+    ok = ok && write_blob(&full, 0) == 0 && sap_scand_reload_keys(&reloader) == CORPUS_LEVELS
+        && wait_scanned(&reloader, TEST_N, 2 * CORPUS_LEVELS) == 0;
+    ok = ok && write_keys(&full, 1) == 0 && sap_scand_reload_keys(&reloader) == CORPUS_LEVELS - 1
+        && wait_scanned(&reloader, TEST_N, 2 * CORPUS_LEVELS - 1) == 0;
+    if (running) {
+        sap_scand_stop(d);
+        pthread_join(thread, NULL);
+    }
+    if (d != NULL) sap_scand_close(d);
+
+    sap_scand_disconnect(&client);
+    sap_scand_disconnect(&watcher);
+    sap_scand_disconnect(&reloader);
+    remove(TEST_REGISTER);
+    remove(TEST_KEYS);
+    corpus_free(&prefix);
+    corpus_free(&full);
+
+    if (ok) {
+        printf("Test PASSED!\n");
+        return 0;
+    }
+    printf("Test FAILED!\n");
+    return 1;
+}
@@ -0,0 +1,75 @@
+#include "scan_sched.h"
+#include <stdio.h>
+
+#define TEST_COST 1000
+
+/// Runs @p batches batches of TEST_COST and counts how many each entity got.
+static void run(sap_sched* s, sap_sched_entity* const* e, size_t n, unsigned int batches, unsigned int* counts)
+{
+    for (size_t i = 0; i < n; i++) counts[i] = 0;
+    for (unsigned int b = 0; b < batches; b++) {
+        sap_sched_entity* next = sap_sched_next(s);
+        for (size_t i = 0; i < n; i++) {
+            if (e[i] == next) counts[i]++;
+        }
+        sap_sched_charge(s, next, 0, TEST_COST);
+    }
+}
+
+/**
+ * @brief Main function that runs the scan scheduler test.
+ *
+ * Two backfill entities with weights 100 and 300 must share the batches 1:3. A
+ * tail entity that becomes runnable must run next, and while it stays runnable
+ * it must get 90% of the batches, with its queue delay recorded. After the tail
+ * entity was idle while the backfills ran, it must not make up for that time:
+ * the backfill queue still gets its share right away. The test is passed if all
+ * counts are within one batch of the expected ones.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main() {
+    sap_sched s;
+    sap_sched_entity a, b, tail;
+    sap_sched_entity* const all[3] = { &a, &b, &tail };
+    unsigned int counts[3];
+    int ok;
+
+    printf("Scan scheduler: ");
+
+    sap_sched_init(&s, 0);
+    ok = sap_sched_add(&s, &a, NULL) == 0 && sap_sched_add(&s, &b, NULL) == 0 && sap_sched_add(&s, &tail, NULL) == 0;
+    ok = ok && sap_sched_next(&s) == NULL;
+
+    sap_sched_set_weight(&b, 300);
+    sap_sched_update(&s, &a, SAP_SCHED_BACKFILL, 1);
+    sap_sched_update(&s, &b, SAP_SCHED_BACKFILL, 1);
+    run(&s, all, 3, 400, counts);
+    ok = ok && counts[0] >= 99 && counts[0] <= 101 && counts[1] >= 299 && counts[1] <= 301;
+
+    sap_sched_update(&s, &tail, SAP_SCHED_TAIL, 5000);
+    ok = ok && sap_sched_next(&s) == &tail;
+    sap_sched_charge(&s, &tail, 5500, TEST_COST);
+    ok = ok && s.stats[SAP_SCHED_TAIL].waits == 1 && s.stats[SAP_SCHED_TAIL].wait_max == 500;
+    run(&s, all, 3, 1000, counts);
+    ok = ok && counts[2] >= 899 && counts[2] <= 901 && counts[0] + counts[1] + counts[2] == 1000;
+
+    sap_sched_update(&s, &tail, SAP_SCHED_IDLE, 0);
+    run(&s, all, 3, 1000, counts);
+    ok = ok && counts[2] == 0;
+    sap_sched_update(&s, &tail, SAP_SCHED_TAIL, 9000);
+    run(&s, all, 3, 20, counts);
+    ok = ok && counts[2] >= 17 && counts[2] <= 19;
+
+    sap_sched_remove(&s, &tail);
+    run(&s, all, 3, 4, counts);
+    ok = ok && counts[2] == 0 && s.runnable[SAP_SCHED_TAIL] == 0 && s.n_entities == 2;
+    sap_sched_free(&s);
+
+    if (ok) {
+        printf("Test PASSED!\n");
+        return 0;
+    }
+    printf("Test FAILED!\n");
+    return 1;
+}
@@ -0,0 +1,141 @@
+#include "corpus.h"
+#include "shm_ring.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define TEST_N 300
+#define TEST_BURST 50
+
+typedef struct {
+    int fd;
+    int ok;
+} hit_pipe;
+
+/// Sends the position of every hit to the parent.
+static void send_hit(void* arg, uint64_t pos, const sap_shm_slot* slot, const uint8_t ss[32])
+{
+    (void)slot;
+    (void)ss;
+    hit_pipe* p = arg;
+    p->ok = p->ok && write(p->fd, &pos, sizeof(pos)) == sizeof(pos);
+}
+
+/// The scanner process: maps the inherited ring read-only and scans it until all announcements are seen.
+static int scan_child(int ring_fd, int out_fd, const corpus* c)
+{
+    sap_shm_reader r;
+    if (sap_shm_reader_attach(&r, ring_fd) != 0) {
+        return 1;
+    }
+    close(ring_fd);
+    sap_scan_keyset ks;
+    const uint8_t* v_priv[CORPUS_LEVELS] = { c->keys[0].v_priv, c->keys[1].v_priv, c->keys[2].v_priv };
+    if (sap_scan_keyset_init(&ks, v_priv) != 0) {
+        return 1;
+    }
+    hit_pipe p = { out_fd, 1 };
+    while (p.ok && r.next < TEST_N) {
+        if (!sap_shm_reader_wait(&r, 5000)) break;
+        p.ok = sap_shm_reader_scan(&r, &ks, send_hit, &p, NULL) != SIZE_MAX;
+    }
+    int ok = p.ok && r.next == TEST_N && r.lost == 0;
+    sap_scan_keyset_free(&ks);
+    sap_shm_reader_close(&r);
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Main function that runs the shared-memory ring test.
+ *
+ * A forked scanner process maps a memfd ring read-only and sleeps on it while
+ * the test writes a mixed register into the ring in bursts. The scanner must
+ * report exactly the register's matches, at their positions, without losing an
+ * announcement. A small named ring is then lapped by its writer: the reader must
+ * skip and count the overwritten positions, and must reject slots that are
+ * overwritten while it holds them.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main() {
+    corpus_params params = { .kyber_k = CORPUS_MIXED, .n = TEST_N, .match_rate = 0.05, .threads = 1 };
+    for (int i = 0; i < CORPUS_SEED_BYTES; i++) params.seed[i] = (uint8_t)(3 * i + 7);
+
+    printf("Shared-memory ring: ");
+
+    corpus c;
+    sap_shm_writer w;
+    int pipe_fds[2];
+    if (corpus_generate(&c, &params) != 0 || sap_shm_writer_create(&w, NULL, 2 * TEST_N) != 0 || pipe(pipe_fds) != 0) {
+        printf("Test FAILED!\n");
+        return 1;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(pipe_fds[0]);
+        _exit(scan_child(w.fd, pipe_fds[1], &c));
+    }
+    close(pipe_fds[1]);
+    int ok = pid > 0;
+    for (size_t i = 0; ok && i < TEST_N; i++) {
+        ok = sap_shm_writer_push(&w, c.levels[i], corpus_ct(&c, i), c.ct_offsets[i + 1] - c.ct_offsets[i],
+            corpus_tag(&c, i)[0]) == 0;
+        if ((i + 1) % TEST_BURST == 0) {
+            sap_shm_writer_flush(&w);
+            usleep(2000);
+        }
+    }
+    sap_shm_writer_flush(&w);
+
+    uint64_t pos;
+    size_t n_hits = 0;
+    while (read(pipe_fds[0], &pos, sizeof(pos)) == sizeof(pos)) {
+        ok = ok && n_hits < c.n_matches && pos == c.matches[n_hits];
+        n_hits++;
+    }
+    close(pipe_fds[0]);
+    int status = 1;
+    ok = ok && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    ok = ok && n_hits == c.n_matches && c.n_matches > 0;
+    sap_shm_writer_close(&w);
+
+    char name[64];
+    snprintf(name, sizeof(name), "/pqsap-shm-test-%d", (int)getpid());
+    sap_shm_reader r;
+    uint8_t ct[SAP_SHM_CT_BYTES + 1] = { 0 };
+    if (ok && sap_shm_writer_create(&w, name, 8) == 0) {
+        ok = sap_shm_reader_open(&r, name) == 0;
+        for (unsigned int i = 0; ok && i < 20; i++) {
+            ct[0] = (uint8_t)i;
+            ok = sap_shm_writer_push(&w, 2, ct, 768, (uint8_t)i) == 0;
+        }
+        ok = ok && sap_shm_writer_push(&w, 4, ct, sizeof(ct), 0) == -1;
+
+        const sap_shm_slot* slots[16];
+        uint64_t seqs[16];
+        uint8_t valid[16];
+        ok = ok && sap_shm_reader_peek(&r, slots, seqs, 16) == 8 && r.next == 12 && r.lost == 12;
+        for (unsigned int i = 0; ok && i < 8; i++) ok = slots[i]->ct[0] == 12 + i && slots[i]->view_tag == 12 + i;
+        for (unsigned int i = 0; ok && i < 3; i++) ok = sap_shm_writer_push(&w, 2, ct, 768, 0) == 0;
+        ok = ok && sap_shm_reader_release(&r, slots, seqs, 8, valid) == 3 && r.next == 20 && r.lost == 15;
+        for (unsigned int i = 0; ok && i < 8; i++) ok = valid[i] == (i >= 3);
+
+        ok = ok && sap_shm_reader_wait(&r, 10) == 1 && sap_shm_reader_peek(&r, slots, seqs, 16) == 3;
+        ok = ok && sap_shm_reader_release(&r, slots, seqs, 3, NULL) == 0 && sap_shm_reader_wait(&r, 10) == 0;
+        sap_shm_reader_close(&r);
+        sap_shm_writer_close(&w);
+        ok = ok && sap_shm_reader_open(&r, name) == -1;
+    } else {
+        ok = 0;
+    }
+    corpus_free(&c);
+
+    if (ok) {
+        printf("Test PASSED!\n");
+        return 0;
+    }
+    printf("Test FAILED!\n");
+    return 1;
+}
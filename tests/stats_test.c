@@ -0,0 +1,116 @@
+#include "corpus.h"
+#include "scan_mixed.h"
+#include "scan_stats.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_N 200
+#define TEST_THREADS 2
+
+typedef struct {
+    const corpus* c;
+    const uint8_t* const* cts;
+    const uint8_t* view_tags;
+    const sap_scan_keyset* ks;
+    size_t found;
+} scanner;
+
+static void* scan_once(void* arg)
+{
+    scanner* t = arg;
+    uint8_t hits[TEST_N];
+    t->found = sap_scan_mixed(hits, NULL, t->cts, t->c->levels, t->view_tags, TEST_N, t->ks);
+    return NULL;
+}
+
+/**
+ * @brief Main function that runs the scan statistics test.
+ *
+ * Two threads scan the same mixed register once each. The totals must count
+ * every announcement and every match twice, and every tag hit must be
+ * decapsulated and end up either as a match or as a false positive. The slots
+ * of the threads (the second may take over the first's) must hold whole scans
+ * with their cycles, and the text dump, direct and from the dump thread, must
+ * name every counter.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main() {
+    corpus_params params = { .kyber_k = CORPUS_MIXED, .n = TEST_N, .match_rate = 0.05, .threads = 1 };
+    for (int i = 0; i < CORPUS_SEED_BYTES; i++) params.seed[i] = (uint8_t)(7 * i + 5);
+
+    printf("Scan statistics: ");
+
+    corpus c;
+    sap_scan_keyset ks;
+    if (corpus_generate(&c, &params) != 0) {
+        printf("Test FAILED!\n");
+        return 1;
+    }
+    const uint8_t* v_priv[CORPUS_LEVELS] = { c.keys[0].v_priv, c.keys[1].v_priv, c.keys[2].v_priv };
+    const uint8_t* cts[TEST_N];
+    uint8_t view_tags[TEST_N];
+    for (size_t i = 0; i < TEST_N; i++) {
+        cts[i] = corpus_ct(&c, i);
+        view_tags[i] = corpus_tag(&c, i)[0];
+    }
+    int ok = sap_scan_keyset_init(&ks, v_priv) == 0;
+
+    sap_stats_reset();
+    scanner t[TEST_THREADS];
+    pthread_t ids[TEST_THREADS];
+    for (int i = 0; ok && i < TEST_THREADS; i++) {
+        t[i] = (scanner){ &c, cts, view_tags, &ks, 0 };
+        pthread_create(&ids[i], NULL, scan_once, &t[i]);
+    }
+    for (int i = 0; ok && i < TEST_THREADS; i++) {
+        pthread_join(ids[i], NULL);
+        ok = t[i].found == c.n_matches;
+    }
+
+    sap_scan_stats total;
+    sap_stats_get(&total);
+    ok = ok && total.v[SAP_STAT_SCANNED] == TEST_THREADS * TEST_N
+        && total.v[SAP_STAT_MATCHES] == TEST_THREADS * c.n_matches
+        && total.v[SAP_STAT_DECAPS] == total.v[SAP_STAT_TAG_HITS]
+        && total.v[SAP_STAT_TAG_HITS] == total.v[SAP_STAT_MATCHES] + total.v[SAP_STAT_FALSE_POSITIVES]
+        && total.v[SAP_STAT_CYCLES_DECRYPT] > 0 && total.v[SAP_STAT_CYCLES_TAG] > 0
+        && total.v[SAP_STAT_CYCLES_CONFIRM] > 0 && total.v[SAP_STAT_CYCLES_IO_WAIT] == 0;
+
+    sap_scan_stats per_thread[SAP_STATS_THREADS + 1];
+    size_t slots = sap_stats_get_threads(per_thread, SAP_STATS_THREADS + 1), scanning = 0;
+    for (size_t i = 0; ok && i < slots; i++) {
+        if (per_thread[i].v[SAP_STAT_SCANNED] == 0) continue;
+        scanning += per_thread[i].v[SAP_STAT_SCANNED];
+        ok = per_thread[i].v[SAP_STAT_SCANNED] % TEST_N == 0 && per_thread[i].v[SAP_STAT_CYCLES_DECRYPT] > 0;
+    }
+    ok = ok && scanning == TEST_THREADS * TEST_N;
+
+    FILE* f = tmpfile();
+    char text[4096] = { 0 };
+    ok = ok && f != NULL && sap_stats_print(f) == 0 && sap_stats_dump_start(f, 10) == 0
+        && sap_stats_dump_start(f, 10) == -1;
+    if (f != NULL) {
+        sap_stats_dump_stop();
+        rewind(f);
+        text[fread(text, 1, sizeof(text) - 1, f)] = '\0';
+        fclose(f);
+    }
+    for (int s = 0; ok && s < SAP_STAT_COUNTERS; s++) ok = strstr(text, sap_stats_name(s)) != NULL;
+    ok = ok && strstr(text, "scan stats: total") != NULL;
+
+    sap_stats_reset();
+    sap_stats_get(&total);
+    ok = ok && total.v[SAP_STAT_SCANNED] == 0;
+
+    sap_scan_keyset_free(&ks);
+    corpus_free(&c);
+
+    if (ok) {
+        printf("Test PASSED!\n");
+        return 0;
+    }
+    printf("Test FAILED!\n");
+    return 1;
+}
@@ -0,0 +1,88 @@
+#include "protocol_api.h"
+#include "randombytes.h"
+#include <stdio.h>
+
+#define TRIALS 4
+#define BATCH 37
+
+/// Unpacks 12-bit coefficients in standard order, the order of the reference backend.
+static void unpack(int16_t r[KYBER_K][KYBER_N], const uint8_t* b)
+{
+    for (int i = 0; i < KYBER_K * KYBER_N / 2; i++) {
+        r[0][2 * i] = (int16_t)((b[3 * i] | (uint16_t)b[3 * i + 1] << 8) & 0xfff);
+        r[0][2 * i + 1] = (int16_t)((b[3 * i + 1] >> 4 | (uint16_t)b[3 * i + 2] << 4) & 0xfff);
+    }
+}
+
+/**
+ * Computes t - A * s in the NTT domain with the reference backend's kernels, for
+ * the packed vectors t and s. For a Kyber key pair this is the noise e, and it
+ * must stay the same for every stealth key pair of the spending key.
+ */
+static void noise_of(int16_t e[KYBER_K][KYBER_N], const uint8_t* t_bytes, const uint8_t* s_bytes,
+    const uint8_t seed[KYBER_SYMBYTES])
+{
+    const sap_backend* ref = sap_backend_get(SAP_BACKEND_REF);
+    _Alignas(64) int16_t a[KYBER_K][KYBER_K][KYBER_N], s[KYBER_K][KYBER_N], t[KYBER_K][KYBER_N];
+    _Alignas(64) int16_t as[KYBER_N];
+
+    ref->gen_matrix(&a[0][0][0], seed, 0);
+    unpack(s, s_bytes);
+    unpack(t, t_bytes);
+    for (int i = 0; i < KYBER_K; i++) {
+        ref->polyvec_basemul_acc_montgomery(as, &a[i][0][0], &s[0][0]);
+        for (int c = 0; c < KYBER_N; c++) {
+            int32_t x = (int32_t)(((int64_t)as[c] << 16) % KYBER_Q);
+            e[i][c] = (int16_t)(((t[i][c] - x) % KYBER_Q + 2 * KYBER_Q) % KYBER_Q);
+        }
+    }
+}
+
+/**
+ * @brief Main function that runs the stealth private key test.
+ *
+ * A spending key pair and random shared secrets give stealth public keys (the
+ * backend's stealth_pub_key entry at this level) and private keys. Every
+ * stealth key pair must have the noise of the spending key pair, t - A * s. On
+ * every backend the CPU supports, the batch derivation must equal the single
+ * one and give the same keys.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main() {
+    uint8_t k_pub[PUBLIC_KEY_BYTES], k_priv[SECRET_KEY_BYTES], ss[BATCH][SS_BYTES];
+    uint8_t pub[STEALTH_ADDRESS_BYTES], priv[STEALTH_SECRET_KEY_BYTES];
+    int16_t e0[KYBER_K][KYBER_N], e[KYBER_K][KYBER_N];
+    uint8_t batch[BATCH][STEALTH_SECRET_KEY_BYTES], first[BATCH][STEALTH_SECRET_KEY_BYTES];
+    sap_spend_key key;
+    int ok = 1, first_backend = 1;
+
+    printf("Stealth private keys K=%d: ", KYBER_K);
+    randombytes(&ss[0][0], sizeof(ss));
+    ok = sap_kem_keypair(k_pub, k_priv) == 0;
+    sap_spend_key_init(&key, k_priv);
+
+    noise_of(e0, k_pub, k_priv, k_pub + STEALTH_ADDRESS_BYTES);
+    for (int t = 0; ok && t < TRIALS; t++) {
+        sap_backend_active()->stealth_pub_key(pub, ss[t], k_pub);
+        calculate_stealth_priv_key(priv, ss[t], &key);
+        noise_of(e, pub, priv, k_pub + STEALTH_ADDRESS_BYTES);
+        ok = memcmp(e, e0, sizeof(e)) == 0 && memcmp(pub, k_pub, sizeof(pub)) != 0;
+    }
+
+    for (int b = 0; ok && b < SAP_BACKEND_COUNT; b++) {
+        if (sap_backend_use((sap_backend_id)b) != 0) continue;
+        ok = ok && calculate_stealth_priv_keys(&batch[0][0], &ss[0][0], BATCH, &key, 3) == 0;
+        for (int i = 0; ok && i < BATCH; i++) {
+            calculate_stealth_priv_key(priv, ss[i], &key);
+            ok = memcmp(priv, batch[i], sizeof(priv)) == 0;
+        }
+        if (first_backend) memcpy(first, batch, sizeof(first));
+        ok = ok && memcmp(first, batch, sizeof(first)) == 0;
+        first_backend = 0;
+    }
+    sap_backend_use(sap_backend_detect());
+
+    printf(ok ? "Test PASSED!\n" : "Test FAILED!\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+#include "protocol_api.h"
+#include "randombytes.h"
+#include "stealth_avx2.h"
+#include <stdio.h>
+
+#define TRIALS 200
+
+/* The multi-pass computation stealth_pub_key_fused_avx2() replaces */
+static void stealth_multi_pass(uint8_t r[KYBER_POLYVECBYTES], const polyvec a[KYBER_K],
+    const polyvec* s, const polyvec* pkpv)
+{
+    polyvec p;
+    for (int i = 0; i < KYBER_K; i++) {
+        polyvec_basemul_acc_montgomery(&p.vec[i], &a[i], s);
+        poly_tomont(&p.vec[i]);
+    }
+    polyvec_add(&p, &p, pkpv);
+    polyvec_reduce(&p);
+    polyvec_tobytes(r, &p);
+}
+
+/**
+ * Fills the operands: A from a random seed, s sampled as in the protocol and an
+ * arbitrary 12-bit pkpv. Every fourth trial instead sets A to (q-1)/2 and s to +-eta1
+ * everywhere, the largest inputs the accumulation sees.
+ */
+static void fill(polyvec a[KYBER_K], polyvec* s, polyvec* pkpv, int trial)
+{
+    uint8_t pk[KYBER_INDCPA_PUBLICKEYBYTES], seed[KYBER_SYMBYTES], noise_seed[KYBER_SYMBYTES];
+
+    randombytes(pk, sizeof(pk));
+    randombytes(noise_seed, sizeof(noise_seed));
+    unpack_pk(pkpv, seed, pk);
+    gen_matrix(a, seed, 0);
+    for (int j = 0; j < KYBER_K; j++) {
+        poly_getnoise_eta1(&s->vec[j], noise_seed, (uint8_t)j);
+    }
+
+    if (trial % 4 == 3) {
+        for (int i = 0; i < KYBER_K; i++) {
+            for (int j = 0; j < KYBER_K; j++) {
+                for (int n = 0; n < KYBER_N; n++) {
+                    a[i].vec[j].coeffs[n] = (KYBER_Q - 1) / 2 + (trial / 8) % 2;
+                    s->vec[j].coeffs[n] = (trial / 4) % 2 ? -KYBER_ETA1 : KYBER_ETA1;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Main function that runs the fused stealth kernel test.
+ *
+ * Compares stealth_pub_key_fused_avx2() with polyvec_basemul_acc_montgomery(),
+ * poly_tomont(), polyvec_add(), polyvec_reduce() and polyvec_tobytes() of the AVX2
+ * library at the compiled security level. Skipped on CPUs without AVX2.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main() {
+    polyvec a[KYBER_K], s, pkpv;
+    uint8_t expected[KYBER_POLYVECBYTES], out[KYBER_POLYVECBYTES];
+    int ok = 1;
+
+    printf("Stealth fused K=%d: ", KYBER_K);
+    if (!sap_backend_supported(SAP_BACKEND_AVX2)) {
+        printf("skipped (no AVX2)\n");
+        return 0;
+    }
+
+    for (int trial = 0; trial < TRIALS && ok; trial++) {
+        fill(a, &s, &pkpv, trial);
+        stealth_multi_pass(expected, a, &s, &pkpv);
+        stealth_pub_key_fused_avx2(out, a, &s, &pkpv);
+        ok = memcmp(expected, out, sizeof(out)) == 0;
+    }
+
+    printf(ok ? "Test PASSED!\n" : "Test FAILED!\n");
+    return ok ? 0 : 1;
+}
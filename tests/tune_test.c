@@ -0,0 +1,88 @@
+#include "corpus.h"
+#include "scan_mixed.h"
+#include "tune.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_N 300
+
+/// Scans the register with @p p; the hits must be exactly the corpus matches.
+static int scan_matches(const sap_tune_profile* p, const corpus* c, const uint8_t* const* cts,
+    const uint8_t* view_tags, const void* key)
+{
+    uint8_t hits[TEST_N];
+    if (sap_tune_scan(p, hits, NULL, cts, view_tags, TEST_N, key) != c->n_matches) {
+        return 0;
+    }
+    size_t seen = 0;
+    for (size_t m = 0; m < c->n_matches; m++) seen += hits[c->matches[m]] == 1;
+    return seen == c->n_matches;
+}
+
+/**
+ * @brief Main function that runs the auto-tuner test.
+ *
+ * Tunes Kyber512 with a short budget and checks the profile names a supported
+ * backend, one of the batch sizes and a usable thread count. The profile must
+ * survive a save and load, and be rejected once its CPU line no longer matches
+ * this machine or for another level. Scanning with the tuned profile, and with
+ * a forced 3-thread, 16-announcement profile, must find exactly the matches.
+ *
+ * @return 0 if the test passes, 1 otherwise.
+ */
+int main() {
+    corpus_params params = { .kyber_k = 2, .n = TEST_N, .match_rate = 0.05, .threads = 1 };
+    for (int i = 0; i < CORPUS_SEED_BYTES; i++) params.seed[i] = (uint8_t)(3 * i + 11);
+    char path[] = "/tmp/tune_test_XXXXXX";
+
+    printf("Auto-tuner: ");
+
+    corpus c;
+    int fd = mkstemp(path);
+    if (fd < 0 || corpus_generate(&c, &params) != 0) {
+        printf("Test FAILED!\n");
+        return 1;
+    }
+    close(fd);
+    const uint8_t* cts[TEST_N];
+    uint8_t view_tags[TEST_N];
+    for (size_t i = 0; i < TEST_N; i++) {
+        cts[i] = corpus_ct(&c, i);
+        view_tags[i] = corpus_tag(&c, i)[0];
+    }
+    void* key = malloc(pqsap_kyber512_scan_level.key_bytes);
+    pqsap_kyber512_scan_level.key_init(key, c.v_priv);
+
+    sap_tune_profile p, q;
+    int ok = sap_tune_run(&p, 2, 60) == 0 && sap_tune_run(&q, 5, 60) == -1;
+    ok = ok && p.kyber_k == 2 && sap_backend_supported(p.backend) && p.throughput > 0
+        && p.threads >= 1 && p.threads <= p.cpus
+        && (p.batch == 16 || p.batch == 64 || p.batch == 256 || p.batch == 1024);
+
+    ok = ok && sap_tune_save(&p, path) == 0 && sap_tune_load(&q, path, 2) == 0
+        && q.backend == p.backend && q.batch == p.batch && q.threads == p.threads && strcmp(q.cpu, p.cpu) == 0
+        && sap_tune_load(&q, path, 3) == -1 && sap_tune_load_or_run(&q, path, 2, 60) == 0;
+
+    ok = ok && sap_tune_apply(&p) == 0 && scan_matches(&p, &c, cts, view_tags, key);
+    sap_tune_profile forced = p;
+    forced.threads = 3;
+    forced.batch = 16;
+    ok = ok && scan_matches(&forced, &c, cts, view_tags, key);
+
+    snprintf(p.cpu, sizeof(p.cpu), "another CPU");
+    ok = ok && sap_tune_save(&p, path) == 0 && sap_tune_load(&q, path, 2) == -1
+        && sap_tune_load_or_run(&q, path, 2, 60) == 1 && sap_tune_load(&p, path, 2) == 0;
+
+    remove(path);
+    free(key);
+    corpus_free(&c);
+
+    if (ok) {
+        printf("Test PASSED!\n");
+        return 0;
+    }
+    printf("Test FAILED!\n");
+    return 1;
+}
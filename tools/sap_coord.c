@@ -0,0 +1,80 @@
+#include "coord.h"
+#include "tune.h"
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+        "Usage: %s -r REGISTER -k KEYFILE [-n WORKERS] [-s SHARDS] [-a ATTEMPTS] [-t TIMEOUT_MS] [-x] [-N]\n"
+        "       %s [-N] -W\n"
+        "  -r REGISTER    register file to scan (sap_corpus format)\n"
+        "  -k KEYFILE     keys to scan for (sap_scand key file)\n"
+        "  -n WORKERS     worker processes at a time (default: the most tuned threads, otherwise 4)\n"
+        "  -s SHARDS      index ranges the register is split into (default four per worker)\n"
+        "  -a ATTEMPTS    workers a shard is handed to before giving up (default 3)\n"
+        "  -t TIMEOUT_MS  time a worker has for one shard (default no limit)\n"
+        "  -x             run every worker as a new process of this program instead of a fork\n"
+        "  -N             keep the detected backends and default sizes instead of the tuned profiles (see sap_tune)\n"
+        "  -W             act as a worker on standard input and output\n", prog, prog);
+}
+
+/**
+ * @brief Scans a register with several worker processes.
+ *
+ * Prints one line per match, "key K index I", in register order, and a summary
+ * on standard error. At startup it applies the scan profile of every level,
+ * tuning the levels without one first, and starts as many workers as the
+ * profiles have threads; workers only load the profiles.
+ */
+int main(int argc, char** argv)
+{
+    sap_coord_config config = { 0 };
+    int opt, exec_workers = 0, tune = 1;
+
+    while ((opt = getopt(argc, argv, "r:k:n:s:a:t:xNW")) != -1) {
+        switch (opt) {
+        case 'r': config.register_path = optarg; break;
+        case 'k': config.key_path = optarg; break;
+        case 'n': config.workers = (unsigned int)atoi(optarg); break;
+        case 's': config.shards = strtoull(optarg, NULL, 10); break;
+        case 'a': config.attempts = (unsigned int)atoi(optarg); break;
+        case 't': config.timeout_ms = (unsigned int)atoi(optarg); break;
+        case 'x': exec_workers = 1; break;
+        case 'N': tune = 0; break;
+        case 'W':
+            if (tune) sap_tune_startup(NULL, 0);
+            return sap_coord_worker_serve(0, 1) == 0 ? 0 : 1;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (config.register_path == NULL || config.key_path == NULL) {
+        usage(argv[0]);
+        return 1;
+    }
+    sap_tune_profile profiles[3];
+    if (tune && sap_tune_startup(profiles, 1) > 0 && config.workers == 0) {
+        for (int l = 0; l < 3; l++) {
+            if (profiles[l].threads > config.workers) config.workers = profiles[l].threads;
+        }
+    }
+
+    char* worker_argv[] = { "/proc/self/exe", tune ? "-W" : "-NW", NULL };
+    sap_coord_transport exec_transport = sap_coord_exec_transport(worker_argv);
+    if (exec_workers) config.transport = &exec_transport;
+
+    sap_coord_result result;
+    int ret = sap_coord_run(&config, &result);
+    for (size_t i = 0; ret == 0 && i < result.n_matches; i++) {
+        printf("key %" PRIu32 " index %" PRIu64 "\n", result.matches[i].key, result.matches[i].index);
+    }
+    fprintf(stderr, "%" PRIu64 " of %" PRIu64 " entries in %zu shards scanned, %zu matches, %u workers started, %u failed\n",
+        result.scanned, result.entries, result.shards, result.n_matches, result.spawned, result.failures);
+    sap_coord_result_free(&result);
+    if (ret != 0) fprintf(stderr, "scan incomplete\n");
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+#include "corpus.h"
+#include "randombytes.h"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+        "Usage: %s -o FILE [-n COUNT] [-r MATCH_RATE] [-k KYBER_K] [-s SEED_HEX] [-t THREADS] [-m]\n"
+        "  -o FILE        output register file\n"
+        "  -n COUNT       number of announcements (default 10000)\n"
+        "  -r MATCH_RATE  fraction addressed to the recipient (default 0.001)\n"
+        "  -k KYBER_K     security level 2, 3 or 4, or \"mixed\" for all three (default 3)\n"
+        "  -s SEED_HEX    64 hex digit seed (default: random)\n"
+        "  -t THREADS     worker threads (default: one per online CPU)\n"
+        "  -m             print the expected match indices\n", prog);
+}
+
+static int parse_seed(uint8_t seed[CORPUS_SEED_BYTES], const char* hex)
+{
+    if (strlen(hex) != 2 * CORPUS_SEED_BYTES) {
+        return -1;
+    }
+    for (int i = 0; i < CORPUS_SEED_BYTES; i++) {
+        unsigned int byte;
+        if (sscanf(hex + 2 * i, "%2x", &byte) != 1) {
+            return -1;
+        }
+        seed[i] = (uint8_t)byte;
+    }
+    return 0;
+}
+
+/**
+ * @brief Generates an announcement register and writes it to disk.
+ *
+ * The register is derived deterministically from the seed through the
+ * keypair_derand/enc_derand KEM APIs, so the same command line always produces
+ * the same file. The expected match indices are stored in the file.
+ */
+int main(int argc, char** argv)
+{
+    corpus_params params = { .kyber_k = 3, .n = 10000, .match_rate = 0.001, .threads = 0 };
+    const char* out = NULL;
+    int print_matches = 0;
+    int have_seed = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:n:r:k:s:t:m")) != -1) {
+        switch (opt) {
+        case 'o': out = optarg; break;
+        case 'n': params.n = strtoull(optarg, NULL, 10); break;
+        case 'r': params.match_rate = strtod(optarg, NULL); break;
+        case 'k': params.kyber_k = strcmp(optarg, "mixed") == 0 ? CORPUS_MIXED : (uint32_t)atoi(optarg); break;
+        case 't': params.threads = (unsigned int)atoi(optarg); break;
+        case 'm': print_matches = 1; break;
+        case 's':
+            if (parse_seed(params.seed, optarg) != 0) {
+                fprintf(stderr, "invalid seed: %s\n", optarg);
+                return 1;
+            }
+            have_seed = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (out == NULL || (params.kyber_k != CORPUS_MIXED && (params.kyber_k < 2 || params.kyber_k > 4))) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (!have_seed) {
+        randombytes(params.seed, CORPUS_SEED_BYTES);
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    corpus c;
+    if (corpus_generate(&c, &params) != 0) {
+        fprintf(stderr, "corpus generation failed\n");
+        return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed_ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+    if (corpus_save(&c, out) != 0) {
+        fprintf(stderr, "could not write %s\n", out);
+        corpus_free(&c);
+        return 1;
+    }
+
+    if (c.kyber_k == CORPUS_MIXED) printf("KYBER_K = mixed");
+    else printf("KYBER_K = %u", c.kyber_k);
+    printf(", N = %zu, matches = %zu, generated in %.3f ms\nseed: ", c.n, c.n_matches, elapsed_ms);
+    for (int i = 0; i < CORPUS_SEED_BYTES; i++) printf("%02x", c.seed[i]);
+    printf("\n");
+
+    if (print_matches) {
+        for (size_t i = 0; i < c.n_matches; i++) printf("%llu\n", (unsigned long long)c.matches[i]);
+    }
+
+    corpus_free(&c);
+    return 0;
+}
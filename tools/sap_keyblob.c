@@ -0,0 +1,78 @@
+#include "keyblob.h"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+        "Usage: %s -k KEYFILE -o BLOB [-e ENCKEY]\n"
+        "       %s -c BLOB [-e ENCKEY]\n"
+        "  -k KEYFILE  key file to prepare (sap_scand format)\n"
+        "  -o BLOB     key blob to write\n"
+        "  -c BLOB     check a key blob and list its keys\n"
+        "  -e ENCKEY   file with the %d-byte key to encrypt or decrypt the blob with\n",
+        prog, prog, SAP_KEYBLOB_KEY_BYTES);
+}
+
+/// Reads the encryption key file; returns 0 on success.
+static int read_key(const char* path, uint8_t key[SAP_KEYBLOB_KEY_BYTES])
+{
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return -1;
+    }
+    int ok = fread(key, 1, SAP_KEYBLOB_KEY_BYTES, f) == SAP_KEYBLOB_KEY_BYTES;
+    fclose(f);
+    return ok ? 0 : -1;
+}
+
+/**
+ * @brief Prepares the keys of a key file into a key blob, or checks a blob.
+ */
+int main(int argc, char** argv)
+{
+    const char *key_path = NULL, *out = NULL, *check = NULL, *enc_path = NULL;
+    uint8_t enc_key[SAP_KEYBLOB_KEY_BYTES];
+    int opt;
+
+    while ((opt = getopt(argc, argv, "k:o:c:e:")) != -1) {
+        switch (opt) {
+        case 'k': key_path = optarg; break;
+        case 'o': out = optarg; break;
+        case 'c': check = optarg; break;
+        case 'e': enc_path = optarg; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if ((check == NULL) == (key_path == NULL || out == NULL)) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (enc_path != NULL && read_key(enc_path, enc_key) != 0) {
+        fprintf(stderr, "cannot read a %d-byte key from %s\n", SAP_KEYBLOB_KEY_BYTES, enc_path);
+        return 1;
+    }
+
+    if (check == NULL) {
+        long n = sap_keyblob_convert(out, key_path, enc_path != NULL ? enc_key : NULL);
+        if (n < 0) {
+            fprintf(stderr, "cannot convert %s into %s\n", key_path, out);
+            return 1;
+        }
+        printf("%ld keys written to %s\n", n, out);
+        return 0;
+    }
+
+    sap_keyblob b;
+    if (sap_keyblob_open(&b, check, enc_path != NULL ? enc_key : NULL, 0) != 0) {
+        fprintf(stderr, "%s is not a valid key blob for this build (or the key is wrong)\n", check);
+        return 1;
+    }
+    for (size_t i = 0; i < b.n; i++) printf("key %zu: kyber_k %u\n", i, b.entries[i].kyber_k);
+    printf("%zu keys, %zu bytes\n", b.n, b.map_bytes);
+    sap_keyblob_close(&b);
+    return 0;
+}
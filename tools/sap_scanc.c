@@ -0,0 +1,146 @@
+#include "corpus.h"
+#include "scand_client.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+        "Usage: %s SOCKET COMMAND [ARGS]\n"
+        "  status                 register size, scan progress and key count\n"
+        "  reload                 reload the daemon's key file\n"
+        "  register CORPUS        register the recipient keys stored in a register file\n"
+        "  query KEY_ID [FROM]    print the matches of a key\n"
+        "  watch KEY_ID...        print new matches of the keys until interrupted\n"
+        "  weight KEY_ID WEIGHT   set the scan time share of a key (default 100)\n"
+        "  metrics                scheduler queue counters\n"
+        "Usage: %s -x CORPUS KEYFILE\n"
+        "  write the recipient keys of a register file as a sap_scand key file\n", prog, prog);
+}
+
+static void print_match(const sap_scand_match* m)
+{
+    printf("key %" PRIu32 " index %" PRIu64 " kyber_k %" PRIu32 " stealth ", m->key_id, m->index, m->kyber_k);
+    for (int i = 0; i < 8; i++) printf("%02x", m->stealth_pub_key[i]);
+    printf("...\n");
+}
+
+/// Writes one REGISTER body per level present in @p c.
+static int export_keys(const corpus* c, const char* path)
+{
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+        return -1;
+    }
+    int ok = 1;
+    for (uint32_t l = 0; l < CORPUS_LEVELS; l++) {
+        size_t ct_bytes, pk_bytes, sk_bytes;
+        uint8_t k = (uint8_t)(l + 2);
+        if (c->keys[l].k_pub == NULL) continue;
+        corpus_level_sizes(k, &ct_bytes, &pk_bytes, &sk_bytes);
+        ok &= fwrite(&k, 1, 1, f) == 1;
+        ok &= fwrite(c->keys[l].k_pub, 1, pk_bytes, f) == pk_bytes;
+        ok &= fwrite(c->keys[l].v_priv, 1, sk_bytes, f) == sk_bytes;
+    }
+    ok &= fclose(f) == 0;
+    return ok ? 0 : -1;
+}
+
+/**
+ * @brief Command line client of sap_scand.
+ *
+ * Stands in for a wallet: registers keys, reads matches and follows new ones.
+ */
+int main(int argc, char** argv)
+{
+    if (argc == 4 && strcmp(argv[1], "-x") == 0) {
+        corpus c;
+        if (corpus_load(&c, argv[2]) != 0) {
+            fprintf(stderr, "cannot read %s\n", argv[2]);
+            return 1;
+        }
+        int ret = export_keys(&c, argv[3]);
+        corpus_free(&c);
+        if (ret != 0) fprintf(stderr, "cannot write %s\n", argv[3]);
+        return ret == 0 ? 0 : 1;
+    }
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    sap_scand_client client;
+    if (sap_scand_connect(&client, argv[1]) != 0) {
+        fprintf(stderr, "cannot connect to %s\n", argv[1]);
+        return 1;
+    }
+    const char* cmd = argv[2];
+    int ret = 0;
+
+    if (strcmp(cmd, "status") == 0) {
+        sap_scand_status s;
+        ret = sap_scand_get_status(&client, &s);
+        if (ret == 0) {
+            printf("entries %" PRIu64 " scanned %" PRIu64 " keys %" PRIu32 "\n", s.entries, s.scanned, s.keys);
+        }
+    } else if (strcmp(cmd, "reload") == 0) {
+        long n = sap_scand_reload_keys(&client);
+        if (n >= 0) printf("%ld keys in the key file\n", n);
+        ret = n < 0 ? -1 : 0;
+    } else if (strcmp(cmd, "register") == 0 && argc == 4) {
+        corpus c;
+        if (corpus_load(&c, argv[3]) != 0) {
+            fprintf(stderr, "cannot read %s\n", argv[3]);
+            sap_scand_disconnect(&client);
+            return 1;
+        }
+        for (uint32_t l = 0; ret == 0 && l < CORPUS_LEVELS; l++) {
+            uint32_t id;
+            if (c.keys[l].k_pub == NULL) continue;
+            ret = sap_scand_register(&client, l + 2, c.keys[l].k_pub, c.keys[l].v_priv, &id);
+            if (ret == 0) printf("kyber_k %" PRIu32 " key %" PRIu32 "\n", l + 2, id);
+        }
+        corpus_free(&c);
+    } else if (strcmp(cmd, "query") == 0 && (argc == 4 || argc == 5)) {
+        uint32_t id = (uint32_t)strtoul(argv[3], NULL, 10);
+        uint64_t from = argc == 5 ? strtoull(argv[4], NULL, 10) : 0;
+        sap_scand_match m[SAP_SCAND_QUERY_MAX];
+        long n;
+        while ((n = sap_scand_query(&client, id, from, m, SAP_SCAND_QUERY_MAX)) > 0) {
+            for (long i = 0; i < n; i++) print_match(&m[i]);
+            from = m[n - 1].index + 1;
+        }
+        ret = n < 0 ? -1 : 0;
+    } else if (strcmp(cmd, "watch") == 0 && argc >= 4) {
+        for (int i = 3; ret == 0 && i < argc; i++) {
+            ret = sap_scand_subscribe(&client, (uint32_t)strtoul(argv[i], NULL, 10));
+        }
+        sap_scand_match m;
+        while (ret == 0 && sap_scand_next_event(&client, &m, -1) == 1) {
+            print_match(&m);
+            fflush(stdout);
+        }
+    } else if (strcmp(cmd, "weight") == 0 && argc == 5) {
+        ret = sap_scand_set_weight(&client, (uint32_t)strtoul(argv[3], NULL, 10), (uint32_t)strtoul(argv[4], NULL, 10));
+    } else if (strcmp(cmd, "metrics") == 0) {
+        static const char* const names[2] = { "tail", "backfill" };
+        sap_scand_queue_metrics m[2];
+        ret = sap_scand_get_metrics(&client, m);
+        for (int q = 0; ret == 0 && q < 2; q++) {
+            printf("%-8s keys %" PRIu32 " batches %" PRIu64 " busy %.1f ms delay avg %.3f ms max %.3f ms\n",
+                names[q], m[q].keys, m[q].batches, m[q].busy_ns / 1e6,
+                m[q].waits ? m[q].wait_sum_ns / 1e6 / m[q].waits : 0.0, m[q].wait_max_ns / 1e6);
+        }
+    } else {
+        usage(argv[0]);
+        ret = -1;
+    }
+
+    if (ret != 0) {
+        fprintf(stderr, "%s failed\n", cmd);
+    }
+    sap_scand_disconnect(&client);
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+#include "scand.h"
+#include "scan_stats.h"
+#include "tune.h"
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static sap_scand* daemon_handle;
+
+static void on_stop(int sig)
+{
+    (void)sig;
+    sap_scand_stop(daemon_handle);
+}
+
+static void on_reload(int sig)
+{
+    (void)sig;
+    sap_scand_reload(daemon_handle);
+}
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+        "Usage: %s -s SOCKET -r REGISTER [-k KEYFILE] [-p POLL_MS] [-t TAIL_SHARE] [-w TAIL_ENTRIES] [-c CHUNK] [-S STATS_MS] [-N]\n"
+        "  -s SOCKET        Unix socket to listen on\n"
+        "  -r REGISTER      register file to watch (sap_corpus format)\n"
+        "  -k KEYFILE       keys to scan for, as a key file or key blob; reloaded on SIGHUP\n"
+        "  -p POLL_MS       register check interval in milliseconds (default 200)\n"
+        "  -t TAIL_SHARE    percent of the scan time for keys near the tip while others backfill (default 90)\n"
+        "  -w TAIL_ENTRIES  how far behind the tip a key still counts as near it (default 16384)\n"
+        "  -c CHUNK         register entries scanned per step, at most 1024 (default: the largest tuned batch)\n"
+        "  -S STATS_MS      print scan counters to stderr every STATS_MS milliseconds\n"
+        "  -N               keep the detected backends and default sizes instead of the tuned profiles (see sap_tune)\n", prog);
+}
+
+/**
+ * @brief Runs sap_scand in the foreground.
+ *
+ * At startup it applies the scan profile of every level, tuning the levels
+ * without one first, and scans chunks of the largest tuned batch size. SIGHUP reloads the key file, SIGINT and SIGTERM stop the
+ * daemon.
+ */
+int main(int argc, char** argv)
+{
+    sap_scand_config config = { 0 };
+    unsigned int stats_ms = 0;
+    int opt, tune = 1;
+
+    while ((opt = getopt(argc, argv, "s:r:k:p:t:w:c:S:N")) != -1) {
+        switch (opt) {
+        case 's': config.socket_path = optarg; break;
+        case 'r': config.register_path = optarg; break;
+        case 'k': config.key_path = optarg; break;
+        case 'p': config.poll_ms = (unsigned int)atoi(optarg); break;
+        case 't': config.tail_share = (unsigned int)atoi(optarg); break;
+        case 'w': config.tail_entries = strtoull(optarg, NULL, 10); break;
+        case 'c': config.chunk_entries = strtoull(optarg, NULL, 10); break;
+        case 'S': stats_ms = (unsigned int)atoi(optarg); break;
+        case 'N': tune = 0; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (config.socket_path == NULL || config.register_path == NULL) {
+        usage(argv[0]);
+        return 1;
+    }
+    sap_tune_profile profiles[3];
+    if (tune && sap_tune_startup(profiles, 1) > 0 && config.chunk_entries == 0) {
+        for (int l = 0; l < 3; l++) {
+            if (profiles[l].batch > config.chunk_entries) config.chunk_entries = profiles[l].batch;
+        }
+    }
+
+    daemon_handle = sap_scand_open(&config);
+    if (daemon_handle == NULL) {
+        fprintf(stderr, "cannot start on %s\n", config.socket_path);
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sigemptyset(&sa.sa_mask);
+    sa.sa_handler = on_stop;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sa.sa_handler = on_reload;
+    sigaction(SIGHUP, &sa, NULL);
+
+    if (stats_ms > 0 && sap_stats_dump_start(stderr, stats_ms) != 0) {
+        fprintf(stderr, "cannot start the statistics thread\n");
+    }
+    int ret = sap_scand_run(daemon_handle);
+    sap_stats_dump_stop();
+    sap_scand_close(daemon_handle);
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+#include "tune.h"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+        "Usage: %s [-k LEVEL] [-b BUDGET_MS] [-o PROFILE] [-f]\n"
+        "  -k LEVEL      Kyber k to tune: 2, 3 or 4 (default all three)\n"
+        "  -b BUDGET_MS  time spent measuring each level (default %d)\n"
+        "  -o PROFILE    profile file (default ~/.cache/pqsap/scan-kK.profile; one level only)\n"
+        "  -f            tune again even if the profile is usable\n", prog, SAP_TUNE_BUDGET_MS);
+}
+
+static const char* const backend_names[SAP_BACKEND_COUNT] = { "ref", "avx2", "avx512" };
+
+/**
+ * @brief Tunes the scanning of each level and writes the profiles.
+ *
+ * Prints the chosen configuration of every level, and whether it was measured
+ * or reused.
+ */
+int main(int argc, char** argv)
+{
+    unsigned int kyber_k = 0, budget_ms = 0;
+    const char* out = NULL;
+    int opt, force = 0;
+
+    while ((opt = getopt(argc, argv, "k:b:o:f")) != -1) {
+        switch (opt) {
+        case 'k': kyber_k = (unsigned int)atoi(optarg); break;
+        case 'b': budget_ms = (unsigned int)atoi(optarg); break;
+        case 'o': out = optarg; break;
+        case 'f': force = 1; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if ((kyber_k != 0 && (kyber_k < 2 || kyber_k > 4)) || (out != NULL && kyber_k == 0)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    for (unsigned int k = 2; k <= 4; k++) {
+        if (kyber_k != 0 && k != kyber_k) continue;
+        char path[4096];
+        if (out != NULL) {
+            snprintf(path, sizeof(path), "%s", out);
+        } else {
+            sap_tune_default_path(path, sizeof(path), k);
+        }
+        sap_tune_profile p;
+        int ret;
+        if (force) {
+            ret = sap_tune_run(&p, k, budget_ms) == 0 ? 1 : -1;
+            if (ret == 1 && sap_tune_save(&p, path) != 0) {
+                fprintf(stderr, "cannot write %s\n", path);
+                return 1;
+            }
+        } else {
+            ret = sap_tune_load_or_run(&p, path, k, budget_ms);
+        }
+        if (ret < 0) {
+            fprintf(stderr, "tuning k=%u failed\n", k);
+            return 1;
+        }
+        printf("k=%u backend %s, batch %zu, %u thread%s: %.0f announcements/s (%s %s)\n", k,
+            backend_names[p.backend], p.batch, p.threads, p.threads == 1 ? "" : "s", p.throughput,
+            ret == 0 ? "reused from" : "measured for", path);
+    }
+    return 0;
+}